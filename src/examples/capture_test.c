@@ -0,0 +1,124 @@
+// Records a software window to a raw capture file while it changes every frame, first a
+// little (a ticking label) and then all of it, and checks the file against the stats.
+// Capturing must cost the UI thread less than XI_CAPTURE_BUDGET_MS per frame on average
+// (xi_CaptureStats.copy_ms), even when every frame redraws the whole window.
+// Build and run from src/ with: make test
+#include "../xi.h"
+#include <stdio.h>
+
+#define XI_CAPTURE_BUDGET_MS 1.0f
+#define WIDTH 1280
+#define HEIGHT 720
+#define CAPTURE_PATH "capture_test.xiraw"
+
+static Label clock_label;
+static int ticks;
+
+static void stop(void *userdata) {
+    (void)userdata;
+    program_active = false;
+}
+
+static void run(Uint32 ms) {
+    program_active = true;
+    xi_AddTimer(ms, 0, stop, NULL);
+    EventLoop();
+}
+
+static void tick(void *userdata) {
+    bool whole = *(bool*)userdata;
+    static char text[32];
+    SDL_snprintf(text, sizeof(text), "frame %d", ++ticks);
+    clock_label.text = text;
+    if (whole) xi_redraw_all();
+    else xi_Invalidate(&clock_label);
+}
+
+static Uint32 read_u32(SDL_RWops *file, bool *ok) {
+    Uint8 b[4];
+    if (SDL_RWread(file, b, 4, 1) != 1) {
+        *ok = false;
+        return 0;
+    }
+    return b[0] | b[1] << 8 | b[2] << 16 | (Uint32)b[3] << 24;
+}
+
+// Walk the records: frame numbers go up by one, or a whole frame follows the gap
+static int check_file(int captured) {
+    SDL_RWops *file = SDL_RWFromFile(CAPTURE_PATH, "rb");
+    char magic[8];
+    if (!file || SDL_RWread(file, magic, 8, 1) != 1 || memcmp(magic, "XICAPRAW", 8) != 0) {
+        printf("%s: missing or without its header\n", CAPTURE_PATH);
+        if (file) SDL_RWclose(file);
+        return 1;
+    }
+    int records = 0, failed = 0;
+    Uint32 last = 0;
+    for (;;) {
+        bool ok = true;
+        Uint32 h[8];
+        for (int i = 0; i < 8; ++i) h[i] = read_u32(file, &ok);
+        if (!ok) break;
+        bool whole = h[4] == 0 && h[5] == 0 && h[6] == h[2] && h[7] == h[3];
+        if ((records == 0 || h[0] != last + 1) && !whole) {
+            printf("record %d (frame %u) follows a gap but isn't a whole frame\n", records, h[0]);
+            failed++;
+        }
+        last = h[0];
+        SDL_RWseek(file, (Sint64)h[6] * h[7] * 4, RW_SEEK_CUR);
+        records++;
+    }
+    SDL_RWclose(file);
+    if (records != captured) {
+        printf("%d records in the file, %d frames captured\n", records, captured);
+        failed++;
+    }
+    return failed;
+}
+
+static int capture(const char *name, bool whole) {
+    if (!xi_StartCapture(CAPTURE_PATH, XI_CAPTURE_RAW)) return 1;
+    int timer = xi_AddTimer(16, 16, tick, &whole);
+    run(1000);
+    xi_CancelTimer(timer);
+    xi_CaptureStats stats = xi_StopCapture();
+    printf("%s: captured %d, dropped %d, written %d, failed %d, %.3f ms per frame on the UI thread\n",
+           name, stats.captured, stats.dropped, stats.written, stats.failed, stats.copy_ms);
+    int failed = check_file(stats.captured);
+    if (stats.captured < 10 || stats.written != stats.captured || stats.failed) {
+        printf("%s: frames went missing\n", name);
+        failed++;
+    }
+    if (stats.copy_ms >= XI_CAPTURE_BUDGET_MS) {
+        printf("%s: capture costs %.3f ms per frame, over the %.1f ms budget\n", name, stats.copy_ms,
+               XI_CAPTURE_BUDGET_MS);
+        failed++;
+    }
+    remove(CAPTURE_PATH);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    xi_UseSoftwareRenderer(true);
+    xiCreateWindow("capture test", WIDTH, HEIGHT);
+
+    xi_Container panel = createContainer(0, 0, WIDTH, HEIGHT, (Color){30, 30, 60, 255}, NULL, false);
+    xi_SetLayout(&panel, XI_LAYOUT_GRID, 8, 8);
+    xi_SetGridColumns(&panel, 6);
+    static Button buttons[36];
+    for (int i = 0; i < 36; ++i) {
+        buttons[i] = CreateButton(0, 0, 180, 60, "button", COLOR_WHITE, COLOR_BLUE, COLOR_GREEN, COLOR_RED);
+        xi_AddWidget(&panel, &buttons[i]);
+    }
+    clock_label = CreateLabel(0, 0, 180, 60, "frame 0", COLOR_WHITE, COLOR_BLACK);
+    xi_AddWidget(&panel, &clock_label);
+    xi_AddWidget(NULL, &panel);
+    run(50);
+
+    int failed = capture("damage only", false) + capture("whole window", true);
+    xiDestroyWindow(&(xi_Window){0});
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+// Times a dropdown with 50000 options: building its filter index, then each step of
+// typing queries into the open popup and deleting them again.
+// Build and run from src/ with: make bench
+#include "../xi.h"
+#include <stdio.h>
+
+#define OPTIONS 50000
+
+static const char *words[] = {"pump", "valve", "sensor", "flow", "pressure", "north", "south",
+                              "tank", "heater", "mixer", "inlet", "outlet", "level", "alarm"};
+#define WORDS (int)(sizeof(words) / sizeof(words[0]))
+
+static double now_ms(void) {
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static void key(xi_Dropdown *d, SDL_Keycode sym) {
+    SDL_Event event = {0};
+    event.type = SDL_KEYDOWN;
+    event.key.keysym.sym = sym;
+    update_dropdown(d, &event);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    xiCreateWindow("dropdown bench", 800, 600);
+
+    static char names[OPTIONS][48];
+    static const char *options[OPTIONS];
+    for (int i = 0; i < OPTIONS; ++i) {
+        SDL_snprintf(names[i], sizeof(names[i]), "%s-%s-%05d", words[i % WORDS],
+                     words[(i / WORDS) % WORDS], i);
+        options[i] = names[i];
+    }
+    static xi_Dropdown d;
+    d = xi_CreateDropdown(0, 0, 300, 32, 14, COLOR_BLACK, COLOR_WHITE);
+    xi_AddWidget(NULL, &d);
+    double start = now_ms();
+    xi_SetDropdownOptions(&d, options, OPTIONS);
+    double indexed = now_ms() - start;
+    printf("%d options: index built in %.1f ms\n", OPTIONS, indexed);
+
+    // Prefix, substring and no-match queries, one character at a time, then deleted
+    const char *queries[] = {"pressure-n", "ter-mix", "let-12", "zzz"};
+    xi_OpenDropdown(&d);
+    render_widgets();
+    for (int q = 0; q < (int)(sizeof(queries) / sizeof(queries[0])); ++q) {
+        double worst_type = 0, total_type = 0, worst_delete = 0;
+        int steps = (int)strlen(queries[q]);
+        for (int i = 0; i < steps; ++i) {
+            SDL_Event event = {0};
+            event.type = SDL_TEXTINPUT;
+            event.text.text[0] = queries[q][i];
+            start = now_ms();
+            update_dropdown(&d, &event);
+            double ms = now_ms() - start;
+            total_type += ms;
+            if (ms > worst_type) worst_type = ms;
+        }
+        int matches = d.result_count;
+        render_widgets();
+        for (int i = 0; i < steps; ++i) {
+            start = now_ms();
+            key(&d, SDLK_BACKSPACE);
+            double ms = now_ms() - start;
+            if (ms > worst_delete) worst_delete = ms;
+        }
+        printf("\"%s\": %d matches; typing %.2f ms per character on average, %.2f ms worst; "
+               "deleting %.2f ms worst\n", queries[q], matches, total_type / steps, worst_type, worst_delete);
+    }
+    xi_CloseDropdown(&d);
+    xi_DestroyDropdown(&d);
+    xiDestroyWindow(&(xi_Window){0});
+    return 0;
+}
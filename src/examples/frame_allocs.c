@@ -0,0 +1,70 @@
+// Checks that a steady UI draws its frames without heap allocations: after a warm-up,
+// every frame must report xi_frame_stats.heap_allocations == 0.
+// Build and run from src/ with: make test
+#include "../xi.h"
+#include <stdio.h>
+
+#define WARMUP_FRAMES 20
+#define FRAMES 300
+
+static const char *cell(void *userdata, int row, int column, char *buffer, int size) {
+    (void)userdata;
+    SDL_snprintf(buffer, size, "%d:%d", row % 50, column);
+    return buffer;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    xi_CountAllocations(true);
+    xiCreateWindow("frame allocations", 1000, 700);
+
+    Slider slider = CreateSlider(10, 10, 200, 40, 0, 100, 50);
+    TextEntry entry = CreateTextEntry(10, 60, 200, 30, 14, COLOR_BLACK, COLOR_WHITE);
+    strcpy(entry.text, "hello world");
+    Label label = CreateLabel(10, 100, 200, 30, "label", COLOR_WHITE, COLOR_BLACK);
+    xi_DataSource source = {cell, NULL, NULL, NULL};
+    xi_Table table = xi_CreateTable(300, 10, 400, 300, 1000000, 20, 12, source);
+    xi_AddTableColumn(&table, "a", 100);
+    xi_AddTableColumn(&table, "b", 0);
+    xi_Plot plot = xi_CreatePlot(10, 350, 900, 200, 1 << 16, COLOR_GREEN, COLOR_BLACK);
+    xi_AddWidget(NULL, &slider);
+    xi_AddWidget(NULL, &entry);
+    xi_AddWidget(NULL, &label);
+    xi_AddWidget(NULL, &table);
+    xi_AddWidget(NULL, &plot);
+
+    static float samples[1000];
+    Uint32 warmup = 0;
+    int failed = 0;
+    for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; ++frame) {
+        // Something changes every frame: new samples, a moving slider, a scrolled table
+        for (int i = 0; i < 1000; ++i) samples[i] = (float)SDL_sin((frame * 1000 + i) * 0.001);
+        xi_PlotAppend(&plot, samples, 1000);
+        slider.value = frame % 3;
+        xi_Invalidate(&slider);
+        xi_ScrollBy(&table, 0, frame % 2 ? 20 : -20);
+        render_widgets();
+
+        Uint32 allocations = xi_frame_stats.heap_allocations;
+        if (frame < WARMUP_FRAMES) {
+            warmup += allocations;
+        } else if (allocations != 0) {
+            printf("frame %d: %u heap allocations\n", frame, allocations);
+            failed++;
+        }
+    }
+    if (warmup == 0) {
+        // The first frames fill the text cache; seeing nothing means nothing was counted
+        printf("no allocations seen while warming up: SDL_SetMemoryFunctions had no effect\n");
+        failed++;
+    }
+    printf("%d steady frames, %d with allocations (warm-up made %u, arena high water %zu bytes)\n",
+           FRAMES, failed, warmup, xi_frame_stats.arena_high_water);
+
+    xi_DestroyTable(&table);
+    xi_DestroyPlot(&plot);
+    xiDestroyWindow(&(xi_Window){0});
+    return failed ? 1 : 0;
+}
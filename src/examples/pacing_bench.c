@@ -0,0 +1,117 @@
+// Drags a slider with a mouse motion event every millisecond and measures how old the
+// newest input on screen is when each frame is shown, without frame pacing and with
+// xi_SetFramePacing(XI_PACE_LATENCY) and (XI_PACE_POWER).
+// The display is emulated so the numbers don't depend on the machine's: a present with
+// vsync on returns at the next 60 Hz vblank, when the frame is counted as shown.
+// Build and run from src/ with: make bench
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+static void display_present(SDL_Renderer *renderer);
+static int display_set_vsync(SDL_Renderer *renderer, int vsync);
+#define SDL_RenderPresent display_present
+#define SDL_RenderSetVSync display_set_vsync
+#include "../xi.h"
+#undef SDL_RenderPresent
+#undef SDL_RenderSetVSync
+
+#define REFRESH_HZ 60
+#define RUN_MS 2000
+#define POSITIONS 1000
+
+static Slider slider;
+static Uint64 pushed[POSITIONS];    // when the motion to each x was pushed
+static SDL_atomic_t dragging;
+static bool vsync;
+static double age_total;
+static int shown;
+
+static Uint64 ticks_ms(Uint64 ticks) {
+    return ticks * 1000 / SDL_GetPerformanceFrequency();
+}
+
+static void display_present(SDL_Renderer *renderer) {
+    SDL_RenderPresent(renderer);
+    if (!vsync) return;
+    Uint64 period = SDL_GetPerformanceFrequency() / REFRESH_HZ;
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 vblank = (now / period + 1) * period;
+    if (vblank - now > SDL_GetPerformanceFrequency() / 500) SDL_Delay((Uint32)ticks_ms(vblank - now) - 1);
+    while (SDL_GetPerformanceCounter() < vblank) {}  // the last bit without oversleeping
+    Uint64 input = pushed[slider.value % POSITIONS];
+    if (renderer == xi_main_context->renderer && SDL_AtomicGet(&dragging) && input && input < vblank) {
+        age_total += (vblank - input) * 1000.0 / SDL_GetPerformanceFrequency();
+        shown++;
+    }
+}
+
+static int display_set_vsync(SDL_Renderer *renderer, int on) {
+    (void)renderer;
+    vsync = on;
+    return 0;
+}
+
+// The mouse: a motion event a millisecond, sweeping the slider
+static int drag(void *userdata) {
+    Uint32 window_id = *(Uint32*)userdata;
+    for (int x = 0; SDL_AtomicGet(&dragging); ++x) {
+        SDL_Event event = {0};
+        event.type = SDL_MOUSEMOTION;
+        event.motion.windowID = window_id;
+        event.motion.x = x % POSITIONS;
+        event.motion.y = 5;
+        pushed[x % POSITIONS] = SDL_GetPerformanceCounter();
+        SDL_PushEvent(&event);
+        SDL_Delay(1);
+    }
+    return 0;
+}
+
+static void stop(void *userdata) {
+    (void)userdata;
+    program_active = false;
+}
+
+static void measure(const char *name, xi_PacingMode mode) {
+    xi_SetFramePacing(mode);
+    if (mode == XI_PACE_OFF) display_set_vsync(NULL, 1);  // the same display, unpaced
+    xi_pacing_stats = (xi_PacingStats){0};
+    SDL_memset(pushed, 0, sizeof(pushed));
+    age_total = 0;
+    shown = 0;
+
+    slider.dragging = true;
+    SDL_AtomicSet(&dragging, 1);
+    SDL_Thread *mouse = SDL_CreateThread(drag, "mouse", &xi_main_context->window_id);
+    program_active = true;
+    xi_AddTimer(RUN_MS, 0, stop, NULL);
+    EventLoop();
+    SDL_AtomicSet(&dragging, 0);
+    SDL_WaitThread(mouse, NULL);
+    slider.dragging = false;
+
+    printf("%-8s %3d frames shown, newest input %.1f ms old on average", name, shown,
+           shown ? age_total / shown : 0.0);
+    if (mode != XI_PACE_OFF) printf(", %d missed vblanks, started %.1f ms before them",
+                                    xi_pacing_stats.missed, xi_pacing_stats.lead_ms);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    xiCreateWindow("pacing bench", 1100, 100);
+    slider = CreateSlider(0, 0, POSITIONS + 10, 10, 0, POSITIONS, 0);
+    xi_AddWidget(NULL, &slider);
+
+    printf("drag input age at an emulated %d Hz display, over %d ms each:\n", REFRESH_HZ, RUN_MS);
+    measure("off", XI_PACE_OFF);
+    measure("latency", XI_PACE_LATENCY);
+    measure("power", XI_PACE_POWER);
+
+    xi_SetFramePacing(XI_PACE_OFF);
+    xiDestroyWindow(&(xi_Window){0});
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Builds one tree of containers, texts, buttons and a plot on the UI thread alone and
+// then with xi_UseParallelBuild on 2 to 16 threads, in a pipelined window, and checks
+// that every build lays the nodes out the same and records the same display list.
+// Build and run from src/ with: make test
+#include "../xi.h"
+#include <stdio.h>
+
+#define BOXES 16
+#define TEXTS 120
+#define BUTTONS (TEXTS / 4)
+#define NODES (BOXES * (1 + TEXTS + BUTTONS))
+
+static xi_Container boxes[BOXES];
+static Text texts[BOXES][TEXTS];
+static Button buttons[BOXES][BUTTONS];
+static xi_Plot plot;
+
+static void snapshot(SDL_Rect *out) {
+    int k = 0;
+    for (int c = 0; c < BOXES; ++c) {
+        out[k++] = boxes[c].node.bounds;
+        for (int i = 0; i < TEXTS; ++i) out[k++] = texts[c][i].node.bounds;
+        for (int i = 0; i < BUTTONS; ++i) out[k++] = buttons[c][i].node.bounds;
+    }
+}
+
+// Lay out the whole tree and record one frame of it into `out`, the way a pipelined
+// window does, keeping a copy of the commands and their data
+static void build(int threads, xi_DisplayList *out, SDL_Rect *bounds) {
+    static xi_DisplayList list;
+    xi_UseParallelBuild(threads);
+    xi_mark_tree_dirty(&xi_root);
+    xi_UpdateLayout();
+    xi_UpdateBounds();
+    snapshot(bounds);
+    list.count = 0;
+    list.data_used = 0;
+    xi_recording = &list;
+    xi_reset_clip();
+    render_widgets();
+    xi_recording = NULL;
+    *out = list;
+    out->cmds = SDL_malloc(list.count * sizeof(xi_DrawCmd) + 1);
+    out->data = SDL_malloc(list.data_used + 1);
+    memcpy(out->cmds, list.cmds, list.count * sizeof(xi_DrawCmd));
+    if (list.data_used) memcpy(out->data, list.data, list.data_used);
+}
+
+static void free_copy(xi_DisplayList *list) {
+    SDL_free(list->cmds);
+    SDL_free(list->data);
+}
+
+static bool same_command(const xi_DrawCmd *a, const xi_DrawCmd *b) {
+    if (a->op != b->op) return false;
+    switch (a->op) {
+    case XI_CMD_RECT:
+    case XI_CMD_CLIP:
+        if (memcmp(&a->u.rect, &b->u.rect, sizeof(SDL_Rect)) != 0) return false;
+        break;
+    case XI_CMD_CIRCLE:
+    case XI_CMD_TRIANGLE:
+        if (memcmp(a->u.points, b->u.points, sizeof(a->u.points)) != 0) return false;
+        break;
+    case XI_CMD_SURFACE:
+        return a->u.surface.surface == b->u.surface.surface &&
+               memcmp(&a->u.surface.dst, &b->u.surface.dst, sizeof(SDL_FRect)) == 0;
+    case XI_CMD_GEOMETRY:
+        return memcmp(&a->u.geometry, &b->u.geometry, sizeof(a->u.geometry)) == 0;
+    case XI_CMD_NO_CLIP:
+        return true;
+    }
+    if (a->op == XI_CMD_CLIP) return true;
+    return a->type == b->type && memcmp(&a->color, &b->color, sizeof(Color)) == 0;
+}
+
+static int compare(const char *what, int threads, const xi_DisplayList *a, const SDL_Rect *a_bounds,
+                   const xi_DisplayList *b, const SDL_Rect *b_bounds) {
+    for (int i = 0; i < NODES; ++i) {
+        if (memcmp(&a_bounds[i], &b_bounds[i], sizeof(SDL_Rect)) != 0) {
+            printf("%s, %d threads: node %d placed differently\n", what, threads, i);
+            return 1;
+        }
+    }
+    if (a->count != b->count || a->data_used != b->data_used) {
+        printf("%s, %d threads: %d commands and %zu data bytes, %d and %zu on one thread\n",
+               what, threads, b->count, b->data_used, a->count, a->data_used);
+        return 1;
+    }
+    if (memcmp(a->data, b->data, a->data_used) != 0) {
+        printf("%s, %d threads: geometry data differs\n", what, threads);
+        return 1;
+    }
+    for (int i = 0; i < a->count; ++i) {
+        if (!same_command(&a->cmds[i], &b->cmds[i])) {
+            printf("%s, %d threads: command %d (op %d) differs\n", what, threads, i, a->cmds[i].op);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Every thread count against one thread, for the current tree and clip
+static int check(const char *what) {
+    static const int counts[] = {2, 4, 8, 16};
+    static SDL_Rect one_bounds[NODES], many_bounds[NODES];
+    xi_DisplayList one, many;
+    int failed = 0;
+    build(1, &one, one_bounds);
+    for (int k = 0; k < (int)SDL_arraysize(counts); ++k) {
+        build(counts[k], &many, many_bounds);
+        failed |= compare(what, counts[k], &one, one_bounds, &many, many_bounds);
+        free_copy(&many);
+    }
+    printf("%s: %d commands, %s\n", what, one.count, failed ? "FAILED" : "same on 2 to 16 threads");
+    free_copy(&one);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    xi_UsePipelinedRendering(2);
+    xiCreateWindow("parallel test", 1920, 1080);
+
+    // A grid of columns, each a top-level subtree the build threads share out
+    static char names[BOXES][TEXTS][16];
+    xi_SetLayout(NULL, XI_LAYOUT_GRID, 4, 4);
+    xi_SetGridColumns(NULL, 8);
+    for (int c = 0; c < BOXES; ++c) {
+        boxes[c] = createContainer(0, 0, 0, 0, (Color){40, 40, (Uint8)(c * 10), 255}, NULL, false);
+        xi_SetLayout(&boxes[c], XI_LAYOUT_COLUMN, 1, 2);
+        xi_AddWidget(NULL, &boxes[c]);
+        for (int i = 0; i < TEXTS; ++i) {
+            SDL_snprintf(names[c][i], 16, "item %d", (c * 7 + i) % 90);
+            texts[c][i] = CreateText(names[c][i], 0, 0, COLOR_BLACK, 8 + i % 5);
+            xi_AddWidget(&boxes[c], &texts[c][i]);
+        }
+        for (int i = 0; i < BUTTONS; ++i) {
+            buttons[c][i] = CreateButton(0, 0, 60, 6, "b", COLOR_BLACK, COLOR_RED, COLOR_GREEN, COLOR_BLUE);
+            xi_AddWidget(&boxes[c], &buttons[c][i]);
+        }
+    }
+    plot = xi_CreatePlot(0, 0, 200, 60, 4096, COLOR_GREEN, COLOR_BLACK);
+    xi_AddWidget(&boxes[3], &plot);
+    static float samples[2000];
+    for (int i = 0; i < 2000; ++i) samples[i] = SDL_sinf(i * 0.05f);
+    xi_PlotAppend(&plot, samples, 2000);
+
+    int failed = check("whole window");
+
+    // A moved button and a text that grew, then a frame drawn under a damage clip
+    xi_SetPosition(&buttons[2][3], 5, 5);
+    texts[5][0].text = "a much longer string now";
+    xi_MarkLayoutDirty(&texts[5][0]);
+    failed |= check("changed tree");
+    xi_clip_limit = (SDL_Rect){100, 100, 700, 300};
+    failed |= check("damage clip");
+    xi_clip_limit = (SDL_Rect){-(1 << 29), -(1 << 29), 1 << 30, 1 << 30};
+
+    xi_UseParallelBuild(1);
+    xi_DestroyPlot(&plot);
+    xiDestroyWindow(&(xi_Window){0});
+    return failed;
+}
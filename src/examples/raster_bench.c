@@ -0,0 +1,70 @@
+// Times full-window redraws of one scene on xi's CPU rasterizer and on SDL's own
+// software renderer, so the two can be compared on the same machine.
+// Build and run from src/ with: make bench
+//   ./raster_bench xi      xi_UseSoftwareRenderer (XI_SIMD=scalar|sse2 picks lower kernels)
+//   ./raster_bench sdl     an SDL renderer with SDL_RENDER_DRIVER=software
+#include "../xi.h"
+#include <stdio.h>
+
+#define WARMUP_FRAMES 20
+#define FRAMES 200
+#define WIDTH 1280
+#define HEIGHT 720
+
+static const char *cell(void *userdata, int row, int column, char *buffer, int size) {
+    (void)userdata;
+    SDL_snprintf(buffer, size, "row %d col %d", row, column);
+    return buffer;
+}
+
+int main(int argc, char **argv) {
+    bool sdl = argc > 1 && strcmp(argv[1], "sdl") == 0;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    if (sdl) SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    else xi_UseSoftwareRenderer(true);
+    xiCreateWindow("raster bench", WIDTH, HEIGHT);
+
+    // A translucent panel of buttons and labels over a table and a plot
+    xi_DataSource source = {cell, NULL, NULL, NULL};
+    xi_Table table = xi_CreateTable(0, 0, WIDTH, HEIGHT / 2, 100000, 22, 14, source);
+    xi_AddTableColumn(&table, "name", 300);
+    xi_AddTableColumn(&table, "value", 0);
+    xi_Plot plot = xi_CreatePlot(0, HEIGHT / 2, WIDTH, HEIGHT / 2, 1 << 14, COLOR_GREEN, COLOR_BLACK);
+    xi_Container panel = createContainer(40, 40, WIDTH - 80, HEIGHT - 80, (Color){20, 20, 60, 160}, NULL, false);
+    xi_SetLayout(&panel, XI_LAYOUT_GRID, 8, 8);
+    xi_SetGridColumns(&panel, 8);
+    static Button buttons[48];
+    static Label labels[48];
+    for (int i = 0; i < 48; ++i) {
+        buttons[i] = CreateButton(0, 0, 140, 36, "button", COLOR_WHITE, (Color){40, 90, 200, 200}, COLOR_BLUE, COLOR_RED);
+        labels[i] = CreateLabel(0, 0, 140, 36, "some label text", COLOR_WHITE, (Color){0, 0, 0, 96});
+        xi_AddWidget(&panel, &buttons[i]);
+        xi_AddWidget(&panel, &labels[i]);
+    }
+    xi_AddWidget(NULL, &table);
+    xi_AddWidget(NULL, &plot);
+    xi_AddWidget(NULL, &panel);
+
+    static float samples[WIDTH];
+    for (int i = 0; i < WIDTH; ++i) samples[i] = (float)SDL_sin(i * 0.02);
+    xi_PlotAppend(&plot, samples, WIDTH);
+
+    double total = 0, best = 1e9;
+    for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; ++frame) {
+        xi_redraw_all();  // every pixel, every frame
+        Uint64 start = SDL_GetPerformanceCounter();
+        xi_render_frame();  // drawing plus the copy or present
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        if (frame < WARMUP_FRAMES) continue;
+        total += ms;
+        if (ms < best) best = ms;
+    }
+    printf("%s%s: %.2f ms per %dx%d frame on average, %.2f ms best, over %d frames\n",
+           sdl ? "SDL software renderer" : "xi rasterizer, ", sdl ? "" : xi_soft.name,
+           total / FRAMES, WIDTH, HEIGHT, best, FRAMES);
+
+    xi_DestroyTable(&table);
+    xi_DestroyPlot(&plot);
+    xiDestroyWindow(&(xi_Window){0});
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Counts the SDL draw calls of a full frame of buttons, entries and sliders drawn flat and
+// with xi_CreateTheme's skins, and times both on SDL's software renderer. A themed frame
+// batches the skins of laid-out widgets, so it must take fewer calls than a flat one.
+// Build and run from src/ with: make bench
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+// Every SDL call that draws something goes through here
+static int draw_calls;
+#define COUNTED(call) (++draw_calls, call)
+#define SDL_RenderClear(...) COUNTED(SDL_RenderClear(__VA_ARGS__))
+#define SDL_RenderCopy(...) COUNTED(SDL_RenderCopy(__VA_ARGS__))
+#define SDL_RenderCopyF(...) COUNTED(SDL_RenderCopyF(__VA_ARGS__))
+#define SDL_RenderDrawLine(...) COUNTED(SDL_RenderDrawLine(__VA_ARGS__))
+#define SDL_RenderDrawPoint(...) COUNTED(SDL_RenderDrawPoint(__VA_ARGS__))
+#define SDL_RenderDrawRect(...) COUNTED(SDL_RenderDrawRect(__VA_ARGS__))
+#define SDL_RenderFillRect(...) COUNTED(SDL_RenderFillRect(__VA_ARGS__))
+#define SDL_RenderGeometry(...) COUNTED(SDL_RenderGeometry(__VA_ARGS__))
+#include "../xi.h"
+
+#define WARMUP_FRAMES 5
+#define FRAMES 200
+
+// Draw calls of one full frame and the average ms per frame
+static int measure(double *ms) {
+    for (int i = 0; i < WARMUP_FRAMES; ++i) {
+        xi_redraw_all();
+        xi_render_frame();  // strings and skins are made on the first frames
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    int calls = 0;
+    for (int i = 0; i < FRAMES; ++i) {
+        draw_calls = 0;
+        xi_redraw_all();
+        xi_render_frame();
+        calls = draw_calls;
+    }
+    *ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() / FRAMES;
+    return calls;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    xiCreateWindow("skin bench", 800, 600);
+
+    // 40 buttons in a grid, 10 entries in a column and 10 loose sliders
+    static Button buttons[40];
+    static TextEntry entries[10];
+    static Slider sliders[10];
+    xi_Container panel = createContainer(10, 10, 500, 580, COLOR_GRAY, "Panel", false);
+    xi_Container side = createContainer(520, 10, 270, 300, COLOR_GRAY, "", false);
+    xi_SetLayout(&panel, XI_LAYOUT_GRID, 20, 10);
+    xi_SetGridColumns(&panel, 4);
+    xi_SetLayout(&side, XI_LAYOUT_COLUMN, 4, 10);
+    xi_AddWidget(NULL, &panel);
+    xi_AddWidget(NULL, &side);
+    for (int i = 0; i < 40; ++i) {
+        buttons[i] = CreateButton(0, 0, 100, 40, "button", COLOR_BLACK, COLOR_RED, COLOR_GREEN, COLOR_BLUE);
+        xi_AddWidget(&panel, &buttons[i]);
+    }
+    for (int i = 0; i < 10; ++i) {
+        entries[i] = CreateTextEntry(0, 0, 200, 24, 16, COLOR_BLACK, COLOR_WHITE);
+        xi_AddWidget(&side, &entries[i]);
+    }
+    for (int i = 0; i < 10; ++i) {
+        sliders[i] = CreateSlider(530, 330 + i * 26, 240, 20, 0, 100, i * 10);
+        xi_AddWidget(NULL, &sliders[i]);
+    }
+
+    xi_Theme *theme = xi_CreateTheme();
+    if (!theme) return 1;
+    double flat_ms, themed_ms;
+    int flat = measure(&flat_ms);
+    xi_UseTheme(theme);
+    int themed = measure(&themed_ms);
+    printf("draw calls per frame: flat %d (%.2f ms), themed %d (%.2f ms)\n",
+           flat, flat_ms, themed, themed_ms);
+
+    xi_UseTheme(NULL);
+    xi_DestroyTheme(theme);
+    xiDestroyWindow(&(xi_Window){0});
+    return themed < flat ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+// Times xi_CompileUI and xi_LoadUI on a generated screen of 20001 widgets: one
+// container holding 2000 rows of nine buttons, labels and texts.
+// Build and run from src/ with: make bench
+#include "../xi.h"
+#include <stdio.h>
+
+#define ROWS 2000
+#define LOADS 5
+
+static double now_ms(void) {
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);  // runs headless unless told otherwise
+    xiCreateWindow("ui load bench", 800, 600);
+
+    FILE *source = fopen("ui_load_bench.xui", "w");
+    if (!source) {
+        printf("can't write ui_load_bench.xui\n");
+        return 1;
+    }
+    fprintf(source, "container title=\"Big\" layout=column grow=1 fill {\n");
+    for (int i = 0; i < ROWS; ++i) {
+        fprintf(source, " group layout=row gap=4 {\n");
+        for (int j = 0; j < 9; ++j) {
+            const char *kind = j % 3 == 0 ? "button" : j % 3 == 1 ? "label" : "text";
+            fprintf(source, "  %s name=w%d_%d text=\"item %d\" size=60x20\n", kind, i, j, j);
+        }
+        fprintf(source, " }\n");
+    }
+    fprintf(source, "}\n");
+    fclose(source);
+
+    double start = now_ms();
+    if (!xi_CompileUI("ui_load_bench.xui", "ui_load_bench.xuib")) return 1;
+    double compiled = now_ms() - start;
+
+    // Best of a few loads; the first one also pages the file in
+    double best = 1e9;
+    xi_UI *ui = NULL;
+    for (int i = 0; i < LOADS; ++i) {
+        if (ui) xi_UnloadUI(ui);
+        start = now_ms();
+        ui = xi_LoadUI("ui_load_bench.xuib", NULL);
+        double loaded = now_ms() - start;
+        if (!ui) return 1;
+        if (loaded < best) best = loaded;
+    }
+    start = now_ms();
+    xi_UpdateLayout();
+    xi_UpdateBounds();
+    double laid_out = now_ms() - start;
+
+    printf("%d widgets: compile %.1f ms, load %.2f ms (best of %d, %s), first layout %.2f ms\n",
+           ui->count, compiled, best, LOADS, ui->mapped ? "mapped" : "read", laid_out);
+    xi_UnloadUI(ui);
+    remove("ui_load_bench.xui");
+    remove("ui_load_bench.xuib");
+    xiDestroyWindow(&(xi_Window){0});
+    return 0;
+}
@@ -5,6 +5,8 @@
 // label
 // slider
 // entry
+// table
+// dropdown
 #include"xi.h"
 const Color COLOR_BACKGROUND   = {30, 30, 30, 255};  // Dark background (VS Code dark)
 const Color COLOR_FOREGROUND   = {220, 220, 220, 255}; // Light gray text
@@ -31,75 +33,76 @@ const Color COLOR_SLIDER_KNOB  = {200, 200, 200, 255}; // Light gray knob
 const Color COLOR_BORDER       = {50, 50, 50, 255};  // General border color
 const Color COLOR_HIGHLIGHT    = {0, 122, 204, 255}; // Highlighted elements (like selection)
 
+// Demo event log: rows are generated on demand, nothing is stored
+#define LOG_ROWS 10000000
+static const char *log_cell(void *userdata, int row, int column, char *buffer, int size) {
+    (void)userdata;
+    if (column == 0) SDL_snprintf(buffer, size, "%02d:%02d:%02d", row / 3600 % 24, row / 60 % 60, row % 60);
+    else SDL_snprintf(buffer, size, "event #%d", row);
+    return buffer;
+}
+
+// Sort on the event number, which is data order; clicking the header again shows it newest first
+static int log_compare(void *userdata, int column, int row_a, int row_b) {
+    (void)userdata;
+    (void)column;
+    return (row_a > row_b) - (row_a < row_b);
+}
+
 
 int main() {
     xi_Window xiWin = xiCreateWindow("xi SDL Window", 1080, 600);
 
-    xi_Container mycontainer = createContainer(500, 100, 500, 400, COLOR_BACKGROUND, "me container",true);
-    xi_Container boxcontainer = createContainer(50, 100, 400, 300, COLOR_BACKGROUND, NULL ,false); // if null is passed for title it becomes a box con
+    // Sizes passed to the constructors are preferred sizes; the layout decides positions
+    xi_Container boxcontainer = createContainer(0, 0, 300, 0, COLOR_BACKGROUND, NULL ,false); // if null is passed for title it becomes a box con
+    xi_Container mycontainer = createContainer(0, 0, 0, 0, COLOR_BACKGROUND, "me container",false);
     // button
-    Button mybutton = CreateButton(10, 10, 70, 30, "click me", COLOR_WHITE, COLOR_GREEN, COLOR_RED, COLOR_BLUE);
+    Button mybutton = CreateButton(0, 0, 100, 40, "click me", COLOR_WHITE, COLOR_GREEN, COLOR_RED, COLOR_BLUE);
     // text
-     Text mytext = CreateText("this is a text",100, 22,COLOR_GREEN,16);
-     Text youtext = CreateText("this is a text",500, 22,COLOR_BLUE,16);
+     Text mytext = CreateText("this is a text",0, 0,COLOR_GREEN,16);
+     Text youtext = CreateText("this is a text",0, 0,COLOR_BLUE,16);
  //   // label
-    Label mylabel = CreateLabel(50, 50, 200, 40, "this is a label", COLOR_WHITE, COLOR_RED); 
+    Label mylabel = CreateLabel(0, 0, 200, 40, "this is a label", COLOR_WHITE, COLOR_RED); 
  //   // slider
-    Slider myslider = CreateSlider(40, 300, 100, 50, 0, 100, 50);
+    Slider myslider = CreateSlider(0, 0, 200, 50, 0, 100, 50);
  // // entry
-  TextEntry myentry = CreateTextEntry(88,33, 500,50,16, COLOR_BLACK, COLOR_WHITE);
+  TextEntry myentry = CreateTextEntry(0, 0, 300, 50,16, COLOR_BLACK, COLOR_WHITE);
+ // // table: ten million rows, only the visible ones get cells
+  xi_DataSource log_source = {log_cell, NULL, log_compare, NULL};
+  xi_Table logtable = xi_CreateTable(0, 0, 280, 200, LOG_ROWS, 20, 14, log_source);
+  xi_AddTableColumn(&logtable, "time", 90);
+  xi_AddTableColumn(&logtable, "event", 0);
+ // // dropdown: type to filter
+  static const char *devices[] = {"pump-01", "pump-02", "valve-north", "valve-south", "sensor-flow", "sensor-pressure"};
+  xi_Dropdown mydropdown = xi_CreateDropdown(0, 0, 300, 32, 16, COLOR_BLACK, COLOR_WHITE);
+  xi_SetDropdownOptions(&mydropdown, devices, sizeof(devices) / sizeof(devices[0]));
+
+   // LAYOUT: side panel + form, both following the window size
+   xi_SetLayout(NULL, XI_LAYOUT_ROW, 20, 20);
+   xi_SetLayout(&boxcontainer, XI_LAYOUT_COLUMN, 10, 10);
+   xi_SetLayout(&mycontainer, XI_LAYOUT_COLUMN, 10, 10);
+
+   // TREE (children are positioned relative to their container)
+   xi_AddWidget(NULL, &boxcontainer);
+   xi_AddWidget(NULL, &mycontainer);
+   xi_AddWidget(&boxcontainer, &youtext);
+   xi_AddWidget(&boxcontainer, &logtable);
+   xi_AddWidget(&mycontainer, &mybutton);
+   xi_AddWidget(&mycontainer, &mytext);
+   xi_AddWidget(&mycontainer, &mylabel);
+   xi_AddWidget(&mycontainer, &myslider);
+   xi_AddWidget(&mycontainer, &myentry);
+   xi_AddWidget(&mycontainer, &mydropdown);
 
+   xi_SetFlex(&boxcontainer, 0, true);   // full height, fixed width
+   xi_SetFlex(&mycontainer, 1, true);    // takes the remaining width
+   xi_SetFlex(&myentry, 0, true);        // entry spans the form
+   xi_SetFlex(&logtable, 1, true);       // log fills the side panel
 
-   // PARENT 
-   mybutton.parent=&mycontainer;
-   mytext.parent=&mycontainer;
-   mylabel.parent=&mycontainer;
-   myslider.parent=&mycontainer;
-   myentry.parent=&mycontainer;
-  //  EventLoop();
+    EventLoop();
 
-    while (program_active) {
-      SDL_Event event;
-      while (SDL_PollEvent(&event)) {
-          switch (event.type) {
-              case SDL_QUIT:
-                 program_active = false;  // User closed the window
-                  break;
-              
-                  break;
-              case SDL_WINDOWEVENT:
-                  if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
-                      // Resize event triggers window size update
-                  }
-                  break;
-              default:
-                  break;
-          }
-          //buttons
-        //  sw_render_all_button_states(&event);
-          //drop down
-        //  sw_render_all_drop_down_states(&event);
-   //slider
-   //sw_render_all_slider_states(&event);
-         //entry
-     //   sw_render_all_entry_states(&event);
-       // Handle container movement
-       handleContainerMovement(&mycontainer, &event);
-       handleContainerMovement(&boxcontainer, &event);
-     
-      }
-       //clear_screen(xiWindow.background_color);
-       xi_ClearScreen(grenderer, COLOR_GRAY);
-       render_container(&mycontainer);
-       render_container(&boxcontainer);
-       render_button(&mybutton);
-       render_text(&mytext);
-       render_text(&youtext);
-       render_label(&mylabel);
-       render_slider(&myslider);
-      render_text_entry(&myentry);
-      SDL_RenderPresent(grenderer);       // Present the rendered output
-  }
+    xi_DestroyDropdown(&mydropdown);
+    xi_DestroyTable(&logtable);
     xiDestroyWindow(&xiWin);
     return 0;
 }
@@ -2,6 +2,21 @@
 #include <SDL2/SDL.h> /// SDL2
 #include <SDL2/SDL_ttf.h> ///SDL TTF
 #include <stdbool.h> /// STDBOOL
+#include <string.h> /// STRING
+#include <stdarg.h> /// STDARG (xi_FrameFormat)
+#include <stdio.h> /// STDIO (rename, remove: xi_CompileUI)
+#include <errno.h> /// ERRNO
+#ifdef XI_USE_SDL_IMAGE
+#include <SDL2/SDL_image.h> /// SDL IMAGE (optional: PNG, JPEG, ... for xi_Image)
+#endif
+#ifdef _WIN32
+#include <windows.h> /// FILE MAPPING (log viewer)
+#else
+#include <fcntl.h> /// FILE MAPPING (log viewer)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 static const char *xi_fontpath = "FreeMono.ttf";
 /// ============================ COLOR STRUCT ============================
@@ -14,8 +29,16 @@ typedef struct {
     Color background_color;
 } xi_Window;
 
-SDL_Window *gwindow;
-SDL_Renderer *grenderer;
+// Custom SDL event used to wake EventLoop from idle when work is posted from another thread
+Uint32 xi_wake_event = (Uint32)-1;
+#if defined(_MSC_VER)
+#define XI_THREAD_LOCAL __declspec(thread)
+#else
+#define XI_THREAD_LOCAL _Thread_local
+#endif
+// Subtracted from every xi_Draw* coordinate; lets widgets draw into offscreen textures.
+// One per thread: subtrees may be drawn on several at once (xi_UseParallelBuild).
+XI_THREAD_LOCAL int xi_origin_x = 0, xi_origin_y = 0;
 
 
 /// ============================ ENUMS ============================
@@ -39,683 +62,10383 @@ typedef enum {
     WIDGET_TEXT,
     WIDGET_SLIDER,
     WIDGET_CONTAINER,
-    WIDGET_ENTRY
+    WIDGET_ENTRY,
+    WIDGET_TABLE,
+    WIDGET_TABLE_CELL,
+    WIDGET_PLOT,
+    WIDGET_DROPDOWN,
+    WIDGET_IMAGE,
+    WIDGET_GROUP,  // invisible, only arranges its children
+    WIDGET_TABS,
+    WIDGET_ROOT
 } WidgetType;
 
+/*
+ Every widget struct starts with an xi_Node, so a pointer to the widget is also a
+ pointer to its node. Nodes form a tree of any depth: x/y are relative to the parent
+ and bounds caches the absolute rectangle used for both drawing and hit-testing.
+
+ Create* returns widgets by value, so they are added to the tree once they sit at
+ their final address:
+
+    xi_Container panel = createContainer(...);
+    Button ok = CreateButton(...);
+    xi_AddWidget(NULL, &panel);   // NULL = top level
+    xi_AddWidget(&panel, &ok);
+*/
+typedef enum {
+    XI_LAYOUT_NONE,     // children keep the x/y they were given
+    XI_LAYOUT_ROW,      // children side by side, left to right
+    XI_LAYOUT_COLUMN,   // children stacked top to bottom
+    XI_LAYOUT_GRID      // children fill a fixed number of columns, row by row
+} xi_LayoutKind;
+
 typedef struct {
+    xi_LayoutKind kind;            // how this node arranges its children
+    int gap, padding, columns;
+    int inset_top;                 // space kept free for chrome such as a title bar
+    int grow;                      // share of spare main-axis space inside a ROW/COLUMN
+    bool fill;                     // stretch across the parent's cross axis
+    int base_width, base_height;   // size asked for at creation or through xi_SetSize()
+    int measured_width, measured_height;
+    SDL_Rect slot;                 // rectangle the parent handed down last time
+    bool measure_dirty;            // own or descendant content changed
+    bool arrange_dirty;            // children must be placed again
+} xi_LayoutInfo;
+
+typedef struct xi_Node {
     WidgetType type;
-    void* widget;  // Pointer to the actual widget (Button, Label, or Text)
-} Widget;
+    int x, y, width, height;    // relative to the parent
+    SDL_Rect bounds;            // absolute, refreshed by xi_UpdateBounds()
+    struct xi_Node *parent;
+    struct xi_Node *first_child, *last_child;
+    struct xi_Node *prev_sibling, *next_sibling;
+    bool bounds_dirty;          // this node moved or was resized
+    bool child_bounds_dirty;    // some descendant needs its bounds refreshed
+    bool scroll_moved;          // scrolled, so its children need their bounds refreshed
+    xi_LayoutInfo layout;
+    SDL_Rect clip;              // absolute area this node may draw into, from its ancestors
+    bool clips_children;        // children can't draw outside this node's content area
+    bool scrollable;            // content can be scrolled with the mouse wheel
+    int scroll_x, scroll_y;     // how far the content is scrolled
+    int content_width, content_height;  // extent of the children, for scroll limits
+    struct xi_Node *first_visible;      // culling hint: first child seen in view last frame
+    struct xi_ScrollState *scroll;      // kinetic scrolling and backing store, if scrollable
+    struct xi_Binding *binding;         // model value this widget shows, see xi_Bind
+} xi_Node;
+
+/// ============================ WINDOW CONTEXTS ============================
+/*
+ Every window has its own context: SDL window and renderer, widget tree and the state
+ of its next frame. The names the rest of the library (and applications) use, such as
+ gwindow, grenderer, xi_root and xi_redraw, refer to the current context, which
+ xi_MakeCurrent() switches. xiCreateWindow() sets up the main context; more windows
+ come from xi_CreateContext():
 
-#define MAX_WIDGETS 100
-Widget widgets[MAX_WIDGETS];
-int widget_count = 0;
+    xi_Context *second = xi_CreateContext("Trends", 800, 600);
+    xi_MakeCurrent(second);
+    xi_AddWidget(NULL, &plot);          // goes into the second window
+    xi_MakeCurrent(xi_main_context);
 
+ EventLoop routes each event to the window it belongs to and draws every window that
+ has something to show. Fonts and rasterized strings are shared by all windows; only
+ the textures made from them are per renderer.
 
-void register_widget(WidgetType type, void* widget) {
-// this function is called internally when a new widgets is created
-/*
-When users call button(), label(), or text(), these will register their widgets internally:
+ Coordinates and font sizes are logical units, the same as SDL's window and mouse
+ coordinates. On a HiDPI display one unit is several pixels (the context's scale):
+ shapes are scaled by the renderer, while text is rasterized at the physical pixel
+ size so it stays sharp.
+*/
+#define XI_MAX_WINDOWS 8
+
+typedef struct xi_Context {
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    Uint32 window_id;
+    int slot;                   // index in xi_contexts, and in per-window cache arrays
+    float scale;                // physical pixels per logical unit (2 on most HiDPI panels)
+    xi_Node root;
+    // Popups (e.g. a dropdown's list) live here: drawn above root, placed in window
+    // coordinates and never moved by a layout
+    xi_Node overlay;
+    // Set when the whole window must be drawn again (layout, moves, window events)
+    bool redraw;
+    // Window area changed through xi_Invalidate() since the last frame; a frame with no
+    // redraw only redraws this part
+    SDL_Rect damage;
+    bool damaged;
+    // Copy of the window kept between frames, so a partial frame has something to draw on
+    SDL_Texture *screen;
+    bool screen_unsupported;
+    bool software;              // drawn on the CPU into canvas; renderer is NULL
+    SDL_Surface *canvas;
+    struct xi_RenderWindow *pipe;  // drawn by the render thread; renderer is NULL
+    struct xi_Capture *capture;    // frames being recorded, see xi_StartCapture
+    int screen_width, screen_height;
+    struct xi_Node *input_capture;  // widget getting all input of this window, e.g. an open popup
+} xi_Context;
 
-Button button(parameters) {
-    Button new_button = create_button(text, x, y, font_size, fg, bg, style);
-    register_widget(WIDGET_BUTTON, &new_button); <<<<<< registering
-    return new_button;
+static xi_Context xi_main_window = {
+    .slot = 0,
+    .scale = 1.0f,
+    .root = {.type = WIDGET_ROOT, .clips_children = true},
+    .overlay = {.type = WIDGET_ROOT, .clips_children = true},
+    .redraw = true,
+};
+xi_Context *const xi_main_context = &xi_main_window;
+xi_Context *xi_current = &xi_main_window;
+static xi_Context *xi_contexts[XI_MAX_WINDOWS] = {&xi_main_window};
+static int xi_context_count = 1;
+
+#define gwindow (xi_current->window)
+#define grenderer (xi_current->renderer)
+#define xi_root (xi_current->root)
+#define xi_overlay (xi_current->overlay)
+#define xi_redraw (xi_current->redraw)
+#define xi_damage (xi_current->damage)
+#define xi_damaged (xi_current->damaged)
+#define xi_screen (xi_current->screen)
+#define xi_input_capture (xi_current->input_capture)
+
+// Widgets created, drawn and given events from now on belong to this window
+void xi_MakeCurrent(xi_Context *context) {
+    if (context) xi_current = context;
 }
 
-*/
-    if (widget_count < MAX_WIDGETS) {
-        widgets[widget_count].type = type;
-        widgets[widget_count].widget = widget;
-        widget_count++;
+// Window a widget is shown in: the context whose tree it hangs from (the current
+// one while it isn't in any tree)
+static xi_Context *xi_context_of(xi_Node *node) {
+    if (xi_context_count == 1) return xi_current;
+    while (node->parent) node = node->parent;
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        xi_Context *c = xi_contexts[i];
+        if (c && (node == &c->root || node == &c->overlay)) return c;
     }
+    return xi_current;
 }
 
-/// ============================ DRAW FUNCTIONS ============================
-static void xi_DrawRect(SDL_Renderer *renderer, int x, int y, int width, int height, Color color, ShapeType type) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_Rect rect = {x, y, width, height};
-    if (type == FILLED) {
-        SDL_RenderFillRect(renderer, &rect);
+// Something that may be shown anywhere changed
+static void xi_redraw_all(void) {
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        if (xi_contexts[i]) xi_contexts[i]->redraw = true;
+    }
+}
+
+static xi_Node xi_make_node(WidgetType type, int x, int y, int width, int height) {
+    xi_Node node = {type, x, y, width, height};
+    node.bounds_dirty = true;
+    node.layout.base_width = width;
+    node.layout.base_height = height;
+    node.layout.measure_dirty = true;
+    node.layout.arrange_dirty = true;
+    return node;
+}
+
+static void xi_invalidate_scroll_caches(xi_Node *node);
+static void xi_stop_kinetic(xi_Node *node);
+static void xi_write_back(xi_Node *node);
+static void xi_mark_tree_dirty(xi_Node *node);
+// Cut every tie to a subtree leaving the tree; defined after the widget types it knows
+static void xi_forget_widget(xi_Node *node);
+static XI_THREAD_LOCAL bool *xi_task_redraw;  // set while a build task runs on this thread
+
+// Flag a node so the next xi_UpdateBounds() refreshes it and everything below it
+static void xi_mark_bounds_dirty(xi_Node *node) {
+    node->bounds_dirty = true;
+    for (xi_Node *p = node->parent; p && !p->child_bounds_dirty; p = p->parent) {
+        p->child_bounds_dirty = true;
+    }
+    xi_invalidate_scroll_caches(node->parent);
+    // What it was drawn over must be repainted too. Build tasks flag their own copy,
+    // merged into the window's once the subtrees are laid out.
+    if (xi_task_redraw) *xi_task_redraw = true;
+    else xi_context_of(node)->redraw = true;
+}
+
+static SDL_Rect xi_intersect_rect(SDL_Rect a, SDL_Rect b);
+
+// Call after changing how a widget looks without moving it (text, colors, state).
+// Only the widget's visible area is redrawn.
+void xi_Invalidate(void *widget) {
+    xi_Node *node = (xi_Node*)widget;
+    xi_invalidate_scroll_caches(node->parent);
+    SDL_Rect area = xi_intersect_rect(node->bounds, node->clip);
+    if (area.w <= 0 || area.h <= 0) return;
+    xi_Context *context = xi_context_of(node);
+    if (context->damaged) SDL_UnionRect(&context->damage, &area, &context->damage);
+    else context->damage = area;
+    context->damaged = true;
+}
+
+// Flag a node whose content or size request changed. Ancestors are re-measured because
+// their size may depend on it; the walk stops at the first ancestor already flagged.
+void xi_MarkLayoutDirty(void *widget) {
+    xi_Node *node = (xi_Node*)widget;
+    node->layout.measure_dirty = true;
+    node->layout.arrange_dirty = true;
+    for (xi_Node *p = node->parent; p && !(p->layout.measure_dirty && p->layout.arrange_dirty); p = p->parent) {
+        p->layout.measure_dirty = true;
+        p->layout.arrange_dirty = true;
+    }
+}
+
+void xi_AddWidget(void *parent, void *widget) {
+    xi_Node *p = parent ? (xi_Node*)parent : &xi_root;
+    xi_Node *node = (xi_Node*)widget;
+
+    node->parent = p;
+    node->next_sibling = NULL;
+    node->prev_sibling = p->last_child;
+    if (p->last_child) {
+        p->last_child->next_sibling = node;
     } else {
-        SDL_RenderDrawRect(renderer, &rect);
+        p->first_child = node;
     }
+    p->last_child = node;
+    xi_mark_bounds_dirty(node);
+    xi_MarkLayoutDirty(node);
 }
 
-void xi_DrawText(SDL_Renderer *renderer, const char *text, int x, int y, Color color, int fontSize) {
-    if (!renderer) {
-        SDL_Log("Renderer is NULL");
-        return;
+// Unlink a node from its parent, e.g. to move it; it keeps its animations and bindings
+static void xi_detach_widget(xi_Node *node) {
+    xi_Node *p = node->parent;
+    if (!p) return;
+
+    xi_MarkLayoutDirty(p);
+    if (node->prev_sibling) node->prev_sibling->next_sibling = node->next_sibling;
+    else p->first_child = node->next_sibling;
+    if (node->next_sibling) node->next_sibling->prev_sibling = node->prev_sibling;
+    else p->last_child = node->prev_sibling;
+    if (p->first_visible == node) p->first_visible = NULL;
+    if (node->scroll) xi_stop_kinetic(node);
+    xi_invalidate_scroll_caches(p);
+    xi_context_of(p)->redraw = true;  // uncover what was behind it
+    node->parent = node->prev_sibling = node->next_sibling = NULL;
+}
+
+// Take a widget and everything below it out of the tree. Their animations, timers,
+// kinetic scrolling and bindings stop, so the memory may be freed right after; bind
+// again after adding them back.
+void xi_RemoveWidget(void *widget) {
+    xi_Node *node = (xi_Node*)widget;
+    if (!node->parent) return;
+    xi_detach_widget(node);
+    xi_forget_widget(node);
+}
+
+static void xi_set_geometry(xi_Node *node, int x, int y, int width, int height) {
+    if (node->x == x && node->y == y && node->width == width && node->height == height) return;
+    node->x = x;
+    node->y = y;
+    node->width = width;
+    node->height = height;
+    xi_mark_bounds_dirty(node);
+}
+
+// Move a widget relative to its parent; its whole subtree follows on the next refresh.
+// Inside a ROW/COLUMN/GRID parent the layout decides the position instead.
+void xi_SetPosition(void *widget, int x, int y) {
+    xi_Node *node = (xi_Node*)widget;
+    xi_set_geometry(node, x, y, node->width, node->height);
+}
+
+// Change the size a widget asks for; applied by the next xi_UpdateLayout()
+void xi_SetSize(void *widget, int width, int height) {
+    xi_Node *node = (xi_Node*)widget;
+    if (node->layout.base_width == width && node->layout.base_height == height) return;
+    node->layout.base_width = width;
+    node->layout.base_height = height;
+    xi_MarkLayoutDirty(node);
+}
+
+static SDL_Rect xi_intersect_rect(SDL_Rect a, SDL_Rect b) {
+    int x1 = a.x > b.x ? a.x : b.x;
+    int y1 = a.y > b.y ? a.y : b.y;
+    int x2 = a.x + a.w < b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y2 = a.y + a.h < b.y + b.h ? a.y + a.h : b.y + b.h;
+    SDL_Rect r = {x1, y1, x2 > x1 ? x2 - x1 : 0, y2 > y1 ? y2 - y1 : 0};
+    return r;
+}
+
+static bool xi_rects_overlap(const SDL_Rect *a, const SDL_Rect *b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+// Area the children of node may draw into
+static SDL_Rect xi_child_clip(const xi_Node *node) {
+    if (!node->clips_children) return node->clip;
+    SDL_Rect content = node->bounds;
+    content.y += node->layout.inset_top;
+    content.h -= node->layout.inset_top;
+    return xi_intersect_rect(node->clip, content);
+}
+
+// Scrolling a row or column only refreshes the children in view; defined with scrolling
+static bool xi_place_scrolled(xi_Node *node, bool in_view_only);
+
+static void xi_update_bounds(xi_Node *node, bool parent_moved) {
+    if (parent_moved || node->bounds_dirty) {
+        xi_Node *parent = node->parent;
+        if (parent) {
+            node->bounds.x = parent->bounds.x - parent->scroll_x + node->x;
+            node->bounds.y = parent->bounds.y - parent->scroll_y + node->y;
+            node->clip = xi_child_clip(parent);
+        } else {
+            node->bounds.x = node->x;
+            node->bounds.y = node->y;
+            node->clip = (SDL_Rect){node->x, node->y, node->width, node->height};
+        }
+        node->bounds.w = node->width;
+        node->bounds.h = node->height;
+        parent_moved = true;
+    } else if (!node->child_bounds_dirty && !node->scroll_moved) {
+        return;  // nothing changed in this subtree
     }
+    bool scrolled = node->scroll_moved;
+    bool in_view_only = scrolled && !parent_moved && !node->child_bounds_dirty;
+    node->bounds_dirty = false;
+    node->child_bounds_dirty = false;
+    node->scroll_moved = false;
+    if (node->scroll && (parent_moved || scrolled) && xi_place_scrolled(node, in_view_only)) return;
 
-    if (!xi_fontpath || xi_fontpath[0] == '\0') {
-        SDL_Log("Font path is not set");
-        return;
+    parent_moved = parent_moved || scrolled;
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        xi_update_bounds(child, parent_moved);
+    }
+}
+
+// An open dropdown's popup follows the field; defined with the dropdown
+static void xi_place_popup(xi_Node *owner);
+
+// Refresh cached absolute bounds. Only subtrees that moved are visited, each node once.
+void xi_UpdateBounds(void) {
+    xi_update_bounds(&xi_root, false);
+    if (xi_input_capture) xi_place_popup(xi_input_capture);
+    xi_update_bounds(&xi_overlay, false);
+}
+
+// Hit test against the cached bounds; parts clipped away by a container don't count
+static bool xi_point_in_bounds(const xi_Node *node, int x, int y) {
+    return x >= node->bounds.x && x <= node->bounds.x + node->bounds.w &&
+           y >= node->bounds.y && y <= node->bounds.y + node->bounds.h &&
+           x >= node->clip.x && x < node->clip.x + node->clip.w &&
+           y >= node->clip.y && y < node->clip.y + node->clip.h;
+}
+
+/// ============================ LAYOUT ============================
+/*
+ Containers (or xi_root) can arrange their children in a row, a column or a grid:
+
+    xi_SetLayout(&form, XI_LAYOUT_COLUMN, 8, 10);   // gap 8, padding 10
+    xi_SetFlex(&notes, 1, true);                    // takes the spare height, full width
+
+ Layout runs in two passes, both memoized per node. Measure works bottom-up and is
+ only redone where xi_MarkLayoutDirty() flagged content changes. Arrange works
+ top-down and skips any subtree whose slot didn't change and that isn't flagged, so
+ a window resize only re-places what actually moves.
+*/
+
+// Measures widget content (e.g. text); defined with the widgets further down
+static bool xi_measure_widget(xi_Node *node, int *width, int *height);
+// Tables place their own recycled cells; defined with the widgets
+static void xi_arrange_table(xi_Node *node);
+
+void xi_SetLayout(void *widget, xi_LayoutKind kind, int gap, int padding) {
+    xi_Node *node = widget ? (xi_Node*)widget : &xi_root;
+    node->layout.kind = kind;
+    node->layout.gap = gap;
+    node->layout.padding = padding;
+    if (kind == XI_LAYOUT_GRID && node->layout.columns < 1) node->layout.columns = 1;
+    xi_MarkLayoutDirty(node);
+}
+
+void xi_SetGridColumns(void *widget, int columns) {
+    xi_Node *node = widget ? (xi_Node*)widget : &xi_root;
+    node->layout.columns = columns < 1 ? 1 : columns;
+    xi_MarkLayoutDirty(node);
+}
+
+// grow: weight for spare space along a ROW/COLUMN parent; fill: stretch across it
+void xi_SetFlex(void *widget, int grow, bool fill) {
+    xi_Node *node = (xi_Node*)widget;
+    node->layout.grow = grow;
+    node->layout.fill = fill;
+    if (node->parent) xi_MarkLayoutDirty(node->parent);
+}
+
+static void xi_measure(xi_Node *node) {
+    xi_LayoutInfo *l = &node->layout;
+    if (!l->measure_dirty) return;
+
+    int width = 0, height = 0, count = 0;
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        xi_measure(child);
+        count++;
     }
 
-    if (fontSize <= 0) {
-        SDL_Log("Invalid font size: %d", fontSize);
-        return;
+    if (l->kind == XI_LAYOUT_NONE || count == 0) {
+        width = l->base_width;
+        height = l->base_height;
+        int content_width, content_height;
+        if (xi_measure_widget(node, &content_width, &content_height)) {
+            if (width <= 0) width = content_width;
+            if (height <= 0) height = content_height;
+        }
+    } else if (l->kind == XI_LAYOUT_ROW || l->kind == XI_LAYOUT_COLUMN) {
+        bool row = l->kind == XI_LAYOUT_ROW;
+        int main_size = l->gap * (count - 1), cross_size = 0;
+        for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+            int cm = row ? child->layout.measured_width : child->layout.measured_height;
+            int cc = row ? child->layout.measured_height : child->layout.measured_width;
+            main_size += cm;
+            if (cc > cross_size) cross_size = cc;
+        }
+        width = 2 * l->padding + (row ? main_size : cross_size);
+        height = 2 * l->padding + l->inset_top + (row ? cross_size : main_size);
+    } else {
+        int columns = l->columns;
+        int cell_width = 0, rows_height = 0, row_height = 0, i = 0;
+        for (xi_Node *child = node->first_child; child; child = child->next_sibling, ++i) {
+            if (child->layout.measured_width > cell_width) cell_width = child->layout.measured_width;
+            if (child->layout.measured_height > row_height) row_height = child->layout.measured_height;
+            if (i % columns == columns - 1 || !child->next_sibling) {
+                rows_height += row_height;
+                row_height = 0;
+            }
+        }
+        int rows = (count + columns - 1) / columns;
+        int used_columns = count < columns ? count : columns;
+        width = 2 * l->padding + used_columns * cell_width + (used_columns - 1) * l->gap;
+        height = 2 * l->padding + l->inset_top + rows_height + (rows - 1) * l->gap;
     }
 
-    if (!text) {
-        SDL_Log("Text is NULL");
-        return;
+    // An explicit size is a minimum for containers that arrange their children.
+    // Scroll areas only ask for their own size; the content scrolls inside it.
+    if (width < l->base_width || node->scrollable) width = l->base_width;
+    if (height < l->base_height || node->scrollable) height = l->base_height;
+    l->measured_width = width;
+    l->measured_height = height;
+    l->measure_dirty = false;
+}
+
+static void xi_arrange(xi_Node *node, SDL_Rect slot);
+static void xi_clamp_scroll(xi_Node *node);
+// Parallel layout of the root's subtrees; defined with the build threads
+static bool xi_parallel_layout(xi_Node *root, SDL_Rect window);
+static bool xi_defer_arrange(xi_Node *node, SDL_Rect slot);
+
+static void xi_arrange_flex(xi_Node *node, bool row) {
+    xi_LayoutInfo *l = &node->layout;
+    int inner_x = l->padding;
+    int inner_y = l->padding + l->inset_top;
+    int inner_main = (row ? node->width : node->height - l->inset_top) - 2 * l->padding;
+    int inner_cross = (row ? node->height - l->inset_top : node->width) - 2 * l->padding;
+
+    int used = 0, total_grow = 0, count = 0;
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        used += row ? child->layout.measured_width : child->layout.measured_height;
+        total_grow += child->layout.grow;
+        count++;
     }
+    used += l->gap * (count - 1);
+    int spare = inner_main - used;
+    if (spare < 0) spare = 0;
 
-    TTF_Font *font = TTF_OpenFont(xi_fontpath, fontSize);
-    if (!font) {
-        SDL_Log("Failed to load font '%s': %s", xi_fontpath, TTF_GetError());
-        return;
+    // Hand out spare space by cumulative weight so rounding never leaves a gap at the end
+    int cursor = row ? inner_x : inner_y;
+    int grow_so_far = 0, given = 0;
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        int extra = 0;
+        if (total_grow > 0 && child->layout.grow > 0) {
+            grow_so_far += child->layout.grow;
+            int target = (int)((long long)spare * grow_so_far / total_grow);
+            extra = target - given;
+            given = target;
+        }
+        int main_size = (row ? child->layout.measured_width : child->layout.measured_height) + extra;
+        int cross_size = child->layout.fill ? inner_cross
+                                            : (row ? child->layout.measured_height : child->layout.measured_width);
+        SDL_Rect slot = row ? (SDL_Rect){cursor, inner_y, main_size, cross_size}
+                            : (SDL_Rect){inner_x, cursor, cross_size, main_size};
+        xi_arrange(child, slot);
+        cursor += main_size + l->gap;
     }
+}
 
-    SDL_Color sdlColor = {color.r, color.g, color.b, color.a};
-    SDL_Surface *textSurface = TTF_RenderText_Blended(font, text, sdlColor);
-    if (!textSurface) {
-        SDL_Log("Failed to create text surface: %s", TTF_GetError());
-        TTF_CloseFont(font);
-        return;
+static void xi_arrange_grid(xi_Node *node) {
+    xi_LayoutInfo *l = &node->layout;
+    int columns = l->columns;
+    int inner_width = node->width - 2 * l->padding;
+    int cell_width = (inner_width - (columns - 1) * l->gap) / columns;
+    if (cell_width < 0) cell_width = 0;
+
+    int y = l->padding + l->inset_top;
+    xi_Node *row_start = node->first_child;
+    while (row_start) {
+        int row_height = 0, i = 0;
+        xi_Node *child = row_start;
+        for (; child && i < columns; child = child->next_sibling, ++i) {
+            if (child->layout.measured_height > row_height) row_height = child->layout.measured_height;
+        }
+        i = 0;
+        for (child = row_start; child && i < columns; child = child->next_sibling, ++i) {
+            int height = child->layout.fill ? row_height : child->layout.measured_height;
+            SDL_Rect slot = {l->padding + i * (cell_width + l->gap), y, cell_width, height};
+            xi_arrange(child, slot);
+        }
+        row_start = child;
+        y += row_height + l->gap;
     }
+}
 
-    SDL_Texture *textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    if (!textTexture) {
-        SDL_Log("Failed to create text texture: %s", SDL_GetError());
-        SDL_FreeSurface(textSurface);
-        TTF_CloseFont(font);
+static void xi_arrange(xi_Node *node, SDL_Rect slot) {
+    xi_LayoutInfo *l = &node->layout;
+    if (!l->arrange_dirty && slot.x == l->slot.x && slot.y == l->slot.y &&
+        slot.w == l->slot.w && slot.h == l->slot.h) {
+        return;  // same place, same content: the whole subtree is still valid
+    }
+    if (xi_defer_arrange(node, slot)) return;
+    l->slot = slot;
+    l->arrange_dirty = false;
+    xi_set_geometry(node, slot.x, slot.y, slot.w, slot.h);
+    if (node->type == WIDGET_TABLE) {
+        xi_arrange_table(node);
         return;
     }
 
-    SDL_Rect destRect = {x, y, textSurface->w, textSurface->h};
-    if (SDL_RenderCopy(renderer, textTexture, NULL, &destRect) != 0) {
-        SDL_Log("Failed to render text: %s", SDL_GetError());
+    switch (l->kind) {
+        case XI_LAYOUT_ROW:
+            xi_arrange_flex(node, true);
+            break;
+        case XI_LAYOUT_COLUMN:
+            xi_arrange_flex(node, false);
+            break;
+        case XI_LAYOUT_GRID:
+            xi_arrange_grid(node);
+            break;
+        default:
+            for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+                SDL_Rect child_slot = {child->x, child->y, child->layout.measured_width, child->layout.measured_height};
+                xi_arrange(child, child_slot);
+            }
+            break;
     }
 
-    SDL_FreeSurface(textSurface);
-    SDL_DestroyTexture(textTexture);
-    TTF_CloseFont(font);
+    if (node->scrollable) {
+        int right = 0, bottom = 0;
+        for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+            if (child->x + child->width > right) right = child->x + child->width;
+            if (child->y + child->height > bottom) bottom = child->y + child->height;
+        }
+        node->content_width = right + l->padding;
+        node->content_height = bottom + l->padding;
+        xi_clamp_scroll(node);
+    }
 }
 
+// Re-run measure and arrange where something changed. Cheap when nothing did.
+void xi_UpdateLayout(void) {
+    SDL_Rect window = {0, 0, xi_root.layout.base_width, xi_root.layout.base_height};
+    if ((xi_root.layout.measure_dirty || xi_root.layout.arrange_dirty) && !xi_parallel_layout(&xi_root, window)) {
+        xi_measure(&xi_root);
+        xi_arrange(&xi_root, window);
+    }
+    if (xi_overlay.layout.measure_dirty || xi_overlay.layout.arrange_dirty) {
+        xi_measure(&xi_overlay);
+        xi_arrange(&xi_overlay, window);
+    }
+}
 
-static void xi_DrawCircle(SDL_Renderer *renderer, int x, int y, int radius, Color color, ShapeType type) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    int offsetX = 0, offsetY = radius;
-    int d = 1 - radius;
+/// ============================ CLIPPING AND SCROLLING ============================
+/*
+ Containers clip their children to their content area. Anything whose bounds fall
+ outside the visible clip is culled before its render function runs, so no draw or
+ text work is spent on it. A scrollable container offsets its children by its scroll
+ position; for ROW/COLUMN/GRID content the render pass also stops at the first child
+ past the visible end and starts near the first visible child, so a long form costs
+ about as much as its visible part.
+*/
 
-    while (offsetX <= offsetY) {
-        if (type == FILLED) {
-            SDL_RenderDrawLine(renderer, x - offsetX, y + offsetY, x + offsetX, y + offsetY);
-            SDL_RenderDrawLine(renderer, x - offsetX, y - offsetY, x + offsetX, y - offsetY);
-            SDL_RenderDrawLine(renderer, x - offsetY, y + offsetX, x + offsetY, y + offsetX);
-            SDL_RenderDrawLine(renderer, x - offsetY, y - offsetX, x + offsetY, y - offsetX);
-        } else {
-            SDL_RenderDrawPoint(renderer, x + offsetX, y + offsetY);
-            SDL_RenderDrawPoint(renderer, x + offsetX, y - offsetY);
-            SDL_RenderDrawPoint(renderer, x - offsetX, y + offsetY);
-            SDL_RenderDrawPoint(renderer, x - offsetX, y - offsetY);
-            SDL_RenderDrawPoint(renderer, x + offsetY, y + offsetX);
-            SDL_RenderDrawPoint(renderer, x + offsetY, y - offsetX);
-            SDL_RenderDrawPoint(renderer, x - offsetY, y + offsetX);
-            SDL_RenderDrawPoint(renderer, x - offsetY, y - offsetX);
-        }
+#define XI_SCROLL_STEP 40       // pixels per mouse wheel notch
+#define XI_SCROLL_FRICTION 6.0f // how fast a fling slows down, per second
+#define XI_MAX_KINETIC 32
 
-        if (d < 0) {
-            d += 2 * offsetX + 3;
-        } else {
-            d += 2 * (offsetX - offsetY) + 5;
-            offsetY--;
+/*
+ Scroll areas keep the pixels of their viewport in a texture. When the scroll position
+ moves by less than a viewport, the old pixels are shifted into a second texture and
+ only the newly exposed strip is rendered; anything inside that changes calls
+ xi_Invalidate() (directly or through a move/resize) and forces a full repaint.
+*/
+typedef struct xi_ScrollState {
+    float pos_x, pos_y;              // sub-pixel position while flinging
+    float velocity_x, velocity_y;    // pixels per second
+    bool kinetic;                    // listed in xi_kinetic_nodes
+    SDL_Texture *texture[2];         // backing store; two so a shift never reads what it writes
+    int current;
+    int width, height;               // logical size of the viewport it was made for
+    float scale;                     // and the window scale; the textures are in pixels
+    int cached_x, cached_y;          // scroll position the backing store shows
+    SDL_Rect cached_clip;            // visible part of the viewport when it was painted
+    bool valid;
+    bool disabled;                   // no render targets: draw children directly
+    int placed_x, placed_y;          // scroll position the children in view were placed at
+} xi_ScrollState;
+
+static xi_Node *xi_kinetic_nodes[XI_MAX_KINETIC];
+static int xi_kinetic_count = 0;
+static Uint64 xi_kinetic_last_tick = 0;
+
+static void xi_invalidate_scroll_caches(xi_Node *node) {
+    for (; node; node = node->parent) {
+        if (node->scroll) node->scroll->valid = false;
+    }
+}
+
+static void xi_stop_kinetic(xi_Node *node) {
+    for (int i = 0; i < xi_kinetic_count; ++i) {
+        if (xi_kinetic_nodes[i] == node) {
+            xi_kinetic_nodes[i] = xi_kinetic_nodes[--xi_kinetic_count];
+            break;
         }
-        offsetX++;
+    }
+    if (node->scroll) {
+        node->scroll->kinetic = false;
+        node->scroll->velocity_x = node->scroll->velocity_y = 0;
     }
 }
 
-static void xi_DrawTriangle(SDL_Renderer *renderer, int x1, int y1, int x2, int y2, int x3, int y3, Color color, ShapeType type) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    if (type == FILLED) {
-        SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
-        SDL_RenderDrawLine(renderer, x2, y2, x3, y3);
-        SDL_RenderDrawLine(renderer, x3, y3, x1, y1);
-    } else {
-        SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
-        SDL_RenderDrawLine(renderer, x2, y2, x3, y3);
-        SDL_RenderDrawLine(renderer, x3, y3, x1, y1);
+void xi_SetScrollable(void *widget, bool scrollable) {
+    xi_Node *node = (xi_Node*)widget;
+    node->scrollable = scrollable;
+    if (scrollable) {
+        node->clips_children = true;
+        if (!node->scroll) node->scroll = SDL_calloc(1, sizeof(xi_ScrollState));
+    } else if (node->scroll) {
+        xi_stop_kinetic(node);
+        SDL_DestroyTexture(node->scroll->texture[0]);
+        SDL_DestroyTexture(node->scroll->texture[1]);
+        SDL_free(node->scroll);
+        node->scroll = NULL;
     }
+    xi_MarkLayoutDirty(node);
 }
 
-static void xi_ClearScreen(SDL_Renderer *renderer, Color color) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderClear(renderer);
+static int xi_viewport_height(const xi_Node *node) {
+    return node->height - node->layout.inset_top;
 }
 
-/// ============================ WINDOW FUNCTIONS ============================
-// Create and initialize the SDL window and renderer
-xi_Window xiCreateWindow(const char *title, int width, int height) {
-    xi_Window xiWin = {NULL, COLOR_GRAY};
+// The children of a scrolled node move, the node itself doesn't. xi_update_bounds
+// only refreshes the children in view for rows and columns.
+static void xi_mark_scrolled(xi_Node *node) {
+    if (!node->scroll) {
+        xi_mark_bounds_dirty(node);
+        return;
+    }
+    node->scroll_moved = true;
+    for (xi_Node *p = node->parent; p && !p->child_bounds_dirty; p = p->parent) {
+        p->child_bounds_dirty = true;
+    }
+    xi_invalidate_scroll_caches(node->parent);
+    if (xi_task_redraw) *xi_task_redraw = true;
+    else xi_context_of(node)->redraw = true;
+}
 
-    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
-        SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
-        return xiWin;
+static void xi_clamp_scroll(xi_Node *node) {
+    int max_x = node->content_width - node->width;
+    int max_y = node->content_height - xi_viewport_height(node);
+    int x = node->scroll_x, y = node->scroll_y;
+    if (x > max_x) x = max_x;
+    if (y > max_y) y = max_y;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x != node->scroll_x || y != node->scroll_y) {
+        node->scroll_x = x;
+        node->scroll_y = y;
+        xi_mark_scrolled(node);
     }
+}
 
-    if (TTF_Init() == -1) {
-        SDL_Log("Unable to initialize SDL_ttf: %s", TTF_GetError());
-        SDL_Quit();
-        return xiWin;
+static bool xi_set_scroll(xi_Node *node, int x, int y) {
+    int old_x = node->scroll_x, old_y = node->scroll_y;
+    node->scroll_x = x;
+    node->scroll_y = y;
+    xi_clamp_scroll(node);
+    if (node->scroll_x == old_x && node->scroll_y == old_y) return false;
+    // Children move on screen; the node's own backing store is shifted, not repainted
+    xi_mark_scrolled(node);
+    return true;
+}
+
+void xi_ScrollTo(void *widget, int x, int y) {
+    xi_Node *node = (xi_Node*)widget;
+    if (!node->scrollable) return;
+    xi_stop_kinetic(node);
+    xi_set_scroll(node, x, y);
+    node->scroll->pos_x = node->scroll_x;
+    node->scroll->pos_y = node->scroll_y;
+}
+
+void xi_ScrollBy(void *widget, int dx, int dy) {
+    xi_Node *node = (xi_Node*)widget;
+    xi_ScrollTo(node, node->scroll_x + dx, node->scroll_y + dy);
+}
+
+// Start (or speed up) an inertial scroll, in pixels per second
+void xi_Fling(void *widget, float velocity_x, float velocity_y) {
+    xi_Node *node = (xi_Node*)widget;
+    if (!node->scrollable) return;
+    xi_ScrollState *state = node->scroll;
+    if (!state->kinetic) {
+        if (xi_kinetic_count == XI_MAX_KINETIC) {
+            xi_ScrollBy(node, (int)(velocity_x / XI_SCROLL_FRICTION), (int)(velocity_y / XI_SCROLL_FRICTION));
+            return;
+        }
+        xi_kinetic_nodes[xi_kinetic_count++] = node;
+        state->kinetic = true;
+        state->pos_x = node->scroll_x;
+        state->pos_y = node->scroll_y;
+        if (xi_kinetic_count == 1) xi_kinetic_last_tick = SDL_GetPerformanceCounter();
     }
+    state->velocity_x += velocity_x;
+    state->velocity_y += velocity_y;
+    xi_context_of(node)->redraw = true;
+}
 
-    gwindow = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_SHOWN);
-    if (!gwindow) {
-        SDL_Log("Failed to create window: %s", SDL_GetError());
-        SDL_Quit();
-        return xiWin;
+// Advance inertial scrolling by the time since the last call. Returns true while anything moves.
+bool xi_TickScrolling(void) {
+    if (xi_kinetic_count == 0) return false;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    float dt = (float)(now - xi_kinetic_last_tick) / (float)SDL_GetPerformanceFrequency();
+    xi_kinetic_last_tick = now;
+    if (dt > 0.05f) dt = 0.05f;  // don't jump after a stall
+
+    for (int i = xi_kinetic_count - 1; i >= 0; --i) {
+        xi_Node *node = xi_kinetic_nodes[i];
+        xi_ScrollState *state = node->scroll;
+        state->pos_x += state->velocity_x * dt;
+        state->pos_y += state->velocity_y * dt;
+        float decay = 1.0f / (1.0f + XI_SCROLL_FRICTION * dt);
+        state->velocity_x *= decay;
+        state->velocity_y *= decay;
+
+        xi_set_scroll(node, (int)state->pos_x, (int)state->pos_y);
+        // Stop at the edges and once the motion is too slow to see
+        if ((int)state->pos_x != node->scroll_x) { state->pos_x = node->scroll_x; state->velocity_x = 0; }
+        if ((int)state->pos_y != node->scroll_y) { state->pos_y = node->scroll_y; state->velocity_y = 0; }
+        if (SDL_fabsf(state->velocity_x) < 10.0f && SDL_fabsf(state->velocity_y) < 10.0f) {
+            xi_stop_kinetic(node);
+        }
+        xi_context_of(node)->redraw = true;  // keep frames coming while a fling is running
     }
+    return true;
+}
 
-    grenderer = SDL_CreateRenderer(gwindow, -1, SDL_RENDERER_ACCELERATED);
-    if (!grenderer) {
-        SDL_Log("Failed to create renderer: %s", SDL_GetError());
-        SDL_DestroyWindow(gwindow);
-        SDL_Quit();
-        gwindow = NULL;
-        return xiWin;
+// Deepest scrollable node under the point, or NULL
+static xi_Node *xi_scroll_target(xi_Node *node, int x, int y) {
+    xi_Node *found = NULL;
+    if (node->scrollable && xi_point_in_bounds(node, x, y)) found = node;
+    // Last child is drawn on top, so search backwards
+    for (xi_Node *child = node->last_child; child; child = child->prev_sibling) {
+        if (!xi_rects_overlap(&child->bounds, &child->clip) && child->clips_children) continue;
+        xi_Node *inner = xi_scroll_target(child, x, y);
+        if (inner) return inner;
     }
+    return found;
+}
 
-    xiWin.defaultFont = NULL;  // No default font to preload
-    return xiWin;
+// Extra clip applied on top of each node's own, e.g. the strip being repainted in a backing store
+static XI_THREAD_LOCAL SDL_Rect xi_clip_limit = {-(1 << 29), -(1 << 29), 1 << 30, 1 << 30};
+
+static bool xi_children_ordered(const xi_Node *node) {
+    return node->clips_children && node->layout.kind != XI_LAYOUT_NONE;
 }
 
-// Destroy the SDL window and renderer
-void xiDestroyWindow(xi_Window *xiWin) {
-    if (xiWin->defaultFont) {
-        TTF_CloseFont(xiWin->defaultFont);
+// Where a child starts and ends along its container's axis, in content coordinates.
+// These come from the layout, so they hold while cached bounds wait for a refresh.
+static int xi_child_start(const xi_Node *child, bool row) {
+    return row ? child->x : child->y;
+}
+
+static int xi_child_end(const xi_Node *child, bool row) {
+    return row ? child->x + child->width : child->y + child->height;
+}
+
+// First child ending past start, walking from the culling hint
+static xi_Node *xi_child_at(xi_Node *node, bool row, int start) {
+    xi_Node *child = node->first_child;
+    if (node->first_visible && node->first_visible->parent == node) child = node->first_visible;
+    while (child->prev_sibling && xi_child_end(child->prev_sibling, row) > start) {
+        child = child->prev_sibling;
     }
-    if (grenderer) {
-        SDL_DestroyRenderer(grenderer);
+    while (child->next_sibling && xi_child_end(child, row) <= start) {
+        child = child->next_sibling;
     }
-    if (gwindow) {
-        SDL_DestroyWindow(gwindow);
+    return child;
+}
+
+// First child that may be visible, for containers whose children run along one axis.
+// Starts from last frame's answer, so small scrolls only step over a few siblings.
+static xi_Node *xi_first_visible_child(xi_Node *node) {
+    xi_Node *child = node->first_child;
+    if (!child || !node->clips_children ||
+        (node->layout.kind != XI_LAYOUT_ROW && node->layout.kind != XI_LAYOUT_COLUMN)) {
+        return child;
     }
-    TTF_Quit();
-    SDL_Quit();
+    bool row = node->layout.kind == XI_LAYOUT_ROW;
+    SDL_Rect view = xi_intersect_rect(xi_child_clip(node), xi_clip_limit);
+    int view_start = row ? view.x - node->bounds.x + node->scroll_x : view.y - node->bounds.y + node->scroll_y;
+    node->first_visible = xi_child_at(node, row, view_start);
+    return node->first_visible;
 }
 
+// True once a child of an ordered container starts past the visible end
+static bool xi_past_visible_end(const xi_Node *node, const xi_Node *child) {
+    SDL_Rect view = xi_intersect_rect(xi_child_clip(node), xi_clip_limit);
+    if (node->layout.kind == XI_LAYOUT_ROW) return node->bounds.x - node->scroll_x + child->x >= view.x + view.w;
+    return node->bounds.y - node->scroll_y + child->y >= view.y + view.h;
+}
 
-//============================= CONTAINER ===========================================
-// Container widget structure
-typedef struct {
-    int x, y, width, height;
-    const char *title;
-    Color color;
-    bool movable;
-} xi_Container;
+// Called by xi_update_bounds when a scroll node's children move. A scroll alone
+// refreshes only the children of a row or column that are in view now or were at the
+// last position, so any child whose cached bounds overlap the view is up to date and
+// the rest can't be drawn or hit; they catch up when they scroll back in.
+static bool xi_place_scrolled(xi_Node *node, bool in_view_only) {
+    xi_ScrollState *scroll = node->scroll;
+    int placed_x = scroll->placed_x, placed_y = scroll->placed_y;
+    scroll->placed_x = node->scroll_x;
+    scroll->placed_y = node->scroll_y;
+    if (!in_view_only || !node->first_child ||
+        (node->layout.kind != XI_LAYOUT_ROW && node->layout.kind != XI_LAYOUT_COLUMN)) {
+        return false;
+    }
+    bool row = node->layout.kind == XI_LAYOUT_ROW;
+    SDL_Rect view = xi_child_clip(node);
+    int size = row ? view.w : view.h;
+    if (size <= 0) return true;
+    int origin = row ? view.x - node->bounds.x : view.y - node->bounds.y;
+    int before = origin + (row ? placed_x : placed_y);
+    int now = origin + (row ? node->scroll_x : node->scroll_y);
 
-// Create a new container instance
-xi_Container createContainer(int x, int y, int width, int height, Color color, const char *title, bool movable) {
-    xi_Container container;
-    container.x = x;
-    container.y = y;
-    container.width = width;
-    container.height = height;
-    container.color = color;
-    container.title = title;
-    container.movable = movable;
-    
-    register_widget(WIDGET_CONTAINER, &container);
-    	
-    return container;
+    // Those that scrolled out first, then everything in view
+    xi_Node *child = xi_child_at(node, row, before);
+    for (; child && xi_child_start(child, row) < before + size; child = child->next_sibling) {
+        if (xi_child_end(child, row) <= now || xi_child_start(child, row) >= now + size) {
+            xi_update_bounds(child, true);
+        }
+    }
+    child = node->first_visible = xi_child_at(node, row, now);
+    for (; child && xi_child_start(child, row) < now + size; child = child->next_sibling) {
+        xi_update_bounds(child, true);
+    }
+    return true;
 }
 
-// Render the container on the screen
-void render_container(xi_Container *container) {
-    int x = container->x;
-    int y = container->y;
-    int width = container->width;
-    int height = container->height;
+/// ============================ FRAME ARENA ============================
+/*
+ Scratch memory that only has to last until the frame is drawn: formatted strings,
+ vertex buffers, temporary arrays. Allocating is a pointer bump and the whole arena is
+ released at once at the end of render_widgets(), so drawing never goes to the heap:
 
-    // Draw the main container rectangle (filled)
-    xi_DrawRect(grenderer, x, y, width, height, container->color, FILLED);
+    const char *label = xi_FrameFormat("%d%%", percent);
+    SDL_Vertex *quads = xi_FrameAlloc(count * 4 * sizeof(SDL_Vertex));
 
-    // Handle title bar and title if a valid title is provided
-    if (container->title && strlen(container->title) > 0) {
-        int titleBarHeight = 30;  // Fixed height for the title bar
-        Color titleBarColor = {200, 200, 200, 255};
+ A frame that needs more than the arena holds gets extra blocks; the arena is then
+ regrown once, at the reset, to fit the largest frame seen, so a steady UI stops
+ allocating after its first frames. xi_frame_stats shows the high-water mark and, after
+ xi_CountAllocations(true), how many heap allocations the last frame made:
 
-        // Draw title bar
-        xi_DrawRect(grenderer, x, y, width, titleBarHeight, titleBarColor, FILLED);
+    xi_CountAllocations(true);   // before xiCreateWindow; wraps SDL's allocator
+    ...
+    render_widgets();
+    SDL_assert(xi_frame_stats.heap_allocations == 0);
 
-        // Draw title text centered vertically within the title bar
-        int textX = x + 10;
-        int textY = y + (titleBarHeight / 4);  // Simple vertical alignment
-        xi_DrawText(grenderer, container->title, textX, textY, COLOR_BLUE, 16);
+ Only SDL_malloc, SDL_calloc and SDL_realloc are seen, made on the UI thread or on a
+ build thread. FreeType, the GPU driver and the C library allocate on their own, and
+ the render thread and workers aren't counted, so zero here doesn't prove that nothing
+ at all touched the heap. examples/frame_allocs.c (make test) checks a steady UI.
+*/
+#define XI_ARENA_INITIAL (64 * 1024)
 
-        // Adjust the container rectangle position if title bar exists
-        y += titleBarHeight;
-        height -= titleBarHeight;
+typedef struct xi_ArenaBlock {
+    struct xi_ArenaBlock *next;
+} xi_ArenaBlock;
+
+typedef struct {
+    Uint8 *base;
+    size_t used, capacity;
+    xi_ArenaBlock *overflow;     // extra blocks for this frame, freed at the reset
+    size_t overflow_used;
+} xi_Arena;
+
+typedef struct {
+    size_t arena_used;           // bytes handed out during the last frame
+    size_t arena_high_water;     // most any frame needed
+    size_t arena_capacity;
+    int arena_regrowths;         // times a frame outgrew the arena
+    Uint32 heap_allocations;     // SDL_malloc/calloc/realloc calls on the UI and build threads
+                                 // during the last render_widgets(); 0 unless counting
+} xi_FrameStats;
+
+static xi_Arena xi_frame_arena;
+static XI_THREAD_LOCAL xi_Arena *xi_thread_arena;  // build threads' own; NULL: xi_frame_arena
+xi_FrameStats xi_frame_stats;
+
+// Counting wrappers around SDL's allocator, installed by xi_CountAllocations
+static SDL_malloc_func xi_real_malloc;
+static SDL_calloc_func xi_real_calloc;
+static SDL_realloc_func xi_real_realloc;
+static SDL_free_func xi_real_free;
+static SDL_threadID xi_ui_thread;
+static SDL_atomic_t xi_heap_allocations;  // build threads count too
+
+// Frame work happens on the UI thread and on build threads (which have their own arena)
+static void xi_count_allocation(void) {
+    if (xi_thread_arena || SDL_ThreadID() == xi_ui_thread) SDL_AtomicIncRef(&xi_heap_allocations);
+}
+
+static void *xi_counting_malloc(size_t size) {
+    xi_count_allocation();
+    return xi_real_malloc(size);
+}
+
+static void *xi_counting_calloc(size_t count, size_t size) {
+    xi_count_allocation();
+    return xi_real_calloc(count, size);
+}
+
+static void *xi_counting_realloc(void *memory, size_t size) {
+    xi_count_allocation();
+    return xi_real_realloc(memory, size);
+}
+
+// Count heap allocations per frame in xi_frame_stats (off by default). Call it from the
+// thread that runs EventLoop. Memory is still freed by the real allocator, so it can be
+// switched at any time.
+void xi_CountAllocations(bool enable) {
+    if (enable == (xi_real_malloc != NULL)) return;
+    if (enable) {
+        xi_ui_thread = SDL_ThreadID();
+        SDL_GetMemoryFunctions(&xi_real_malloc, &xi_real_calloc, &xi_real_realloc, &xi_real_free);
+        SDL_SetMemoryFunctions(xi_counting_malloc, xi_counting_calloc, xi_counting_realloc, xi_real_free);
+    } else {
+        SDL_SetMemoryFunctions(xi_real_malloc, xi_real_calloc, xi_real_realloc, xi_real_free);
+        xi_real_malloc = NULL;
+    }
+}
+
+// Memory valid until the end of the current frame, 16-byte aligned. NULL only when
+// out of memory.
+void *xi_FrameAlloc(size_t size) {
+    xi_Arena *arena = xi_thread_arena ? xi_thread_arena : &xi_frame_arena;
+    size = (size + 15) & ~(size_t)15;
+    if (!arena->base) {
+        arena->base = SDL_malloc(XI_ARENA_INITIAL);
+        if (!arena->base) return NULL;
+        arena->capacity = XI_ARENA_INITIAL;
+    }
+    if (arena->capacity - arena->used >= size) {
+        void *memory = arena->base + arena->used;
+        arena->used += size;
+        return memory;
+    }
+
+    // Out of room this frame: a block of its own, freed at the reset
+    xi_ArenaBlock *block = SDL_malloc(sizeof(xi_ArenaBlock) + 16 + size);
+    if (!block) {
+        SDL_Log("Out of memory in the frame arena (%u bytes)", (unsigned)size);
+        return NULL;
+    }
+    block->next = arena->overflow;
+    arena->overflow = block;
+    arena->overflow_used += size;
+    return (Uint8*)block + ((sizeof(xi_ArenaBlock) + 15) & ~(size_t)15);
+}
+
+// printf into the frame arena
+char *xi_FrameFormat(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = SDL_vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (length < 0) return NULL;
+    char *text = xi_FrameAlloc((size_t)length + 1);
+    if (!text) return NULL;
+    va_start(args, format);
+    SDL_vsnprintf(text, (size_t)length + 1, format, args);
+    va_end(args);
+    return text;
+}
+
+// Copy up to `length` bytes of a string into the frame arena
+char *xi_FrameString(const char *text, size_t length) {
+    size_t available = strlen(text);
+    if (length > available) length = available;
+    char *copy = xi_FrameAlloc(length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// Release everything allocated from an arena; returns true if it had to be regrown
+static bool xi_reset_arena(xi_Arena *arena) {
+    size_t used = arena->used + arena->overflow_used;
+    bool regrown = arena->overflow != NULL;
+    if (arena->overflow) {
+        while (arena->overflow) {
+            xi_ArenaBlock *next = arena->overflow->next;
+            SDL_free(arena->overflow);
+            arena->overflow = next;
+        }
+        size_t capacity = arena->capacity;
+        while (capacity < used + used / 2) capacity *= 2;  // room to spare for the next peak
+        Uint8 *base = SDL_realloc(arena->base, capacity);
+        if (base) {
+            arena->base = base;
+            arena->capacity = capacity;
+        }
+        arena->overflow_used = 0;
+    }
+    arena->used = 0;
+    return regrown;
+}
+
+// Release everything allocated this frame. O(1) unless the frame outgrew the arena.
+static void xi_reset_frame_arena(void) {
+    xi_Arena *arena = &xi_frame_arena;
+    size_t used = arena->used + arena->overflow_used;
+    xi_frame_stats.arena_used = used;
+    if (used > xi_frame_stats.arena_high_water) xi_frame_stats.arena_high_water = used;
+    if (xi_reset_arena(arena)) xi_frame_stats.arena_regrowths++;
+    xi_frame_stats.arena_capacity = arena->capacity;
+}
+
+static void xi_free_frame_arena(void) {
+    xi_reset_frame_arena();
+    SDL_free(xi_frame_arena.base);
+    xi_frame_arena.base = NULL;
+    xi_frame_arena.capacity = 0;
+}
+
+/// ============================ SOFTWARE RASTERIZER ============================
+/*
+ For machines without a GPU (headless servers, thin clients) a window can draw on the
+ CPU into an ARGB8888 framebuffer instead of going through an SDL renderer:
+
+    xi_UseSoftwareRenderer(true);       // before xiCreateWindow / xi_CreateContext
+    xi_Window win = xiCreateWindow("Console", 1280, 720);
+
+ (or set XI_SOFTWARE_RENDER=1 in the environment). Nothing else changes: xi_DrawRect,
+ xi_DrawCircle, xi_DrawTriangle, xi_DrawText, images and plots all land in the
+ framebuffer. It also stands in for the window copy, so partial frames work as usual
+ and only the damaged rectangle is copied to the window surface.
+
+ All drawing comes down to rows of 32-bit pixels: solid fills, one color blended over
+ them, and a source row blended with its own alpha (text coverage, images). Each has
+ SSE2 and AVX2 versions next to the plain C one; the best the CPU supports is picked
+ at startup. XI_SIMD=scalar, sse2 or avx2 in the environment forces one.
+*/
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XI_SIMD_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define XI_TARGET(isa) __attribute__((target(isa)))
+#else
+#define XI_TARGET(isa)
+#endif
+#endif
+
+typedef struct {
+    const char *name;
+    void (*fill)(Uint32 *dst, int count, Uint32 color);
+    void (*blend)(Uint32 *dst, int count, Uint32 color);            // color's alpha over dst
+    void (*blend_row)(Uint32 *dst, const Uint32 *src, int count);   // each src pixel's alpha
+} xi_SoftKernels;
+
+static xi_SoftKernels xi_soft;
+static bool xi_software_default = false;
+static SDL_Rect xi_soft_clip;  // in framebuffer pixels
+
+// Draw new windows on the CPU (true) or through an SDL renderer (false, the default)
+void xi_UseSoftwareRenderer(bool enable) {
+    xi_software_default = enable;
+}
+
+static Uint32 xi_pack_color(Color c) {
+    return (Uint32)c.a << 24 | (Uint32)c.r << 16 | (Uint32)c.g << 8 | c.b;
+}
+
+// s over d with alpha a, both channels of a pair at once; x / 255 as (x + 128) * 257 >> 16
+static Uint32 xi_blend_pixel(Uint32 d, Uint32 s, Uint32 a) {
+    Uint32 rb = (s & 0xFF00FF) * a + (d & 0xFF00FF) * (255 - a) + 0x800080;
+    Uint32 g = (s & 0xFF00) * a + (d & 0xFF00) * (255 - a) + 0x8000;
+    rb = ((rb + ((rb >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+    g = ((g + ((g >> 8) & 0xFF00)) >> 8) & 0xFF00;
+    return 0xFF000000 | rb | g;
+}
+
+static void xi_fill_scalar(Uint32 *dst, int count, Uint32 color) {
+    for (int i = 0; i < count; ++i) dst[i] = color;
+}
+
+static void xi_blend_scalar(Uint32 *dst, int count, Uint32 color) {
+    Uint32 a = color >> 24;
+    for (int i = 0; i < count; ++i) dst[i] = xi_blend_pixel(dst[i], color, a);
+}
+
+static void xi_blend_row_scalar(Uint32 *dst, const Uint32 *src, int count) {
+    for (int i = 0; i < count; ++i) {
+        Uint32 a = src[i] >> 24;
+        if (a == 255) dst[i] = src[i];
+        else if (a) dst[i] = xi_blend_pixel(dst[i], src[i], a);
+    }
+}
+
+#ifdef XI_SIMD_X86
+XI_TARGET("sse2") static void xi_fill_sse2(Uint32 *dst, int count, Uint32 color) {
+    __m128i c = _mm_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i*)(dst + i), c);
+    for (; i < count; ++i) dst[i] = color;
+}
+
+// Per 16-bit lane: (s * a + d * (255 - a) + 128) / 255, exact for 8-bit inputs
+XI_TARGET("sse2") static __m128i xi_mix16_sse2(__m128i s, __m128i d, __m128i a) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)));
+    t = _mm_add_epi16(t, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+XI_TARGET("sse2") static void xi_blend_sse2(Uint32 *dst, int count, Uint32 color) {
+    __m128i zero = _mm_setzero_si128(), opaque = _mm_set1_epi32((int)0xFF000000);
+    __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    __m128i a = _mm_set1_epi16((short)(color >> 24));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = xi_mix16_sse2(s, _mm_unpacklo_epi8(d, zero), a);
+        __m128i hi = xi_mix16_sse2(s, _mm_unpackhi_epi8(d, zero), a);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+    xi_blend_scalar(dst + i, count - i, color);
+}
+
+XI_TARGET("sse2") static void xi_blend_row_sse2(Uint32 *dst, const Uint32 *src, int count) {
+    __m128i zero = _mm_setzero_si128(), opaque = _mm_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i alpha = _mm_srli_epi32(s, 24);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero));
+        if (mask == 0xFFFF) continue;  // fully transparent, common around glyphs
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_set1_epi32(255))) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i slo = _mm_unpacklo_epi8(s, zero), shi = _mm_unpackhi_epi8(s, zero);
+        __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, 0xFF), 0xFF);
+        __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, 0xFF), 0xFF);
+        __m128i lo = xi_mix16_sse2(slo, _mm_unpacklo_epi8(d, zero), alo);
+        __m128i hi = xi_mix16_sse2(shi, _mm_unpackhi_epi8(d, zero), ahi);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+    xi_blend_row_scalar(dst + i, src + i, count - i);
+}
+
+XI_TARGET("avx2") static void xi_fill_avx2(Uint32 *dst, int count, Uint32 color) {
+    __m256i c = _mm256_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), c);
+    for (; i < count; ++i) dst[i] = color;
+}
+
+XI_TARGET("avx2") static __m256i xi_mix16_avx2(__m256i s, __m256i d, __m256i a) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a)));
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+XI_TARGET("avx2") static void xi_blend_avx2(Uint32 *dst, int count, Uint32 color) {
+    __m256i zero = _mm256_setzero_si256(), opaque = _mm256_set1_epi32((int)0xFF000000);
+    __m256i s = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+    __m256i a = _mm256_set1_epi16((short)(color >> 24));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = xi_mix16_avx2(s, _mm256_unpacklo_epi8(d, zero), a);
+        __m256i hi = xi_mix16_avx2(s, _mm256_unpackhi_epi8(d, zero), a);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque));
+    }
+    xi_blend_scalar(dst + i, count - i, color);
+}
+
+XI_TARGET("avx2") static void xi_blend_row_avx2(Uint32 *dst, const Uint32 *src, int count) {
+    __m256i zero = _mm256_setzero_si256(), opaque = _mm256_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i alpha = _mm256_srli_epi32(s, 24);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, zero)) == -1) continue;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_set1_epi32(255))) == -1) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+        // unpack and pack work within 128-bit halves, so pixel order comes back intact
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i slo = _mm256_unpacklo_epi8(s, zero), shi = _mm256_unpackhi_epi8(s, zero);
+        __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(slo, 0xFF), 0xFF);
+        __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(shi, 0xFF), 0xFF);
+        __m256i lo = xi_mix16_avx2(slo, _mm256_unpacklo_epi8(d, zero), alo);
+        __m256i hi = xi_mix16_avx2(shi, _mm256_unpackhi_epi8(d, zero), ahi);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque));
+    }
+    xi_blend_row_scalar(dst + i, src + i, count - i);
+}
+#endif
+
+static void xi_pick_soft_kernels(void) {
+    const char *force = SDL_getenv("XI_SIMD");
+    xi_soft = (xi_SoftKernels){"scalar", xi_fill_scalar, xi_blend_scalar, xi_blend_row_scalar};
+#ifdef XI_SIMD_X86
+    if (force && SDL_strcmp(force, "scalar") == 0) return;
+    if (SDL_HasSSE2()) {
+        xi_soft = (xi_SoftKernels){"sse2", xi_fill_sse2, xi_blend_sse2, xi_blend_row_sse2};
+    }
+    if (SDL_HasAVX2() && !(force && SDL_strcmp(force, "sse2") == 0)) {
+        xi_soft = (xi_SoftKernels){"avx2", xi_fill_avx2, xi_blend_avx2, xi_blend_row_avx2};
+    }
+#else
+    (void)force;
+#endif
+}
+
+// Logical units (after xi_origin) to framebuffer pixels
+static int xi_soft_px(float v) {
+    return (int)SDL_floorf(v * xi_current->scale + 0.5f);
+}
+
+static Uint32 *xi_soft_row(int y) {
+    SDL_Surface *canvas = xi_current->canvas;
+    return (Uint32*)((Uint8*)canvas->pixels + (size_t)y * canvas->pitch);
+}
+
+// Pixels [x0, x1) of row y, clipped
+static void xi_soft_span(int y, int x0, int x1, Uint32 color) {
+    const SDL_Rect *c = &xi_soft_clip;
+    if (y < c->y || y >= c->y + c->h) return;
+    if (x0 < c->x) x0 = c->x;
+    if (x1 > c->x + c->w) x1 = c->x + c->w;
+    if (x0 >= x1) return;
+    Uint32 alpha = color >> 24;
+    if (alpha == 255) xi_soft.fill(xi_soft_row(y) + x0, x1 - x0, color);
+    else if (alpha) xi_soft.blend(xi_soft_row(y) + x0, x1 - x0, color);
+}
+
+static void xi_soft_fill_pixels(int x0, int y0, int x1, int y1, Uint32 color) {
+    if (y0 < xi_soft_clip.y) y0 = xi_soft_clip.y;
+    if (y1 > xi_soft_clip.y + xi_soft_clip.h) y1 = xi_soft_clip.y + xi_soft_clip.h;
+    for (int y = y0; y < y1; ++y) xi_soft_span(y, x0, x1, color);
+}
+
+static void xi_soft_rect(int x, int y, int width, int height, Color color, ShapeType type) {
+    int x0 = xi_soft_px(x - xi_origin_x), y0 = xi_soft_px(y - xi_origin_y);
+    int x1 = xi_soft_px(x - xi_origin_x + width), y1 = xi_soft_px(y - xi_origin_y + height);
+    Uint32 c = xi_pack_color(color);
+    if (type == FILLED) {
+        xi_soft_fill_pixels(x0, y0, x1, y1, c);
+        return;
+    }
+    int t = xi_soft_px(1) > 1 ? xi_soft_px(1) : 1;  // a one-unit line
+    xi_soft_fill_pixels(x0, y0, x1, y0 + t, c);
+    xi_soft_fill_pixels(x0, y1 - t, x1, y1, c);
+    xi_soft_fill_pixels(x0, y0 + t, x0 + t, y1 - t, c);
+    xi_soft_fill_pixels(x1 - t, y0 + t, x1, y1 - t, c);
+}
+
+static void xi_soft_circle(int x, int y, int radius, Color color, ShapeType type) {
+    float s = xi_current->scale;
+    float cx = (x - xi_origin_x + 0.5f) * s, cy = (y - xi_origin_y + 0.5f) * s;
+    float r = (radius + 0.5f) * s;
+    float inner = type == FILLED ? -1.0f : r - (s > 1.0f ? s : 1.0f);
+    Uint32 c = xi_pack_color(color);
+    int top = (int)SDL_floorf(cy - r), bottom = (int)SDL_ceilf(cy + r);
+    for (int py = top; py < bottom; ++py) {
+        float dy = py + 0.5f - cy;
+        if (dy * dy > r * r) continue;
+        float half = SDL_sqrtf(r * r - dy * dy);
+        int left = (int)SDL_floorf(cx - half + 0.5f), right = (int)SDL_floorf(cx + half + 0.5f);
+        if (inner > 0 && dy * dy < inner * inner) {
+            float hole = SDL_sqrtf(inner * inner - dy * dy);
+            xi_soft_span(py, left, (int)SDL_floorf(cx - hole + 0.5f), c);
+            xi_soft_span(py, (int)SDL_floorf(cx + hole + 0.5f), right, c);
+        } else {
+            xi_soft_span(py, left, right, c);
+        }
+    }
+}
+
+// Solid triangle in pixel coordinates; pixels whose centers are inside are covered, so
+// triangles sharing an edge (the quads of a plot) neither overlap nor leave gaps
+static void xi_soft_fill_triangle(float x1, float y1, float x2, float y2, float x3, float y3, Uint32 color) {
+    float xs[3] = {x1, x2, x3}, ys[3] = {y1, y2, y3};
+    float top = SDL_min(y1, SDL_min(y2, y3)), bottom = SDL_max(y1, SDL_max(y2, y3));
+    int first = (int)SDL_ceilf(top - 0.5f), last = (int)SDL_ceilf(bottom - 0.5f);
+    if (first < xi_soft_clip.y) first = xi_soft_clip.y;
+    if (last > xi_soft_clip.y + xi_soft_clip.h) last = xi_soft_clip.y + xi_soft_clip.h;
+    for (int py = first; py < last; ++py) {
+        float yc = py + 0.5f, left = 1e30f, right = -1e30f;
+        for (int e = 0; e < 3; ++e) {
+            float ax = xs[e], ay = ys[e], bx = xs[(e + 1) % 3], by = ys[(e + 1) % 3];
+            if ((ay <= yc && by > yc) || (by <= yc && ay > yc)) {
+                float x = ax + (yc - ay) * (bx - ax) / (by - ay);
+                if (x < left) left = x;
+                if (x > right) right = x;
+            }
+        }
+        if (left < right) xi_soft_span(py, (int)SDL_ceilf(left - 0.5f), (int)SDL_ceilf(right - 0.5f), color);
+    }
+}
+
+static void xi_soft_line(int x1, int y1, int x2, int y2, Uint32 color) {
+    int t = xi_soft_px(1) > 1 ? xi_soft_px(1) : 1;
+    int dx = SDL_abs(x2 - x1), dy = -SDL_abs(y2 - y1);
+    int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1, err = dx + dy;
+    for (;;) {
+        xi_soft_fill_pixels(x1, y1, x1 + t, y1 + t, color);
+        if (x1 == x2 && y1 == y2) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+    }
+}
+
+static void xi_soft_triangle(int x1, int y1, int x2, int y2, int x3, int y3, Color color, ShapeType type) {
+    Uint32 c = xi_pack_color(color);
+    float s = xi_current->scale;
+    x1 -= xi_origin_x; x2 -= xi_origin_x; x3 -= xi_origin_x;
+    y1 -= xi_origin_y; y2 -= xi_origin_y; y3 -= xi_origin_y;
+    if (type == FILLED) {
+        xi_soft_fill_triangle(x1 * s, y1 * s, x2 * s, y2 * s, x3 * s, y3 * s, c);
+        return;
+    }
+    xi_soft_line(xi_soft_px(x1), xi_soft_px(y1), xi_soft_px(x2), xi_soft_px(y2), c);
+    xi_soft_line(xi_soft_px(x2), xi_soft_px(y2), xi_soft_px(x3), xi_soft_px(y3), c);
+    xi_soft_line(xi_soft_px(x3), xi_soft_px(y3), xi_soft_px(x1), xi_soft_px(y1), c);
+}
+
+// Blend the part from of an ARGB8888 surface into the framebuffer pixel rectangle dst,
+// scaling to it (nearest pixel) when the sizes differ, at opacity alpha
+static void xi_soft_blit_region(SDL_Surface *src, SDL_Rect from, SDL_Rect dst, Uint8 alpha) {
+    SDL_Rect area = xi_intersect_rect(dst, xi_soft_clip);
+    if (area.w <= 0 || area.h <= 0 || dst.w <= 0 || dst.h <= 0 || from.w <= 0 || from.h <= 0) return;
+    bool same_size = from.w == dst.w && from.h == dst.h && alpha == 255;
+    Uint32 *scaled = same_size ? NULL : xi_FrameAlloc((size_t)area.w * sizeof(Uint32));
+    if (!same_size && !scaled) return;
+    for (int y = area.y; y < area.y + area.h; ++y) {
+        int sy = from.y + (int)((Sint64)(y - dst.y) * from.h / dst.h);
+        const Uint32 *row = (const Uint32*)((const Uint8*)src->pixels + (size_t)sy * src->pitch) + from.x;
+        if (same_size) {
+            xi_soft.blend_row(xi_soft_row(y) + area.x, row + (area.x - dst.x), area.w);
+            continue;
+        }
+        for (int x = 0; x < area.w; ++x) {
+            Uint32 pixel = row[(Sint64)(area.x + x - dst.x) * from.w / dst.w];
+            if (alpha != 255) pixel = (pixel & 0xFFFFFF) | ((pixel >> 24) * alpha / 255) << 24;
+            scaled[x] = pixel;
+        }
+        xi_soft.blend_row(xi_soft_row(y) + area.x, scaled, area.w);
+    }
+}
+
+static void xi_soft_blit(SDL_Surface *src, SDL_Rect dst) {
+    xi_soft_blit_region(src, (SDL_Rect){0, 0, src->w, src->h}, dst, 255);
+}
+
+// Triangles of SDL_RenderGeometry, one color each (from their first vertex)
+static void xi_soft_geometry(const SDL_Vertex *vertices, const int *indices, int index_count) {
+    float s = xi_current->scale;
+    for (int i = 0; i + 2 < index_count; i += 3) {
+        const SDL_Vertex *a = &vertices[indices[i]], *b = &vertices[indices[i + 1]], *c = &vertices[indices[i + 2]];
+        Color color = {a->color.r, a->color.g, a->color.b, a->color.a};
+        xi_soft_fill_triangle(a->position.x * s, a->position.y * s, b->position.x * s, b->position.y * s,
+                              c->position.x * s, c->position.y * s, xi_pack_color(color));
+    }
+}
+
+// Make sure the framebuffer matches the window surface; returns false if there is none
+static bool xi_soft_prepare_canvas(void) {
+    SDL_Surface *window_surface = SDL_GetWindowSurface(gwindow);
+    if (!window_surface) {
+        SDL_Log("No window surface for software rendering: %s", SDL_GetError());
+        return false;
+    }
+    SDL_Surface *canvas = xi_current->canvas;
+    if (canvas && canvas->w == window_surface->w && canvas->h == window_surface->h) return true;
+    if (canvas) SDL_FreeSurface(canvas);
+    canvas = SDL_CreateRGBSurfaceWithFormat(0, window_surface->w, window_surface->h, 32, SDL_PIXELFORMAT_ARGB8888);
+    xi_current->canvas = canvas;
+    if (!canvas) {
+        SDL_Log("Failed to create framebuffer: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetSurfaceBlendMode(canvas, SDL_BLENDMODE_NONE);  // copied to the window as is
+    xi_redraw = true;
+    return true;
+}
+
+/// ============================ RENDER THREAD ============================
+/*
+ In pipelined mode the UI thread never waits on the GPU. Drawing a frame records what
+ to draw into a display list; a render thread owns the window's SDL renderer, plays
+ finished lists back and presents them. A slow present or a vsync wait then only holds
+ up that thread, and events keep being handled meanwhile:
+
+    xi_UsePipelinedRendering(3);        // before xiCreateWindow / xi_CreateContext
+    xi_Window win = xiCreateWindow("Scope", 1280, 720);
+
+ Each window has 2 or 3 lists taking turns: one being built, the others waiting to be
+ drawn or being drawn. When none is free the UI thread skips the frame instead of
+ waiting; what changed stays pending and goes into the next one. xi_render_stats
+ counts frames built, skipped and presented.
+
+ Strings and images are recorded as the surfaces they were rasterized into and the
+ render thread makes the textures. A surface the UI thread lets go of (an evicted
+ string, a released image) is freed only after every list that may draw it is done.
+
+ SDL wants a renderer used from a single thread, which here is the render thread.
+ Some platforms (macOS) only render on the main thread; leave this off there. Scroll
+ backing stores and SDF text are not used in this mode.
+*/
+#define XI_MAX_DISPLAY_LISTS 3
+
+typedef enum {
+    XI_CMD_CLEAR, XI_CMD_RECT, XI_CMD_CIRCLE, XI_CMD_TRIANGLE, XI_CMD_SURFACE,
+    XI_CMD_GEOMETRY, XI_CMD_CLIP, XI_CMD_NO_CLIP
+} xi_DrawOp;
+
+typedef struct {
+    Uint8 op;
+    Uint8 type;             // ShapeType of shapes
+    Color color;
+    union {
+        SDL_Rect rect;      // RECT, CLIP
+        int points[6];      // CIRCLE: x, y, radius; TRIANGLE: the corners
+        struct { SDL_Surface *surface; SDL_FRect dst; } surface;
+        struct { size_t offset; int vertex_count, index_count; SDL_Surface *surface; } geometry;  // in the list's data; textured from surface, if set
+    } u;
+} xi_DrawCmd;
+
+typedef enum { XI_LIST_FREE, XI_LIST_BUILDING, XI_LIST_READY, XI_LIST_DRAWING } xi_ListState;
+
+typedef struct {
+    xi_ListState state;     // changed under xi_pipe.lock
+    Uint32 seq;             // frame number; lists are drawn in this order
+    bool full;              // the whole window; otherwise drawn over the last frame
+    float scale;
+    xi_DrawCmd *cmds;
+    int count, capacity;
+    Uint8 *data;            // vertices and indices of GEOMETRY commands
+    size_t data_used, data_capacity;
+} xi_DisplayList;
+
+typedef struct xi_RenderWindow {
+    int slot;
+    SDL_Window *window;
+    SDL_Renderer *renderer;     // only used by the render thread
+    SDL_Texture *screen;        // the last frame, drawn over by lists that aren't full
+    int screen_width, screen_height;
+    SDL_Surface **surfaces;     // surfaces this window made a texture of
+    int surface_count, surface_capacity;
+    float output_scale;         // pixels per window unit, published under xi_pipe.lock
+    SDL_atomic_t need_full;     // a partial list couldn't be drawn; the next one is full
+    SDL_atomic_t no_screen;     // no window copy: every list is full
+    int buffers;
+    xi_DisplayList lists[XI_MAX_DISPLAY_LISTS];
+} xi_RenderWindow;
+
+typedef struct {
+    SDL_Surface *surface;
+    Uint32 seq;             // last list that was started when it was let go of
+} xi_RetiredSurface;
+
+typedef struct {
+    Uint64 frames_built;
+    Uint64 frames_skipped;      // no free list: the render thread was behind
+    Uint64 frames_presented;
+} xi_RenderStats;
+
+static struct {
+    int buffers;                // lists per window; 0: windows draw on the UI thread
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *work;             // lists ready, surfaces retired or a request
+    SDL_cond *done;             // a request was carried out
+    bool stop;
+    xi_RenderWindow *windows[XI_MAX_WINDOWS];
+    xi_RenderWindow *open, *close;  // requests from the UI thread
+    Uint32 seq;
+    xi_RetiredSurface *retired;
+    int retired_count, retired_capacity;
+    SDL_Surface **freeing;      // render thread's batch, freed outside the lock
+    int freeing_capacity;
+} xi_pipe;
+
+xi_RenderStats xi_render_stats;     // updated under the render thread's lock
+static XI_THREAD_LOCAL xi_DisplayList *xi_recording;  // list this thread is building
+
+// Draw new windows through a render thread with `buffers` display lists (2 or 3),
+// or on the UI thread (0, the default)
+void xi_UsePipelinedRendering(int buffers) {
+    if (buffers < 0) buffers = 0;
+    if (buffers == 1) buffers = 2;  // one list would make every frame wait
+    if (buffers > XI_MAX_DISPLAY_LISTS) buffers = XI_MAX_DISPLAY_LISTS;
+    xi_pipe.buffers = buffers;
+}
+
+// Shapes through an SDL renderer, in its current units
+static void xi_gpu_rect(SDL_Renderer *renderer, SDL_Rect rect, Color color, ShapeType type) {
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    if (type == FILLED) {
+        SDL_RenderFillRect(renderer, &rect);
+    } else {
+        SDL_RenderDrawRect(renderer, &rect);
+    }
+}
+
+static void xi_gpu_circle(SDL_Renderer *renderer, int x, int y, int radius, Color color, ShapeType type) {
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    int offsetX = 0, offsetY = radius;
+    int d = 1 - radius;
+
+    while (offsetX <= offsetY) {
+        if (type == FILLED) {
+            SDL_RenderDrawLine(renderer, x - offsetX, y + offsetY, x + offsetX, y + offsetY);
+            SDL_RenderDrawLine(renderer, x - offsetX, y - offsetY, x + offsetX, y - offsetY);
+            SDL_RenderDrawLine(renderer, x - offsetY, y + offsetX, x + offsetY, y + offsetX);
+            SDL_RenderDrawLine(renderer, x - offsetY, y - offsetX, x + offsetY, y - offsetX);
+        } else {
+            SDL_RenderDrawPoint(renderer, x + offsetX, y + offsetY);
+            SDL_RenderDrawPoint(renderer, x + offsetX, y - offsetY);
+            SDL_RenderDrawPoint(renderer, x - offsetX, y + offsetY);
+            SDL_RenderDrawPoint(renderer, x - offsetX, y - offsetY);
+            SDL_RenderDrawPoint(renderer, x + offsetY, y + offsetX);
+            SDL_RenderDrawPoint(renderer, x + offsetY, y - offsetX);
+            SDL_RenderDrawPoint(renderer, x - offsetY, y + offsetX);
+            SDL_RenderDrawPoint(renderer, x - offsetY, y - offsetX);
+        }
+
+        if (d < 0) {
+            d += 2 * offsetX + 3;
+        } else {
+            d += 2 * (offsetX - offsetY) + 5;
+            offsetY--;
+        }
+        offsetX++;
+    }
+}
+
+static void xi_gpu_triangle(SDL_Renderer *renderer, const int *p, Color color, ShapeType type) {
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    if (type == FILLED) {
+        SDL_Color c = {color.r, color.g, color.b, color.a};
+        SDL_Vertex v[3] = {{{(float)p[0], (float)p[1]}, c, {0, 0}}, {{(float)p[2], (float)p[3]}, c, {0, 0}},
+                           {{(float)p[4], (float)p[5]}, c, {0, 0}}};
+        SDL_RenderGeometry(renderer, NULL, v, 3, NULL, 0);
+    } else {
+        SDL_RenderDrawLine(renderer, p[0], p[1], p[2], p[3]);
+        SDL_RenderDrawLine(renderer, p[2], p[3], p[4], p[5]);
+        SDL_RenderDrawLine(renderer, p[4], p[5], p[0], p[1]);
+    }
+}
+
+// Next command of the list being built; NULL outside a frame or when out of memory
+static xi_DrawCmd *xi_record(xi_DrawOp op) {
+    xi_DisplayList *list = xi_recording;
+    if (!list) return NULL;
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        xi_DrawCmd *cmds = SDL_realloc(list->cmds, capacity * sizeof(xi_DrawCmd));
+        if (!cmds) {
+            SDL_Log("Out of memory for the display list");
+            return NULL;
+        }
+        list->cmds = cmds;
+        list->capacity = capacity;
+    }
+    xi_DrawCmd *cmd = &list->cmds[list->count++];
+    cmd->op = (Uint8)op;
+    return cmd;
+}
+
+static void xi_record_shape(xi_DrawOp op, const int *values, int count, Color color, ShapeType type) {
+    xi_DrawCmd *cmd = xi_record(op);
+    if (!cmd) return;
+    cmd->type = (Uint8)type;
+    cmd->color = color;
+    memcpy(cmd->u.points, values, count * sizeof(int));
+}
+
+static void xi_record_surface(SDL_Surface *surface, SDL_FRect dst) {
+    xi_DrawCmd *cmd = xi_record(XI_CMD_SURFACE);
+    if (!cmd) return;
+    cmd->u.surface.surface = surface;
+    cmd->u.surface.dst = dst;
+}
+
+static void xi_record_geometry(const SDL_Vertex *vertices, int vertex_count, const int *indices, int index_count, SDL_Surface *surface) {
+    xi_DisplayList *list = xi_recording;
+    if (!list) return;
+    size_t offset = (list->data_used + 7) & ~(size_t)7;
+    size_t vertex_bytes = vertex_count * sizeof(SDL_Vertex), bytes = vertex_bytes + index_count * sizeof(int);
+    if (offset + bytes > list->data_capacity) {
+        size_t capacity = list->data_capacity ? list->data_capacity : 16 * 1024;
+        while (capacity < offset + bytes) capacity *= 2;
+        Uint8 *data = SDL_realloc(list->data, capacity);
+        if (!data) {
+            SDL_Log("Out of memory for the display list");
+            return;
+        }
+        list->data = data;
+        list->data_capacity = capacity;
+    }
+    xi_DrawCmd *cmd = xi_record(XI_CMD_GEOMETRY);
+    if (!cmd) return;
+    memcpy(list->data + offset, vertices, vertex_bytes);
+    memcpy(list->data + offset + vertex_bytes, indices, index_count * sizeof(int));
+    list->data_used = offset + bytes;
+    cmd->u.geometry.offset = offset;
+    cmd->u.geometry.vertex_count = vertex_count;
+    cmd->u.geometry.index_count = index_count;
+    cmd->u.geometry.surface = surface;
+}
+
+// Clip rectangle in window units; NULL turns clipping off
+static void xi_record_clip(const SDL_Rect *clip) {
+    xi_DrawCmd *cmd = xi_record(clip ? XI_CMD_CLIP : XI_CMD_NO_CLIP);
+    if (cmd && clip) cmd->u.rect = *clip;
+}
+
+// Free a surface the UI thread is done with; lists not yet drawn may still use it
+static void xi_release_surface(SDL_Surface *surface) {
+    if (!surface) return;
+    if (!xi_pipe.thread) {
+        SDL_FreeSurface(surface);
+        return;
+    }
+    SDL_LockMutex(xi_pipe.lock);
+    if (xi_pipe.retired_count == xi_pipe.retired_capacity) {
+        int capacity = xi_pipe.retired_capacity ? xi_pipe.retired_capacity * 2 : 64;
+        xi_RetiredSurface *retired = SDL_realloc(xi_pipe.retired, capacity * sizeof(xi_RetiredSurface));
+        if (!retired) {
+            SDL_UnlockMutex(xi_pipe.lock);
+            SDL_Log("Out of memory retiring a surface; it is leaked");
+            return;
+        }
+        xi_pipe.retired = retired;
+        xi_pipe.retired_capacity = capacity;
+    }
+    xi_pipe.retired[xi_pipe.retired_count++] = (xi_RetiredSurface){surface, xi_pipe.seq};
+    SDL_CondSignal(xi_pipe.work);
+    SDL_UnlockMutex(xi_pipe.lock);
+}
+
+// Render thread: texture of a recorded surface for one window, made on first use. Each
+// surface keeps its textures, one per window slot, in its userdata.
+static SDL_Texture *xi_surface_texture(xi_RenderWindow *w, SDL_Surface *surface) {
+    SDL_Texture **textures = surface->userdata;
+    if (!textures) {
+        textures = SDL_calloc(XI_MAX_WINDOWS, sizeof(SDL_Texture*));
+        if (!textures) return NULL;
+        surface->userdata = textures;
+    }
+    if (textures[w->slot]) return textures[w->slot];
+    if (w->surface_count == w->surface_capacity) {
+        int capacity = w->surface_capacity ? w->surface_capacity * 2 : 64;
+        SDL_Surface **surfaces = SDL_realloc(w->surfaces, capacity * sizeof(SDL_Surface*));
+        if (!surfaces) return NULL;
+        w->surfaces = surfaces;
+        w->surface_capacity = capacity;
+    }
+    textures[w->slot] = SDL_CreateTextureFromSurface(w->renderer, surface);
+    if (!textures[w->slot]) {
+        SDL_Log("Failed to create texture: %s", SDL_GetError());
+        return NULL;
+    }
+    w->surfaces[w->surface_count++] = surface;
+    return textures[w->slot];
+}
+
+// Render thread: destroy a surface's textures, then the surface
+static void xi_free_retired(SDL_Surface *surface) {
+    SDL_Texture **textures = surface->userdata;
+    for (int slot = 0; textures && slot < XI_MAX_WINDOWS; ++slot) {
+        xi_RenderWindow *w = xi_pipe.windows[slot];
+        if (!textures[slot] || !w) continue;
+        SDL_DestroyTexture(textures[slot]);
+        for (int i = 0; i < w->surface_count; ++i) {
+            if (w->surfaces[i] == surface) {
+                w->surfaces[i] = w->surfaces[--w->surface_count];
+                break;
+            }
+        }
+    }
+    SDL_free(textures);
+    surface->userdata = NULL;
+    SDL_FreeSurface(surface);
+}
+
+// Render thread, under the lock: take the retired surfaces no list can still draw
+static int xi_collect_retired(void) {
+    Uint32 oldest = xi_pipe.seq + 1;
+    for (int slot = 0; slot < XI_MAX_WINDOWS; ++slot) {
+        xi_RenderWindow *w = xi_pipe.windows[slot];
+        for (int i = 0; w && i < w->buffers; ++i) {
+            if (w->lists[i].state != XI_LIST_FREE && w->lists[i].seq < oldest) oldest = w->lists[i].seq;
+        }
+    }
+    if (xi_pipe.freeing_capacity < xi_pipe.retired_count) {
+        SDL_Surface **freeing = SDL_realloc(xi_pipe.freeing, xi_pipe.retired_capacity * sizeof(SDL_Surface*));
+        if (!freeing) return 0;
+        xi_pipe.freeing = freeing;
+        xi_pipe.freeing_capacity = xi_pipe.retired_capacity;
+    }
+    int count = 0, kept = 0;
+    for (int i = 0; i < xi_pipe.retired_count; ++i) {
+        if (xi_pipe.retired[i].seq < oldest) xi_pipe.freeing[count++] = xi_pipe.retired[i].surface;
+        else xi_pipe.retired[kept++] = xi_pipe.retired[i];
+    }
+    xi_pipe.retired_count = kept;
+    return count;
+}
+
+// Render thread: a window's textures, window copy and renderer
+static void xi_release_render_window(xi_RenderWindow *w) {
+    for (int i = 0; i < w->surface_count; ++i) {
+        SDL_Texture **textures = w->surfaces[i]->userdata;
+        SDL_DestroyTexture(textures[w->slot]);
+        textures[w->slot] = NULL;
+    }
+    w->surface_count = 0;
+    if (w->screen) SDL_DestroyTexture(w->screen);
+    if (w->renderer) SDL_DestroyRenderer(w->renderer);
+    w->renderer = NULL;
+    w->screen = NULL;
+}
+
+// Render thread: the window's size in pixels over its size in units
+static void xi_publish_scale(xi_RenderWindow *w, int pixel_w) {
+    int window_w, window_h;
+    SDL_GetWindowSize(w->window, &window_w, &window_h);
+    SDL_LockMutex(xi_pipe.lock);
+    w->output_scale = window_w > 0 && pixel_w > 0 ? (float)pixel_w / window_w : 1.0f;
+    SDL_UnlockMutex(xi_pipe.lock);
+}
+
+// Render thread: a list that can't be drawn over the last frame; ask for a full one
+static bool xi_refuse_list(xi_RenderWindow *w) {
+    SDL_AtomicSet(&w->need_full, 1);
+    SDL_Event event = {0};
+    event.type = xi_wake_event;
+    SDL_PushEvent(&event);
+    return false;
+}
+
+// Render thread: play a list back into the window copy and present it. Returns false
+// when it was dropped.
+static bool xi_play_list(xi_RenderWindow *w, const xi_DisplayList *list) {
+    SDL_Renderer *renderer = w->renderer;
+    int width, height;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+    xi_publish_scale(w, width);
+    if (w->screen && (width != w->screen_width || height != w->screen_height)) {
+        SDL_DestroyTexture(w->screen);
+        w->screen = NULL;
+    }
+    if (!w->screen && !SDL_AtomicGet(&w->no_screen)) {
+        w->screen = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!w->screen) {
+            SDL_Log("No window copy, drawing full frames: %s", SDL_GetError());
+            SDL_AtomicSet(&w->no_screen, 1);
+        }
+        w->screen_width = width;
+        w->screen_height = height;
+        if (!list->full) return xi_refuse_list(w);  // nothing to draw over
+    }
+    if (!w->screen && !list->full) return xi_refuse_list(w);
+
+    SDL_SetRenderTarget(renderer, w->screen);
+    SDL_RenderSetScale(renderer, list->scale, list->scale);
+    SDL_RenderSetClipRect(renderer, NULL);
+    for (int i = 0; i < list->count; ++i) {
+        const xi_DrawCmd *cmd = &list->cmds[i];
+        const int *p = cmd->u.points;
+        switch (cmd->op) {
+            case XI_CMD_CLEAR:
+                SDL_SetRenderDrawColor(renderer, cmd->color.r, cmd->color.g, cmd->color.b, cmd->color.a);
+                SDL_RenderClear(renderer);
+                break;
+            case XI_CMD_RECT: xi_gpu_rect(renderer, cmd->u.rect, cmd->color, cmd->type); break;
+            case XI_CMD_CIRCLE: xi_gpu_circle(renderer, p[0], p[1], p[2], cmd->color, cmd->type); break;
+            case XI_CMD_TRIANGLE: xi_gpu_triangle(renderer, p, cmd->color, cmd->type); break;
+            case XI_CMD_SURFACE: {
+                SDL_Texture *texture = xi_surface_texture(w, cmd->u.surface.surface);
+                if (texture) SDL_RenderCopyF(renderer, texture, NULL, &cmd->u.surface.dst);
+                break;
+            }
+            case XI_CMD_GEOMETRY: {
+                const SDL_Vertex *vertices = (const SDL_Vertex*)(list->data + cmd->u.geometry.offset);
+                const int *indices = (const int*)(vertices + cmd->u.geometry.vertex_count);
+                SDL_Surface *surface = cmd->u.geometry.surface;
+                SDL_Texture *texture = surface ? xi_surface_texture(w, surface) : NULL;
+                if (surface && !texture) break;
+                SDL_RenderGeometry(renderer, texture, vertices, cmd->u.geometry.vertex_count, indices, cmd->u.geometry.index_count);
+                break;
+            }
+            case XI_CMD_CLIP: SDL_RenderSetClipRect(renderer, &cmd->u.rect); break;
+            case XI_CMD_NO_CLIP: SDL_RenderSetClipRect(renderer, NULL); break;
+        }
+    }
+    if (w->screen) {
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderSetScale(renderer, list->scale, list->scale);
+        SDL_RenderSetClipRect(renderer, NULL);
+        SDL_RenderCopy(renderer, w->screen, NULL, NULL);
+    }
+    SDL_RenderPresent(renderer);  // may wait for vsync; the UI thread goes on
+    return true;
+}
+
+static int xi_render_thread(void *data) {
+    (void)data;
+    SDL_LockMutex(xi_pipe.lock);
+    for (;;) {
+        if (xi_pipe.open) {
+            xi_RenderWindow *w = xi_pipe.open;
+            SDL_UnlockMutex(xi_pipe.lock);
+            w->renderer = SDL_CreateRenderer(w->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            if (w->renderer) {
+                int pixel_w;
+                SDL_GetRendererOutputSize(w->renderer, &pixel_w, NULL);
+                xi_publish_scale(w, pixel_w);
+            } else {
+                SDL_Log("Failed to create renderer on the render thread: %s", SDL_GetError());
+            }
+            SDL_LockMutex(xi_pipe.lock);
+            if (w->renderer) xi_pipe.windows[w->slot] = w;
+            xi_pipe.open = NULL;
+            SDL_CondBroadcast(xi_pipe.done);
+            continue;
+        }
+        if (xi_pipe.close) {
+            xi_RenderWindow *w = xi_pipe.close;
+            xi_pipe.windows[w->slot] = NULL;  // its lists are dropped
+            xi_release_render_window(w);
+            xi_pipe.close = NULL;
+            SDL_CondBroadcast(xi_pipe.done);
+            continue;
+        }
+
+        int count = xi_collect_retired();
+        if (count > 0) {
+            SDL_UnlockMutex(xi_pipe.lock);
+            for (int i = 0; i < count; ++i) xi_free_retired(xi_pipe.freeing[i]);
+            SDL_LockMutex(xi_pipe.lock);
+            continue;
+        }
+
+        // The oldest finished list of any window
+        xi_RenderWindow *owner = NULL;
+        xi_DisplayList *list = NULL;
+        for (int slot = 0; slot < XI_MAX_WINDOWS; ++slot) {
+            xi_RenderWindow *w = xi_pipe.windows[slot];
+            for (int i = 0; w && i < w->buffers; ++i) {
+                xi_DisplayList *l = &w->lists[i];
+                if (l->state == XI_LIST_READY && (!list || l->seq < list->seq)) {
+                    list = l;
+                    owner = w;
+                }
+            }
+        }
+        if (list) {
+            list->state = XI_LIST_DRAWING;
+            SDL_UnlockMutex(xi_pipe.lock);
+            bool presented = xi_play_list(owner, list);
+            SDL_LockMutex(xi_pipe.lock);
+            list->state = XI_LIST_FREE;
+            if (presented) xi_render_stats.frames_presented++;
+            continue;
+        }
+        if (xi_pipe.stop) break;
+        SDL_CondWait(xi_pipe.work, xi_pipe.lock);
+    }
+    SDL_UnlockMutex(xi_pipe.lock);
+    return 0;
+}
+
+// Carry out an open or close request on the render thread and wait for it
+static void xi_render_request(xi_RenderWindow **request, xi_RenderWindow *w) {
+    SDL_LockMutex(xi_pipe.lock);
+    *request = w;
+    SDL_CondSignal(xi_pipe.work);
+    while (*request) SDL_CondWait(xi_pipe.done, xi_pipe.lock);
+    SDL_UnlockMutex(xi_pipe.lock);
+}
+
+// Give a window to the render thread, starting it if needed. False: draw on the UI thread.
+static bool xi_open_render_window(xi_Context *context) {
+    if (!xi_pipe.thread) {
+        xi_pipe.lock = SDL_CreateMutex();
+        xi_pipe.work = SDL_CreateCond();
+        xi_pipe.done = SDL_CreateCond();
+        xi_pipe.stop = false;
+        if (xi_pipe.lock && xi_pipe.work && xi_pipe.done) {
+            xi_pipe.thread = SDL_CreateThread(xi_render_thread, "xi_render", NULL);
+        }
+        if (!xi_pipe.thread) {
+            SDL_Log("Failed to start the render thread: %s", SDL_GetError());
+            return false;
+        }
+    }
+    xi_RenderWindow *w = SDL_calloc(1, sizeof(xi_RenderWindow));
+    if (!w) return false;
+    w->slot = context->slot;
+    w->window = context->window;
+    w->buffers = xi_pipe.buffers;
+    w->output_scale = 1.0f;
+    xi_render_request(&xi_pipe.open, w);
+    if (!w->renderer) {
+        SDL_free(w);
+        return false;
+    }
+    context->pipe = w;
+    return true;
+}
+
+static void xi_close_render_window(xi_Context *context) {
+    xi_RenderWindow *w = context->pipe;
+    xi_render_request(&xi_pipe.close, w);
+    for (int i = 0; i < XI_MAX_DISPLAY_LISTS; ++i) {
+        SDL_free(w->lists[i].cmds);
+        SDL_free(w->lists[i].data);
+    }
+    SDL_free(w->surfaces);
+    SDL_free(w);
+    context->pipe = NULL;
+}
+
+// Finish what is queued, free the retired surfaces and end the render thread
+static void xi_stop_render_thread(void) {
+    if (!xi_pipe.thread) return;
+    SDL_LockMutex(xi_pipe.lock);
+    xi_pipe.stop = true;
+    SDL_CondSignal(xi_pipe.work);
+    SDL_UnlockMutex(xi_pipe.lock);
+    SDL_WaitThread(xi_pipe.thread, NULL);
+    xi_pipe.thread = NULL;
+    for (int i = 0; i < xi_pipe.retired_count; ++i) xi_free_retired(xi_pipe.retired[i].surface);
+    SDL_free(xi_pipe.retired);
+    SDL_free(xi_pipe.freeing);
+    xi_pipe.retired = NULL;
+    xi_pipe.freeing = NULL;
+    xi_pipe.retired_count = xi_pipe.retired_capacity = xi_pipe.freeing_capacity = 0;
+    SDL_DestroyCond(xi_pipe.work);
+    SDL_DestroyCond(xi_pipe.done);
+    SDL_DestroyMutex(xi_pipe.lock);
+}
+
+// Current window's scale as the render thread last saw it
+static float xi_pipe_scale(void) {
+    SDL_LockMutex(xi_pipe.lock);
+    float scale = xi_current->pipe->output_scale;
+    SDL_UnlockMutex(xi_pipe.lock);
+    return scale;
+}
+
+// Take a free list of the current window to build the frame into. NULL when all are
+// in use: the frame is skipped and its changes wait for the next one.
+static xi_DisplayList *xi_begin_display_list(void) {
+    xi_RenderWindow *w = xi_current->pipe;
+    xi_DisplayList *list = NULL;
+    SDL_LockMutex(xi_pipe.lock);
+    for (int i = 0; i < w->buffers && !list; ++i) {
+        if (w->lists[i].state == XI_LIST_FREE) list = &w->lists[i];
+    }
+    if (list) {
+        list->state = XI_LIST_BUILDING;
+        list->seq = ++xi_pipe.seq;
+    } else {
+        xi_render_stats.frames_skipped++;
+    }
+    SDL_UnlockMutex(xi_pipe.lock);
+    if (!list) return NULL;
+    list->count = 0;
+    list->data_used = 0;
+    list->scale = xi_current->scale;
+    xi_recording = list;
+    return list;
+}
+
+static void xi_submit_display_list(xi_DisplayList *list) {
+    xi_recording = NULL;
+    SDL_LockMutex(xi_pipe.lock);
+    list->state = XI_LIST_READY;
+    xi_render_stats.frames_built++;
+    SDL_CondSignal(xi_pipe.work);
+    SDL_UnlockMutex(xi_pipe.lock);
+}
+
+/// ============================ PARALLEL BUILD ============================
+/*
+ Big screens spend most of a frame measuring, arranging and drawing their top-level
+ containers, which don't depend on each other. With a pool of build threads those
+ subtrees are handled at the same time:
+
+    xi_UseParallelBuild(SDL_GetCPUCount());   // threads, counting the UI thread; 0: off
+
+ Layout splits after the root: each dirty child of xi_root is measured as a task, the
+ root then places its children and each one that moved or changed is arranged as a
+ task. In pipelined mode (xi_UsePipelinedRendering) drawing splits the same way: each
+ visible child of the root records into a command buffer of its own and the buffers
+ are appended to the frame's display list in sibling (z) order, giving exactly the
+ list the UI thread would have built alone.
+
+ Tasks are dealt out in contiguous runs, one per thread, and a thread that runs out
+ steals from the end of another's run. The UI thread works on its own run and waits
+ for the rest. Each thread measures text with fonts it opened itself; the shared caches
+ (rendered strings, images) take a lock while tasks run. Callbacks of widgets under
+ different top-level containers (a table's cell text) may run at the same time.
+*/
+#define XI_MAX_BUILD_THREADS 16
+
+typedef struct {
+    xi_Node *node;
+    xi_Node *end;               // drawing: node and its siblings up to this one
+    SDL_Rect slot;              // arranging: where its parent put it
+    xi_DisplayList buffer;      // drawing: the subtrees' commands
+    bool redraw;                // its layout moved something
+} xi_BuildTask;
+
+typedef struct {
+    SDL_SpinLock lock;
+    int head, tail;             // tasks not taken yet; the owner takes from the head
+} xi_TaskRun;
+
+// Each thread measures text with fonts of its own, so layout tasks don't queue on a lock
+#define XI_BUILD_FONTS 8
+
+typedef struct {
+    const char *path;
+    struct { int size; TTF_Font *font; } fonts[XI_BUILD_FONTS];
+    int count, next;
+} xi_ThreadFonts;
+
+static struct {
+    int threads;                // build threads besides the UI thread
+    SDL_Thread *handles[XI_MAX_BUILD_THREADS];
+    xi_Arena arenas[XI_MAX_BUILD_THREADS];
+    xi_TaskRun runs[XI_MAX_BUILD_THREADS + 1];  // one per thread, the UI thread's last
+    xi_ThreadFonts fonts[XI_MAX_BUILD_THREADS + 1];
+    SDL_mutex *lock;
+    SDL_cond *start, *finished;
+    Uint32 phase;               // bumped to start one
+    int busy;                   // build threads still in it
+    bool quit;
+    SDL_mutex *shared;          // held around shared caches while a phase runs
+    bool running;
+    void (*run)(xi_BuildTask *task);
+    xi_BuildTask *tasks;
+    int task_count, task_capacity;
+    xi_Node *deferred_parent;   // arranging: children of this node become tasks
+    SDL_Rect clip_limit;        // drawing: the frame's, for every task
+} xi_build;
+
+static XI_THREAD_LOCAL xi_ThreadFonts *xi_thread_fonts;  // while this thread runs tasks
+
+// Around fonts, strings and images: only locks while tasks run on several threads
+static void xi_lock_shared(void) {
+    if (xi_build.running) SDL_LockMutex(xi_build.shared);
+}
+
+static void xi_unlock_shared(void) {
+    if (xi_build.running) SDL_UnlockMutex(xi_build.shared);
+}
+
+static xi_BuildTask *xi_take_task(int self) {
+    int parts = xi_build.threads + 1;
+    for (int k = 0; k < parts; ++k) {
+        xi_TaskRun *run = &xi_build.runs[(self + k) % parts];
+        int index = -1;
+        SDL_AtomicLock(&run->lock);
+        if (run->head < run->tail) index = k == 0 ? run->head++ : --run->tail;  // steal from the end
+        SDL_AtomicUnlock(&run->lock);
+        if (index >= 0) return &xi_build.tasks[index];
+    }
+    return NULL;
+}
+
+static void xi_work_on_phase(int self) {
+    xi_BuildTask *task;
+    xi_thread_fonts = &xi_build.fonts[self];
+    while ((task = xi_take_task(self))) {
+        xi_task_redraw = &task->redraw;
+        xi_build.run(task);
+        xi_task_redraw = NULL;
+    }
+    xi_thread_fonts = NULL;
+}
+
+static void xi_close_thread_fonts(xi_ThreadFonts *fonts) {
+    for (int i = 0; i < fonts->count; ++i) TTF_CloseFont(fonts->fonts[i].font);
+    fonts->count = fonts->next = 0;
+}
+
+static int xi_build_thread(void *data) {
+    int self = (int)(intptr_t)data;
+    xi_thread_arena = &xi_build.arenas[self];
+    Uint32 seen = 0;
+    SDL_LockMutex(xi_build.lock);
+    for (;;) {
+        while (xi_build.phase == seen && !xi_build.quit) SDL_CondWait(xi_build.start, xi_build.lock);
+        if (xi_build.quit) break;
+        seen = xi_build.phase;
+        SDL_UnlockMutex(xi_build.lock);
+        xi_work_on_phase(self);
+        SDL_LockMutex(xi_build.lock);
+        if (--xi_build.busy == 0) SDL_CondSignal(xi_build.finished);
+    }
+    SDL_UnlockMutex(xi_build.lock);
+    return 0;
+}
+
+static void xi_stop_build_threads(void) {
+    if (!xi_build.lock) return;
+    SDL_LockMutex(xi_build.lock);
+    xi_build.quit = true;
+    SDL_CondBroadcast(xi_build.start);
+    SDL_UnlockMutex(xi_build.lock);
+    for (int i = 0; i < xi_build.threads; ++i) {
+        SDL_WaitThread(xi_build.handles[i], NULL);
+        xi_reset_arena(&xi_build.arenas[i]);
+        SDL_free(xi_build.arenas[i].base);
+        xi_build.arenas[i] = (xi_Arena){0};
+    }
+    for (int i = 0; i <= xi_build.threads; ++i) xi_close_thread_fonts(&xi_build.fonts[i]);
+    xi_build.threads = 0;
+    for (int i = 0; i < xi_build.task_capacity; ++i) {
+        SDL_free(xi_build.tasks[i].buffer.cmds);
+        SDL_free(xi_build.tasks[i].buffer.data);
+    }
+    SDL_free(xi_build.tasks);
+    xi_build.tasks = NULL;
+    xi_build.task_count = xi_build.task_capacity = 0;
+    SDL_DestroyCond(xi_build.start);
+    SDL_DestroyCond(xi_build.finished);
+    SDL_DestroyMutex(xi_build.lock);
+    SDL_DestroyMutex(xi_build.shared);
+    xi_build.start = xi_build.finished = NULL;
+    xi_build.lock = xi_build.shared = NULL;
+}
+
+// Lay out and draw top-level subtrees on `threads` threads, the UI thread included
+// (0 or 1: all on the UI thread, the default). Call from the UI thread between frames.
+void xi_UseParallelBuild(int threads) {
+    xi_stop_build_threads();
+    if (threads > XI_MAX_BUILD_THREADS + 1) threads = XI_MAX_BUILD_THREADS + 1;
+    if (threads < 2) return;
+    xi_build.lock = SDL_CreateMutex();
+    xi_build.shared = SDL_CreateMutex();
+    xi_build.start = SDL_CreateCond();
+    xi_build.finished = SDL_CreateCond();
+    if (!xi_build.lock || !xi_build.shared || !xi_build.start || !xi_build.finished) {
+        SDL_Log("Failed to create build thread locks: %s", SDL_GetError());
+        xi_stop_build_threads();
+        return;
+    }
+    xi_build.quit = false;
+    xi_build.phase = 0;
+    for (int i = 0; i < threads - 1; ++i) {
+        SDL_Thread *thread = SDL_CreateThread(xi_build_thread, "xi build", (void*)(intptr_t)i);
+        if (!thread) {
+            SDL_Log("Failed to start build thread: %s", SDL_GetError());
+            break;
+        }
+        xi_build.handles[xi_build.threads++] = thread;
+    }
+}
+
+static xi_BuildTask *xi_add_task(xi_Node *node) {
+    if (xi_build.task_count == xi_build.task_capacity) {
+        int capacity = xi_build.task_capacity ? xi_build.task_capacity * 2 : 32;
+        xi_BuildTask *tasks = SDL_realloc(xi_build.tasks, capacity * sizeof(xi_BuildTask));
+        if (!tasks) return NULL;
+        memset(tasks + xi_build.task_capacity, 0, (capacity - xi_build.task_capacity) * sizeof(xi_BuildTask));
+        xi_build.tasks = tasks;
+        xi_build.task_capacity = capacity;
+    }
+    xi_BuildTask *task = &xi_build.tasks[xi_build.task_count++];
+    task->node = node;
+    task->end = node->next_sibling;
+    task->redraw = false;
+    return task;
+}
+
+// Run fn on every task, spread over the build threads; returns once all are done.
+// True if any task's layout asked for a full frame.
+static bool xi_run_tasks(void (*fn)(xi_BuildTask *task)) {
+    int count = xi_build.task_count, parts = xi_build.threads + 1;
+    for (int i = 0; i < parts; ++i) {
+        xi_build.runs[i].head = (int)((Sint64)count * i / parts);
+        xi_build.runs[i].tail = (int)((Sint64)count * (i + 1) / parts);
+    }
+    SDL_LockMutex(xi_build.lock);
+    xi_build.run = fn;
+    xi_build.running = true;
+    xi_build.busy = xi_build.threads;
+    xi_build.phase++;
+    SDL_CondBroadcast(xi_build.start);
+    SDL_UnlockMutex(xi_build.lock);
+
+    xi_work_on_phase(parts - 1);
+
+    SDL_LockMutex(xi_build.lock);
+    while (xi_build.busy > 0) SDL_CondWait(xi_build.finished, xi_build.lock);
+    xi_build.running = false;
+    SDL_UnlockMutex(xi_build.lock);
+
+    bool redraw = false;
+    for (int i = 0; i < count; ++i) redraw = redraw || xi_build.tasks[i].redraw;
+    return redraw;
+}
+
+static void xi_measure_task(xi_BuildTask *task) {
+    xi_measure(task->node);
+}
+
+static void xi_arrange_task(xi_BuildTask *task) {
+    xi_arrange(task->node, task->slot);
+}
+
+// xi_UpdateLayout for a root whose children can be laid out apart. False when there
+// are no build threads (or the root's own scroll state would be shared).
+static bool xi_parallel_layout(xi_Node *root, SDL_Rect window) {
+    if (xi_build.threads == 0 || root->scroll) return false;
+    xi_build.task_count = 0;
+    if (root->layout.measure_dirty) {
+        for (xi_Node *child = root->first_child; child; child = child->next_sibling) {
+            if (child->layout.measure_dirty && !xi_add_task(child)) break;
+        }
+    }
+    if (xi_build.task_count > 1 && xi_run_tasks(xi_measure_task)) xi_redraw = true;
+    xi_measure(root);  // only its own size is left to work out
+
+    // The root places its children here; their subtrees are arranged as tasks
+    xi_build.task_count = 0;
+    xi_build.deferred_parent = root;
+    xi_arrange(root, window);
+    xi_build.deferred_parent = NULL;
+    // With several tasks the root is flagged up front, so tasks marking their subtree
+    // never write to it
+    if (xi_build.task_count == 1) {
+        xi_arrange_task(&xi_build.tasks[0]);
+    } else if (xi_build.task_count > 1) {
+        root->child_bounds_dirty = true;
+        if (xi_run_tasks(xi_arrange_task)) xi_redraw = true;
+    }
+    return true;
+}
+
+// Called by xi_arrange for each child it places: under the root being laid out in
+// parallel, the child takes its place now and its subtree becomes a task
+static bool xi_defer_arrange(xi_Node *node, SDL_Rect slot) {
+    if (!node->parent || node->parent != xi_build.deferred_parent) return false;
+    xi_BuildTask *task = xi_add_task(node);
+    if (!task) return false;
+    task->slot = slot;
+    xi_set_geometry(node, slot.x, slot.y, slot.w, slot.h);  // the task then finds it in place
+    return true;
+}
+
+// Let go of what build threads took from their arenas this frame
+static void xi_reset_build_arenas(void) {
+    for (int i = 0; i < xi_build.threads; ++i) xi_reset_arena(&xi_build.arenas[i]);
+}
+
+/// ============================ DRAW FUNCTIONS ============================
+static void xi_DrawRect(SDL_Renderer *renderer, int x, int y, int width, int height, Color color, ShapeType type) {
+    if (xi_current->software) {
+        xi_soft_rect(x, y, width, height, color, type);
+        return;
+    }
+    SDL_Rect rect = {x - xi_origin_x, y - xi_origin_y, width, height};
+    if (xi_current->pipe) {
+        xi_record_shape(XI_CMD_RECT, &rect.x, 4, color, type);
+        return;
+    }
+    xi_gpu_rect(renderer, rect, color, type);
+}
+
+/*
+ Text drawing keeps its expensive parts around. Fonts are opened once per size, and
+ rendered strings stay in textures keyed by (text, size, color) until they are the
+ least recently drawn entry in a full cache. A frame that shows the same strings as
+ the last one does no font or surface work at all.
+
+ Fonts and rendered strings are shared by all windows. A texture belongs to one
+ renderer, so each entry keeps its rendered surface and makes a texture per window
+ the first time that window draws it.
+
+ Sizes in the cache are physical pixels: 16 units of text are rendered at 16 px in a
+ window at scale 1 and at 32 px in one at scale 2. Moving a window to a display with
+ another scale only rasterizes the sizes that display hasn't used yet.
+*/
+#define XI_FONT_CACHE_SIZE 16  // sizes are in pixels, so each display scale needs its own
+#define XI_TEXT_CACHE_SIZE 512
+#define XI_TEXT_BUCKETS 1024  // power of two
+
+typedef struct {
+    int size;
+    TTF_Font *font;
+} xi_FontEntry;
+
+typedef struct {
+    char *text;             // NULL when the entry is free
+    Uint32 hash;
+    int size;
+    Color color;
+    SDL_Surface *surface;                  // the rasterized string, shared by all windows
+    SDL_Texture *textures[XI_MAX_WINDOWS]; // made from it, per window context slot
+    int width, height;
+    Uint32 last_used;
+    int next;               // next entry in the same bucket, plus one (0 ends the chain)
+} xi_TextEntry;
+
+static xi_FontEntry xi_fonts[XI_FONT_CACHE_SIZE];
+static int xi_font_count = 0, xi_font_next = 0;
+static const char *xi_font_cache_path = NULL;
+
+static xi_TextEntry xi_text_cache[XI_TEXT_CACHE_SIZE];
+static int xi_text_buckets[XI_TEXT_BUCKETS];  // first entry of each chain, plus one
+static int xi_text_count = 0;
+static Uint32 xi_text_clock = 0;
+
+static void xi_free_text_entry(xi_TextEntry *entry) {
+    SDL_free(entry->text);
+    xi_release_surface(entry->surface);  // lists waiting to be drawn may show it
+    for (int w = 0; w < XI_MAX_WINDOWS; ++w) {
+        if (entry->textures[w]) SDL_DestroyTexture(entry->textures[w]);
+        entry->textures[w] = NULL;
+    }
+}
+
+// Drop one window's string textures before its renderer goes away
+static void xi_drop_window_text(int slot) {
+    for (int i = 0; i < xi_text_count; ++i) {
+        if (xi_text_cache[i].textures[slot]) SDL_DestroyTexture(xi_text_cache[i].textures[slot]);
+        xi_text_cache[i].textures[slot] = NULL;
+    }
+}
+
+// Drop every cached string texture and font, e.g. before the renderer goes away
+void xi_ClearTextCache(void) {
+    for (int i = 0; i < xi_text_count; ++i) {
+        xi_free_text_entry(&xi_text_cache[i]);
+    }
+    xi_text_count = 0;
+    memset(xi_text_buckets, 0, sizeof(xi_text_buckets));
+    for (int i = 0; i < xi_font_count; ++i) {
+        TTF_CloseFont(xi_fonts[i].font);
+    }
+    xi_font_count = xi_font_next = 0;
+}
+
+static TTF_Font *xi_get_font(int size) {
+    if (xi_font_cache_path != xi_fontpath) {
+        xi_ClearTextCache();  // glyphs of another font are no use
+        xi_font_cache_path = xi_fontpath;
+    }
+    for (int i = 0; i < xi_font_count; ++i) {
+        if (xi_fonts[i].size == size) return xi_fonts[i].font;
+    }
+
+    TTF_Font *font = TTF_OpenFont(xi_fontpath, size);
+    if (!font) {
+        SDL_Log("Failed to load font '%s': %s", xi_fontpath, TTF_GetError());
+        return NULL;
+    }
+    int slot;
+    if (xi_font_count < XI_FONT_CACHE_SIZE) {
+        slot = xi_font_count++;
+    } else {
+        slot = xi_font_next;  // replace the oldest; its string textures stay valid
+        xi_font_next = (xi_font_next + 1) % XI_FONT_CACHE_SIZE;
+        TTF_CloseFont(xi_fonts[slot].font);
+    }
+    xi_fonts[slot].size = size;
+    xi_fonts[slot].font = font;
+    return font;
+}
+
+static Uint32 xi_text_hash(const char *text, int size, Color color) {
+    Uint32 hash = 2166136261u;  // FNV-1a
+    for (const unsigned char *c = (const unsigned char*)text; *c; ++c) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    hash = (hash ^ (Uint32)size) * 16777619u;
+    hash = (hash ^ ((Uint32)color.r | (Uint32)color.g << 8 | (Uint32)color.b << 16 | (Uint32)color.a << 24)) * 16777619u;
+    return hash;
+}
+
+static void xi_unlink_text(int index) {
+    int *link = &xi_text_buckets[xi_text_cache[index].hash & (XI_TEXT_BUCKETS - 1)];
+    while (*link != index + 1) link = &xi_text_cache[*link - 1].next;
+    *link = xi_text_cache[index].next;
+}
+
+// Font size in pixels for a size in logical units
+static int xi_pixel_size(int size, float scale) {
+    int pixels = (int)(size * scale + 0.5f);
+    return pixels > 0 ? pixels : 1;
+}
+
+// Slot of the window context drawing with renderer (offscreen targets count as their window's)
+static int xi_renderer_slot(SDL_Renderer *renderer) {
+    if (renderer == xi_current->renderer) return xi_current->slot;
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        if (xi_contexts[i] && xi_contexts[i]->renderer == renderer) return i;
+    }
+    return -1;
+}
+
+// Texture of a cached string for one window, made from the shared surface on first use
+static SDL_Texture *xi_text_texture(xi_TextEntry *entry, SDL_Renderer *renderer, int slot) {
+    if (!entry->textures[slot]) {
+        entry->textures[slot] = SDL_CreateTextureFromSurface(renderer, entry->surface);
+        if (!entry->textures[slot]) SDL_Log("Failed to create text texture: %s", SDL_GetError());
+    }
+    return entry->textures[slot];
+}
+
+// Cached rendering of a string, rasterizing it on a miss
+static xi_TextEntry *xi_get_text(const char *text, int size, Color color) {
+    Uint32 hash = xi_text_hash(text, size, color);
+    for (int i = xi_text_buckets[hash & (XI_TEXT_BUCKETS - 1)]; i; i = xi_text_cache[i - 1].next) {
+        xi_TextEntry *entry = &xi_text_cache[i - 1];
+        if (entry->hash == hash && entry->size == size && entry->color.r == color.r &&
+            entry->color.g == color.g && entry->color.b == color.b && entry->color.a == color.a &&
+            strcmp(entry->text, text) == 0) {
+            entry->last_used = ++xi_text_clock;
+            return entry;
+        }
+    }
+
+    TTF_Font *font = xi_get_font(size);
+    if (!font) return NULL;
+
+    SDL_Color sdlColor = {color.r, color.g, color.b, color.a};
+    SDL_Surface *textSurface = TTF_RenderText_Blended(font, text, sdlColor);
+    if (!textSurface) {
+        SDL_Log("Failed to create text surface: %s", TTF_GetError());
+        return NULL;
+    }
+    if (textSurface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        // The software rasterizer blends ARGB8888 rows (older SDL_ttf returns other layouts)
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(textSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(textSurface);
+        if (!converted) {
+            SDL_Log("Failed to convert text surface: %s", SDL_GetError());
+            return NULL;
+        }
+        textSurface = converted;
+    }
+
+    // Take a free entry, or evict the least recently drawn one
+    int index = xi_text_count;
+    if (xi_text_count < XI_TEXT_CACHE_SIZE) {
+        xi_text_count++;
+    } else {
+        index = 0;
+        for (int i = 1; i < XI_TEXT_CACHE_SIZE; ++i) {
+            if (xi_text_cache[i].last_used < xi_text_cache[index].last_used) index = i;
+        }
+        xi_unlink_text(index);
+        xi_free_text_entry(&xi_text_cache[index]);
+    }
+
+    xi_TextEntry *entry = &xi_text_cache[index];
+    entry->text = SDL_strdup(text);
+    entry->hash = hash;
+    entry->size = size;
+    entry->color = color;
+    entry->surface = textSurface;
+    entry->width = textSurface->w;
+    entry->height = textSurface->h;
+    entry->last_used = ++xi_text_clock;
+    int bucket = hash & (XI_TEXT_BUCKETS - 1);
+    entry->next = xi_text_buckets[bucket];
+    xi_text_buckets[bucket] = index + 1;
+    return entry;
+}
+
+static bool xi_sdf_draw(SDL_Renderer *renderer, const char *text, int x, int y, Color color, int size);  // SDF text
+static bool xi_sdf_measure(const char *text, int size, int *width, int *height);
+
+void xi_DrawText(SDL_Renderer *renderer, const char *text, int x, int y, Color color, int fontSize) {
+    if (!renderer && !xi_current->software && !xi_current->pipe) {
+        SDL_Log("Renderer is NULL");
+        return;
+    }
+
+    if (!xi_fontpath || xi_fontpath[0] == '\0') {
+        SDL_Log("Font path is not set");
+        return;
+    }
+
+    if (fontSize <= 0) {
+        SDL_Log("Invalid font size: %d", fontSize);
+        return;
+    }
+
+    if (!text) {
+        SDL_Log("Text is NULL");
+        return;
+    }
+
+    if (text[0] == '\0') return;  // SDL_ttf can't render an empty string
+    if (xi_sdf_draw(renderer, text, x, y, color, fontSize)) return;
+
+    if (xi_current->software) {
+        xi_TextEntry *entry = xi_get_text(text, xi_pixel_size(fontSize, xi_current->scale), color);
+        if (entry) {
+            SDL_Rect dst = {xi_soft_px(x - xi_origin_x), xi_soft_px(y - xi_origin_y), entry->width, entry->height};
+            xi_soft_blit(entry->surface, dst);
+        }
+        return;
+    }
+    if (xi_current->pipe) {
+        float scale = xi_current->scale;
+        xi_lock_shared();
+        xi_TextEntry *entry = xi_get_text(text, xi_pixel_size(fontSize, scale), color);
+        if (entry) {
+            SDL_FRect dst = {(float)(x - xi_origin_x), (float)(y - xi_origin_y), entry->width / scale, entry->height / scale};
+            xi_record_surface(entry->surface, dst);  // outlives the entry until the list is drawn
+        }
+        xi_unlock_shared();
+        return;
+    }
+
+    int slot = xi_renderer_slot(renderer);
+    if (slot < 0) {
+        SDL_Log("Renderer doesn't belong to a window");
+        return;
+    }
+    // Rasterize at the window's pixel size and map the texture 1:1 onto its pixels
+    float scale = xi_contexts[slot]->scale;
+    xi_TextEntry *entry = xi_get_text(text, xi_pixel_size(fontSize, scale), color);
+    if (!entry) return;
+    SDL_Texture *texture = xi_text_texture(entry, renderer, slot);
+    if (!texture) return;
+
+    SDL_FRect destRect = {(float)(x - xi_origin_x), (float)(y - xi_origin_y), entry->width / scale, entry->height / scale};
+    if (SDL_RenderCopyF(renderer, texture, NULL, &destRect) != 0) {
+        SDL_Log("Failed to render text: %s", SDL_GetError());
+    }
+}
+
+// Font of this build thread for measuring; opened (and replaced) under the shared lock
+static TTF_Font *xi_thread_font(int size) {
+    xi_ThreadFonts *fonts = xi_thread_fonts;
+    if (fonts->path != xi_fontpath) {
+        xi_lock_shared();
+        xi_close_thread_fonts(fonts);
+        xi_unlock_shared();
+        fonts->path = xi_fontpath;
+    }
+    for (int i = 0; i < fonts->count; ++i) {
+        if (fonts->fonts[i].size == size) return fonts->fonts[i].font;
+    }
+    xi_lock_shared();
+    TTF_Font *font = TTF_OpenFont(xi_fontpath, size);
+    if (font && fonts->count == XI_BUILD_FONTS) TTF_CloseFont(fonts->fonts[fonts->next].font);
+    xi_unlock_shared();
+    if (!font) {
+        SDL_Log("Failed to load font '%s': %s", xi_fontpath, TTF_GetError());
+        return NULL;
+    }
+    int slot;
+    if (fonts->count < XI_BUILD_FONTS) {
+        slot = fonts->count++;
+    } else {
+        slot = fonts->next;  // replace the oldest
+        fonts->next = (fonts->next + 1) % XI_BUILD_FONTS;
+    }
+    fonts->fonts[slot].size = size;
+    fonts->fonts[slot].font = font;
+    return font;
+}
+
+// Size text would take when drawn with xi_DrawText; returns false if it can't be measured
+bool xi_MeasureText(const char *text, int fontSize, int *width, int *height) {
+    *width = *height = 0;
+    if (!text || fontSize <= 0 || !xi_fontpath || xi_fontpath[0] == '\0') return false;
+    xi_lock_shared();
+    bool sdf = xi_sdf_measure(text, fontSize, width, height);  // the same at every scale
+    xi_unlock_shared();
+    if (sdf) return true;
+
+    // Measured at the size it will be drawn at, in logical units rounded up
+    float scale = xi_current->scale;
+    int pixels = xi_pixel_size(fontSize, scale);
+    TTF_Font *font = xi_thread_fonts ? xi_thread_font(pixels) : xi_get_font(pixels);
+    if (!font) return false;
+    if (TTF_SizeText(font, text, width, height) != 0) return false;
+    *width = (int)SDL_ceilf(*width / scale);
+    *height = (int)SDL_ceilf(*height / scale);
+    return true;
+}
+
+
+static void xi_DrawCircle(SDL_Renderer *renderer, int x, int y, int radius, Color color, ShapeType type) {
+    if (xi_current->software) {
+        xi_soft_circle(x, y, radius, color, type);
+        return;
+    }
+    x -= xi_origin_x;
+    y -= xi_origin_y;
+    if (xi_current->pipe) {
+        int values[3] = {x, y, radius};
+        xi_record_shape(XI_CMD_CIRCLE, values, 3, color, type);
+        return;
+    }
+    xi_gpu_circle(renderer, x, y, radius, color, type);
+}
+
+static void xi_DrawTriangle(SDL_Renderer *renderer, int x1, int y1, int x2, int y2, int x3, int y3, Color color, ShapeType type) {
+    if (xi_current->software) {
+        xi_soft_triangle(x1, y1, x2, y2, x3, y3, color, type);
+        return;
+    }
+    int points[6] = {x1 - xi_origin_x, y1 - xi_origin_y, x2 - xi_origin_x, y2 - xi_origin_y,
+                     x3 - xi_origin_x, y3 - xi_origin_y};
+    if (xi_current->pipe) {
+        xi_record_shape(XI_CMD_TRIANGLE, points, 6, color, type);
+        return;
+    }
+    xi_gpu_triangle(renderer, points, color, type);
+}
+
+static void xi_ClearScreen(SDL_Renderer *renderer, Color color) {
+    if (xi_current->software) {
+        SDL_Surface *canvas = xi_current->canvas;
+        for (int y = 0; y < canvas->h; ++y) xi_soft.fill(xi_soft_row(y), canvas->w, xi_pack_color(color));
+        return;
+    }
+    if (xi_current->pipe) {
+        xi_DrawCmd *cmd = xi_record(XI_CMD_CLEAR);
+        if (cmd) cmd->color = color;
+        return;
+    }
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderClear(renderer);
+}
+
+/// ============================ SDF TEXT ============================
+/*
+ Text normally goes into the cache once per string, pixel size and color. Interfaces
+ that show text at many sizes (slider labels follow the slider's height, zoomable
+ views, windows on displays with different scales) can draw it from a signed distance
+ field instead:
+
+    xi_UseSDFText(true);     // before widgets are first measured
+
+ Each glyph is rasterized once, at XI_SDF_BASE px, into a shared 8-bit atlas that
+ holds the distance to the glyph's outline rather than its coverage. Every size is
+ drawn from that: one quad per glyph, and a pixel is covered as far as the distance
+ under it lies inside the outline, with a one-pixel ramp for antialiasing.
+
+ Software windows apply that threshold to every pixel. SDL renderers have no
+ programmable shading, so there it is applied when the atlas is uploaded, once per
+ octave of scale (1/4x to 8x the base size), and the GPU filters between atlas pixels.
+ Above the base size that filtering magnifies the thresholded atlas, so edges ramp
+ over about one atlas pixel: text at 4x-8x XI_SDF_BASE looks soft there, where software
+ windows stay sharp. On GPU windows it suits text near or below the base size best.
+ Either way a string is one batch from one texture. Glyphs that don't fit in the
+ atlas are drawn as ordinary text.
+*/
+#define XI_SDF_BASE 32      // px size glyphs are rasterized at
+#define XI_SDF_SPREAD 4     // px of distance kept on each side of the outline
+#define XI_SDF_ATLAS 512
+#define XI_SDF_LEVELS 6     // uploaded thresholds for 1/4x, 1/2x, 1x, 2x, 4x and 8x
+
+enum { XI_SDF_NEW, XI_SDF_READY, XI_SDF_MISSING };
+
+typedef struct {
+    Uint8 state;
+    Uint16 x, y, w, h;  // cell in the atlas: the glyph plus the spread on each side
+    float advance;      // at the base size
+} xi_SdfGlyph;
+
+static struct {
+    bool enabled;
+    const char *path;          // font the atlas was made from
+    Uint8 *atlas;              // XI_SDF_ATLAS^2 distances, 128 on the outline
+    xi_SdfGlyph glyphs[256];   // by byte, like TTF_RenderText
+    int shelf_x, shelf_y, shelf_h;
+    int line_height;           // at the base size
+    Uint32 generation;         // bumped whenever glyphs are added
+    SDL_Texture *textures[XI_MAX_WINDOWS][XI_SDF_LEVELS];
+    Uint32 uploaded[XI_MAX_WINDOWS][XI_SDF_LEVELS];  // generation each texture holds
+    int rasterized;            // glyphs made so far
+} xi_sdf;
+
+// Draw and measure text from the distance field atlas (true) or per size (false).
+// Large text is softer than per-size text in SDL renderer windows (see above).
+void xi_UseSDFText(bool enable) {
+    if (xi_sdf.enabled == enable) return;
+    xi_sdf.enabled = enable;
+    // Text measures differently each way, so every window lays out again
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        if (!xi_contexts[i]) continue;
+        xi_mark_tree_dirty(&xi_contexts[i]->root);
+        xi_mark_tree_dirty(&xi_contexts[i]->overlay);
+    }
+    xi_redraw_all();
+}
+
+// Drop one window's atlas textures before its renderer goes away
+static void xi_sdf_drop_window(int slot) {
+    for (int level = 0; level < XI_SDF_LEVELS; ++level) {
+        if (xi_sdf.textures[slot][level]) SDL_DestroyTexture(xi_sdf.textures[slot][level]);
+        xi_sdf.textures[slot][level] = NULL;
+        xi_sdf.uploaded[slot][level] = 0;
+    }
+}
+
+static void xi_sdf_free(void) {
+    for (int slot = 0; slot < XI_MAX_WINDOWS; ++slot) xi_sdf_drop_window(slot);
+    SDL_free(xi_sdf.atlas);
+    bool enabled = xi_sdf.enabled;
+    memset(&xi_sdf, 0, sizeof(xi_sdf));
+    xi_sdf.enabled = enabled;
+}
+
+// Coverage of a glyph pixel, 0 outside the surface
+static int xi_sdf_coverage(const SDL_Surface *glyph, int x, int y) {
+    if (x < 0 || y < 0 || x >= glyph->w || y >= glyph->h) return 0;
+    return ((const Uint32*)((const Uint8*)glyph->pixels + (size_t)y * glyph->pitch))[x] >> 24;
+}
+
+// Distance field of a rasterized glyph into its atlas cell. A partly covered pixel has
+// the outline inside it; any other pixel measures to the nearest pixel on the other
+// side, corrected by how far the outline reaches into that one.
+static void xi_sdf_encode(const SDL_Surface *glyph, int cell_x, int cell_y, int w, int h) {
+    const int spread = XI_SDF_SPREAD;
+    float lengths[2 * XI_SDF_SPREAD + 1][2 * XI_SDF_SPREAD + 1];
+    for (int dy = -spread; dy <= spread; ++dy) {
+        for (int dx = -spread; dx <= spread; ++dx) lengths[dy + spread][dx + spread] = SDL_sqrtf((float)(dx * dx + dy * dy));
+    }
+    for (int y = 0; y < h; ++y) {
+        Uint8 *out = xi_sdf.atlas + (size_t)(cell_y + y) * XI_SDF_ATLAS + cell_x;
+        for (int x = 0; x < w; ++x) {
+            int gx = x - spread, gy = y - spread;
+            int a = xi_sdf_coverage(glyph, gx, gy);
+            float distance;
+            if (a > 0 && a < 255) {
+                distance = a / 255.0f - 0.5f;
+            } else {
+                bool inside = a == 255;
+                distance = spread + 0.5f;
+                for (int dy = -spread; dy <= spread; ++dy) {
+                    for (int dx = -spread; dx <= spread; ++dx) {
+                        int b = xi_sdf_coverage(glyph, gx + dx, gy + dy);
+                        if (inside ? b == 255 : b == 0) continue;
+                        float d = lengths[dy + spread][dx + spread] + (inside ? b / 255.0f - 0.5f : 0.5f - b / 255.0f);
+                        if (d < distance) distance = d;
+                    }
+                }
+                if (!inside) distance = -distance;
+            }
+            int value = 128 + (int)SDL_floorf(distance * 127.0f / spread + 0.5f);
+            out[x] = (Uint8)(value < 0 ? 0 : value > 255 ? 255 : value);
+        }
+    }
+}
+
+// Room for a w x h cell on the current shelf, or a new one below it
+static bool xi_sdf_place(int w, int h, int *x, int *y) {
+    if (xi_sdf.shelf_x + w > XI_SDF_ATLAS) {
+        xi_sdf.shelf_y += xi_sdf.shelf_h;
+        xi_sdf.shelf_x = xi_sdf.shelf_h = 0;
+    }
+    if (w > XI_SDF_ATLAS || xi_sdf.shelf_y + h > XI_SDF_ATLAS) return false;
+    *x = xi_sdf.shelf_x;
+    *y = xi_sdf.shelf_y;
+    xi_sdf.shelf_x += w + 1;  // a gap so filtering never reaches the next glyph
+    if (h + 1 > xi_sdf.shelf_h) xi_sdf.shelf_h = h + 1;
+    return true;
+}
+
+// Atlas entry of a character, rasterizing it the first time; NULL if it can't be had
+static xi_SdfGlyph *xi_sdf_glyph(unsigned char c) {
+    xi_SdfGlyph *glyph = &xi_sdf.glyphs[c];
+    if (glyph->state != XI_SDF_NEW) return glyph->state == XI_SDF_READY ? glyph : NULL;
+    glyph->state = XI_SDF_MISSING;
+
+    TTF_Font *font = xi_get_font(XI_SDF_BASE);
+    int advance;
+    if (!font || TTF_GlyphMetrics(font, c, NULL, NULL, NULL, NULL, &advance) != 0) return NULL;
+    glyph->advance = (float)advance;
+
+    SDL_Surface *surface = TTF_RenderGlyph_Blended(font, c, (SDL_Color){255, 255, 255, 255});
+    if (!surface) {  // blank glyphs such as space only advance
+        glyph->state = XI_SDF_READY;
+        return glyph;
+    }
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(surface);
+        if (!converted) return NULL;
+        surface = converted;
+    }
+    int w = surface->w + 2 * XI_SDF_SPREAD, h = surface->h + 2 * XI_SDF_SPREAD, x, y;
+    if (!xi_sdf_place(w, h, &x, &y)) {
+        SDL_Log("SDF atlas is full, drawing '%c' as ordinary text", c);
+        SDL_FreeSurface(surface);
+        return NULL;
+    }
+    xi_sdf_encode(surface, x, y, w, h);
+    SDL_FreeSurface(surface);
+    glyph->x = (Uint16)x;
+    glyph->y = (Uint16)y;
+    glyph->w = (Uint16)w;
+    glyph->h = (Uint16)h;
+    glyph->state = XI_SDF_READY;
+    xi_sdf.generation++;
+    xi_sdf.rasterized++;
+    return glyph;
+}
+
+// Make the atlas for the current font, starting with printable ASCII so that most
+// interfaces upload it once
+static bool xi_sdf_prepare(void) {
+    if (xi_sdf.atlas && xi_sdf.path == xi_fontpath) return true;
+    xi_sdf_free();
+    TTF_Font *font = xi_get_font(XI_SDF_BASE);
+    if (!font) return false;
+    xi_sdf.atlas = SDL_calloc(XI_SDF_ATLAS, XI_SDF_ATLAS);
+    if (!xi_sdf.atlas) return false;
+    xi_sdf.path = xi_fontpath;
+    xi_sdf.line_height = TTF_FontHeight(font);
+    xi_sdf.generation = 1;
+    for (int c = ' '; c <= '~'; ++c) xi_sdf_glyph((unsigned char)c);
+    return true;
+}
+
+// Every glyph of text in the atlas, or false to draw it the ordinary way
+static bool xi_sdf_has_glyphs(const char *text) {
+    // Pipelined windows can't upload the atlas: the render thread owns their textures
+    if (!xi_sdf.enabled || xi_current->pipe || !xi_sdf_prepare()) return false;
+    for (const unsigned char *c = (const unsigned char*)text; *c; ++c) {
+        if (!xi_sdf_glyph(*c)) return false;
+    }
+    return true;
+}
+
+static bool xi_sdf_measure(const char *text, int size, int *width, int *height) {
+    if (!xi_sdf_has_glyphs(text)) return false;
+    float advance = 0;
+    for (const unsigned char *c = (const unsigned char*)text; *c; ++c) advance += xi_sdf.glyphs[*c].advance;
+    float k = (float)size / XI_SDF_BASE;
+    *width = (int)SDL_ceilf(advance * k);
+    *height = (int)SDL_ceilf(xi_sdf.line_height * k);
+    return true;
+}
+
+// Atlas distance at cell coordinates (u, v), filtered between the four nearest pixels
+static float xi_sdf_sample(const xi_SdfGlyph *glyph, float u, float v) {
+    if (u < 0) u = 0;
+    if (v < 0) v = 0;
+    if (u > glyph->w - 1) u = (float)(glyph->w - 1);
+    if (v > glyph->h - 1) v = (float)(glyph->h - 1);
+    int x = (int)u, y = (int)v;
+    int x1 = x + 1 < glyph->w ? x + 1 : x, y1 = y + 1 < glyph->h ? y + 1 : y;
+    float fx = u - x, fy = v - y;
+    const Uint8 *top = xi_sdf.atlas + (size_t)(glyph->y + y) * XI_SDF_ATLAS + glyph->x;
+    const Uint8 *bottom = xi_sdf.atlas + (size_t)(glyph->y + y1) * XI_SDF_ATLAS + glyph->x;
+    float upper = top[x] + (top[x1] - top[x]) * fx;
+    float lower = bottom[x] + (bottom[x1] - bottom[x]) * fx;
+    return upper + (lower - upper) * fy;
+}
+
+// One glyph into the software framebuffer: its cell's top left at (x, y) logical units,
+// k units per atlas pixel, coverage = (distance - 128) * slope + 0.5
+static void xi_sdf_soft_glyph(const xi_SdfGlyph *glyph, float x, float y, float k, float slope, Color color) {
+    float scale = xi_current->scale, step = k * scale;  // framebuffer pixels per atlas pixel
+    float left = x * scale, top = y * scale;
+    int x0 = (int)SDL_floorf(left), y0 = (int)SDL_floorf(top);
+    SDL_Rect cell = {x0, y0, (int)SDL_ceilf(left + glyph->w * step) - x0, (int)SDL_ceilf(top + glyph->h * step) - y0};
+    SDL_Rect area = xi_intersect_rect(cell, xi_soft_clip);
+    if (area.w <= 0 || area.h <= 0) return;
+    Uint32 *row = xi_FrameAlloc((size_t)area.w * sizeof(Uint32));
+    if (!row) return;
+    Uint32 rgb = xi_pack_color(color) & 0xFFFFFF;
+    for (int py = area.y; py < area.y + area.h; ++py) {
+        float v = (py + 0.5f - top) / step - 0.5f;
+        for (int i = 0; i < area.w; ++i) {
+            float u = (area.x + i + 0.5f - left) / step - 0.5f;
+            float coverage = (xi_sdf_sample(glyph, u, v) - 128.0f) * slope + 0.5f;
+            coverage = coverage < 0 ? 0 : coverage > 1 ? 1 : coverage;
+            row[i] = (Uint32)(coverage * color.a + 0.5f) << 24 | rgb;
+        }
+        xi_soft.blend_row(xi_soft_row(py) + area.x, row, area.w);
+    }
+}
+
+// The atlas thresholded for one octave of scale, uploaded again when glyphs were added
+static SDL_Texture *xi_sdf_texture(SDL_Renderer *renderer, int slot, int level) {
+    SDL_Texture **texture = &xi_sdf.textures[slot][level];
+    if (!*texture) {
+        *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, XI_SDF_ATLAS, XI_SDF_ATLAS);
+        if (!*texture) {
+            SDL_Log("Failed to create SDF atlas texture: %s", SDL_GetError());
+            return NULL;
+        }
+        SDL_SetTextureBlendMode(*texture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(*texture, SDL_ScaleModeLinear);
+    }
+    if (xi_sdf.uploaded[slot][level] == xi_sdf.generation) return *texture;
+
+    Uint32 *pixels = SDL_malloc((size_t)XI_SDF_ATLAS * XI_SDF_ATLAS * sizeof(Uint32));
+    if (!pixels) return NULL;
+    float slope = SDL_powf(2.0f, (float)(level - 2)) * XI_SDF_SPREAD / 127.0f;
+    Uint32 alpha[256];
+    for (int d = 0; d < 256; ++d) {
+        float coverage = (d - 128) * slope + 0.5f;
+        coverage = coverage < 0 ? 0 : coverage > 1 ? 1 : coverage;
+        alpha[d] = (Uint32)(coverage * 255.0f + 0.5f) << 24 | 0xFFFFFF;  // white, tinted per vertex
+    }
+    for (size_t i = 0; i < (size_t)XI_SDF_ATLAS * XI_SDF_ATLAS; ++i) pixels[i] = alpha[xi_sdf.atlas[i]];
+    if (SDL_UpdateTexture(*texture, NULL, pixels, XI_SDF_ATLAS * sizeof(Uint32)) != 0) {
+        SDL_Log("Failed to upload SDF atlas: %s", SDL_GetError());
+    }
+    SDL_free(pixels);
+    xi_sdf.uploaded[slot][level] = xi_sdf.generation;
+    return *texture;
+}
+
+static bool xi_sdf_draw(SDL_Renderer *renderer, const char *text, int x, int y, Color color, int size) {
+    if (!xi_sdf_has_glyphs(text)) return false;
+    float k = (float)size / XI_SDF_BASE;  // logical units per base pixel
+    float left = (float)(x - xi_origin_x) - XI_SDF_SPREAD * k, top = (float)(y - xi_origin_y) - XI_SDF_SPREAD * k;
+
+    if (xi_current->software) {
+        float slope = k * xi_current->scale * XI_SDF_SPREAD / 127.0f;
+        for (const unsigned char *c = (const unsigned char*)text; *c; ++c) {
+            const xi_SdfGlyph *glyph = &xi_sdf.glyphs[*c];
+            if (glyph->w) xi_sdf_soft_glyph(glyph, left, top, k, slope, color);
+            left += glyph->advance * k;
+        }
+        return true;
+    }
+
+    int slot = xi_renderer_slot(renderer);
+    if (slot < 0) return false;
+    int level = (int)SDL_floorf(SDL_logf(k * xi_contexts[slot]->scale) / 0.6931472f + 0.5f) + 2;
+    level = level < 0 ? 0 : level >= XI_SDF_LEVELS ? XI_SDF_LEVELS - 1 : level;
+    SDL_Texture *texture = xi_sdf_texture(renderer, slot, level);
+    if (!texture) return false;
+
+    int count = (int)strlen(text);
+    SDL_Vertex *vertices = xi_FrameAlloc((size_t)count * 4 * sizeof(SDL_Vertex));
+    int *indices = xi_FrameAlloc((size_t)count * 6 * sizeof(int));
+    if (!vertices || !indices) return false;
+    SDL_Color tint = {color.r, color.g, color.b, color.a};
+    const float texel = 1.0f / XI_SDF_ATLAS;
+    int quads = 0;
+    for (const unsigned char *c = (const unsigned char*)text; *c; ++c) {
+        const xi_SdfGlyph *glyph = &xi_sdf.glyphs[*c];
+        if (glyph->w) {
+            float x1 = left + glyph->w * k, y1 = top + glyph->h * k;
+            float u0 = glyph->x * texel, v0 = glyph->y * texel;
+            float u1 = (glyph->x + glyph->w) * texel, v1 = (glyph->y + glyph->h) * texel;
+            SDL_Vertex *v = vertices + quads * 4;
+            v[0] = (SDL_Vertex){{left, top}, tint, {u0, v0}};
+            v[1] = (SDL_Vertex){{x1, top}, tint, {u1, v0}};
+            v[2] = (SDL_Vertex){{x1, y1}, tint, {u1, v1}};
+            v[3] = (SDL_Vertex){{left, y1}, tint, {u0, v1}};
+            int *index = indices + quads * 6, base = quads * 4;
+            index[0] = base; index[1] = base + 1; index[2] = base + 2;
+            index[3] = base; index[4] = base + 2; index[5] = base + 3;
+            quads++;
+        }
+        left += glyph->advance * k;
+    }
+    if (quads && SDL_RenderGeometry(renderer, texture, vertices, quads * 4, indices, quads * 6) != 0) {
+        SDL_Log("Failed to draw SDF text: %s", SDL_GetError());
+    }
+    return true;
+}
+
+/// ============================ TIMERS AND ANIMATION ============================
+/*
+ Timers call a function once after a delay, or repeatedly:
+
+    int blink = xi_AddTimer(500, 500, toggle_cursor, entry);   // every 500 ms
+    ...
+    xi_CancelTimer(blink);
+
+ They live in a timing wheel of 1 ms slots, so adding, cancelling and firing don't
+ depend on how many timers exist. EventLoop sleeps until the next deadline (or input),
+ so an idle window with a blinking cursor wakes twice a second instead of every frame.
+
+ Tweens move a float toward a target over time with an easing curve and repaint their
+ widget on each frame while they run:
+
+    xi_Animate(&button, &button.hover_amount, 1.0f, 120, XI_EASE_OUT);
+
+ Animating a value that is already animating continues from where it is.
+*/
+#define XI_TIMER_SLOTS 512   // power of two; deadlines further out wait a lap in their slot
+#define XI_MAX_TWEENS 64
+
+typedef void (*xi_TimerCallback)(void *userdata);
+
+typedef struct {
+    Uint32 deadline;         // SDL_GetTicks() time it fires
+    Uint32 interval;         // repeat period; 0 fires once
+    xi_TimerCallback fn;
+    void *userdata;
+    int next;                // next timer in the slot or free list, plus one (0 ends it)
+    Uint16 generation;       // part of the id, so stale ids can't cancel a reused timer
+    bool active;
+    bool firing;             // taken off the wheel by the current xi_TickTimers()
+} xi_Timer;
+
+static xi_Timer *xi_timers = NULL;
+static int xi_timer_capacity = 0, xi_timer_count = 0, xi_timer_free = 0;
+static int xi_timer_wheel[XI_TIMER_SLOTS];   // first timer in each slot, plus one
+static Uint32 xi_timer_now = 0;              // everything due up to here has fired
+typedef struct {
+    int index;
+    Uint16 generation;
+} xi_DueTimer;
+
+static xi_DueTimer *xi_timer_due = NULL;
+static int xi_timer_due_capacity = 0;
+
+static bool xi_tick_before(Uint32 a, Uint32 b) {
+    return (Sint32)(a - b) < 0;  // SDL_GetTicks() wraps after 49 days
+}
+
+static void xi_wheel_insert(int index) {
+    int *slot = &xi_timer_wheel[xi_timers[index].deadline & (XI_TIMER_SLOTS - 1)];
+    xi_timers[index].next = *slot;
+    *slot = index + 1;
+}
+
+static void xi_wheel_remove(int index) {
+    int *link = &xi_timer_wheel[xi_timers[index].deadline & (XI_TIMER_SLOTS - 1)];
+    while (*link && *link != index + 1) link = &xi_timers[*link - 1].next;
+    if (*link) *link = xi_timers[index].next;
+}
+
+static void xi_free_timer(int index) {
+    xi_Timer *timer = &xi_timers[index];
+    timer->active = false;
+    timer->firing = false;
+    timer->generation = (timer->generation + 1) & 0x7FFF;  // ids stay positive
+    if (timer->generation == 0) timer->generation = 1;      // and never 0
+    timer->next = xi_timer_free;
+    xi_timer_free = index + 1;
+    xi_timer_count--;
+}
+
+// Call fn(userdata) after delay_ms, then every interval_ms (0: only once).
+// Returns an id for xi_CancelTimer, or 0 when out of memory.
+int xi_AddTimer(Uint32 delay_ms, Uint32 interval_ms, xi_TimerCallback fn, void *userdata) {
+    if (!xi_timer_free) {
+        int capacity = xi_timer_capacity ? xi_timer_capacity * 2 : 64;
+        if (capacity > 0x10000) {
+            SDL_Log("Too many timers");
+            return 0;
+        }
+        xi_Timer *timers = SDL_realloc(xi_timers, capacity * sizeof(xi_Timer));
+        if (!timers) {
+            SDL_Log("Out of memory for timers");
+            return 0;
+        }
+        for (int i = capacity - 1; i >= xi_timer_capacity; --i) {
+            memset(&timers[i], 0, sizeof(xi_Timer));
+            timers[i].generation = 1;
+            timers[i].next = xi_timer_free;
+            xi_timer_free = i + 1;
+        }
+        xi_timers = timers;
+        xi_timer_capacity = capacity;
+    }
+    Uint32 now = SDL_GetTicks();
+    if (xi_timer_count == 0) xi_timer_now = now;  // the wheel stands still while empty
+
+    int index = xi_timer_free - 1;
+    xi_Timer *timer = &xi_timers[index];
+    xi_timer_free = timer->next;
+    timer->deadline = now + (delay_ms ? delay_ms : 1);
+    timer->interval = interval_ms;
+    timer->fn = fn;
+    timer->userdata = userdata;
+    timer->active = true;
+    timer->firing = false;
+    xi_timer_count++;
+    xi_wheel_insert(index);
+    return (int)timer->generation << 16 | index;
+}
+
+void xi_CancelTimer(int id) {
+    int index = id & 0xFFFF;
+    if (id <= 0 || index >= xi_timer_capacity) return;
+    xi_Timer *timer = &xi_timers[index];
+    if (!timer->active || timer->generation != (Uint16)(id >> 16)) return;
+    if (!timer->firing) xi_wheel_remove(index);
+    xi_free_timer(index);
+}
+
+// Fire every timer that is due. Called by EventLoop; callbacks run on the UI thread.
+void xi_TickTimers(void) {
+    Uint32 now = SDL_GetTicks();
+    if (xi_timer_count == 0 || !xi_tick_before(xi_timer_now, now)) {
+        if (xi_timer_count == 0) xi_timer_now = now;
+        return;
+    }
+
+    // Visit the slots passed since the last tick (each slot once, however long that was)
+    Uint32 steps = now - xi_timer_now;
+    if (steps > XI_TIMER_SLOTS) steps = XI_TIMER_SLOTS;
+    int due = 0;
+    for (Uint32 step = 1; step <= steps; ++step) {
+        int *link = &xi_timer_wheel[(xi_timer_now + step) & (XI_TIMER_SLOTS - 1)];
+        while (*link) {
+            int index = *link - 1;
+            xi_Timer *timer = &xi_timers[index];
+            if (xi_tick_before(now, timer->deadline)) {
+                link = &timer->next;  // a later lap
+                continue;
+            }
+            *link = timer->next;
+            timer->firing = true;
+            if (due == xi_timer_due_capacity) {
+                int capacity = xi_timer_due_capacity ? xi_timer_due_capacity * 2 : 16;
+                xi_DueTimer *grown = SDL_realloc(xi_timer_due, capacity * sizeof(xi_DueTimer));
+                if (!grown) {
+                    SDL_Log("Out of memory firing timers");
+                    xi_wheel_insert(index);  // try again on the next tick
+                    timer->firing = false;
+                    break;
+                }
+                xi_timer_due = grown;
+                xi_timer_due_capacity = capacity;
+            }
+            xi_timer_due[due].index = index;
+            xi_timer_due[due].generation = timer->generation;
+            due++;
+        }
+    }
+    xi_timer_now = now;
+
+    // Callbacks may add and cancel timers (including ones still waiting to fire here)
+    for (int i = 0; i < due; ++i) {
+        int index = xi_timer_due[i].index;
+        xi_Timer *timer = &xi_timers[index];
+        if (!timer->active || timer->generation != xi_timer_due[i].generation) continue;
+        xi_TimerCallback fn = timer->fn;
+        void *userdata = timer->userdata;
+        if (timer->interval) {
+            timer->deadline += timer->interval;
+            if (!xi_tick_before(now, timer->deadline)) timer->deadline = now + timer->interval;
+            timer->firing = false;
+            xi_wheel_insert(index);
+        } else {
+            xi_free_timer(index);
+        }
+        fn(userdata);
+    }
+}
+
+// Milliseconds until the next timer fires, 0 if one is overdue, -1 if none is pending
+int xi_NextTimerDelay(void) {
+    if (xi_timer_count == 0) return -1;
+    Uint32 now = SDL_GetTicks();
+    for (Uint32 step = 1; step <= XI_TIMER_SLOTS; ++step) {
+        Uint32 time = xi_timer_now + step;
+        for (int i = xi_timer_wheel[time & (XI_TIMER_SLOTS - 1)]; i; i = xi_timers[i - 1].next) {
+            if (!xi_tick_before(time, xi_timers[i - 1].deadline)) {
+                return xi_tick_before(now, time) ? (int)(time - now) : 0;
+            }
+        }
+    }
+    // Nothing within a lap of the wheel: look for the earliest far deadline
+    Uint32 earliest = 0;
+    bool found = false;
+    for (int i = 0; i < xi_timer_capacity; ++i) {
+        if (xi_timers[i].active && !xi_timers[i].firing &&
+            (!found || xi_tick_before(xi_timers[i].deadline, earliest))) {
+            earliest = xi_timers[i].deadline;
+            found = true;
+        }
+    }
+    if (!found) return -1;
+    return xi_tick_before(now, earliest) ? (int)(earliest - now) : 0;
+}
+
+typedef enum {
+    XI_EASE_LINEAR,
+    XI_EASE_IN,        // starts slow
+    XI_EASE_OUT,       // ends slow; good for hover feedback
+    XI_EASE_IN_OUT
+} xi_Easing;
+
+typedef struct {
+    xi_Node *node;      // repainted while the value changes
+    float *value;
+    float from, to;
+    Uint32 start, duration;
+    xi_Easing easing;
+} xi_Tween;
+
+static xi_Tween xi_tweens[XI_MAX_TWEENS];
+static int xi_tween_count = 0;
+
+static float xi_ease(xi_Easing easing, float t) {
+    switch (easing) {
+        case XI_EASE_IN:
+            return t * t;
+        case XI_EASE_OUT:
+            return 1.0f - (1.0f - t) * (1.0f - t);
+        case XI_EASE_IN_OUT:
+            return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * (1.0f - t) * (1.0f - t);
+        default:
+            return t;
+    }
+}
+
+// Move *value to target over duration_ms, repainting widget on each frame until done
+void xi_Animate(void *widget, float *value, float target, Uint32 duration_ms, xi_Easing easing) {
+    xi_Tween *tween = NULL;
+    for (int i = 0; i < xi_tween_count; ++i) {
+        if (xi_tweens[i].value == value) tween = &xi_tweens[i];
+    }
+    if (!tween && duration_ms > 0 && *value != target && xi_tween_count < XI_MAX_TWEENS) {
+        tween = &xi_tweens[xi_tween_count++];
+    }
+    xi_Invalidate(widget);
+    if (!tween) {
+        *value = target;  // nothing to animate, or no room: jump there
+        return;
+    }
+    tween->node = (xi_Node*)widget;
+    tween->value = value;
+    tween->from = *value;
+    tween->to = target;
+    tween->start = SDL_GetTicks();
+    tween->duration = duration_ms ? duration_ms : 1;
+    tween->easing = easing;
+}
+
+// Stop the animations of a widget that is going away; values stay where they are
+void xi_StopAnimations(void *widget) {
+    for (int i = 0; i < xi_tween_count; ++i) {
+        if (xi_tweens[i].node == (xi_Node*)widget) xi_tweens[i--] = xi_tweens[--xi_tween_count];
+    }
+}
+
+// Advance all tweens to the current time. Returns true while any is running.
+bool xi_TickTweens(void) {
+    Uint32 now = SDL_GetTicks();
+    for (int i = 0; i < xi_tween_count; ++i) {
+        xi_Tween *tween = &xi_tweens[i];
+        float t = (float)(now - tween->start) / (float)tween->duration;
+        if (t > 1.0f) t = 1.0f;
+        *tween->value = tween->from + (tween->to - tween->from) * xi_ease(tween->easing, t);
+        xi_Invalidate(tween->node);
+        if (t >= 1.0f) xi_tweens[i--] = xi_tweens[--xi_tween_count];
+    }
+    return xi_tween_count > 0;
+}
+
+static Color xi_mix_color(Color a, Color b, float amount) {
+    if (amount <= 0.0f) return a;
+    if (amount >= 1.0f) return b;
+    Color c = {(Uint8)(a.r + (b.r - a.r) * amount), (Uint8)(a.g + (b.g - a.g) * amount),
+               (Uint8)(a.b + (b.b - a.b) * amount), (Uint8)(a.a + (b.a - a.a) * amount)};
+    return c;
+}
+
+// Drop all timers and tweens; called by xiDestroyWindow
+static void xi_clear_timers(void) {
+    SDL_free(xi_timers);
+    SDL_free(xi_timer_due);
+    xi_timers = NULL;
+    xi_timer_due = NULL;
+    xi_timer_capacity = xi_timer_count = xi_timer_free = xi_timer_due_capacity = 0;
+    memset(xi_timer_wheel, 0, sizeof(xi_timer_wheel));
+    xi_tween_count = 0;
+}
+
+/// ============================ WINDOW FUNCTIONS ============================
+static bool xi_open_context(xi_Context *context, const char *title, int width, int height) {
+    context->window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+    if (!context->window) {
+        SDL_Log("Failed to create window: %s", SDL_GetError());
+        return false;
+    }
+
+    const char *software = SDL_getenv("XI_SOFTWARE_RENDER");
+    context->software = xi_software_default || (software && software[0] == '1');
+    if (context->software) {
+        context->window_id = SDL_GetWindowID(context->window);
+        xi_SetSize(&context->root, width, height);
+        xi_SetSize(&context->overlay, width, height);
+        return true;  // the framebuffer is made with the first frame
+    }
+
+    if (xi_pipe.buffers > 0 && xi_open_render_window(context)) {
+        context->window_id = SDL_GetWindowID(context->window);
+        xi_SetSize(&context->root, width, height);
+        xi_SetSize(&context->overlay, width, height);
+        return true;  // the renderer lives on the render thread
+    }
+
+    context->renderer = SDL_CreateRenderer(context->window, -1, SDL_RENDERER_ACCELERATED);
+    if (!context->renderer) {
+        SDL_Log("Failed to create renderer: %s", SDL_GetError());
+        SDL_DestroyWindow(context->window);
+        context->window = NULL;
+        return false;
+    }
+
+    context->window_id = SDL_GetWindowID(context->window);
+    xi_SetSize(&context->root, width, height);
+    xi_SetSize(&context->overlay, width, height);
+    return true;
+}
+
+// Create and initialize the SDL window and renderer
+xi_Window xiCreateWindow(const char *title, int width, int height) {
+    xi_Window xiWin = {NULL, COLOR_GRAY};
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
+        return xiWin;
+    }
+
+    if (TTF_Init() == -1) {
+        SDL_Log("Unable to initialize SDL_ttf: %s", TTF_GetError());
+        SDL_Quit();
+        return xiWin;
+    }
+
+    xi_wake_event = SDL_RegisterEvents(1);
+    xi_pick_soft_kernels();
+
+    xi_current = xi_main_context;
+    if (!xi_open_context(xi_main_context, title, width, height)) {
+        SDL_Quit();
+        return xiWin;
+    }
+    xiWin.defaultFont = NULL;  // No default font to preload
+    return xiWin;
+}
+
+// Open another window, with its own widget tree. Call after xiCreateWindow.
+xi_Context *xi_CreateContext(const char *title, int width, int height) {
+    int slot = 0;
+    while (slot < XI_MAX_WINDOWS && xi_contexts[slot]) slot++;
+    if (slot == XI_MAX_WINDOWS) {
+        SDL_Log("Too many windows (at most %d)", XI_MAX_WINDOWS);
+        return NULL;
+    }
+    xi_Context *context = SDL_calloc(1, sizeof(xi_Context));
+    if (!context) {
+        SDL_Log("Out of memory for window %s", title);
+        return NULL;
+    }
+    context->slot = slot;
+    context->scale = 1.0f;
+    context->root = (xi_Node){.type = WIDGET_ROOT, .clips_children = true};
+    context->overlay = (xi_Node){.type = WIDGET_ROOT, .clips_children = true};
+    context->redraw = true;
+    if (!xi_open_context(context, title, width, height)) {
+        SDL_free(context);
+        return NULL;
+    }
+    xi_contexts[slot] = context;
+    xi_context_count++;
+    return context;
+}
+
+struct xi_CaptureStats;
+static void xi_stop_capture(xi_Context *context, struct xi_CaptureStats *stats);
+static void xi_skin_drop_window(int slot);
+static void xi_image_drop_renderer(SDL_Renderer *renderer);
+
+static void xi_close_context(xi_Context *context) {
+    xi_stop_capture(context, NULL);
+    xi_drop_window_text(context->slot);
+    xi_sdf_drop_window(context->slot);
+    xi_skin_drop_window(context->slot);
+    if (context->canvas) {
+        SDL_FreeSurface(context->canvas);
+        context->canvas = NULL;
+    }
+    if (context->screen) {
+        SDL_DestroyTexture(context->screen);
+        context->screen = NULL;
+    }
+    if (context->renderer) {
+        SDL_DestroyRenderer(context->renderer);
+        context->renderer = NULL;
+    }
+    if (context->pipe) xi_close_render_window(context);
+    if (context->window) {
+        SDL_DestroyWindow(context->window);
+        context->window = NULL;
+    }
+}
+
+// Close a window made by xi_CreateContext. Widgets still in it are removed as by
+// xi_RemoveWidget and its images let go of their textures; the widgets' own memory
+// (tables, dropdowns, ...) is still the caller's to destroy.
+void xi_DestroyContext(xi_Context *context) {
+    if (!context || context == xi_main_context) return;
+    while (context->root.first_child) xi_RemoveWidget(context->root.first_child);
+    while (context->overlay.first_child) xi_RemoveWidget(context->overlay.first_child);
+    // A later renderer at the same address must not find these textures
+    if (context->renderer) xi_image_drop_renderer(context->renderer);
+    xi_close_context(context);
+    xi_contexts[context->slot] = NULL;
+    xi_context_count--;
+    if (xi_current == context) xi_current = xi_main_context;
+    SDL_free(context);
+}
+
+// Destroy the SDL windows and renderers
+void xi_StopWorkers(void);  // defined with the worker threads
+void xi_DestroyImmediateUI(void);
+
+void xiDestroyWindow(xi_Window *xiWin) {
+    if (xiWin->defaultFont) {
+        TTF_CloseFont(xiWin->defaultFont);
+    }
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        if (xi_contexts[i]) xi_stop_capture(xi_contexts[i], NULL);  // its images are encoded by the workers
+    }
+    xi_StopWorkers();
+    xi_stop_build_threads();
+    xi_DestroyImmediateUI();
+    xi_clear_timers();
+    xi_free_frame_arena();
+    for (int i = 1; i < XI_MAX_WINDOWS; ++i) {
+        xi_DestroyContext(xi_contexts[i]);
+    }
+    xi_ClearTextCache();
+    xi_sdf_free();
+    xi_close_context(xi_main_context);
+    xi_stop_render_thread();
+    TTF_Quit();
+    SDL_Quit();
+}
+
+
+//=================== THEMES ==================
+/*
+ A theme draws buttons, entries, sliders, containers, dropdowns, tab strips, table
+ headers and scroll bars with images instead of flat fills: borders, rounded corners,
+ shadows, whatever the artwork has. Every skin is a nine-slice region of one atlas, so
+ corners keep their size, edges stretch along one axis and the middle along both, and
+ one small image fits any widget:
+
+    xi_Theme *theme = xi_CreateTheme();        // built-in rounded look
+    SDL_Surface *art = IMG_Load("button.png"); // at XI_SKIN_DENSITY pixels per unit
+    xi_SetSkin(theme, XI_SKIN_BUTTON, art, 8, 8, 8, 10);  // left, top, right, bottom
+    xi_UseTheme(theme);                         // NULL: flat colors again
+
+ Skins are drawn in batches. The children of a window root are split into runs that
+ don't overlap each other; the skins of a whole run go out in one SDL_RenderGeometry
+ call from the atlas, then text and everything else is drawn over them. A themed
+ window thus costs one call plus its text where flat widgets cost one or two calls
+ each. In a run a skin must not cover what an earlier widget drew besides its own
+ skin, which holds for laid-out widgets. Widgets below a scroll area or below a
+ widget other than a laid-out container draw their skins one at a time, and so do
+ software windows, which blit the slices. Scroll bars lie over the content they
+ scroll, so they are never batched either. A button's hover and click skins fade in
+ over the normal one. Skins replace the widgets' background colors; text keeps its
+ colors.
+*/
+typedef enum {
+    XI_SKIN_BUTTON, XI_SKIN_BUTTON_HOVER, XI_SKIN_BUTTON_CLICK,
+    XI_SKIN_ENTRY, XI_SKIN_ENTRY_FOCUS,
+    XI_SKIN_SLIDER_TRACK, XI_SKIN_SLIDER_KNOB,
+    XI_SKIN_PANEL, XI_SKIN_TITLE_BAR,
+    XI_SKIN_DROPDOWN,
+    XI_SKIN_TAB, XI_SKIN_TAB_ACTIVE,
+    XI_SKIN_TABLE_HEADER,
+    XI_SKIN_SCROLLBAR,          // the thumb
+    XI_SKIN_COUNT
+} xi_SkinPart;
+
+#define XI_SKIN_ATLAS 512       // atlas pixels per side
+#define XI_SKIN_DENSITY 2       // atlas pixels per window unit
+#define XI_SKIN_RUN 64          // most widgets checked for overlap in one run
+
+typedef struct {
+    SDL_Rect rect;              // in the atlas; w == 0: not set, the widget is drawn flat
+    int left, top, right, bottom;  // slice insets in atlas pixels
+} xi_Skin;
+
+typedef struct xi_Theme {
+    SDL_Surface *atlas;         // ARGB8888, XI_SKIN_ATLAS square
+    xi_Skin skins[XI_SKIN_COUNT];
+    int shelf_x, shelf_y, shelf_height;  // packing position
+    Uint32 generation;          // changes with the atlas
+    SDL_Texture *textures[XI_MAX_WINDOWS];
+    Uint32 uploaded[XI_MAX_WINDOWS];
+    struct xi_Theme *next;      // all themes, to drop a closing window's textures
+} xi_Theme;
+
+typedef struct {
+    SDL_Vertex *vertices;
+    int *indices;
+    int quads, capacity;
+} xi_SkinBatch;
+
+static xi_Theme *xi_theme = NULL;   // in use
+static xi_Theme *xi_themes = NULL;
+static XI_THREAD_LOCAL xi_SkinBatch *xi_skin_batch;  // collecting a run's skins
+static XI_THREAD_LOCAL SDL_Rect xi_skin_clip;        // what the collected skins are cut to
+static XI_THREAD_LOCAL bool xi_skins_batched;        // the current widget's skins are drawn already
+
+// Draw node's skins; false when it has none in the theme in use and keeps its flat look
+static bool xi_skin_node(xi_Node *node);
+
+// Copy image into a free spot of the atlas, with its edge pixels repeated around it so
+// filtering never picks up a neighbour
+static bool xi_put_skin(xi_Theme *theme, xi_SkinPart part, SDL_Surface *image, int left, int top, int right, int bottom) {
+    int w = image->w + 2, h = image->h + 2;
+    if (theme->shelf_x + w > XI_SKIN_ATLAS) {
+        theme->shelf_x = 0;
+        theme->shelf_y += theme->shelf_height;
+        theme->shelf_height = 0;
+    }
+    if (w > XI_SKIN_ATLAS || theme->shelf_y + h > XI_SKIN_ATLAS) {
+        SDL_Log("Skin atlas is full");
+        return false;
+    }
+    SDL_Surface *pixels = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    // Lists being drawn may still use the atlas: change a copy and let the old one go
+    SDL_Surface *atlas = xi_pipe.thread ? SDL_ConvertSurfaceFormat(theme->atlas, SDL_PIXELFORMAT_ARGB8888, 0) : theme->atlas;
+    if (!pixels || !atlas) {
+        SDL_Log("Failed to add a skin: %s", SDL_GetError());
+        SDL_FreeSurface(pixels);
+        if (atlas != theme->atlas) SDL_FreeSurface(atlas);
+        return false;
+    }
+    int x0 = theme->shelf_x, y0 = theme->shelf_y;
+    for (int y = 0; y < h; ++y) {
+        int sy = y == 0 ? 0 : y == h - 1 ? image->h - 1 : y - 1;
+        const Uint32 *from = (const Uint32*)((const Uint8*)pixels->pixels + (size_t)sy * pixels->pitch);
+        Uint32 *to = (Uint32*)((Uint8*)atlas->pixels + (size_t)(y0 + y) * atlas->pitch) + x0;
+        to[0] = from[0];
+        memcpy(to + 1, from, (size_t)image->w * sizeof(Uint32));
+        to[w - 1] = from[image->w - 1];
+    }
+    SDL_FreeSurface(pixels);
+    if (atlas != theme->atlas) {
+        SDL_SetSurfaceBlendMode(atlas, SDL_BLENDMODE_BLEND);
+        xi_release_surface(theme->atlas);
+        theme->atlas = atlas;
+    }
+    theme->shelf_x += w;
+    if (h > theme->shelf_height) theme->shelf_height = h;
+    theme->skins[part] = (xi_Skin){{x0 + 1, y0 + 1, image->w, image->h}, left, top, right, bottom};
+    theme->generation++;
+    if (theme == xi_theme) xi_redraw_all();
+    return true;
+}
+
+// Use image (any format, XI_SKIN_DENSITY pixels per window unit) for part. The insets
+// say how much of each side is border that keeps its size. Space of a replaced skin
+// is not reused.
+bool xi_SetSkin(xi_Theme *theme, xi_SkinPart part, SDL_Surface *image, int left, int top, int right, int bottom) {
+    if (!theme || !image || part < 0 || part >= XI_SKIN_COUNT) return false;
+    if (left < 0 || top < 0 || right < 0 || bottom < 0 || left + right > image->w || top + bottom > image->h) {
+        SDL_Log("Skin insets %d %d %d %d don't fit a %dx%d image", left, top, right, bottom, image->w, image->h);
+        return false;
+    }
+    return xi_put_skin(theme, part, image, left, top, right, bottom);
+}
+
+// Rounded rectangle with a border and a soft shadow below, made into a skin
+static void xi_make_skin(xi_Theme *theme, xi_SkinPart part, Color fill, Color border, int radius, int shadow) {
+    int d = XI_SKIN_DENSITY;
+    float r = (float)radius * d, line = (float)d, drop = (float)shadow * d;
+    int inset = (radius + shadow) * d + 2;
+    int width = inset * 2 + 2, height = width + (int)drop;  // two stretchable pixels in the middle
+    SDL_Surface *image = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!image) {
+        SDL_Log("Failed to make a skin: %s", SDL_GetError());
+        return;
+    }
+    // The box leaves room for the shadow at the bottom and half of it at the sides
+    float x0 = drop / 2, y0 = 0, x1 = width - drop / 2, y1 = height - drop;
+    for (int y = 0; y < height; ++y) {
+        Uint32 *row = (Uint32*)((Uint8*)image->pixels + (size_t)y * image->pitch);
+        for (int x = 0; x < width; ++x) {
+            float px = x + 0.5f, py = y + 0.5f;
+            // Distance to the rounded box (negative inside), and to the box moved down
+            float qx = SDL_fabsf(px - (x0 + x1) / 2) - ((x1 - x0) / 2 - r);
+            float qy = SDL_fabsf(py - (y0 + y1) / 2) - ((y1 - y0) / 2 - r);
+            float out = SDL_sqrtf(SDL_max(qx, 0) * SDL_max(qx, 0) + SDL_max(qy, 0) * SDL_max(qy, 0));
+            float dist = out + SDL_min(SDL_max(qx, qy), 0) - r;
+            float sy = SDL_fabsf(py - drop / 2 - (y0 + y1) / 2) - ((y1 - y0) / 2 - r);
+            float sout = SDL_sqrtf(SDL_max(qx, 0) * SDL_max(qx, 0) + SDL_max(sy, 0) * SDL_max(sy, 0));
+            float sdist = sout + SDL_min(SDL_max(qx, sy), 0) - r;
+
+            float shade = drop > 0 ? 0.35f * SDL_max(0.0f, SDL_min(1.0f, 1.0f - sdist / drop)) : 0.0f;
+            float cover = SDL_max(0.0f, SDL_min(1.0f, 0.5f - dist));
+            float edge = SDL_max(0.0f, SDL_min(1.0f, 0.5f - dist)) - SDL_max(0.0f, SDL_min(1.0f, 0.5f - (dist + line)));
+            // Fill, then the border line over it, then the shadow under both
+            float fr = fill.r + (border.r - fill.r) * edge / SDL_max(cover, 1e-6f);
+            float fg = fill.g + (border.g - fill.g) * edge / SDL_max(cover, 1e-6f);
+            float fb = fill.b + (border.b - fill.b) * edge / SDL_max(cover, 1e-6f);
+            float fa = cover * fill.a / 255.0f;
+            float a = fa + shade * (1 - fa);
+            float k = a > 0 ? fa / a : 0;  // shadow is black
+            row[x] = (Uint32)(a * 255 + 0.5f) << 24 | (Uint32)(fr * k + 0.5f) << 16 |
+                     (Uint32)(fg * k + 0.5f) << 8 | (Uint32)(fb * k + 0.5f);
+        }
+    }
+    xi_put_skin(theme, part, image, inset, inset, inset, inset + (int)drop);
+    SDL_FreeSurface(image);
+}
+
+// A theme with the built-in look; change skins with xi_SetSkin
+xi_Theme *xi_CreateTheme(void) {
+    xi_Theme *theme = SDL_calloc(1, sizeof(xi_Theme));
+    if (theme) theme->atlas = SDL_CreateRGBSurfaceWithFormat(0, XI_SKIN_ATLAS, XI_SKIN_ATLAS, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!theme || !theme->atlas) {
+        SDL_Log("Failed to create theme: %s", SDL_GetError());
+        SDL_free(theme);
+        return NULL;
+    }
+    SDL_SetSurfaceBlendMode(theme->atlas, SDL_BLENDMODE_BLEND);
+    theme->generation = 1;
+    theme->next = xi_themes;
+    xi_themes = theme;
+    xi_make_skin(theme, XI_SKIN_BUTTON, (Color){232, 232, 236, 255}, (Color){150, 150, 160, 255}, 4, 2);
+    xi_make_skin(theme, XI_SKIN_BUTTON_HOVER, (Color){214, 226, 250, 255}, (Color){90, 130, 220, 255}, 4, 2);
+    xi_make_skin(theme, XI_SKIN_BUTTON_CLICK, (Color){176, 198, 240, 255}, (Color){60, 100, 200, 255}, 4, 2);
+    xi_make_skin(theme, XI_SKIN_ENTRY, (Color){255, 255, 255, 255}, (Color){160, 160, 170, 255}, 3, 0);
+    xi_make_skin(theme, XI_SKIN_ENTRY_FOCUS, (Color){255, 255, 255, 255}, (Color){60, 120, 230, 255}, 3, 0);
+    xi_make_skin(theme, XI_SKIN_SLIDER_TRACK, (Color){216, 216, 222, 255}, (Color){170, 170, 180, 255}, 4, 0);
+    xi_make_skin(theme, XI_SKIN_SLIDER_KNOB, (Color){70, 120, 220, 255}, (Color){40, 80, 180, 255}, 5, 1);
+    xi_make_skin(theme, XI_SKIN_PANEL, (Color){246, 246, 248, 255}, (Color){190, 190, 196, 255}, 6, 3);
+    xi_make_skin(theme, XI_SKIN_TITLE_BAR, (Color){216, 219, 226, 255}, (Color){190, 190, 196, 255}, 6, 0);
+    xi_make_skin(theme, XI_SKIN_DROPDOWN, (Color){255, 255, 255, 255}, (Color){160, 160, 170, 255}, 3, 0);
+    xi_make_skin(theme, XI_SKIN_TAB, (Color){216, 219, 226, 255}, (Color){190, 190, 196, 255}, 4, 0);
+    xi_make_skin(theme, XI_SKIN_TAB_ACTIVE, (Color){246, 246, 248, 255}, (Color){150, 150, 160, 255}, 4, 0);
+    xi_make_skin(theme, XI_SKIN_TABLE_HEADER, (Color){226, 228, 234, 255}, (Color){190, 190, 196, 255}, 2, 0);
+    xi_make_skin(theme, XI_SKIN_SCROLLBAR, (Color){170, 170, 178, 255}, (Color){140, 140, 150, 255}, 2, 0);
+    return theme;
+}
+
+// Draw with theme from now on; NULL goes back to flat colors
+void xi_UseTheme(xi_Theme *theme) {
+    if (theme == xi_theme) return;
+    xi_theme = theme;
+    xi_redraw_all();
+}
+
+static void xi_skin_drop_window(int slot) {
+    for (xi_Theme *theme = xi_themes; theme; theme = theme->next) {
+        if (theme->textures[slot]) SDL_DestroyTexture(theme->textures[slot]);
+        theme->textures[slot] = NULL;
+        theme->uploaded[slot] = 0;
+    }
+}
+
+void xi_DestroyTheme(xi_Theme *theme) {
+    if (!theme) return;
+    if (theme == xi_theme) xi_UseTheme(NULL);
+    for (xi_Theme **link = &xi_themes; *link; link = &(*link)->next) {
+        if (*link == theme) {
+            *link = theme->next;
+            break;
+        }
+    }
+    for (int slot = 0; slot < XI_MAX_WINDOWS; ++slot) {
+        if (theme->textures[slot]) SDL_DestroyTexture(theme->textures[slot]);
+    }
+    xi_release_surface(theme->atlas);
+    SDL_free(theme);
+}
+
+// The atlas as a texture of the current window, uploaded again after changes
+static SDL_Texture *xi_skin_texture(xi_Theme *theme) {
+    int slot = xi_current->slot;
+    SDL_Texture **texture = &theme->textures[slot];
+    if (!*texture) {
+        *texture = SDL_CreateTexture(grenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, XI_SKIN_ATLAS, XI_SKIN_ATLAS);
+        if (!*texture) {
+            SDL_Log("Failed to create skin atlas texture: %s", SDL_GetError());
+            return NULL;
+        }
+        SDL_SetTextureBlendMode(*texture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(*texture, SDL_ScaleModeLinear);
+    }
+    if (theme->uploaded[slot] != theme->generation) {
+        if (SDL_UpdateTexture(*texture, NULL, theme->atlas->pixels, theme->atlas->pitch) != 0) {
+            SDL_Log("Failed to upload skin atlas: %s", SDL_GetError());
+        }
+        theme->uploaded[slot] = theme->generation;
+    }
+    return *texture;
+}
+
+static bool xi_skin_reserve(xi_SkinBatch *batch, int quads) {
+    if (batch->quads + quads <= batch->capacity) return true;
+    int capacity = batch->capacity ? batch->capacity * 2 : 64;
+    while (capacity < batch->quads + quads) capacity *= 2;
+    SDL_Vertex *vertices = xi_FrameAlloc((size_t)capacity * 4 * sizeof(SDL_Vertex));
+    int *indices = xi_FrameAlloc((size_t)capacity * 6 * sizeof(int));
+    if (!vertices || !indices) return false;
+    if (batch->quads) {
+        memcpy(vertices, batch->vertices, (size_t)batch->quads * 4 * sizeof(SDL_Vertex));
+        memcpy(indices, batch->indices, (size_t)batch->quads * 6 * sizeof(int));
+    }
+    batch->vertices = vertices;
+    batch->indices = indices;
+    batch->capacity = capacity;
+    return true;
+}
+
+// Add the nine slices of skin stretched over rect (window units, origin already taken
+// off), cut to clip when given
+static void xi_skin_quads(xi_SkinBatch *batch, const xi_Skin *skin, SDL_FRect rect, Uint8 alpha, const SDL_FRect *clip) {
+    if (!xi_skin_reserve(batch, 9)) return;
+    float d = XI_SKIN_DENSITY;
+    float left = skin->left / d, right = skin->right / d, top = skin->top / d, bottom = skin->bottom / d;
+    if (left + right > rect.w) {  // too small for the borders: shrink them alike
+        float k = rect.w / (left + right);
+        left *= k;
+        right *= k;
+    }
+    if (top + bottom > rect.h) {
+        float k = rect.h / (top + bottom);
+        top *= k;
+        bottom *= k;
+    }
+    float xs[4] = {rect.x, rect.x + left, rect.x + rect.w - right, rect.x + rect.w};
+    float ys[4] = {rect.y, rect.y + top, rect.y + rect.h - bottom, rect.y + rect.h};
+    const float texel = 1.0f / XI_SKIN_ATLAS;
+    const SDL_Rect *r = &skin->rect;
+    float us[4] = {r->x * texel, (r->x + skin->left) * texel, (r->x + r->w - skin->right) * texel, (r->x + r->w) * texel};
+    float vs[4] = {r->y * texel, (r->y + skin->top) * texel, (r->y + r->h - skin->bottom) * texel, (r->y + r->h) * texel};
+    SDL_Color tint = {255, 255, 255, alpha};
+
+    for (int j = 0; j < 3; ++j) {
+        for (int i = 0; i < 3; ++i) {
+            float x0 = xs[i], x1 = xs[i + 1], y0 = ys[j], y1 = ys[j + 1];
+            float u0 = us[i], u1 = us[i + 1], v0 = vs[j], v1 = vs[j + 1];
+            if (x1 <= x0 || y1 <= y0) continue;
+            if (clip) {
+                float cx0 = SDL_max(x0, clip->x), cx1 = SDL_min(x1, clip->x + clip->w);
+                float cy0 = SDL_max(y0, clip->y), cy1 = SDL_min(y1, clip->y + clip->h);
+                if (cx1 <= cx0 || cy1 <= cy0) continue;
+                float du = (u1 - u0) / (x1 - x0), dv = (v1 - v0) / (y1 - y0);
+                u1 = u0 + (cx1 - x0) * du;
+                u0 = u0 + (cx0 - x0) * du;
+                v1 = v0 + (cy1 - y0) * dv;
+                v0 = v0 + (cy0 - y0) * dv;
+                x0 = cx0; x1 = cx1; y0 = cy0; y1 = cy1;
+            }
+            SDL_Vertex *v = batch->vertices + batch->quads * 4;
+            v[0] = (SDL_Vertex){{x0, y0}, tint, {u0, v0}};
+            v[1] = (SDL_Vertex){{x1, y0}, tint, {u1, v0}};
+            v[2] = (SDL_Vertex){{x1, y1}, tint, {u1, v1}};
+            v[3] = (SDL_Vertex){{x0, y1}, tint, {u0, v1}};
+            int *index = batch->indices + batch->quads * 6, base = batch->quads * 4;
+            index[0] = base; index[1] = base + 1; index[2] = base + 2;
+            index[3] = base; index[4] = base + 2; index[5] = base + 3;
+            batch->quads++;
+        }
+    }
+}
+
+// Software windows: blit the slices one by one
+static void xi_soft_skin(const xi_Skin *skin, SDL_Rect rect, Uint8 alpha) {
+    float s = xi_current->scale, d = XI_SKIN_DENSITY;
+    int x0 = (int)SDL_floorf((rect.x - xi_origin_x) * s), y0 = (int)SDL_floorf((rect.y - xi_origin_y) * s);
+    int x3 = (int)SDL_ceilf((rect.x - xi_origin_x + rect.w) * s), y3 = (int)SDL_ceilf((rect.y - xi_origin_y + rect.h) * s);
+    int left = (int)(skin->left * s / d + 0.5f), right = (int)(skin->right * s / d + 0.5f);
+    int top = (int)(skin->top * s / d + 0.5f), bottom = (int)(skin->bottom * s / d + 0.5f);
+    if (left + right > x3 - x0) left = right = (x3 - x0) / 2;
+    if (top + bottom > y3 - y0) top = bottom = (y3 - y0) / 2;
+    int xs[4] = {x0, x0 + left, x3 - right, x3}, ys[4] = {y0, y0 + top, y3 - bottom, y3};
+    const SDL_Rect *r = &skin->rect;
+    int us[4] = {r->x, r->x + skin->left, r->x + r->w - skin->right, r->x + r->w};
+    int vs[4] = {r->y, r->y + skin->top, r->y + r->h - skin->bottom, r->y + r->h};
+    for (int j = 0; j < 3; ++j) {
+        for (int i = 0; i < 3; ++i) {
+            SDL_Rect from = {us[i], vs[j], us[i + 1] - us[i], vs[j + 1] - vs[j]};
+            SDL_Rect to = {xs[i], ys[j], xs[i + 1] - xs[i], ys[j + 1] - ys[j]};
+            xi_soft_blit_region(xi_theme->atlas, from, to, alpha);
+        }
+    }
+}
+
+// Draw part over rect (window units). False when the theme has no such skin and the
+// widget should draw its flat look instead.
+static bool xi_draw_skin(xi_SkinPart part, SDL_Rect rect, Uint8 alpha) {
+    if (!xi_theme || xi_theme->skins[part].rect.w == 0) return false;
+    const xi_Skin *skin = &xi_theme->skins[part];
+    if (alpha == 0 || xi_skins_batched) return true;
+    SDL_FRect dst = {(float)(rect.x - xi_origin_x), (float)(rect.y - xi_origin_y), (float)rect.w, (float)rect.h};
+    if (xi_skin_batch) {
+        SDL_FRect clip = {(float)(xi_skin_clip.x - xi_origin_x), (float)(xi_skin_clip.y - xi_origin_y),
+                          (float)xi_skin_clip.w, (float)xi_skin_clip.h};
+        xi_skin_quads(xi_skin_batch, skin, dst, alpha, &clip);
+        return true;
+    }
+    if (xi_current->software) {
+        xi_soft_skin(skin, rect, alpha);
+        return true;
+    }
+    xi_SkinBatch batch = {0};  // alone, within the clip already set
+    xi_skin_quads(&batch, skin, dst, alpha, NULL);
+    if (!batch.quads) return true;
+    if (xi_current->pipe) {
+        xi_record_geometry(batch.vertices, batch.quads * 4, batch.indices, batch.quads * 6, xi_theme->atlas);
+        return true;
+    }
+    SDL_Texture *texture = xi_skin_texture(xi_theme);
+    if (texture) SDL_RenderGeometry(grenderer, texture, batch.vertices, batch.quads * 4, batch.indices, batch.quads * 6);
+    return true;
+}
+
+//============================= CONTAINER ===========================================
+// Container widget structure
+typedef struct {
+    xi_Node node;
+    const char *title;
+    Color color;
+    bool movable;
+    bool dragging;
+    int drag_offset_x, drag_offset_y;
+} xi_Container;
+
+// Create a new container instance
+xi_Container createContainer(int x, int y, int width, int height, Color color, const char *title, bool movable) {
+    xi_Container container = {0};
+    container.node = xi_make_node(WIDGET_CONTAINER, x, y, width, height);
+    container.color = color;
+    container.title = title;
+    container.movable = movable;
+    container.node.clips_children = true;
+    if (title && strlen(title) > 0) {
+        container.node.layout.inset_top = 30;  // keep laid-out children below the title bar
+    }
+    return container;
+}
+
+// Render the container on the screen
+void render_container(xi_Container *container) {
+    int x = container->node.bounds.x;
+    int y = container->node.bounds.y;
+    int width = container->node.bounds.w;
+    int height = container->node.bounds.h;
+
+    bool skinned = xi_skin_node(&container->node);
+
+    // Draw the main container rectangle (filled)
+    if (!skinned) xi_DrawRect(grenderer, x, y, width, height, container->color, FILLED);
+
+    // Handle title bar and title if a valid title is provided
+    if (container->title && strlen(container->title) > 0) {
+        int titleBarHeight = 30;  // Fixed height for the title bar
+        Color titleBarColor = {200, 200, 200, 255};
+
+        // Draw title bar
+        if (!skinned) xi_DrawRect(grenderer, x, y, width, titleBarHeight, titleBarColor, FILLED);
+
+        // Draw title text centered vertically within the title bar
+        int textX = x + 10;
+        int textY = y + (titleBarHeight / 4);  // Simple vertical alignment
+        xi_DrawText(grenderer, container->title, textX, textY, COLOR_BLUE, 16);
+
+        // Adjust the container rectangle position if title bar exists
+        y += titleBarHeight;
+        height -= titleBarHeight;
+    }
+
+    // Redraw container outline after adjusting for title bar
+    if (!skinned) xi_DrawRect(grenderer, x, y, width, height, container->color, OUTLINE);
+}
+
+// Handle container movement if movable is true
+void handleContainerMovement(xi_Container *container, SDL_Event *event) {
+    if (!container->movable) return;
+
+    const SDL_Rect *bounds = &container->node.bounds;
+    if (event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT) {
+        int mouseX = event->button.x;
+        int mouseY = event->button.y;
+
+        // Check if click is within the title bar
+        if (mouseX >= bounds->x && mouseX <= bounds->x + bounds->w &&
+            mouseY >= bounds->y && mouseY <= bounds->y + 30) {
+            container->dragging = true;
+            container->drag_offset_x = mouseX - bounds->x;
+            container->drag_offset_y = mouseY - bounds->y;
+        }
+    } else if (event->type == SDL_MOUSEBUTTONUP && event->button.button == SDL_BUTTON_LEFT) {
+        container->dragging = false;
+    } else if (event->type == SDL_MOUSEMOTION && container->dragging) {
+        // Positions are parent-relative; children follow through their cached bounds
+        xi_Node *parent = container->node.parent;
+        int parentX = parent ? parent->bounds.x : 0;
+        int parentY = parent ? parent->bounds.y : 0;
+        xi_SetPosition(container, event->motion.x - container->drag_offset_x - parentX,
+                       event->motion.y - container->drag_offset_y - parentY);
+    }
+}
+
+//==================== WIDGETS ==================
+
+// --------------------------- Text Entry Struct ---------------------------
+
+#define MAX_TEXT_LENGTH 256
+#define XI_CURSOR_BLINK 530  // ms the cursor stays on, then off
+typedef struct {
+    xi_Node node;
+    char text[MAX_TEXT_LENGTH];
+    int cursor_position;
+    int text_offset;
+    bool active;
+    int font_size;
+    Color text_color;
+    Color background_color;
+    bool cursor_visible;
+    int blink_timer;     // running while active
+} TextEntry;
+
+// Initialize a single-line text entry box
+TextEntry CreateTextEntry(int x, int y, int width, int height, int font_size, Color text_color, Color background_color) {
+    TextEntry entry;
+    entry.node = xi_make_node(WIDGET_ENTRY, x, y, width, height);
+    entry.font_size = font_size;
+    entry.text_color = text_color;
+    entry.background_color = background_color;
+    entry.active = false;
+    entry.cursor_position = 0;
+    entry.text_offset = 0;
+    entry.cursor_visible = false;
+    entry.blink_timer = 0;
+    memset(entry.text, 0, MAX_TEXT_LENGTH); // Initialize text with empty characters
+    return entry;
+}
+
+// Render the text entry box with scrolling support
+void render_text_entry(TextEntry *entry) {
+    int x = entry->node.bounds.x;
+    int y = entry->node.bounds.y;
+    int width = entry->node.bounds.w;
+    int height = entry->node.bounds.h;
+
+    if (!xi_skin_node(&entry->node)) {
+        // Draw background
+        xi_DrawRect(grenderer, x, y, width, height, entry->background_color, FILLED);
+
+        // Draw border
+        xi_DrawRect(grenderer, x, y, width, height, COLOR_BLUE, OUTLINE);
+    }
+
+    // Determine max visible characters (adjust for padding)
+    int max_visible_chars = (width - 10) / 10;  // 10px padding on the left side
+
+    // Adjust text offset (scrolling one char earlier)
+    if (entry->cursor_position >= entry->text_offset + max_visible_chars - 1) {
+        entry->text_offset = entry->cursor_position - (max_visible_chars - 1);
+    } else if (entry->cursor_position < entry->text_offset) {
+        entry->text_offset = entry->cursor_position;
+    }
+
+    // Draw only the visible portion of text
+    const char *visible_text = xi_FrameString(entry->text + entry->text_offset, max_visible_chars > 0 ? max_visible_chars : 0);
+    if (visible_text) xi_DrawText(grenderer, visible_text, x + 5, y + 5, entry->text_color, entry->font_size);
+
+    // Draw cursor
+    if (entry->active && entry->cursor_visible) {
+        int cursor_x = x + 5 + ((entry->cursor_position - entry->text_offset) * 10);
+        xi_DrawRect(grenderer, cursor_x, y + 5, 2, entry->font_size, entry->text_color, FILLED);
+    }
+}
+
+static void xi_blink_cursor(void *userdata) {
+    TextEntry *entry = (TextEntry*)userdata;
+    entry->cursor_visible = !entry->cursor_visible;
+    xi_Invalidate(entry);
+}
+
+// Show the cursor and start a new blink cycle (or stop blinking when inactive)
+static void xi_restart_blink(TextEntry *entry) {
+    xi_CancelTimer(entry->blink_timer);
+    entry->blink_timer = entry->active ? xi_AddTimer(XI_CURSOR_BLINK, XI_CURSOR_BLINK, xi_blink_cursor, entry) : 0;
+    entry->cursor_visible = entry->active;
+}
+
+// Update text entry with user input and enable scrolling
+void update_text_entry(TextEntry *entry, SDL_Event *event) {
+    if (!entry->active) return;
+    if (event->type == SDL_TEXTINPUT || event->type == SDL_KEYDOWN) {
+        xi_restart_blink(entry);  // the cursor stays solid while typing
+    }
+
+    if (event->type == SDL_TEXTINPUT) {
+        int text_length = strlen(entry->text);
+        if (text_length < MAX_TEXT_LENGTH - 1) {
+            memmove(&entry->text[entry->cursor_position + 1], &entry->text[entry->cursor_position], text_length - entry->cursor_position + 1);
+            entry->text[entry->cursor_position] = event->text.text[0];
+            entry->cursor_position++;
+        }
+        xi_Invalidate(entry);
+    } else if (event->type == SDL_KEYDOWN) {
+        xi_Invalidate(entry);
+        if (event->key.keysym.sym == SDLK_BACKSPACE && entry->cursor_position > 0) {
+            memmove(&entry->text[entry->cursor_position - 1], &entry->text[entry->cursor_position], strlen(entry->text) - entry->cursor_position + 1);
+            entry->cursor_position--;
+        } else if (event->key.keysym.sym == SDLK_LEFT && entry->cursor_position > 0) {
+            entry->cursor_position--;
+        } else if (event->key.keysym.sym == SDLK_RIGHT && entry->cursor_position < strlen(entry->text)) {
+            entry->cursor_position++;
+        }
+    }
+    if (entry->node.binding) xi_write_back(&entry->node);
+}
+
+// Handle activation on mouse click
+void handle_text_entry_click(TextEntry *entry, SDL_Event *event) {
+    if (event->type == SDL_MOUSEBUTTONDOWN) {
+        bool active = xi_point_in_bounds(&entry->node, event->button.x, event->button.y);
+        if (active != entry->active) {
+            entry->active = active;
+            xi_restart_blink(entry);
+            xi_Invalidate(entry);
+        }
+    }
+} 
+
+
+// ---------------- Label Structure ----------------
+typedef struct {
+    xi_Node node;
+    const char *text;
+    Color text_color;
+    Color background_color; // Can be transparent
+    char *owned_text; // set when text was replaced through the update queue
+} Label;
+
+// ---------------- Button Structure ----------------
+typedef struct {
+    xi_Node node;
+    const char *text;
+    Color text_color;
+    Color background_color;
+    Color hover_color;
+    Color click_color;
+    bool hovered;
+    bool clicked;
+    char *owned_text; // set when text was replaced through the update queue
+    float hover_amount, click_amount; // 0..1, fading toward hovered/clicked
+    int clicks;       // completed clicks (pressed and released over the button)
+} Button;
+
+// ---------------- Text Structure ----------------
+typedef struct {
+    xi_Node node;
+    const char *text;
+    Color text_color;
+    int font_size;
+    char *owned_text; // set when text was replaced through the update queue
+} Text;
+
+// ---------------- Label Functions ----------------
+Label CreateLabel(int x, int y, int width, int height, const char *text, Color text_color, Color background_color) {
+    Label label = {xi_make_node(WIDGET_LABEL, x, y, width, height), text, text_color, background_color, NULL};
+    return label;
+}
+
+void render_label(Label *label) {
+    const SDL_Rect *b = &label->node.bounds;
+    if (label->background_color.a != 0) {  // If not transparent
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, label->background_color, FILLED);
+    }
+    xi_DrawText(grenderer, label->text, b->x + 5, b->y + 5, label->text_color, 16);
+}
+
+// ---------------- Button Functions ----------------
+#define XI_HOVER_FADE 120  // ms
+#define XI_CLICK_FADE 60
+
+Button CreateButton(int x, int y, int width, int height, const char *text, Color text_color, Color background_color, Color hover_color, Color click_color) {
+    Button button = {xi_make_node(WIDGET_BUTTON, x, y, width, height), text, text_color, background_color, hover_color, click_color, false, false, NULL, 0.0f, 0.0f, 0};
+    return button;
+}
+
+void render_button(Button *button) {
+    const SDL_Rect *b = &button->node.bounds;
+    if (!xi_skin_node(&button->node)) {
+        Color current_color = xi_mix_color(button->background_color, button->hover_color, button->hover_amount);
+        current_color = xi_mix_color(current_color, button->click_color, button->click_amount);
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, current_color, FILLED);
+    }
+    xi_DrawText(grenderer,  button->text, b->x + 10, b->y + 10, button->text_color, 16);
+}
+
+void update_button(Button *button, SDL_Event *event) {
+    int mx = event->motion.x;
+    int my = event->motion.y;
+    bool was_hovered = button->hovered, was_clicked = button->clicked;
+
+    if (event->type == SDL_MOUSEMOTION) {
+        button->hovered = xi_point_in_bounds(&button->node, mx, my);
+    }
+    if (event->type == SDL_MOUSEBUTTONDOWN && button->hovered) {
+        button->clicked = true;
+    }
+    if (event->type == SDL_MOUSEBUTTONUP) {
+        if (button->clicked && button->hovered) button->clicks++;
+        button->clicked = false;
+    }
+    if (button->hovered != was_hovered) {
+        xi_Animate(button, &button->hover_amount, button->hovered ? 1.0f : 0.0f, XI_HOVER_FADE, XI_EASE_OUT);
+    }
+    if (button->clicked != was_clicked) {
+        xi_Animate(button, &button->click_amount, button->clicked ? 1.0f : 0.0f, XI_CLICK_FADE, XI_EASE_OUT);
+    }
+}
+
+// ---------------- Text Functions ----------------
+Text CreateText( const char *text,int x, int y, Color text_color, int font_size) {
+    Text txt = {xi_make_node(WIDGET_TEXT, x, y, 0, 0), text, text_color, font_size, NULL};
+    return txt;
+}
+
+void render_text(Text *text) {
+    xi_DrawText(grenderer, text->text, text->node.bounds.x, text->node.bounds.y, text->text_color, text->font_size);
+}
+
+static bool xi_measure_widget(xi_Node *node, int *width, int *height) {
+    if (node->type == WIDGET_TEXT) {
+        Text *text = (Text*)node;
+        return xi_MeasureText(text->text, text->font_size, width, height);
+    }
+    return false;
+}
+
+// ----------- slider -----------------
+typedef struct {
+    xi_Node node;
+    int min_value, max_value;
+    int value;
+    bool dragging;
+} Slider;
+
+// Create a slider
+Slider CreateSlider(int x, int y, int width, int height, int min_value, int max_value, int start_value) {
+    Slider slider = {xi_make_node(WIDGET_SLIDER, x, y, width, height), min_value, max_value, start_value, false};
+    return slider;
+}
+
+// Left edge of the thumb, which is as wide as the slider is high and stays inside the track
+static int slider_handle_x(const Slider *slider) {
+    const SDL_Rect *b = &slider->node.bounds;
+    float percentage = (float)(slider->value - slider->min_value) / (slider->max_value - slider->min_value);
+    return b->x + (int)(percentage * (b->w - b->h));
+}
+
+// Render the slider with a centered value
+void render_slider(Slider *slider) {
+    int x = slider->node.bounds.x;
+    int y = slider->node.bounds.y;
+    int width = slider->node.bounds.w;
+    int height = slider->node.bounds.h;
+    int handle_x = slider_handle_x(slider);
+
+    if (!xi_skin_node(&slider->node)) {
+        // Draw the bar (track)
+        xi_DrawRect(grenderer, x, y, width, height, COLOR_WHITE, FILLED);
+
+        // Draw the thumb (handle) inside the bar
+        xi_DrawRect(grenderer, handle_x, y, height, height, COLOR_BLUE, FILLED);
+    }
+
+    // Render the value inside the thumb
+    const char *value_text = xi_FrameFormat("%d", slider->value);
+
+    int text_x = handle_x + (height / 4);  // Center inside the thumb
+    int text_y = y + (height / 4);
+
+    if (value_text) xi_DrawText(grenderer, value_text, text_x, text_y,  COLOR_WHITE, height / 2);
+}
+
+// Update the slider based on mouse input
+void update_slider(Slider *slider, SDL_Event *event) {
+    int mx = event->motion.x;
+    int my = event->motion.y;
+    const SDL_Rect *b = &slider->node.bounds;
+
+    if (event->type == SDL_MOUSEBUTTONDOWN) {
+        int handle_x = slider_handle_x(slider);
+
+        if (mx >= handle_x && mx <= handle_x + b->h &&
+            my >= b->y && my <= b->y + b->h) {
+            slider->dragging = true;
+        }
+    }
+
+    if (event->type == SDL_MOUSEMOTION && slider->dragging) {
+        int new_value = slider->min_value + ((mx - b->x) * (slider->max_value - slider->min_value)) / (b->w - b->h);
+        if (new_value < slider->min_value) new_value = slider->min_value;
+        if (new_value > slider->max_value) new_value = slider->max_value;
+        if (new_value != slider->value) {
+            slider->value = new_value;
+            xi_Invalidate(slider);
+            if (slider->node.binding) xi_write_back(&slider->node);
+        }
+    }
+
+    if (event->type == SDL_MOUSEBUTTONUP) {
+        slider->dragging = false;
+    }
+}
+
+// ----------- table and list -----------------
+/*
+ Tables and lists show rows of a data source instead of owning a widget per cell:
+
+    const char *log_cell(void *log, int row, int column, char *buffer, int size) {...}
+    xi_DataSource source = {log_cell, NULL, compare_log_rows, &log};
+    xi_Table table = xi_CreateTable(0, 0, 600, 400, 10000000, 20, 14, source);
+    xi_AddTableColumn(&table, "Time", 160);
+    xi_AddTableColumn(&table, "Message", 0);   // 0: the width the other columns leave
+    xi_AddWidget(&panel, &table);
+
+ Only the rows and columns in view get cell widgets. Cells come from a pool that is
+ recycled as rows scroll in and out, and a cell keeps its text while its row stays in
+ view, so scrolling only asks the data source about rows that just appeared. Sorting
+ keeps a permutation of row numbers and never copies data. Tables of more than
+ XI_SORT_BACKGROUND_ROWS rows are sorted on a worker thread, so their compare must be
+ safe to call from one; the old order stays on screen until the new one is swapped in
+ through the update queue. With source.row_height set,
+ rows may differ in height: heights are measured per block of rows when a block is
+ first reached, and blocks never visited count as row_height per row.
+
+ From other threads, xi_PostSetValue(&table, count) changes the row count and
+ xi_PostInvalidate(&table) refetches the visible cells.
+*/
+typedef const char *(*xi_CellTextFn)(void *userdata, int row, int column, char *buffer, int size);
+typedef int (*xi_RowHeightFn)(void *userdata, int row);
+typedef int (*xi_CompareRowsFn)(void *userdata, int column, int row_a, int row_b);
+typedef bool (*xi_CellMarkFn)(void *userdata, int row, int column, const char *text, int *start, int *length);
+
+typedef struct {
+    xi_CellTextFn cell_text;    // may write into buffer or return a string of its own
+    xi_RowHeightFn row_height;  // NULL: every row is the table's row height
+    xi_CompareRowsFn compare;   // NULL: clicking a header doesn't sort
+    void *userdata;
+    xi_CellMarkFn mark;         // NULL: no highlighting; else picks a byte range of the text
+} xi_DataSource;
+
+#define XI_MAX_COLUMNS 32
+#define XI_SORT_BACKGROUND_ROWS 100000  // larger tables sort on a worker thread
+#define XI_CELL_TEXT 256
+#define XI_ROW_BLOCK 256            // rows measured together when heights vary
+#define XI_MAX_CONTENT (1 << 30)    // scroll positions are ints; rows past this can't be reached
+
+typedef struct {
+    const char *title;
+    int width;                      // 0: share what the other columns leave
+} xi_TableColumn;
+
+typedef struct {
+    xi_Node node;
+    int row, column;                // display row and column shown; row is -1 when unused
+    char text[XI_CELL_TEXT];
+    int mark_start, mark_length;    // highlighted part of text
+} xi_TableCell;
+
+typedef struct {
+    xi_Node node;
+    xi_DataSource source;
+    int row_count;
+    int row_height;                 // every row's height, or the estimate for unmeasured ones
+    int font_size;
+    xi_TableColumn columns[XI_MAX_COLUMNS];
+    int column_count;
+    Color text_color, background_color, stripe_color, header_color, mark_color, selected_color;
+    bool follow_end;                // stay scrolled to the end while rows are added
+    int selected;                   // highlighted display row, -1 for none
+
+    int *order;                     // display row -> data row while sorted, else NULL
+    int order_capacity;
+    int sort_column;                // -1 while rows are in data order
+    bool sort_descending;
+    struct xi_SortJob *sort_job;    // order being built on a worker, if any
+
+    int *block_height;              // per block of XI_ROW_BLOCK rows, measured or estimated
+    Sint64 *block_tree;             // Fenwick tree over block_height, for offset -> row lookups
+    bool *block_measured;
+    int block_count;
+
+    xi_TableCell **cells;           // recycled pool; the cells are children of the table
+    xi_TableCell **visible;         // scratch: cell for each visible (row, column)
+    int cell_count;
+    int first_row, row_span, first_column, column_span;  // what the cells show now
+    int cells_width;                // width the cells were placed for
+    bool cells_stale;               // data changed: every visible cell is fetched again
+} xi_Table;
+
+xi_Table xi_CreateTable(int x, int y, int width, int height, int row_count, int row_height, int font_size, xi_DataSource source) {
+    xi_Table table;
+    memset(&table, 0, sizeof(table));
+    table.node = xi_make_node(WIDGET_TABLE, x, y, width, height);
+    table.source = source;
+    table.row_count = row_count < 0 ? 0 : row_count;
+    table.row_height = row_height > 0 ? row_height : 1;
+    table.font_size = font_size;
+    table.text_color = COLOR_BLACK;
+    table.background_color = COLOR_WHITE;
+    table.stripe_color = (Color){238, 238, 242, 255};
+    table.header_color = (Color){205, 205, 212, 255};
+    table.mark_color = COLOR_YELLOW;
+    table.selected_color = (Color){175, 205, 250, 255};
+    table.selected = -1;
+    table.sort_column = -1;
+    table.cells_stale = true;
+    xi_SetScrollable(&table, true);
+    return table;
+}
+
+// A list is a table with a single headerless column spanning its width
+xi_Table xi_CreateList(int x, int y, int width, int height, int row_count, int row_height, int font_size, xi_DataSource source) {
+    xi_Table list = xi_CreateTable(x, y, width, height, row_count, row_height, font_size, source);
+    list.columns[0].width = 0;
+    list.column_count = 1;
+    return list;
+}
+
+static int xi_table_data_row(const xi_Table *table, int row) {
+    return table->order ? table->order[row] : row;
+}
+
+static int xi_table_row_height(const xi_Table *table, int row) {
+    if (!table->source.row_height) return table->row_height;
+    int height = table->source.row_height(table->source.userdata, xi_table_data_row(table, row));
+    return height > 0 ? height : 1;
+}
+
+// Left edge and width of a column; width-0 columns share what the fixed ones leave
+static void xi_table_column_span(const xi_Table *table, int column, int *x, int *width) {
+    int fixed = 0, shared = 0;
+    for (int i = 0; i < table->column_count; ++i) {
+        if (table->columns[i].width > 0) fixed += table->columns[i].width;
+        else shared++;
+    }
+    int spare = table->node.width - fixed;
+    int share = shared ? spare / shared : 0;
+    if (share < 40) share = 40;
+
+    *x = 0;
+    for (int i = 0; i < column; ++i) {
+        *x += table->columns[i].width > 0 ? table->columns[i].width : share;
+    }
+    *width = table->columns[column].width > 0 ? table->columns[column].width : share;
+}
+
+static Sint64 xi_table_total_height(const xi_Table *table) {
+    if (!table->source.row_height) return (Sint64)table->row_count * table->row_height;
+    Sint64 total = 0;
+    for (int i = table->block_count; i > 0; i -= i & -i) total += table->block_tree[i - 1];
+    return total;
+}
+
+static void xi_table_update_content(xi_Table *table) {
+    int x = 0, width = 0;
+    if (table->column_count > 0) xi_table_column_span(table, table->column_count - 1, &x, &width);
+    Sint64 height = xi_table_total_height(table);
+    table->node.content_width = x + width;
+    table->node.content_height = height > XI_MAX_CONTENT ? XI_MAX_CONTENT : (int)height;
+}
+
+// Something the cells show changed: fetch them again and repaint the table's own store
+static void xi_table_changed(xi_Table *table) {
+    table->cells_stale = true;
+    xi_invalidate_scroll_caches(&table->node);
+    xi_context_of(&table->node)->redraw = true;
+}
+
+// ---- Row offsets when heights vary ----
+
+static int xi_block_rows(const xi_Table *table, int block) {
+    int rows = table->row_count - block * XI_ROW_BLOCK;
+    return rows < XI_ROW_BLOCK ? rows : XI_ROW_BLOCK;
+}
+
+static void xi_block_add(xi_Table *table, int block, Sint64 delta) {
+    for (int i = block + 1; i <= table->block_count; i += i & -i) table->block_tree[i - 1] += delta;
+}
+
+// Size the block arrays for the row count. The first `keep` blocks keep their measured
+// heights; the rest go back to estimates.
+static void xi_table_reset_blocks(xi_Table *table, int keep) {
+    if (!table->block_height) keep = 0;
+    int count = (table->row_count + XI_ROW_BLOCK - 1) / XI_ROW_BLOCK;
+    if (count != table->block_count || !table->block_height) {
+        int *heights = SDL_realloc(table->block_height, (count ? count : 1) * sizeof(int));
+        Sint64 *tree = SDL_realloc(table->block_tree, (count ? count : 1) * sizeof(Sint64));
+        bool *measured = SDL_realloc(table->block_measured, (count ? count : 1) * sizeof(bool));
+        if (heights) table->block_height = heights;
+        if (tree) table->block_tree = tree;
+        if (measured) table->block_measured = measured;
+        if (!heights || !tree || !measured) {
+            SDL_Log("Out of memory for %d table rows", table->row_count);
+            table->block_count = 0;
+            return;
+        }
+    }
+    if (keep > count) keep = count;
+    table->block_count = count;
+    for (int i = 0; i < count; ++i) {
+        if (i < keep && table->block_measured[i]) continue;
+        table->block_height[i] = xi_block_rows(table, i) * table->row_height;
+        table->block_measured[i] = false;
+    }
+    // Linear-time Fenwick build
+    for (int i = 0; i < count; ++i) table->block_tree[i] = table->block_height[i];
+    for (int i = 1; i <= count; ++i) {
+        int parent = i + (i & -i);
+        if (parent <= count) table->block_tree[parent - 1] += table->block_tree[i - 1];
+    }
+}
+
+static void xi_table_measure_block(xi_Table *table, int block) {
+    if (table->block_measured[block]) return;
+    int height = 0;
+    int row = block * XI_ROW_BLOCK, end = row + xi_block_rows(table, block);
+    for (; row < end; ++row) height += xi_table_row_height(table, row);
+    xi_block_add(table, block, height - table->block_height[block]);
+    table->block_height[block] = height;
+    table->block_measured[block] = true;
+    if (height != xi_block_rows(table, block) * table->row_height) {
+        // The estimate was off, so rows after this block moved: place the cells again.
+        // The scroll range follows on the next clamp.
+        xi_table_update_content(table);
+        xi_table_changed(table);
+    }
+}
+
+// Display row at content offset y (row_count past the end) and the offset where it starts
+static int xi_table_row_at(xi_Table *table, int y, int *row_top) {
+    if (!table->source.row_height) {
+        int row = y / table->row_height;
+        if (row > table->row_count) row = table->row_count;
+        *row_top = row * table->row_height;
+        return row;
+    }
+    if (table->block_count == 0) {
+        *row_top = 0;
+        return table->row_count;
+    }
+
+    // Descend the Fenwick tree to the block holding y
+    int block = 0;
+    Sint64 top = 0;
+    int step = 1;
+    while (step * 2 <= table->block_count) step *= 2;
+    for (; step; step /= 2) {
+        if (block + step <= table->block_count && top + table->block_tree[block + step - 1] <= y) {
+            block += step;
+            top += table->block_tree[block - 1];
+        }
+    }
+
+    for (; block < table->block_count; ++block) {
+        xi_table_measure_block(table, block);
+        int row = block * XI_ROW_BLOCK, end = row + xi_block_rows(table, block);
+        for (; row < end; ++row) {
+            int height = xi_table_row_height(table, row);
+            if (top + height > y) {
+                *row_top = (int)top;
+                return row;
+            }
+            top += height;
+        }
+    }
+    *row_top = top > XI_MAX_CONTENT ? XI_MAX_CONTENT : (int)top;
+    return table->row_count;
+}
+
+// ---- Public API ----
+
+void xi_AddTableColumn(void *table, const char *title, int width) {
+    xi_Table *t = (xi_Table*)table;
+    if (t->column_count == XI_MAX_COLUMNS) {
+        SDL_Log("Table already has %d columns", XI_MAX_COLUMNS);
+        return;
+    }
+    t->columns[t->column_count].title = title;
+    t->columns[t->column_count].width = width;
+    t->column_count++;
+    if (title) t->node.layout.inset_top = t->row_height;  // room for the header row
+    xi_table_update_content(t);
+    xi_table_changed(t);
+    xi_MarkLayoutDirty(t);
+}
+
+// What to sort by. SDL_qsort has no context argument, so each thread that sorts (the UI
+// thread, or a worker for large tables) points xi_sort_key at its own.
+typedef struct {
+    xi_DataSource source;
+    int column;
+    bool descending;
+} xi_SortKey;
+
+static XI_THREAD_LOCAL const xi_SortKey *xi_sort_key = NULL;
+
+static int xi_compare_display_rows(const void *a, const void *b) {
+    const xi_SortKey *key = xi_sort_key;
+    int row_a = *(const int*)a, row_b = *(const int*)b;
+    int result = key->source.compare(key->source.userdata, key->column, row_a, row_b);
+    if (key->descending) result = -result;
+    return result ? result : (row_a > row_b) - (row_a < row_b);  // ties keep data order
+}
+
+static void xi_sort_rows(int *order, int count, const xi_SortKey *key) {
+    for (int i = 0; i < count; ++i) order[i] = i;
+    xi_sort_key = key;
+    SDL_qsort(order, count, sizeof(int), xi_compare_display_rows);
+}
+
+static bool xi_reserve_order(xi_Table *t, int count) {
+    if (count <= t->order_capacity) return true;
+    int capacity = t->order_capacity ? t->order_capacity : 1024;
+    while (capacity < count) capacity *= 2;
+    int *order = SDL_realloc(t->order, capacity * sizeof(int));
+    if (!order) {
+        SDL_Log("Out of memory sorting %d rows", count);
+        return false;
+    }
+    t->order = order;
+    t->order_capacity = capacity;
+    return true;
+}
+
+// Sort rows old_count..row_count-1 on their own, then merge them into the sorted order
+// from the back. Rows that sort after everything (a log sorted by time) cost nothing extra.
+static void xi_merge_sorted_rows(xi_Table *t, int old_count) {
+    int added = t->row_count - old_count;
+    int *rows = SDL_malloc(added * sizeof(int));
+    if (!rows || !xi_reserve_order(t, t->row_count)) {
+        SDL_free(rows);
+        SDL_free(t->order);
+        t->order = NULL;  // fall back to data order
+        t->order_capacity = 0;
+        t->sort_column = -1;
+        return;
+    }
+    for (int i = 0; i < added; ++i) rows[i] = old_count + i;
+    xi_SortKey key = {t->source, t->sort_column, t->sort_descending};
+    xi_sort_key = &key;
+    SDL_qsort(rows, added, sizeof(int), xi_compare_display_rows);
+
+    int i = old_count - 1, j = added - 1, out = t->row_count - 1;
+    while (j >= 0) {
+        if (i >= 0 && xi_compare_display_rows(&t->order[i], &rows[j]) > 0) t->order[out--] = t->order[i--];
+        else t->order[out--] = rows[j--];
+    }
+    SDL_free(rows);
+}
+
+// Tell the table which row numbers its data source spans now (e.g. a log grew)
+void xi_SetRowCount(void *table, int count) {
+    xi_Table *t = (xi_Table*)table;
+    if (count < 0) count = 0;
+    int old_count = t->row_count;
+    if (count == old_count) return;
+    bool at_end = t->node.scroll_y >= t->node.content_height - xi_viewport_height(&t->node);
+    t->row_count = count;
+    if (t->selected >= count) t->selected = -1;
+
+    if (t->order) {
+        if (count > old_count) {
+            xi_merge_sorted_rows(t, old_count);
+        } else {
+            // Rows went away: drop them from the permutation, keeping the order of the rest
+            int kept = 0;
+            for (int i = 0; i < old_count; ++i) {
+                if (t->order[i] < count) t->order[kept++] = t->order[i];
+            }
+        }
+    }
+    if (t->source.row_height) {
+        // Unsorted rows keep their places, so full blocks stay measured
+        int stable = count > old_count ? old_count : count;
+        xi_table_reset_blocks(t, t->order ? 0 : stable / XI_ROW_BLOCK);
+    }
+    xi_table_update_content(t);
+    if (t->follow_end && at_end) {
+        xi_stop_kinetic(&t->node);
+        t->node.scroll_y = t->node.content_height;  // clamped to the last full page below
+    }
+    xi_clamp_scroll(&t->node);
+    xi_table_changed(t);
+}
+
+// Keep the newest rows in view as the row count grows, like tail -f, while the
+// table is scrolled to its end
+void xi_FollowTableEnd(void *table, bool follow) {
+    ((xi_Table*)table)->follow_end = follow;
+}
+
+// Fetch the visible cells again after the data behind them changed
+void xi_RefreshTable(void *table) {
+    xi_table_changed((xi_Table*)table);
+}
+
+// Data row shown at a display row, taking sorting into account
+int xi_TableDataRow(const void *table, int row) {
+    const xi_Table *t = (const xi_Table*)table;
+    if (row < 0 || row >= t->row_count) return -1;
+    return xi_table_data_row(t, row);
+}
+
+// The rows moved: what was measured or selected no longer lines up
+static void xi_table_reordered(xi_Table *t) {
+    if (t->source.row_height) xi_table_reset_blocks(t, 0);  // heights moved with their rows
+    t->selected = -1;
+    xi_table_update_content(t);
+    xi_table_changed(t);
+}
+
+// Large sorts run on a worker and hand their result back through the update queue;
+// defined with those
+static bool xi_run_in_background(void (*fn)(void *userdata), void (*cancel)(void *userdata), void *userdata);
+void xi_PostClosure(void (*fn)(void *userdata), void *userdata);
+
+typedef struct xi_SortJob {
+    xi_Table *table;  // NULL once the table stopped waiting for this order
+    xi_SortKey key;
+    int *order;
+    int count;
+} xi_SortJob;
+
+static void xi_free_sort_job(xi_SortJob *job) {
+    SDL_free(job->order);
+    SDL_free(job);
+}
+
+// UI thread: swap the finished order in, unless the table moved on
+static void xi_sort_job_done(void *userdata) {
+    xi_SortJob *job = userdata;
+    xi_Table *t = job->table;
+    if (!t) {
+        xi_free_sort_job(job);
+        return;
+    }
+    t->sort_job = NULL;
+    SDL_free(t->order);
+    t->order = job->order;
+    t->order_capacity = job->count;
+    t->sort_column = job->key.column;
+    t->sort_descending = job->key.descending;
+    // Rows added or removed while it ran are merged in or dropped as usual
+    int count = t->row_count;
+    t->row_count = job->count;
+    SDL_free(job);
+    xi_table_reordered(t);
+    xi_SetRowCount(t, count);
+}
+
+static void xi_sort_job_run(void *userdata) {
+    xi_SortJob *job = userdata;
+    xi_sort_rows(job->order, job->count, &job->key);
+    xi_PostClosure(xi_sort_job_done, job);
+}
+
+// The pool stopped before the sort started
+static void xi_sort_job_dropped(void *userdata) {
+    xi_SortJob *job = userdata;
+    if (job->table) job->table->sort_job = NULL;
+    xi_free_sort_job(job);
+}
+
+static void xi_cancel_sort(xi_Table *t) {
+    if (!t->sort_job) return;
+    t->sort_job->table = NULL;  // freed when it reports back
+    t->sort_job = NULL;
+}
+
+static bool xi_sort_in_background(xi_Table *t, int column, bool descending) {
+    xi_SortJob *job = SDL_calloc(1, sizeof(xi_SortJob));
+    int *order = SDL_malloc(t->row_count * sizeof(int));
+    if (!job || !order) {
+        SDL_free(job);
+        SDL_free(order);
+        return false;
+    }
+    *job = (xi_SortJob){t, {t->source, column, descending}, order, t->row_count};
+    if (!xi_run_in_background(xi_sort_job_run, xi_sort_job_dropped, job)) {
+        xi_free_sort_job(job);
+        return false;
+    }
+    t->sort_job = job;
+    return true;
+}
+
+// Sort by a column through the data source's compare; column -1 goes back to data order.
+// Above XI_SORT_BACKGROUND_ROWS rows the sort finishes later, on a worker thread.
+void xi_SortTable(void *table, int column, bool descending) {
+    xi_Table *t = (xi_Table*)table;
+    xi_cancel_sort(t);
+    if (column < 0 || column >= t->column_count || !t->source.compare) {
+        SDL_free(t->order);
+        t->order = NULL;
+        t->order_capacity = 0;
+        t->sort_column = -1;
+    } else if (t->row_count > XI_SORT_BACKGROUND_ROWS && xi_sort_in_background(t, column, descending)) {
+        return;
+    } else {
+        if (!xi_reserve_order(t, t->row_count)) return;
+        t->sort_column = column;
+        t->sort_descending = descending;
+        xi_SortKey key = {t->source, column, descending};
+        xi_sort_rows(t->order, t->row_count, &key);
+    }
+    xi_table_reordered(t);
+}
+
+// Free the cell pool and row bookkeeping; removes the table from the tree
+void xi_DestroyTable(void *table) {
+    xi_Table *t = (xi_Table*)table;
+    xi_cancel_sort(t);
+    xi_RemoveWidget(t);
+    for (int i = 0; i < t->cell_count; ++i) SDL_free(t->cells[i]);
+    SDL_free(t->cells);
+    SDL_free(t->visible);
+    SDL_free(t->order);
+    SDL_free(t->block_height);
+    SDL_free(t->block_tree);
+    SDL_free(t->block_measured);
+    xi_SetScrollable(t, false);
+    t->cells = t->visible = NULL;
+    t->order = NULL;
+    t->block_height = NULL;
+    t->block_tree = NULL;
+    t->block_measured = NULL;
+    t->cell_count = t->order_capacity = t->block_count = 0;
+    t->node.first_child = t->node.last_child = NULL;
+}
+
+// ---- Cells ----
+
+static bool xi_table_grow_pool(xi_Table *t, int needed) {
+    xi_TableCell **cells = SDL_realloc(t->cells, needed * sizeof(xi_TableCell*));
+    if (cells) t->cells = cells;
+    xi_TableCell **visible = SDL_realloc(t->visible, needed * sizeof(xi_TableCell*));
+    if (visible) t->visible = visible;
+    if (!cells || !visible) return false;
+
+    while (t->cell_count < needed) {
+        xi_TableCell *cell = SDL_calloc(1, sizeof(xi_TableCell));
+        if (!cell) return false;
+        cell->node = xi_make_node(WIDGET_TABLE_CELL, 0, 0, 0, 0);
+        cell->row = -1;
+        xi_AddWidget(t, cell);
+        t->cells[t->cell_count++] = cell;
+    }
+    return true;
+}
+
+static void xi_place_cell(xi_TableCell *cell, int x, int y, int width, int height) {
+    cell->node.x = x;
+    cell->node.y = y;
+    cell->node.width = width;
+    cell->node.height = height;
+    xi_update_bounds(&cell->node, true);  // the table's bounds are current during rendering
+}
+
+/*
+ Give every visible (row, column) a cell. Cells still showing a visible row keep their
+ text and place; the rest are reassigned to what scrolled into view. Runs as the table
+ renders, so only rows that are actually drawn are ever materialized.
+*/
+static void xi_sync_table_cells(xi_Table *t) {
+    xi_Node *node = &t->node;
+    xi_clamp_scroll(node);  // row heights measured last frame may have shrunk the content
+    if (node->bounds_dirty) xi_update_bounds(node, false);
+
+    int viewport = xi_viewport_height(node);
+    int first_column = t->column_count, column_span = 0;
+    for (int c = 0; c < t->column_count; ++c) {
+        int x, width;
+        xi_table_column_span(t, c, &x, &width);
+        if (x + width <= node->scroll_x || x >= node->scroll_x + node->width) continue;
+        if (c < first_column) first_column = c;
+        column_span = c - first_column + 1;
+    }
+
+    int top;
+    int first_row = xi_table_row_at(t, node->scroll_y, &top);
+    int row_span = 0;
+    for (int row = first_row, y = top; row < t->row_count && y < node->scroll_y + viewport; ++row, ++row_span) {
+        if (t->source.row_height && row % XI_ROW_BLOCK == 0) xi_table_measure_block(t, row / XI_ROW_BLOCK);
+        y += xi_table_row_height(t, row);
+    }
+
+    if (!t->cells_stale && first_row == t->first_row && row_span == t->row_span &&
+        first_column == t->first_column && column_span == t->column_span) {
+        return;  // same cells as last frame
+    }
+
+    int needed = row_span * column_span;
+    if (needed > t->cell_count && !xi_table_grow_pool(t, needed)) {
+        SDL_Log("Out of memory for table cells");
+        return;
+    }
+
+    // Keep cells whose row and column are still in view
+    for (int i = 0; i < needed; ++i) t->visible[i] = NULL;
+    for (int i = 0; i < t->cell_count; ++i) {
+        xi_TableCell *cell = t->cells[i];
+        if (cell->row < 0) continue;
+        int r = cell->row - first_row, c = cell->column - first_column;
+        if (!t->cells_stale && r >= 0 && r < row_span && c >= 0 && c < column_span) {
+            t->visible[r * column_span + c] = cell;
+        } else {
+            cell->row = -1;
+        }
+    }
+
+    // Hand the free cells to whatever just came into view
+    int next_free = 0;
+    int header = node->layout.inset_top;
+    for (int r = 0, y = top; r < row_span; ++r) {
+        int row = first_row + r;
+        int height = xi_table_row_height(t, row);
+        for (int c = 0; c < column_span; ++c) {
+            if (t->visible[r * column_span + c]) continue;
+            while (t->cells[next_free]->row >= 0) next_free++;
+            xi_TableCell *cell = t->cells[next_free];
+            int column = first_column + c;
+            int x, width;
+            xi_table_column_span(t, column, &x, &width);
+            cell->row = row;
+            cell->column = column;
+            const char *text = t->source.cell_text(t->source.userdata, xi_table_data_row(t, row), column,
+                                                   cell->text, XI_CELL_TEXT);
+            if (!text) cell->text[0] = '\0';
+            else if (text != cell->text) SDL_strlcpy(cell->text, text, XI_CELL_TEXT);
+            cell->mark_start = cell->mark_length = 0;
+            if (t->source.mark && (!t->source.mark(t->source.userdata, xi_table_data_row(t, row), column, cell->text,
+                                                    &cell->mark_start, &cell->mark_length) ||
+                                   cell->mark_start < 0 || cell->mark_start + cell->mark_length > (int)strlen(cell->text))) {
+                cell->mark_start = cell->mark_length = 0;
+            }
+            xi_place_cell(cell, x, header + y, width, height);
+        }
+        y += height;
+    }
+
+    // Park unused cells where they are culled
+    for (int i = 0; i < t->cell_count; ++i) {
+        xi_TableCell *cell = t->cells[i];
+        if (cell->row < 0 && (cell->node.width || cell->node.height)) xi_place_cell(cell, 0, 0, 0, 0);
+    }
+
+    t->first_row = first_row;
+    t->row_span = row_span;
+    t->first_column = first_column;
+    t->column_span = column_span;
+    t->cells_stale = false;
+}
+
+static void xi_arrange_table(xi_Node *node) {
+    xi_Table *t = (xi_Table*)node;
+    if (t->cells_width != node->width) {
+        t->cells_width = node->width;  // shared column widths follow the table width
+        xi_table_changed(t);
+    }
+    if (t->source.row_height && !t->block_height) xi_table_reset_blocks(t, 0);
+    xi_table_update_content(t);
+    xi_clamp_scroll(node);
+}
+
+static void xi_apply_clip(const SDL_Rect *clip);  // defined with the render pass
+
+void render_table(xi_Table *t) {
+    const SDL_Rect *b = &t->node.bounds;
+    xi_sync_table_cells(t);
+    int header = t->node.layout.inset_top;
+    bool skinned = xi_skin_node(&t->node);  // the header, which the background must not cover
+    int top = skinned ? header : 0;
+    xi_DrawRect(grenderer, b->x, b->y + top, b->w, b->h - top, t->background_color, FILLED);
+
+    if (header <= 0) return;
+    if (!skinned) xi_DrawRect(grenderer, b->x, b->y, b->w, header, t->header_color, FILLED);
+    for (int c = 0; c < t->column_count; ++c) {
+        int x, width;
+        xi_table_column_span(t, c, &x, &width);
+        x += b->x - t->node.scroll_x;
+        if (x + width <= b->x || x >= b->x + b->w) continue;
+
+        const char *title = xi_FrameFormat("%s%s", t->columns[c].title ? t->columns[c].title : "",
+                                           c != t->sort_column ? "" : t->sort_descending ? " v" : " ^");
+        SDL_Rect column_clip = xi_intersect_rect(t->node.clip, (SDL_Rect){x, b->y, width - 1, header});
+        xi_apply_clip(&column_clip);
+        if (title) xi_DrawText(grenderer, title, x + 4, b->y + (header - t->font_size) / 2, t->text_color, t->font_size);
+        xi_apply_clip(&t->node.clip);
+        xi_DrawRect(grenderer, x + width - 1, b->y, 1, header, t->stripe_color, FILLED);
+    }
+}
+
+void render_table_cell(xi_Table *t, xi_TableCell *cell) {
+    const SDL_Rect *b = &cell->node.bounds;
+    if (cell->row == t->selected) {
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, t->selected_color, FILLED);
+    } else if (cell->row & 1) {
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, t->stripe_color, FILLED);
+    }
+    // Long text stays inside its column
+    SDL_Rect clip = xi_intersect_rect(cell->node.clip, (SDL_Rect){b->x, b->y, b->w - 1, b->h});
+    xi_apply_clip(&clip);
+    if (cell->mark_length > 0) {
+        char part[XI_CELL_TEXT];
+        int start_x, mark_width, height;
+        SDL_strlcpy(part, cell->text, cell->mark_start + 1);
+        xi_MeasureText(part, t->font_size, &start_x, &height);
+        SDL_strlcpy(part, cell->text + cell->mark_start, cell->mark_length + 1);
+        xi_MeasureText(part, t->font_size, &mark_width, &height);
+        xi_DrawRect(grenderer, b->x + 4 + start_x, b->y + 1, mark_width, b->h - 2, t->mark_color, FILLED);
+    }
+    xi_DrawText(grenderer, cell->text, b->x + 4, b->y + (b->h - t->font_size) / 2, t->text_color, t->font_size);
+}
+
+// Offset of a display row from the top of the content
+static int xi_table_row_top(xi_Table *t, int row) {
+    if (!t->source.row_height) {
+        Sint64 top = (Sint64)row * t->row_height;
+        return top > XI_MAX_CONTENT ? XI_MAX_CONTENT : (int)top;
+    }
+    if (!t->block_height) xi_table_reset_blocks(t, 0);
+    int block = row / XI_ROW_BLOCK;
+    if (block >= t->block_count) return t->node.content_height;
+    xi_table_measure_block(t, block);
+    Sint64 top = 0;
+    for (int i = block; i > 0; i -= i & -i) top += t->block_tree[i - 1];
+    for (int r = block * XI_ROW_BLOCK; r < row; ++r) top += xi_table_row_height(t, r);
+    return top > XI_MAX_CONTENT ? XI_MAX_CONTENT : (int)top;
+}
+
+// Display row under a window position, or -1 (outside, header, past the last row)
+int xi_TableRowAt(void *table, int x, int y) {
+    xi_Table *t = (xi_Table*)table;
+    const SDL_Rect *b = &t->node.bounds;
+    if (!xi_point_in_bounds(&t->node, x, y) || y < b->y + t->node.layout.inset_top) return -1;
+    int top;
+    int row = xi_table_row_at(t, y - b->y - t->node.layout.inset_top + t->node.scroll_y, &top);
+    return row < t->row_count ? row : -1;
+}
+
+// Highlight a row (-1: none) and scroll just enough to show it
+void xi_SetTableSelection(void *table, int row) {
+    xi_Table *t = (xi_Table*)table;
+    if (row < -1 || row >= t->row_count) row = -1;
+    if (row == t->selected) return;
+    t->selected = row;
+    xi_invalidate_scroll_caches(&t->node);  // cells keep their text, only the highlight moves
+    xi_context_of(&t->node)->redraw = true;
+    if (row < 0) return;
+
+    int top = xi_table_row_top(t, row);
+    int height = xi_table_row_height(t, row);
+    int viewport = xi_viewport_height(&t->node);
+    if (top < t->node.scroll_y) {
+        xi_ScrollTo(t, t->node.scroll_x, top);
+    } else if (top + height > t->node.scroll_y + viewport) {
+        xi_ScrollTo(t, t->node.scroll_x, top + height - viewport);
+    }
+}
+
+// Clicking a row selects it. Clicking a column header sorts by it; clicking it again
+// flips the direction.
+void update_table(xi_Table *t, SDL_Event *event) {
+    if (event->type != SDL_MOUSEBUTTONDOWN || event->button.button != SDL_BUTTON_LEFT) return;
+    int mx = event->button.x, my = event->button.y;
+    const SDL_Rect *b = &t->node.bounds;
+    if (!xi_point_in_bounds(&t->node, mx, my)) return;
+    if (my >= b->y + t->node.layout.inset_top) {
+        xi_SetTableSelection(t, xi_TableRowAt(t, mx, my));
+        return;
+    }
+    if (!t->source.compare) return;
+
+    for (int c = 0; c < t->column_count; ++c) {
+        int x, width;
+        xi_table_column_span(t, c, &x, &width);
+        x += b->x - t->node.scroll_x;
+        if (mx >= x && mx < x + width) {
+            xi_SortTable(t, c, c == t->sort_column ? !t->sort_descending : false);
+            return;
+        }
+    }
+}
+
+
+//=================== UI UPDATE QUEUE ==================
+/*
+ Widgets are only ever touched by the thread running EventLoop. Other threads post
+ commands instead:
+
+     xi_PostSetValue(&myslider, reading);   // from a worker thread
+
+ Posting never blocks: commands go into a lock-free multi-producer/single-consumer
+ list (Vyukov style) and EventLoop drains it once per frame. When several commands
+ of the same kind target the same widget before the next frame, only the latest one
+ is applied, so a feed updating at kHz rates still costs one update per frame.
+ Widgets passed here must stay alive until the queue has been drained.
+*/
+typedef enum {
+    XI_CMD_SET_TEXT,
+    XI_CMD_SET_VALUE,
+    XI_CMD_INVALIDATE,
+    XI_CMD_CLOSURE
+} xi_CommandType;
+
+typedef void (*xi_Closure)(void *userdata);
+
+typedef struct xi_Command {
+    struct xi_Command *next;
+    xi_CommandType type;
+    void *widget;        // any widget; its node says what kind it is
+    int value;
+    char *text;          // heap copy, handed over to the widget when applied
+    xi_Closure fn;
+    void *userdata;
+} xi_Command;
+
+typedef struct {
+    xi_Command *head;    // producers swap themselves in here
+    xi_Command *tail;    // only touched by the consumer
+    xi_Command stub;
+    SDL_atomic_t wake_pending;
+} xi_CommandQueue;
+
+xi_CommandQueue xi_update_queue = {&xi_update_queue.stub, &xi_update_queue.stub};
+
+static void xi_queue_push(xi_CommandQueue *q, xi_Command *cmd) {
+    SDL_AtomicSetPtr((void **)&cmd->next, NULL);
+    xi_Command *prev = SDL_AtomicSetPtr((void **)&q->head, cmd);
+    // Between the swap above and this store the list is briefly disconnected;
+    // the consumer treats that as "empty for now" and picks the rest up next frame.
+    SDL_AtomicSetPtr((void **)&prev->next, cmd);
+}
+
+static xi_Command *xi_queue_pop(xi_CommandQueue *q) {
+    xi_Command *tail = q->tail;
+    xi_Command *next = SDL_AtomicGetPtr((void **)&tail->next);
+
+    if (tail == &q->stub) {
+        if (!next) return NULL;
+        q->tail = next;
+        tail = next;
+        next = SDL_AtomicGetPtr((void **)&next->next);
+    }
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    if (tail != SDL_AtomicGetPtr((void **)&q->head)) return NULL; // producer mid-push
+
+    xi_queue_push(q, &q->stub);
+    next = SDL_AtomicGetPtr((void **)&tail->next);
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+static void xi_post(xi_Command *cmd) {
+    xi_queue_push(&xi_update_queue, cmd);
+
+    // One wake event per drain is enough, no matter how many producers post
+    if (xi_wake_event != (Uint32)-1 && SDL_AtomicCAS(&xi_update_queue.wake_pending, 0, 1)) {
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = xi_wake_event;
+        SDL_PushEvent(&event);
+    }
+}
+
+static xi_Command *xi_new_command(xi_CommandType type, void *widget) {
+    xi_Command *cmd = SDL_calloc(1, sizeof(xi_Command));
+    if (!cmd) {
+        SDL_Log("Out of memory posting UI command");
+        return NULL;
+    }
+    cmd->type = type;
+    cmd->widget = widget;
+    return cmd;
+}
+
+// Replace the text of a Label, Button, Text or TextEntry (the string is copied)
+void xi_PostSetText(void *widget, const char *text) {
+    xi_Command *cmd = xi_new_command(XI_CMD_SET_TEXT, widget);
+    if (!cmd) return;
+    cmd->text = SDL_strdup(text ? text : "");
+    if (!cmd->text) {
+        SDL_Log("Out of memory posting UI command");
+        SDL_free(cmd);
+        return;
+    }
+    xi_post(cmd);
+}
+
+// Set the value of a Slider (clamped to its range when applied)
+void xi_PostSetValue(void *widget, int value) {
+    xi_Command *cmd = xi_new_command(XI_CMD_SET_VALUE, widget);
+    if (!cmd) return;
+    cmd->value = value;
+    xi_post(cmd);
+}
+
+// Ask for a redraw, e.g. after changing data a widget points to
+void xi_PostInvalidate(void *widget) {
+    xi_Command *cmd = xi_new_command(XI_CMD_INVALIDATE, widget);
+    if (!cmd) return;
+    xi_post(cmd);
+}
+
+// Run fn(userdata) on the UI thread; closures are never coalesced and run in posting order
+void xi_PostClosure(xi_Closure fn, void *userdata) {
+    xi_Command *cmd = xi_new_command(XI_CMD_CLOSURE, NULL);
+    if (!cmd) return;
+    cmd->fn = fn;
+    cmd->userdata = userdata;
+    xi_post(cmd);
+}
+
+static void xi_take_text(const char **text, char **owned, char *new_text) {
+    SDL_free(*owned);
+    *owned = new_text;
+    *text = new_text;
+}
+
+// Give a Label, Button, Text or TextEntry new text; text is a heap copy the widget takes over
+static void xi_set_widget_text(xi_Node *node, char *text) {
+    switch (node->type) {
+        case WIDGET_LABEL: {
+            Label *label = (Label*)node;
+            xi_take_text(&label->text, &label->owned_text, text);
+            return;
+        }
+        case WIDGET_BUTTON: {
+            Button *button = (Button*)node;
+            xi_take_text(&button->text, &button->owned_text, text);
+            return;
+        }
+        case WIDGET_TEXT: {
+            Text *t = (Text*)node;
+            xi_take_text(&t->text, &t->owned_text, text);
+            xi_MarkLayoutDirty(t);  // Text is sized by its content
+            return;
+        }
+        case WIDGET_ENTRY: {
+            TextEntry *entry = (TextEntry*)node;
+            strncpy(entry->text, text, MAX_TEXT_LENGTH - 1);
+            entry->text[MAX_TEXT_LENGTH - 1] = '\0';
+            int length = strlen(entry->text);
+            if (entry->cursor_position > length) entry->cursor_position = length;
+            break;
+        }
+        default:
+            break;
+    }
+    SDL_free(text);
+}
+
+// Set the value of a Slider (clamped to its range) or the row count of a Table
+static void xi_set_widget_value(xi_Node *node, int value) {
+    if (node->type == WIDGET_TABLE) {
+        xi_SetRowCount(node, value);
+    } else if (node->type == WIDGET_SLIDER) {
+        Slider *slider = (Slider*)node;
+        if (value < slider->min_value) value = slider->min_value;
+        if (value > slider->max_value) value = slider->max_value;
+        slider->value = value;
+    }
+}
+
+static void xi_apply_command(xi_Command *cmd) {
+    switch (cmd->type) {
+        case XI_CMD_SET_TEXT:
+            xi_set_widget_text(cmd->widget, cmd->text);
+            cmd->text = NULL;
+            break;
+        case XI_CMD_SET_VALUE:
+            xi_set_widget_value(cmd->widget, cmd->value);
+            break;
+        case XI_CMD_INVALIDATE:
+            if (((xi_Node*)cmd->widget)->type == WIDGET_TABLE) {
+                xi_RefreshTable(cmd->widget);
+            }
+            break;
+        case XI_CMD_CLOSURE:
+            cmd->fn(cmd->userdata);
+            xi_redraw_all();  // it may have changed anything
+            break;
+    }
+    if (cmd->widget) {
+        xi_Invalidate(cmd->widget);
+    }
+}
+
+// Scratch space reused by every drain so steady-state draining doesn't allocate
+static xi_Command **xi_drain_cmds = NULL;
+static int xi_drain_capacity = 0;
+static int *xi_drain_slots = NULL;
+static int xi_drain_slot_capacity = 0;
+
+static Uint32 xi_command_hash(const xi_Command *cmd) {
+    uintptr_t key = (uintptr_t)cmd->widget ^ ((uintptr_t)cmd->type << 3);
+    key ^= key >> 17;
+    key *= 0x9E3779B1u;
+    return (Uint32)(key ^ (key >> 15));
+}
+
+static bool xi_same_target(const xi_Command *a, const xi_Command *b) {
+    return a->widget == b->widget && a->type == b->type;
+}
+
+// Apply everything posted since the last call. Called once per frame by EventLoop.
+void xi_ProcessUpdateQueue(void) {
+    SDL_AtomicSet(&xi_update_queue.wake_pending, 0);
+
+    int count = 0;
+    xi_Command *cmd;
+    while ((cmd = xi_queue_pop(&xi_update_queue)) != NULL) {
+        if (count == xi_drain_capacity) {
+            int capacity = xi_drain_capacity ? xi_drain_capacity * 2 : 64;
+            xi_Command **grown = SDL_realloc(xi_drain_cmds, capacity * sizeof(xi_Command*));
+            if (!grown) {
+                SDL_Log("Out of memory draining UI commands");
+                xi_apply_command(cmd);
+                SDL_free(cmd->text);
+                SDL_free(cmd);
+                continue;
+            }
+            xi_drain_cmds = grown;
+            xi_drain_capacity = capacity;
+        }
+        xi_drain_cmds[count++] = cmd;
+    }
+    if (count == 0) return;
+
+    // Open-addressing table from (widget, command type) to the newest command for it
+    int slots = 16;
+    while (slots < count * 2) slots *= 2;
+    if (slots > xi_drain_slot_capacity) {
+        int *grown = SDL_realloc(xi_drain_slots, slots * sizeof(int));
+        if (grown) {
+            xi_drain_slots = grown;
+            xi_drain_slot_capacity = slots;
+        } else {
+            slots = 0;  // can't coalesce this time, apply everything in order
+        }
+    }
+    if (slots) {
+        memset(xi_drain_slots, -1, slots * sizeof(int));
+        for (int i = 0; i < count; ++i) {
+            if (xi_drain_cmds[i]->type == XI_CMD_CLOSURE) continue;
+            Uint32 h = xi_command_hash(xi_drain_cmds[i]) & (slots - 1);
+            while (xi_drain_slots[h] >= 0 && !xi_same_target(xi_drain_cmds[xi_drain_slots[h]], xi_drain_cmds[i])) {
+                h = (h + 1) & (slots - 1);
+            }
+            xi_drain_slots[h] = i;  // later commands overwrite earlier ones
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        cmd = xi_drain_cmds[i];
+        bool latest = true;
+        if (slots && cmd->type != XI_CMD_CLOSURE) {
+            Uint32 h = xi_command_hash(cmd) & (slots - 1);
+            while (!xi_same_target(xi_drain_cmds[xi_drain_slots[h]], cmd)) {
+                h = (h + 1) & (slots - 1);
+            }
+            latest = xi_drain_slots[h] == i;
+        }
+        if (latest) {
+            xi_apply_command(cmd);
+        }
+        SDL_free(cmd->text);
+        SDL_free(cmd);
+    }
+}
+
+//=================== BINDINGS ==================
+/*
+ Model values that widgets show, so the application changes a value once instead of
+ every widget that displays it:
+
+    static void format_volume(xi_Value *result, xi_Value *const *in, int count, void *userdata) {
+        char text[32];
+        SDL_snprintf(text, sizeof(text), "Volume %g%%", xi_GetNumber(in[0]));
+        xi_SetString(result, text);
+    }
+
+    xi_Value *volume = xi_CreateNumber(40);
+    xi_Value *caption = xi_CreateComputed(XI_VALUE_STRING, format_volume, NULL, &volume, 1);
+    xi_Bind(&slider, volume);           // dragging the slider sets volume
+    xi_Bind(&label, caption);
+    xi_SetNumber(volume, 55);           // both widgets follow on the next frame
+
+ Setting a value only queues it. Once per frame EventLoop calls xi_PropagateValues(),
+ which walks the changes in topological order (by depth in the graph), so a computed
+ value is recomputed once after all of its inputs, and a widget is updated and
+ invalidated once however many of its values changed. A recomputed value that comes
+ out the same stops there. The work follows what changed, not how many widgets are
+ bound. Values belong to the UI thread; other threads use xi_PostClosure. Compute
+ functions read their inputs and set their result, nothing else.
+*/
+typedef enum { XI_VALUE_NUMBER, XI_VALUE_STRING } xi_ValueKind;
+
+typedef struct xi_Value xi_Value;
+
+// Sets result from the inputs with xi_SetNumber or xi_SetString
+typedef void (*xi_ComputeFn)(xi_Value *result, xi_Value *const *inputs, int count, void *userdata);
+
+typedef struct xi_Binding {
+    xi_Node *widget;
+    xi_Value *value;
+    int index;                  // position in value->bindings
+    bool queued;                // waiting to be applied by this propagation
+} xi_Binding;
+
+struct xi_Value {
+    xi_ValueKind kind;
+    double number;
+    char *text;                 // strings only, never NULL
+    int level;                  // 0 for plain values, 1 + the deepest input for computed ones
+    bool queued;                // waiting in xi_dirty_levels
+    bool changed;               // the running compute function changed the result
+    xi_ComputeFn compute;       // NULL for plain values
+    void *userdata;
+    xi_Value **inputs;
+    int input_count;
+    xi_Value **dependents;      // computed values reading this one
+    int dependent_count, dependent_capacity;
+    xi_Binding **bindings;      // widgets showing this one
+    int binding_count, binding_capacity;
+    xi_Node *written_by;        // widget whose edit set it, left as the user typed it
+};
+
+typedef struct {
+    int values_updated;         // changed values whose dependents were visited
+    int widgets_updated;
+} xi_BindingStats;
+
+xi_BindingStats xi_binding_stats;
+
+typedef struct {
+    xi_Value **items;
+    int count, capacity;
+} xi_ValueQueue;
+
+#define XI_MAX_PROPAGATION_ROUNDS 8  // compute functions setting other values start another round
+
+// Changed values waiting for xi_PropagateValues, one queue per level
+static xi_ValueQueue *xi_dirty_levels = NULL;
+static int xi_dirty_level_count = 0;
+static bool xi_values_dirty = false;
+static xi_Binding **xi_dirty_bindings = NULL;
+static int xi_dirty_binding_count = 0;
+static int xi_dirty_binding_capacity = 0;
+static xi_Value *xi_computing = NULL;  // value whose compute function is running
+
+static bool xi_grow_array(void **items, int *capacity, int count, size_t size) {
+    if (count < *capacity) return true;
+    int grown = *capacity ? *capacity * 2 : 8;
+    void *p = SDL_realloc(*items, grown * size);
+    if (!p) {
+        SDL_Log("Out of memory binding values");
+        return false;
+    }
+    *items = p;
+    *capacity = grown;
+    return true;
+}
+
+static void xi_queue_value(xi_Value *value) {
+    if (value->queued) return;
+    if (value->level >= xi_dirty_level_count) {
+        int count = value->level + 1;
+        xi_ValueQueue *levels = SDL_realloc(xi_dirty_levels, count * sizeof(xi_ValueQueue));
+        if (!levels) {
+            SDL_Log("Out of memory queueing a value change");
+            return;
+        }
+        memset(levels + xi_dirty_level_count, 0, (count - xi_dirty_level_count) * sizeof(xi_ValueQueue));
+        xi_dirty_levels = levels;
+        xi_dirty_level_count = count;
+    }
+    xi_ValueQueue *q = &xi_dirty_levels[value->level];
+    if (!xi_grow_array((void**)&q->items, &q->capacity, q->count, sizeof(xi_Value*))) return;
+    q->items[q->count++] = value;
+    value->queued = true;
+    xi_values_dirty = true;
+}
+
+static bool xi_store_string(xi_Value *value, const char *text);
+
+// Store without propagating; true when the value changed
+static bool xi_store_number(xi_Value *value, double number) {
+    if (value->kind == XI_VALUE_STRING) {
+        char buffer[32];
+        SDL_snprintf(buffer, sizeof(buffer), "%g", number);
+        return xi_store_string(value, buffer);
+    }
+    if (value->number == number) return false;
+    value->number = number;
+    return true;
+}
+
+static bool xi_store_string(xi_Value *value, const char *text) {
+    if (!text) text = "";
+    if (value->kind == XI_VALUE_NUMBER) return xi_store_number(value, SDL_strtod(text, NULL));
+    if (strcmp(value->text, text) == 0) return false;
+    char *copy = SDL_strdup(text);
+    if (!copy) {
+        SDL_Log("Out of memory setting a value");
+        return false;
+    }
+    SDL_free(value->text);
+    value->text = copy;
+    return true;
+}
+
+static bool xi_can_set(xi_Value *value) {
+    if (!value) return false;
+    if (value->compute && value != xi_computing) {
+        SDL_Log("Computed values are set by their compute function");
+        return false;
+    }
+    return true;
+}
+
+static void xi_value_stored(xi_Value *value, bool changed) {
+    if (!changed) return;
+    if (value == xi_computing) value->changed = true;
+    else xi_queue_value(value);
+}
+
+// Numbers set on a string value are formatted with %g, strings set on a number are parsed
+void xi_SetNumber(xi_Value *value, double number) {
+    if (!xi_can_set(value) || !xi_store_number(value, number)) return;
+    value->written_by = NULL;
+    xi_value_stored(value, true);
+}
+
+void xi_SetString(xi_Value *value, const char *text) {
+    if (!xi_can_set(value) || !xi_store_string(value, text)) return;
+    value->written_by = NULL;
+    xi_value_stored(value, true);
+}
+
+double xi_GetNumber(const xi_Value *value) {
+    return value->kind == XI_VALUE_STRING ? SDL_strtod(value->text, NULL) : value->number;
+}
+
+// The text of a string value (NULL for numbers)
+const char *xi_GetString(const xi_Value *value) {
+    return value->kind == XI_VALUE_STRING ? value->text : NULL;
+}
+
+static const char *xi_value_text(const xi_Value *value, char *buffer, int size) {
+    if (value->kind == XI_VALUE_STRING) return value->text;
+    SDL_snprintf(buffer, size, "%g", value->number);
+    return buffer;
+}
+
+static xi_Value *xi_new_value(xi_ValueKind kind) {
+    xi_Value *value = SDL_calloc(1, sizeof(xi_Value));
+    if (value && kind == XI_VALUE_STRING) value->text = SDL_strdup("");
+    if (!value || (kind == XI_VALUE_STRING && !value->text)) {
+        SDL_Log("Out of memory creating a value");
+        SDL_free(value);
+        return NULL;
+    }
+    value->kind = kind;
+    return value;
+}
+
+xi_Value *xi_CreateNumber(double number) {
+    xi_Value *value = xi_new_value(XI_VALUE_NUMBER);
+    if (value) value->number = number;
+    return value;
+}
+
+xi_Value *xi_CreateString(const char *text) {
+    xi_Value *value = xi_new_value(XI_VALUE_STRING);
+    if (value) xi_store_string(value, text);
+    return value;
+}
+
+static bool xi_recompute(xi_Value *value) {
+    xi_Value *outer = xi_computing;
+    xi_computing = value;
+    value->changed = false;
+    value->compute(value, value->inputs, value->input_count, value->userdata);
+    xi_computing = outer;
+    return value->changed;
+}
+
+void xi_DestroyValue(xi_Value *value);
+
+// A value computed from others whenever one of them changes. Inputs must exist first,
+// which keeps the graph free of cycles.
+xi_Value *xi_CreateComputed(xi_ValueKind kind, xi_ComputeFn fn, void *userdata, xi_Value *const *inputs, int count) {
+    xi_Value *value = xi_new_value(kind);
+    if (!value) return NULL;
+    value->compute = fn;
+    value->userdata = userdata;
+    if (count > 0) {
+        value->inputs = SDL_malloc(count * sizeof(xi_Value*));
+        if (!value->inputs) {
+            SDL_Log("Out of memory creating a value");
+            xi_DestroyValue(value);
+            return NULL;
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        xi_Value *input = inputs[i];
+        if (!xi_grow_array((void**)&input->dependents, &input->dependent_capacity, input->dependent_count, sizeof(xi_Value*))) {
+            xi_DestroyValue(value);
+            return NULL;
+        }
+        input->dependents[input->dependent_count++] = value;
+        value->inputs[value->input_count++] = input;
+        if (input->level + 1 > value->level) value->level = input->level + 1;
+    }
+    xi_recompute(value);
+    return value;
+}
+
+// Copy the bound value into its widget
+static void xi_apply_binding(xi_Binding *binding) {
+    xi_Node *node = binding->widget;
+    if (node->type == WIDGET_SLIDER || node->type == WIDGET_TABLE) {
+        xi_set_widget_value(node, (int)SDL_floor(xi_GetNumber(binding->value) + 0.5));
+    } else {
+        char buffer[32];
+        char *text = SDL_strdup(xi_value_text(binding->value, buffer, sizeof(buffer)));
+        if (!text) {
+            SDL_Log("Out of memory showing a value");
+            return;
+        }
+        xi_set_widget_text(node, text);
+    }
+    xi_Invalidate(node);
+    xi_binding_stats.widgets_updated++;
+}
+
+static void xi_queue_binding(xi_Binding *binding) {
+    if (binding->queued) return;
+    if (!xi_grow_array((void**)&xi_dirty_bindings, &xi_dirty_binding_capacity, xi_dirty_binding_count, sizeof(xi_Binding*))) return;
+    xi_dirty_bindings[xi_dirty_binding_count++] = binding;
+    binding->queued = true;
+}
+
+// Bring everything that depends on the values set since the last call up to date.
+// Called once per frame by EventLoop.
+void xi_PropagateValues(void) {
+    if (!xi_values_dirty) return;
+    for (int round = 0; xi_values_dirty && round < XI_MAX_PROPAGATION_ROUNDS; ++round) {
+        xi_values_dirty = false;
+        // Dependents always sit on deeper levels, so each level is final once reached
+        for (int level = 0; level < xi_dirty_level_count; ++level) {
+            for (int i = 0; i < xi_dirty_levels[level].count; ++i) {
+                xi_Value *value = xi_dirty_levels[level].items[i];
+                value->queued = false;
+                if (value->compute && !xi_recompute(value)) continue;  // same result, nothing below changes
+                xi_binding_stats.values_updated++;
+                for (int d = 0; d < value->dependent_count; ++d) {
+                    xi_queue_value(value->dependents[d]);
+                }
+                for (int b = 0; b < value->binding_count; ++b) {
+                    if (value->bindings[b]->widget != value->written_by) xi_queue_binding(value->bindings[b]);
+                }
+                value->written_by = NULL;
+            }
+            xi_dirty_levels[level].count = 0;
+        }
+    }
+    if (xi_values_dirty) {
+        SDL_Log("Values still changing after %d rounds; the rest waits for the next frame", XI_MAX_PROPAGATION_ROUNDS);
+    }
+    for (int i = 0; i < xi_dirty_binding_count; ++i) {
+        xi_dirty_bindings[i]->queued = false;
+        xi_apply_binding(xi_dirty_bindings[i]);
+    }
+    xi_dirty_binding_count = 0;
+}
+
+// Stop a widget following its value; it keeps what it shows
+void xi_Unbind(void *widget) {
+    xi_Node *node = (xi_Node*)widget;
+    xi_Binding *binding = node->binding;
+    if (!binding) return;
+    xi_Value *value = binding->value;
+    xi_Binding *last = value->bindings[--value->binding_count];
+    value->bindings[binding->index] = last;
+    last->index = binding->index;
+    if (binding->queued) {
+        for (int i = 0; i < xi_dirty_binding_count; ++i) {
+            if (xi_dirty_bindings[i] == binding) xi_dirty_bindings[i] = xi_dirty_bindings[--xi_dirty_binding_count];
+        }
+    }
+    SDL_free(binding);
+    node->binding = NULL;
+}
+
+// Show value in a Label, Button, Text, TextEntry, Slider or Table (as its row count).
+// Sliders and entries write what the user does back into a plain value.
+void xi_Bind(void *widget, xi_Value *value) {
+    xi_Node *node = (xi_Node*)widget;
+    xi_Unbind(node);
+    if (!value) return;
+    xi_Binding *binding = SDL_calloc(1, sizeof(xi_Binding));
+    if (!binding || !xi_grow_array((void**)&value->bindings, &value->binding_capacity, value->binding_count, sizeof(xi_Binding*))) {
+        SDL_Log("Out of memory binding a widget");
+        SDL_free(binding);
+        return;
+    }
+    binding->widget = node;
+    binding->value = value;
+    binding->index = value->binding_count;
+    value->bindings[value->binding_count++] = binding;
+    node->binding = binding;
+    xi_apply_binding(binding);
+}
+
+// A slider was dragged or an entry edited. The widget itself is not updated from the
+// value, or an entry bound to a number would turn "" into "0" while it is being typed.
+static void xi_write_back(xi_Node *node) {
+    xi_Value *value = node->binding->value;
+    if (value->compute) return;  // computed values only flow into widgets
+    bool changed = false;
+    if (node->type == WIDGET_SLIDER) changed = xi_store_number(value, ((Slider*)node)->value);
+    else if (node->type == WIDGET_ENTRY) changed = xi_store_string(value, ((TextEntry*)node)->text);
+    if (!changed) return;
+    value->written_by = node;
+    xi_value_stored(value, true);
+}
+
+// Free a value and unbind its widgets. Computed values reading it must go first.
+void xi_DestroyValue(xi_Value *value) {
+    if (!value) return;
+    if (value->dependent_count > 0) {
+        SDL_Log("Value still has %d computed values reading it", value->dependent_count);
+        return;
+    }
+    while (value->binding_count > 0) {
+        xi_Unbind(value->bindings[0]->widget);
+    }
+    for (int i = 0; i < value->input_count; ++i) {
+        xi_Value *input = value->inputs[i];
+        for (int d = 0; d < input->dependent_count; ++d) {
+            if (input->dependents[d] == value) {
+                input->dependents[d] = input->dependents[--input->dependent_count];
+                break;
+            }
+        }
+    }
+    if (value->queued) {
+        xi_ValueQueue *q = &xi_dirty_levels[value->level];
+        for (int i = 0; i < q->count; ++i) {
+            if (q->items[i] == value) {
+                memmove(q->items + i, q->items + i + 1, (q->count - i - 1) * sizeof(xi_Value*));
+                q->count--;
+                break;
+            }
+        }
+    }
+    SDL_free(value->inputs);
+    SDL_free(value->dependents);
+    SDL_free(value->bindings);
+    SDL_free(value->text);
+    SDL_free(value);
+}
+
+//=================== WORKER THREADS ==================
+/*
+ A small pool of threads for slow work that must not hold up the UI thread, such as
+ decoding images. A job hands its result back with xi_PostClosure:
+
+    xi_RunInBackground(decode, job);    // decode(job) runs on a worker,
+                                        // then calls xi_PostClosure(show, job)
+
+ Jobs start in the order they were queued. The pool is started on first use with one
+ thread per core but one (at least 1, at most XI_MAX_WORKERS).
+*/
+#define XI_MAX_WORKERS 8
+
+typedef struct xi_Job {
+    struct xi_Job *next;
+    xi_Closure fn;
+    xi_Closure cancel;  // called instead of fn if the pool stops first; may be NULL
+    void *userdata;
+} xi_Job;
+
+static struct {
+    SDL_mutex *lock;
+    SDL_cond *wake;
+    xi_Job *head, *tail;
+    SDL_Thread *threads[XI_MAX_WORKERS];
+    int thread_count;
+    bool quit;
+} xi_workers;
+
+static int xi_worker_main(void *data) {
+    (void)data;
+    SDL_LockMutex(xi_workers.lock);
+    for (;;) {
+        while (!xi_workers.head && !xi_workers.quit) {
+            SDL_CondWait(xi_workers.wake, xi_workers.lock);
+        }
+        if (xi_workers.quit) break;
+        xi_Job *job = xi_workers.head;
+        xi_workers.head = job->next;
+        if (!xi_workers.head) xi_workers.tail = NULL;
+        SDL_UnlockMutex(xi_workers.lock);
+
+        job->fn(job->userdata);
+        SDL_free(job);
+        SDL_LockMutex(xi_workers.lock);
+    }
+    SDL_UnlockMutex(xi_workers.lock);
+    return 0;
+}
+
+static bool xi_start_workers(void) {
+    if (xi_workers.thread_count > 0) return true;
+    if (!xi_workers.lock) {
+        xi_workers.lock = SDL_CreateMutex();
+        xi_workers.wake = SDL_CreateCond();
+        if (!xi_workers.lock || !xi_workers.wake) {
+            SDL_Log("Failed to create worker lock: %s", SDL_GetError());
+            return false;
+        }
+    }
+    int count = SDL_GetCPUCount() - 1;
+    if (count < 1) count = 1;
+    if (count > XI_MAX_WORKERS) count = XI_MAX_WORKERS;
+    xi_workers.quit = false;
+    for (int i = 0; i < count; ++i) {
+        SDL_Thread *thread = SDL_CreateThread(xi_worker_main, "xi worker", NULL);
+        if (!thread) {
+            SDL_Log("Failed to start worker thread: %s", SDL_GetError());
+            break;
+        }
+        xi_workers.threads[xi_workers.thread_count++] = thread;
+    }
+    return xi_workers.thread_count > 0;
+}
+
+// Hand a job to the running pool; false if there is none. Unlike xi_RunInBackground
+// this never starts the pool, so other threads may call it once it runs.
+static bool xi_queue_job(xi_Closure fn, xi_Closure cancel, void *userdata) {
+    if (xi_workers.thread_count == 0) return false;
+    xi_Job *job = SDL_malloc(sizeof(xi_Job));
+    if (!job) {
+        SDL_Log("Out of memory for background job");
+        return false;
+    }
+    job->next = NULL;
+    job->fn = fn;
+    job->cancel = cancel;
+    job->userdata = userdata;
+
+    SDL_LockMutex(xi_workers.lock);
+    if (xi_workers.tail) xi_workers.tail->next = job;
+    else xi_workers.head = job;
+    xi_workers.tail = job;
+    SDL_CondSignal(xi_workers.wake);
+    SDL_UnlockMutex(xi_workers.lock);
+    return true;
+}
+
+// Like xi_RunInBackground; cancel(userdata) runs on the UI thread instead if the pool
+// is stopped before the job starts, so the job can release what it holds
+static bool xi_run_in_background(xi_Closure fn, xi_Closure cancel, void *userdata) {
+    return xi_start_workers() && xi_queue_job(fn, cancel, userdata);
+}
+
+// Run fn(userdata) on a worker thread. Returns false (and runs nothing) if no worker
+// could be started.
+bool xi_RunInBackground(xi_Closure fn, void *userdata) {
+    return xi_run_in_background(fn, NULL, userdata);
+}
+
+// Stop the pool after the running jobs finish. Queued jobs don't run; the library's
+// own get their cancel call. Called by xiDestroyWindow.
+void xi_StopWorkers(void) {
+    if (!xi_workers.lock) return;
+    SDL_LockMutex(xi_workers.lock);
+    xi_workers.quit = true;
+    SDL_CondBroadcast(xi_workers.wake);
+    SDL_UnlockMutex(xi_workers.lock);
+    for (int i = 0; i < xi_workers.thread_count; ++i) {
+        SDL_WaitThread(xi_workers.threads[i], NULL);
+    }
+    xi_workers.thread_count = 0;
+    while (xi_workers.head) {
+        xi_Job *job = xi_workers.head;
+        xi_workers.head = job->next;
+        if (job->cancel) job->cancel(job->userdata);
+        SDL_free(job);
+    }
+    xi_workers.tail = NULL;
+    SDL_DestroyCond(xi_workers.wake);
+    SDL_DestroyMutex(xi_workers.lock);
+    xi_workers.wake = NULL;
+    xi_workers.lock = NULL;
+}
+
+
+//=================== LOG VIEWER ==================
+/*
+ A read-only view of a (possibly huge, possibly growing) text file, one list row per
+ line:
+
+    xi_LogView log = xi_CreateLogView(0, 0, 600, 400, 14);
+    xi_AddWidget(&panel, &log);
+    xi_OpenLog(&log, "/var/log/syslog", true);   // true: follow appended lines
+    xi_SearchLog(&log, "error");                 // highlight and jump to the next match
+
+ Opening returns at once. A background thread reads the file in chunks and records the
+ byte offset of every XI_LOG_CHECKPOINT-th line; rows appear as it gets through the
+ file. The widget memory-maps what has been indexed and finds a line by scanning
+ forward from the nearest checkpoint, so memory is bounded by the visible lines plus a
+ small fraction of the line count, never by the file size. While following, the thread
+ only reads what was appended since its last look.
+
+ Searching also runs on that thread; the visible lines are highlighted straight away.
+ A file that is truncated (logrotate's copytruncate) is indexed again from the start.
+ The view checks the file's size before reading the mapping, so until then the lines
+ past the new end show empty instead of faulting; only a truncation landing between
+ that check and the read of one line can still do so.
+*/
+#define XI_LOG_CHECKPOINT 1024      // lines between remembered line offsets
+#define XI_LOG_CHUNK (1 << 20)      // bytes read at a time by the background thread
+#define XI_LOG_POLL 250             // ms between size checks while following
+#define XI_LOG_POST_INTERVAL 50     // ms between row count updates while indexing
+#define XI_LOG_QUERY 128
+#define XI_LOG_MAP_MIN (64 << 20)   // bytes mapped at least; mappings grow by doubling
+
+typedef struct xi_LogView {
+    xi_Table table;                 // the lines are rows of a headerless list
+    char *path;
+    bool follow;
+    Uint32 serial;                  // tells posts for this opening from ones for an earlier view here
+    struct xi_LogView *next_open;   // open views, to drop posts for closed ones
+
+    // UI thread: mapping of (at least) the indexed part of the file
+    const char *data;
+    Sint64 mapped_size;             // length of the mapping, may reach past the end of the file
+    Sint64 readable_end;            // indexed bytes as of the last look
+    Uint32 mapped_generation;
+#ifdef _WIN32
+    HANDLE file_handle, mapping_handle;
+#else
+    int fd;
+#endif
+    int cached_line;                // last line located and where it starts, to read on from there
+    Sint64 cached_offset;
+    char query[XI_LOG_QUERY];       // highlighted in visible lines
+
+    // Shared with the background thread, guarded by lock
+    SDL_mutex *lock;
+    SDL_cond *wake;
+    SDL_Thread *thread;
+    bool stop;
+    Sint64 *checkpoints;            // offset of line k * XI_LOG_CHECKPOINT
+    int checkpoint_count, checkpoint_capacity;
+    int line_count;
+    Sint64 indexed_end;             // lines up to here may be read
+    Uint32 generation;              // bumped when the file shrank and indexing started over
+    char search_query[XI_LOG_QUERY];
+    Uint32 search_id, found_id;
+    int search_line;                // line the search starts at, and its offset
+    Sint64 search_offset;
+    int found_line;                 // -1: no match
+} xi_LogView;
+
+static const char *xi_log_cell(void *userdata, int row, int column, char *buffer, int size);
+static bool xi_log_mark(void *userdata, int row, int column, const char *text, int *start, int *length);
+
+xi_LogView xi_CreateLogView(int x, int y, int width, int height, int font_size) {
+    xi_LogView view;
+    memset(&view, 0, sizeof(view));
+    xi_DataSource source = {xi_log_cell, NULL, NULL, NULL, xi_log_mark};
+    view.table = xi_CreateList(x, y, width, height, 0, font_size + 6, font_size, source);
+    view.cached_line = -1;
+    view.found_line = -1;
+#ifdef _WIN32
+    view.file_handle = view.mapping_handle = NULL;
+#else
+    view.fd = -1;
+#endif
+    return view;
+}
+
+static void xi_log_unmap(xi_LogView *view) {
+    if (!view->data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(view->data);
+    CloseHandle(view->mapping_handle);
+    view->mapping_handle = NULL;
+#else
+    munmap((void*)view->data, (size_t)view->mapped_size);
+#endif
+    view->data = NULL;
+    view->mapped_size = 0;
+}
+
+// Map at least the first `size` bytes of the file. POSIX mappings may reach past the end
+// of the file as long as those pages aren't read, so they grow by doubling and a growing
+// log is mapped again only now and then; Windows can't map past the end.
+static bool xi_log_map(xi_LogView *view, Sint64 size) {
+    xi_log_unmap(view);
+    if (size <= 0 || (Uint64)size > (size_t)-1) return size <= 0;
+#ifdef _WIN32
+    view->mapping_handle = CreateFileMappingA(view->file_handle, NULL, PAGE_READONLY,
+                                              (DWORD)((Uint64)size >> 32), (DWORD)size, NULL);
+    if (view->mapping_handle) {
+        view->data = MapViewOfFile(view->mapping_handle, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+        if (!view->data) CloseHandle(view->mapping_handle);
+    }
+#else
+    Sint64 length = XI_LOG_MAP_MIN;
+    while (length < size) length *= 2;
+    void *data = (Uint64)length <= (size_t)-1 ? mmap(NULL, (size_t)length, PROT_READ, MAP_SHARED, view->fd, 0) : MAP_FAILED;
+    if (data == MAP_FAILED) {  // short of address space: just what is needed
+        length = size;
+        data = mmap(NULL, (size_t)length, PROT_READ, MAP_SHARED, view->fd, 0);
+    }
+    view->data = data == MAP_FAILED ? NULL : data;
+    size = length;
+#endif
+    if (!view->data) {
+        SDL_Log("Failed to map '%s'", view->path);
+        return false;
+    }
+    view->mapped_size = size;
+    return true;
+}
+
+// Rows (and where the readable bytes end) as last published by the background thread
+static int xi_log_published(xi_LogView *view, Sint64 *end, Uint32 *generation) {
+    SDL_LockMutex(view->lock);
+    int lines = view->line_count;
+    *end = view->indexed_end;
+    *generation = view->generation;
+    SDL_UnlockMutex(view->lock);
+    return lines;
+}
+
+// How much of the mapping may be read: the indexed bytes that are still in the file.
+// Reading a mapped page past the end of a truncated file would raise SIGBUS.
+static Sint64 xi_log_readable(xi_LogView *view) {
+    Sint64 size;
+#ifdef _WIN32
+    LARGE_INTEGER length;
+    size = GetFileSizeEx(view->file_handle, &length) ? length.QuadPart : 0;
+#else
+    struct stat info;
+    size = fstat(view->fd, &info) == 0 ? (Sint64)info.st_size : 0;
+#endif
+    Sint64 end = view->readable_end < view->mapped_size ? view->readable_end : view->mapped_size;
+    return size < end ? size : end;
+}
+
+// Byte offset where a line starts, or -1. Lines are found from the closest checkpoint,
+// or from the last line found when reading on (the usual case while rendering rows).
+// Only the first `readable` bytes of the mapping are looked at.
+static Sint64 xi_log_line_start(xi_LogView *view, int line, Sint64 readable) {
+    if (view->cached_line < 0 || line < view->cached_line || line - view->cached_line >= XI_LOG_CHECKPOINT) {
+        SDL_LockMutex(view->lock);
+        int checkpoint = line / XI_LOG_CHECKPOINT;
+        bool known = checkpoint < view->checkpoint_count;
+        if (known) view->cached_offset = view->checkpoints[checkpoint];
+        SDL_UnlockMutex(view->lock);
+        if (!known) return -1;
+        view->cached_line = checkpoint * XI_LOG_CHECKPOINT;
+    }
+    if (view->cached_offset > readable) return -1;
+    const char *end = view->data + readable;
+    const char *p = view->data + view->cached_offset;
+    while (view->cached_line < line) {
+        p = p < end ? memchr(p, '\n', end - p) : NULL;
+        if (!p) return -1;
+        p++;
+        view->cached_line++;
+        view->cached_offset = p - view->data;
+    }
+    return view->cached_offset;
+}
+
+static const char *xi_log_cell(void *userdata, int row, int column, char *buffer, int size) {
+    (void)column;
+    xi_LogView *view = (xi_LogView*)userdata;
+    Sint64 end;
+    Uint32 generation;
+    if (row >= xi_log_published(view, &end, &generation)) return "";
+    if (generation != view->mapped_generation) {
+        view->cached_line = -1;  // indexing started over; the mapping still shows the file
+        view->mapped_generation = generation;
+    }
+    view->readable_end = end;
+    if (end > view->mapped_size && !xi_log_map(view, end)) return "";
+
+    Sint64 readable = xi_log_readable(view);
+    Sint64 start = xi_log_line_start(view, row, readable);
+    if (start < 0) return "";
+    const char *p = view->data + start;
+    const char *limit = view->data + readable;
+    int length = 0;
+    // Tabs and control characters would show as boxes
+    for (; p < limit && *p != '\n' && length < size - 1; ++p) {
+        if (*p == '\r') continue;
+        buffer[length++] = (unsigned char)*p < ' ' ? ' ' : *p;
+    }
+    buffer[length] = '\0';
+    return buffer;
+}
+
+static bool xi_log_mark(void *userdata, int row, int column, const char *text, int *start, int *length) {
+    (void)row;
+    (void)column;
+    xi_LogView *view = (xi_LogView*)userdata;
+    if (!view->query[0]) return false;
+    const char *found = strstr(text, view->query);
+    if (!found) return false;
+    *start = (int)(found - text);
+    *length = (int)strlen(view->query);
+    return true;
+}
+
+// ---- Background thread ----
+
+static void xi_log_add_checkpoint(xi_LogView *view, Sint64 offset) {
+    SDL_LockMutex(view->lock);
+    if (view->checkpoint_count == view->checkpoint_capacity) {
+        int capacity = view->checkpoint_capacity ? view->checkpoint_capacity * 2 : 256;
+        Sint64 *checkpoints = SDL_realloc(view->checkpoints, capacity * sizeof(Sint64));
+        if (!checkpoints) {
+            SDL_UnlockMutex(view->lock);
+            SDL_Log("Out of memory indexing '%s'", view->path);
+            return;
+        }
+        view->checkpoints = checkpoints;
+        view->checkpoint_capacity = capacity;
+    }
+    view->checkpoints[view->checkpoint_count++] = offset;
+    SDL_UnlockMutex(view->lock);
+}
+
+static const char *xi_find_bytes(const char *haystack, size_t size, const char *needle, size_t length) {
+    if (length == 0 || size < length) return NULL;
+    const char *last = haystack + size - length;
+    for (const char *p = haystack; p <= last; ++p) {
+        p = memchr(p, needle[0], last - p + 1);
+        if (!p) return NULL;
+        if (memcmp(p, needle, length) == 0) return p;
+    }
+    return NULL;
+}
+
+// What the background thread hands to the UI thread. It names the view by address and
+// serial, so a post still queued when the view is closed (and maybe freed) is dropped.
+typedef struct {
+    xi_LogView *view;
+    Uint32 serial;
+    int rows;                       // -1: a search finished
+} xi_LogPost;
+
+static void xi_log_apply_post(void *userdata);
+
+static void xi_log_post(xi_LogView *view, int rows) {
+    xi_LogPost *post = SDL_malloc(sizeof(xi_LogPost));
+    if (!post) {
+        SDL_Log("Out of memory posting log update");
+        return;
+    }
+    *post = (xi_LogPost){view, view->serial, rows};
+    xi_PostClosure(xi_log_apply_post, post);
+}
+
+/*
+ Look for the query from (line, offset) to the end of the index, then from the start
+ back to where it began. Gives up as soon as a newer search (or close) comes in.
+*/
+static void xi_log_search(xi_LogView *view, SDL_RWops *file, char *buffer) {
+    SDL_LockMutex(view->lock);
+    Uint32 id = view->search_id;
+    char query[XI_LOG_QUERY];
+    SDL_strlcpy(query, view->search_query, sizeof(query));
+    int line = view->search_line;
+    Sint64 offset = view->search_offset, end = view->indexed_end;
+    SDL_UnlockMutex(view->lock);
+
+    size_t length = strlen(query);
+    int found = -1;
+    Sint64 start_offset = offset, limit = end;
+    bool wrapped = false;
+    while (found < 0 && length > 0 && length < XI_LOG_CHUNK) {
+        if (offset >= limit) {
+            if (wrapped) break;
+            wrapped = true;  // carry on from the top down to where the search started
+            offset = 0;
+            line = 0;
+            limit = start_offset + (Sint64)length - 1 < end ? start_offset + (Sint64)length - 1 : end;
+            continue;
+        }
+        SDL_LockMutex(view->lock);
+        bool superseded = view->stop || view->search_id != id;
+        SDL_UnlockMutex(view->lock);
+        if (superseded) return;
+
+        Sint64 want = limit - offset < XI_LOG_CHUNK ? limit - offset : XI_LOG_CHUNK;
+        if (SDL_RWseek(file, offset, RW_SEEK_SET) < 0) break;
+        size_t got = SDL_RWread(file, buffer, 1, (size_t)want);
+        if (got == 0) break;
+
+        const char *match = xi_find_bytes(buffer, got, query, length);
+        // The next chunk starts early enough to catch a match across the boundary
+        size_t advance = offset + (Sint64)got < limit && got >= length ? got - (length - 1) : got;
+        const char *counted_end = match ? match : buffer + advance;
+        for (const char *p = buffer; (p = memchr(p, '\n', counted_end - p)) != NULL; ++p) line++;
+        if (match) found = line;
+        offset += advance;
+    }
+
+    SDL_LockMutex(view->lock);
+    if (view->search_id == id) {
+        view->found_id = id;
+        view->found_line = found;
+    }
+    SDL_UnlockMutex(view->lock);
+    xi_log_post(view, -1);
+}
+
+static int xi_log_indexer(void *data) {
+    xi_LogView *view = (xi_LogView*)data;
+    char *buffer = SDL_malloc(XI_LOG_CHUNK);
+    SDL_RWops *file = SDL_RWFromFile(view->path, "rb");
+    if (!buffer || !file) {
+        SDL_Log("Can't index '%s': %s", view->path, SDL_GetError());
+        SDL_free(buffer);
+        if (file) SDL_RWclose(file);
+        return 1;
+    }
+
+    Sint64 scanned = 0, line_end = 0;
+    int lines = 0, posted = -1;
+    Uint32 handled_search = 0, last_post = 0;
+
+    SDL_LockMutex(view->lock);
+    while (!view->stop) {
+        if (view->search_id != handled_search) {
+            handled_search = view->search_id;
+            SDL_UnlockMutex(view->lock);
+            xi_log_search(view, file, buffer);
+            SDL_LockMutex(view->lock);
+            continue;
+        }
+        SDL_UnlockMutex(view->lock);
+
+        Sint64 size = SDL_RWsize(file);
+        if (size >= 0 && size < scanned) {
+            // Truncated or replaced: index it again from the top
+            scanned = line_end = 0;
+            lines = 0;
+            SDL_LockMutex(view->lock);
+            view->checkpoint_count = 1;
+            view->line_count = 0;
+            view->indexed_end = 0;
+            view->generation++;
+            SDL_UnlockMutex(view->lock);
+        }
+
+        bool more = size > scanned && SDL_RWseek(file, scanned, RW_SEEK_SET) >= 0;
+        size_t got = 0;
+        if (more) {
+            Sint64 want = size - scanned < XI_LOG_CHUNK ? size - scanned : XI_LOG_CHUNK;
+            got = SDL_RWread(file, buffer, 1, (size_t)want);
+        }
+        for (const char *p = buffer, *end = buffer + got; (p = memchr(p, '\n', end - p)) != NULL; ++p) {
+            lines++;
+            line_end = scanned + (p - buffer) + 1;
+            if (lines % XI_LOG_CHECKPOINT == 0) xi_log_add_checkpoint(view, line_end);
+        }
+        scanned += got;
+
+        // A last line without a newline only counts once the file is complete
+        bool at_end = got == 0 || scanned >= size;
+        int visible = lines;
+        Sint64 published_end = line_end;
+        if (at_end && !view->follow && line_end < scanned) {
+            visible = lines + 1;
+            published_end = scanned;
+        }
+        SDL_LockMutex(view->lock);
+        view->line_count = visible;
+        view->indexed_end = published_end;
+        SDL_UnlockMutex(view->lock);
+
+        if (visible != posted && (at_end || SDL_GetTicks() - last_post >= XI_LOG_POST_INTERVAL)) {
+            xi_log_post(view, visible);  // rows show up as indexing gets through the file
+            posted = visible;
+            last_post = SDL_GetTicks();
+        }
+
+        SDL_LockMutex(view->lock);
+        if (at_end && !view->stop && view->search_id == handled_search) {
+            if (view->follow) SDL_CondWaitTimeout(view->wake, view->lock, XI_LOG_POLL);
+            else SDL_CondWait(view->wake, view->lock);
+        }
+    }
+    SDL_UnlockMutex(view->lock);
+
+    SDL_RWclose(file);
+    SDL_free(buffer);
+    return 0;
+}
+
+// ---- UI thread ----
+
+static xi_LogView *xi_open_logs = NULL;
+static Uint32 xi_log_serial = 0;
+
+// Jump to the line the background search found, if it's for the latest query
+static void xi_log_show_match(xi_LogView *view) {
+    SDL_LockMutex(view->lock);
+    int line = view->found_id == view->search_id ? view->found_line : -1;
+    SDL_UnlockMutex(view->lock);
+    if (line < 0 || line >= view->table.row_count) return;
+
+    xi_Node *node = &view->table.node;
+    int top = xi_table_row_top(&view->table, line);
+    int viewport = xi_viewport_height(node);
+    if (top < node->scroll_y || top + view->table.row_height > node->scroll_y + viewport) {
+        xi_ScrollTo(view, node->scroll_x, top - viewport / 3);
+    }
+}
+
+static void xi_log_apply_post(void *userdata) {
+    xi_LogPost *post = (xi_LogPost*)userdata;
+    xi_LogView *view = xi_open_logs;
+    while (view && (view != post->view || view->serial != post->serial)) view = view->next_open;
+    if (view && post->rows < 0) xi_log_show_match(view);
+    else if (view) xi_SetRowCount(view, post->rows);
+    SDL_free(post);
+}
+
+void xi_CloseLog(xi_LogView *view);
+
+// Start indexing a file and show its lines. follow: keep watching for appended lines.
+bool xi_OpenLog(xi_LogView *view, const char *path, bool follow) {
+    if (view->lock) {
+        SDL_Log("Log view already has a file open");
+        return false;
+    }
+#ifdef _WIN32
+    view->file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (view->file_handle == INVALID_HANDLE_VALUE) {
+        view->file_handle = NULL;
+        SDL_Log("Failed to open '%s'", path);
+        return false;
+    }
+#else
+    view->fd = open(path, O_RDONLY);
+    if (view->fd < 0) {
+        SDL_Log("Failed to open '%s'", path);
+        return false;
+    }
+#endif
+    view->path = SDL_strdup(path);
+    view->follow = follow;
+    view->serial = ++xi_log_serial;
+    view->lock = SDL_CreateMutex();
+    view->wake = SDL_CreateCond();
+    if (view->path && view->lock && view->wake) {
+        xi_log_add_checkpoint(view, 0);  // line 0 starts at offset 0
+        view->thread = SDL_CreateThread(xi_log_indexer, "xi log index", view);
+    }
+    if (!view->thread) {
+        SDL_Log("Failed to start log indexing: %s", SDL_GetError());
+        xi_CloseLog(view);
+        return false;
+    }
+    view->table.source.userdata = view;  // the view sits at its final address now
+    xi_FollowTableEnd(view, follow);
+    view->next_open = xi_open_logs;
+    xi_open_logs = view;
+    return true;
+}
+
+// Highlight query in the visible lines and jump to its next occurrence from the top
+// line on. Cheap to call on every keystroke: an older search still running is dropped.
+void xi_SearchLog(xi_LogView *view, const char *query) {
+    SDL_strlcpy(view->query, query ? query : "", sizeof(view->query));
+    xi_RefreshTable(view);
+    if (!view->lock || !view->query[0]) return;
+
+    int line = view->table.first_row;
+    Sint64 offset = view->data ? xi_log_line_start(view, line, xi_log_readable(view)) : 0;
+    if (offset < 0) line = offset = 0;
+    SDL_LockMutex(view->lock);
+    SDL_strlcpy(view->search_query, view->query, sizeof(view->search_query));
+    view->search_line = line;
+    view->search_offset = offset;
+    view->search_id++;
+    SDL_CondSignal(view->wake);
+    SDL_UnlockMutex(view->lock);
+}
+
+// Jump to the occurrence after the one shown last
+void xi_FindNextInLog(xi_LogView *view) {
+    if (!view->lock || !view->query[0]) return;
+    SDL_LockMutex(view->lock);
+    int line = view->found_line >= 0 ? view->found_line + 1 : view->table.first_row;
+    SDL_UnlockMutex(view->lock);
+    if (line >= view->table.row_count) line = 0;
+    Sint64 offset = view->data ? xi_log_line_start(view, line, xi_log_readable(view)) : 0;
+    if (offset < 0) line = offset = 0;
+
+    SDL_LockMutex(view->lock);
+    view->search_line = line;
+    view->search_offset = offset;
+    view->search_id++;
+    SDL_CondSignal(view->wake);
+    SDL_UnlockMutex(view->lock);
+}
+
+// Stop the background thread, unmap the file and free the index; the widget stays
+void xi_CloseLog(xi_LogView *view) {
+#ifdef _WIN32
+    if (!view->file_handle) return;
+#else
+    if (view->fd < 0) return;
+#endif
+    for (xi_LogView **link = &xi_open_logs; *link; link = &(*link)->next_open) {
+        if (*link == view) {
+            *link = view->next_open;
+            break;
+        }
+    }
+    if (view->thread) {
+        SDL_LockMutex(view->lock);
+        view->stop = true;
+        SDL_CondSignal(view->wake);
+        SDL_UnlockMutex(view->lock);
+        SDL_WaitThread(view->thread, NULL);
+    }
+
+    xi_log_unmap(view);
+#ifdef _WIN32
+    CloseHandle(view->file_handle);
+    view->file_handle = NULL;
+#else
+    close(view->fd);
+    view->fd = -1;
+#endif
+    SDL_DestroyCond(view->wake);
+    SDL_DestroyMutex(view->lock);
+    SDL_free(view->checkpoints);
+    SDL_free(view->path);
+    view->lock = NULL;
+    view->wake = NULL;
+    view->thread = NULL;
+    view->checkpoints = NULL;
+    view->path = NULL;
+    view->checkpoint_count = view->checkpoint_capacity = view->line_count = 0;
+    view->indexed_end = view->readable_end = 0;
+    view->stop = false;
+    view->cached_line = -1;
+    xi_SetRowCount(view, 0);
+}
+
+
+//=================== PLOT ==================
+/*
+ A live chart of a stream of samples:
+
+    xi_Plot plot = xi_CreatePlot(0, 0, 600, 200, 1 << 22, COLOR_GREEN, COLOR_BLACK);
+    xi_AddWidget(&panel, &plot);
+    xi_PlotAppend(&plot, readings, count);   // from one producer thread, any batch size
+
+ Samples go into a ring buffer. Next to it the plot keeps a min/max summary at several
+ resolutions (blocks of 4, 16, 64, ... samples), filled in as blocks complete. A frame
+ draws at most one min/max pair per pixel column, and each pair comes from the
+ coarsest blocks that fit in the column plus a few finer ones at its edges, so drawing
+ costs about the same whether a column covers ten samples or ten million. The trace
+ is drawn with a single SDL_RenderGeometry call.
+
+ Mouse wheel zooms around the pointer, dragging pans back in time and a double click
+ returns to following the newest samples.
+*/
+#define XI_PLOT_LEVELS 16           // summary levels, each 4x coarser than the last
+
+typedef struct {
+    xi_Node node;
+    Color line_color, background_color;
+
+    // Ring buffer; only the producer writes samples, total and writing are published
+    // under lock
+    float *samples;
+    Uint64 capacity;                // power of two
+    Uint64 total;                   // samples ever appended
+    Uint64 writing;                 // total once the append in progress is done
+    SDL_SpinLock lock;
+    SDL_atomic_t pending;           // a redraw was already posted for new samples
+
+    // UI thread
+    float *level_min[XI_PLOT_LEVELS], *level_max[XI_PLOT_LEVELS];  // level 0 is the samples
+    int levels;
+    Uint64 ingested;                // samples folded into the summary
+    Uint64 valid_start;             // oldest sample that is still trustworthy
+    double span;                    // samples across the plot width
+    double end;                     // newest sample shown when not live
+    bool live;                      // keep the newest sample at the right edge
+    float range_min, range_max;     // fixed vertical range; equal values: fit the data
+    bool dragging;
+    int drag_x;
+    double drag_end;
+} xi_Plot;
+
+// capacity: samples kept, rounded up to a power of two
+xi_Plot xi_CreatePlot(int x, int y, int width, int height, int capacity, Color line_color, Color background_color) {
+    xi_Plot plot;
+    memset(&plot, 0, sizeof(plot));
+    plot.node = xi_make_node(WIDGET_PLOT, x, y, width, height);
+    plot.line_color = line_color;
+    plot.background_color = background_color;
+    plot.capacity = 16;
+    while (plot.capacity < (Uint64)capacity) plot.capacity *= 2;
+    plot.span = width > 0 ? width : 1;
+    plot.live = true;
+
+    plot.samples = SDL_malloc(plot.capacity * sizeof(float));
+    plot.levels = 1;
+    bool ok = plot.samples != NULL;
+    for (Uint64 entries = plot.capacity / 4; ok && entries > 0 && plot.levels < XI_PLOT_LEVELS; entries /= 4) {
+        plot.level_min[plot.levels] = SDL_malloc(entries * sizeof(float));
+        plot.level_max[plot.levels] = SDL_malloc(entries * sizeof(float));
+        ok = plot.level_min[plot.levels] && plot.level_max[plot.levels];
+        plot.levels++;
+    }
+    if (!ok) {
+        SDL_Log("Out of memory for a plot of %d samples", capacity);
+        for (int i = 1; i < plot.levels; ++i) {
+            SDL_free(plot.level_min[i]);
+            SDL_free(plot.level_max[i]);
+        }
+        SDL_free(plot.samples);
+        plot.samples = NULL;
+        plot.capacity = 0;
+        plot.levels = 0;
+    }
+    return plot;
+}
+
+void xi_DestroyPlot(xi_Plot *plot) {
+    for (int i = 1; i < plot->levels; ++i) {
+        SDL_free(plot->level_min[i]);
+        SDL_free(plot->level_max[i]);
+    }
+    SDL_free(plot->samples);
+    memset(plot->level_min, 0, sizeof(plot->level_min));
+    memset(plot->level_max, 0, sizeof(plot->level_max));
+    plot->samples = NULL;
+    plot->capacity = 0;
+    plot->levels = 0;
+}
+
+// History a frame reads, behind the newest sample. The last quarter of the ring is
+// slack for the producer, which doesn't wait for frames.
+static Uint64 xi_plot_window(const xi_Plot *plot) {
+    return plot->capacity - plot->capacity / 4;
+}
+
+// Append samples. Safe from one producer thread at a time, concurrently with drawing.
+void xi_PlotAppend(xi_Plot *plot, const float *samples, int count) {
+    if (!plot->samples || count <= 0) return;
+    if ((Uint64)count > xi_plot_window(plot)) {
+        samples += count - xi_plot_window(plot);  // only the newest ones could be shown
+        count = (int)xi_plot_window(plot);
+    }
+    Uint64 mask = plot->capacity - 1;
+    Uint64 start = plot->total & mask;  // total only changes here, so no lock to read it
+    Uint64 first = plot->capacity - start < (Uint64)count ? plot->capacity - start : (Uint64)count;
+    // Announce the slots about to be overwritten before touching them; see xi_plot_lapped
+    SDL_AtomicLock(&plot->lock);
+    plot->writing = plot->total + count;
+    SDL_AtomicUnlock(&plot->lock);
+    SDL_MemoryBarrierRelease();
+    memcpy(plot->samples + start, samples, first * sizeof(float));
+    memcpy(plot->samples, samples + first, (count - first) * sizeof(float));
+
+    SDL_AtomicLock(&plot->lock);
+    plot->total += count;
+    SDL_AtomicUnlock(&plot->lock);
+    // One redraw request per frame, however many appends happen before it
+    if (SDL_AtomicCAS(&plot->pending, 0, 1)) xi_PostInvalidate(plot);
+}
+
+// Fold newly appended samples into the summary; only completed blocks are written
+static void xi_plot_ingest(xi_Plot *plot) {
+    SDL_AtomicSet(&plot->pending, 0);
+    SDL_AtomicLock(&plot->lock);
+    Uint64 total = plot->total;
+    SDL_AtomicUnlock(&plot->lock);
+
+    Uint64 window = xi_plot_window(plot);
+    if (total > window && plot->valid_start < total - window) plot->valid_start = total - window;
+    if (plot->ingested < plot->valid_start) plot->ingested = plot->valid_start;  // fell behind a full ring
+
+    Uint64 mask = plot->capacity - 1;
+    for (int level = 1; level < plot->levels; ++level) {
+        Uint64 size = (Uint64)1 << (2 * level);
+        Uint64 entry_mask = (plot->capacity >> (2 * level)) - 1;
+        Uint64 child_mask = level == 1 ? mask : (plot->capacity >> (2 * (level - 1))) - 1;
+        const float *child_min = level == 1 ? plot->samples : plot->level_min[level - 1];
+        const float *child_max = level == 1 ? plot->samples : plot->level_max[level - 1];
+        for (Uint64 block = plot->ingested / size; block < total / size; ++block) {
+            Uint64 child = block * 4;
+            float lo = child_min[child & child_mask], hi = child_max[child & child_mask];
+            for (int i = 1; i < 4; ++i) {
+                float a = child_min[(child + i) & child_mask], b = child_max[(child + i) & child_mask];
+                if (a < lo) lo = a;
+                if (b > hi) hi = b;
+            }
+            plot->level_min[level][block & entry_mask] = lo;
+            plot->level_max[level][block & entry_mask] = hi;
+        }
+    }
+    plot->ingested = total;
+}
+
+// After a frame read samples from valid_start on: true if the producer may have
+// overwritten some of them meanwhile. valid_start then moves past them, so reading
+// again gives a consistent picture.
+static bool xi_plot_lapped(xi_Plot *plot) {
+    SDL_MemoryBarrierAcquire();
+    SDL_AtomicLock(&plot->lock);
+    Uint64 writing = plot->writing;
+    SDL_AtomicUnlock(&plot->lock);
+    if (writing <= plot->valid_start + plot->capacity) return false;
+    plot->valid_start = writing - xi_plot_window(plot);
+    return true;
+}
+
+// Min and max of samples [a, b): whole blocks of this level in the middle, finer levels
+// for the ragged edges
+static void xi_plot_range(const xi_Plot *plot, int level, Uint64 a, Uint64 b, float *lo, float *hi) {
+    if (a >= b) return;
+    if (level == 0) {
+        Uint64 mask = plot->capacity - 1;
+        for (Uint64 i = a; i < b; ++i) {
+            float v = plot->samples[i & mask];
+            if (v < *lo) *lo = v;
+            if (v > *hi) *hi = v;
+        }
+        return;
+    }
+    Uint64 size = (Uint64)1 << (2 * level);
+    Uint64 first = (a + size - 1) / size, last = b / size;
+    if (first >= last) {
+        xi_plot_range(plot, level - 1, a, b, lo, hi);
+        return;
+    }
+    xi_plot_range(plot, level - 1, a, first * size, lo, hi);
+    Uint64 entry_mask = (plot->capacity >> (2 * level)) - 1;
+    for (Uint64 block = first; block < last; ++block) {
+        float v = plot->level_min[level][block & entry_mask];
+        float w = plot->level_max[level][block & entry_mask];
+        if (v < *lo) *lo = v;
+        if (w > *hi) *hi = w;
+    }
+    xi_plot_range(plot, level - 1, last * size, b, lo, hi);
+}
+
+// Index of the first sample at the left edge
+static double xi_plot_view_start(const xi_Plot *plot) {
+    double end = plot->live ? (double)plot->ingested : plot->end;
+    return end - plot->span;
+}
+
+// One min/max pair per pixel column, plus the range over all of them. False if none
+// of the view has samples.
+static bool xi_plot_columns(const xi_Plot *plot, int columns, float *column_min, float *column_max,
+                            float *range_lo, float *range_hi) {
+    double start = xi_plot_view_start(plot);
+    double per_column = plot->span / columns;
+    float lo_all = 0, hi_all = 0;
+    bool any = false;
+    for (int c = 0; c < columns; ++c) {
+        double from = start + c * per_column, to = start + (c + 1) * per_column;
+        Sint64 a = (Sint64)SDL_floor(from), e = (Sint64)SDL_floor(to);
+        if (e <= a) e = a + 1;  // zoomed past one sample per column: repeat the sample
+        if (a < (Sint64)plot->valid_start) a = (Sint64)plot->valid_start;
+        if (e > (Sint64)plot->ingested) e = (Sint64)plot->ingested;
+        float lo = 0, hi = -1;  // empty
+        if (a < e) {
+            lo = plot->samples[a & (plot->capacity - 1)];
+            hi = lo;
+            int level = 0;
+            while (level + 1 < plot->levels && ((Sint64)1 << (2 * (level + 1))) <= e - a) level++;
+            xi_plot_range(plot, level, (Uint64)a, (Uint64)e, &lo, &hi);
+            if (!any || lo < lo_all) lo_all = lo;
+            if (!any || hi > hi_all) hi_all = hi;
+            any = true;
+        }
+        column_min[c] = lo;
+        column_max[c] = hi;
+    }
+    *range_lo = lo_all;
+    *range_hi = hi_all;
+    return any;
+}
+
+void render_plot(xi_Plot *plot) {
+    const SDL_Rect *b = &plot->node.bounds;
+    xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, plot->background_color, FILLED);
+    if (!plot->samples || b->w <= 2 || b->h <= 2) return;
+
+    // Per-frame buffers come from the frame arena
+    int columns = b->w - 2;
+    float *column_min = xi_FrameAlloc(columns * sizeof(float));
+    float *column_max = xi_FrameAlloc(columns * sizeof(float));
+    SDL_Vertex *vertices = xi_FrameAlloc(columns * 4 * sizeof(SDL_Vertex));
+    int *indices = xi_FrameAlloc(columns * 6 * sizeof(int));
+    if (!column_min || !column_max || !vertices || !indices) return;
+
+    // A producer that lapped what was read makes it start later and read again. One
+    // that keeps doing so leaves this frame blank; its next append asks for another.
+    float lo_all = 0, hi_all = 0;
+    bool any = false;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        xi_plot_ingest(plot);
+        any = xi_plot_columns(plot, columns, column_min, column_max, &lo_all, &hi_all);
+        if (!xi_plot_lapped(plot)) break;
+        any = false;
+    }
+    if (!any) return;
+
+    if (plot->range_min < plot->range_max) {
+        lo_all = plot->range_min;
+        hi_all = plot->range_max;
+    }
+    if (hi_all - lo_all < 1e-6f) {
+        lo_all -= 0.5f;
+        hi_all += 0.5f;
+    }
+    float scale = (b->h - 2) / (hi_all - lo_all);
+    float bottom = (float)(b->y + b->h - 1 - xi_origin_y);
+    float left = (float)(b->x + 1 - xi_origin_x);
+    SDL_Color color = {plot->line_color.r, plot->line_color.g, plot->line_color.b, plot->line_color.a};
+
+    // Each column becomes a quad from its min to its max, stretched to meet the previous
+    // column so the trace has no gaps
+    int quads = 0;
+    float previous_lo = 0, previous_hi = -1;
+    for (int c = 0; c < columns; ++c) {
+        float lo = column_min[c], hi = column_max[c];
+        if (hi < lo) {
+            previous_hi = -1;
+            previous_lo = 0;
+            continue;
+        }
+        float draw_lo = lo, draw_hi = hi;
+        if (previous_hi >= previous_lo) {
+            if (previous_hi < draw_lo) draw_lo = previous_hi;
+            if (previous_lo > draw_hi) draw_hi = previous_lo;
+        }
+        previous_lo = lo;
+        previous_hi = hi;
+
+        float y_top = bottom - (draw_hi - lo_all) * scale;
+        float y_bottom = bottom - (draw_lo - lo_all) * scale + 1.0f;  // at least a pixel tall
+        float x0 = left + c, x1 = left + c + 1;
+        SDL_Vertex *v = vertices + quads * 4;
+        v[0] = (SDL_Vertex){{x0, y_top}, color, {0, 0}};
+        v[1] = (SDL_Vertex){{x1, y_top}, color, {0, 0}};
+        v[2] = (SDL_Vertex){{x1, y_bottom}, color, {0, 0}};
+        v[3] = (SDL_Vertex){{x0, y_bottom}, color, {0, 0}};
+        int *index = indices + quads * 6;
+        int base = quads * 4;
+        index[0] = base; index[1] = base + 1; index[2] = base + 2;
+        index[3] = base; index[4] = base + 2; index[5] = base + 3;
+        quads++;
+    }
+    if (xi_current->software) {
+        xi_soft_geometry(vertices, indices, quads * 6);
+    } else if (xi_current->pipe) {
+        xi_record_geometry(vertices, quads * 4, indices, quads * 6, NULL);
+    } else if (SDL_RenderGeometry(grenderer, NULL, vertices, quads * 4, indices, quads * 6) != 0) {
+        SDL_Log("Failed to draw plot: %s", SDL_GetError());
+    }
+}
+
+// Show the newest `span` samples, or a window ending at sample `end` when not live
+void xi_SetPlotView(xi_Plot *plot, double span, double end, bool live) {
+    double max_span = (double)xi_plot_window(plot);
+    plot->span = span < 2 ? 2 : span > max_span ? max_span : span;
+    plot->end = end;
+    plot->live = live;
+    xi_Invalidate(plot);
+}
+
+// Fixed vertical range; pass min >= max to fit the visible samples
+void xi_SetPlotRange(xi_Plot *plot, float min, float max) {
+    plot->range_min = min;
+    plot->range_max = max;
+    xi_Invalidate(plot);
+}
+
+void update_plot(xi_Plot *plot, SDL_Event *event) {
+    const SDL_Rect *b = &plot->node.bounds;
+    double per_pixel = plot->span / (b->w > 2 ? b->w - 2 : 1);
+
+    if (event->type == SDL_MOUSEWHEEL && event->wheel.y != 0) {
+        int mx, my;
+        SDL_GetMouseState(&mx, &my);
+        if (!xi_point_in_bounds(&plot->node, mx, my)) return;
+        // Keep the sample under the pointer in place
+        double start = xi_plot_view_start(plot);
+        double anchor = start + (mx - b->x - 1) * per_pixel;
+        double span = plot->span * (event->wheel.y > 0 ? 0.8 : 1.25);
+        double fraction = (mx - b->x - 1) / (double)(b->w > 2 ? b->w - 2 : 1);
+        double end = anchor - fraction * span + span;
+        if (end >= (double)plot->ingested) end = (double)plot->ingested;
+        xi_SetPlotView(plot, span, end, plot->live);
+    } else if (event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT &&
+               xi_point_in_bounds(&plot->node, event->button.x, event->button.y)) {
+        if (event->button.clicks == 2) {
+            xi_SetPlotView(plot, plot->span, 0, true);
+            return;
+        }
+        plot->dragging = true;
+        plot->drag_x = event->button.x;
+        plot->drag_end = plot->live ? (double)plot->ingested : plot->end;
+    } else if (event->type == SDL_MOUSEMOTION && plot->dragging) {
+        double end = plot->drag_end - (event->motion.x - plot->drag_x) * per_pixel;
+        bool live = end >= (double)plot->ingested;
+        xi_SetPlotView(plot, plot->span, live ? 0 : end, live);
+    } else if (event->type == SDL_MOUSEBUTTONUP) {
+        plot->dragging = false;
+    }
+}
+
+
+//=================== DROPDOWN ==================
+/*
+ A combobox: a field showing the chosen option, and a popup list to pick from that
+ filters as you type.
+
+    xi_Dropdown devices = xi_CreateDropdown(0, 0, 300, 32, 14, COLOR_BLACK, COLOR_WHITE);
+    xi_SetDropdownOptions(&devices, names, count);   // strings are not copied
+    xi_AddWidget(&panel, &devices);
+    ...
+    if (devices.selected >= 0) use(names[devices.selected]);
+
+ The popup is a virtualized list in xi_overlay, so 50k options cost as much to show as
+ ten. Typing filters through an index built when the options are set and kept up to
+ date by xi_AddDropdownOption/xi_RemoveDropdownOption: a case-folded sorted order gives
+ the prefix matches by binary search, and a trigram index (every 3-character sequence
+ -> the options containing it) narrows substring matches down to the options sharing
+ the query's rarest trigram. Adding a character only re-checks the previous matches.
+ Prefix matches are listed first, alphabetically, then the other matches in option
+ order.
+
+ While the popup is open the dropdown takes all input: arrows move through the list,
+ Enter or a click picks, Escape or a click elsewhere closes it.
+*/
+#define XI_DROPDOWN_ROWS 8          // popup height in rows
+#define XI_DROPDOWN_QUERY 128
+
+typedef struct {
+    Uint32 key;                     // three case-folded bytes; 0 marks a free slot
+    int count, capacity;
+    int *options;                   // ascending option indices containing the trigram
+} xi_Trigram;
+
+typedef struct {
+    xi_Node node;
+    int font_size;
+    Color text_color, background_color;
+    int selected;                   // chosen option, -1 for none
+
+    const char **options;
+    bool *removed;
+    int option_count, option_capacity;
+    int *sorted;                    // live options in case-folded order
+    int sorted_count;
+    xi_Trigram *trigrams;           // open addressing, capacity a power of two
+    int trigram_count, trigram_capacity;
+
+    bool open;
+    char query[XI_DROPDOWN_QUERY];
+    char last_query[XI_DROPDOWN_QUERY];
+    int *results;                   // options matching query, in display order
+    int *scratch;
+    int result_count, result_capacity;
+    bool results_valid;             // results match last_query and can be narrowed
+    xi_Table popup;
+} xi_Dropdown;
+
+static const char *xi_dropdown_cell(void *userdata, int row, int column, char *buffer, int size);
+static bool xi_dropdown_mark(void *userdata, int row, int column, const char *text, int *start, int *length);
+
+xi_Dropdown xi_CreateDropdown(int x, int y, int width, int height, int font_size, Color text_color, Color background_color) {
+    xi_Dropdown dropdown;
+    memset(&dropdown, 0, sizeof(dropdown));
+    dropdown.node = xi_make_node(WIDGET_DROPDOWN, x, y, width, height);
+    dropdown.font_size = font_size;
+    dropdown.text_color = text_color;
+    dropdown.background_color = background_color;
+    dropdown.selected = -1;
+    xi_DataSource source = {xi_dropdown_cell, NULL, NULL, NULL, xi_dropdown_mark};
+    dropdown.popup = xi_CreateList(0, 0, width, 0, 0, font_size + 8, font_size, source);
+    return dropdown;
+}
+
+// Case-insensitive (ASCII) search; returns the match or NULL
+static const char *xi_find_nocase(const char *text, const char *query) {
+    size_t length = strlen(query);
+    if (length == 0) return text;
+    for (; *text; ++text) {
+        if (SDL_tolower((unsigned char)*text) == SDL_tolower((unsigned char)*query) &&
+            SDL_strncasecmp(text, query, length) == 0) {
+            return text;
+        }
+    }
+    return NULL;
+}
+
+static Uint32 xi_trigram_key(const char *text) {
+    return (Uint32)SDL_tolower((unsigned char)text[0]) << 16 |
+           (Uint32)SDL_tolower((unsigned char)text[1]) << 8 |
+           (Uint32)SDL_tolower((unsigned char)text[2]);
+}
+
+static xi_Trigram *xi_trigram_slot(xi_Trigram *table, int capacity, Uint32 key) {
+    Uint32 i = (key * 2654435761u) & (capacity - 1);
+    while (table[i].key && table[i].key != key) i = (i + 1) & (capacity - 1);
+    return &table[i];
+}
+
+static xi_Trigram *xi_find_trigram(xi_Dropdown *d, Uint32 key, bool create) {
+    if (!d->trigrams) {
+        if (!create) return NULL;
+        d->trigram_capacity = 1024;
+        d->trigrams = SDL_calloc(d->trigram_capacity, sizeof(xi_Trigram));
+        if (!d->trigrams) return NULL;
+    }
+    xi_Trigram *slot = xi_trigram_slot(d->trigrams, d->trigram_capacity, key);
+    if (slot->key || !create) return slot->key ? slot : NULL;
+
+    if ((d->trigram_count + 1) * 10 > d->trigram_capacity * 7) {
+        // Grow at 70% load and rehash
+        int capacity = d->trigram_capacity * 2;
+        xi_Trigram *table = SDL_calloc(capacity, sizeof(xi_Trigram));
+        if (!table) return NULL;
+        for (int i = 0; i < d->trigram_capacity; ++i) {
+            if (d->trigrams[i].key) *xi_trigram_slot(table, capacity, d->trigrams[i].key) = d->trigrams[i];
+        }
+        SDL_free(d->trigrams);
+        d->trigrams = table;
+        d->trigram_capacity = capacity;
+        slot = xi_trigram_slot(table, capacity, key);
+    }
+    slot->key = key;
+    d->trigram_count++;
+    return slot;
+}
+
+static int xi_compare_options(const xi_Dropdown *d, int a, int b) {
+    int result = SDL_strcasecmp(d->options[a], d->options[b]);
+    return result ? result : (a > b) - (a < b);
+}
+
+// First position in the sorted order whose option is not less than `query`,
+// comparing only the query's length (so all options starting with it follow)
+static int xi_sorted_lower_bound(const xi_Dropdown *d, const char *query, size_t length, bool past_prefix) {
+    int lo = 0, hi = d->sorted_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int c = SDL_strncasecmp(d->options[d->sorted[mid]], query, length);
+        if (c < 0 || (past_prefix && c == 0)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Options are indexed in increasing order, so every postings list stays sorted
+static bool xi_index_trigrams(xi_Dropdown *d, int option) {
+    for (const char *text = d->options[option]; text[0] && text[1] && text[2]; ++text) {
+        xi_Trigram *trigram = xi_find_trigram(d, xi_trigram_key(text), true);
+        if (!trigram) return false;
+        if (trigram->count && trigram->options[trigram->count - 1] == option) continue;  // repeated in this option
+        if (trigram->count == trigram->capacity) {
+            int capacity = trigram->capacity ? trigram->capacity * 2 : 4;
+            int *options = SDL_realloc(trigram->options, capacity * sizeof(int));
+            if (!options) return false;
+            trigram->options = options;
+            trigram->capacity = capacity;
+        }
+        trigram->options[trigram->count++] = option;
+    }
+    return true;
+}
+
+static bool xi_index_option(xi_Dropdown *d, int option) {
+    // Sorted order: binary search for the place, then shift
+    int lo = 0, hi = d->sorted_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (xi_compare_options(d, d->sorted[mid], option) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    memmove(d->sorted + lo + 1, d->sorted + lo, (d->sorted_count - lo) * sizeof(int));
+    d->sorted[lo] = option;
+    d->sorted_count++;
+    return xi_index_trigrams(d, option);
+}
+
+static bool xi_reserve_options(xi_Dropdown *d, int count) {
+    if (count <= d->option_capacity) return true;
+    int capacity = d->option_capacity ? d->option_capacity : 64;
+    while (capacity < count) capacity *= 2;
+    const char **options = SDL_realloc(d->options, capacity * sizeof(char*));
+    if (options) d->options = options;
+    bool *removed = SDL_realloc(d->removed, capacity * sizeof(bool));
+    if (removed) d->removed = removed;
+    int *sorted = SDL_realloc(d->sorted, capacity * sizeof(int));
+    if (sorted) d->sorted = sorted;
+    int *results = SDL_realloc(d->results, capacity * sizeof(int));
+    if (results) d->results = results;
+    int *scratch = SDL_realloc(d->scratch, capacity * sizeof(int));
+    if (scratch) d->scratch = scratch;
+    if (!options || !removed || !sorted || !results || !scratch) {
+        SDL_Log("Out of memory for %d dropdown options", count);
+        return false;
+    }
+    d->option_capacity = capacity;
+    return true;
+}
+
+static void xi_dropdown_refilter(xi_Dropdown *d);
+
+static void xi_free_option_index(xi_Dropdown *d) {
+    for (int i = 0; i < d->trigram_capacity; ++i) SDL_free(d->trigrams[i].options);
+    SDL_free(d->trigrams);
+    d->trigrams = NULL;
+    d->trigram_count = d->trigram_capacity = 0;
+    d->sorted_count = 0;
+}
+
+static xi_Dropdown *xi_sorting_dropdown = NULL;  // SDL_qsort has no context; UI thread only, like tables
+
+static int xi_compare_sorted_options(const void *a, const void *b) {
+    return xi_compare_options(xi_sorting_dropdown, *(const int*)a, *(const int*)b);
+}
+
+// Replace all options and build the index once. The strings must outlive the dropdown.
+void xi_SetDropdownOptions(xi_Dropdown *d, const char **options, int count) {
+    xi_free_option_index(d);
+    d->option_count = 0;
+    d->selected = -1;
+    if (count > 0 && !xi_reserve_options(d, count)) return;
+    for (int i = 0; i < count; ++i) {
+        d->options[i] = options[i] ? options[i] : "";
+        d->removed[i] = false;
+        d->sorted[i] = i;
+    }
+    d->option_count = count;
+
+    // One sort instead of count insertions
+    xi_sorting_dropdown = d;
+    SDL_qsort(d->sorted, count, sizeof(int), xi_compare_sorted_options);
+    d->sorted_count = count;
+    for (int i = 0; i < count; ++i) {
+        if (!xi_index_trigrams(d, i)) {
+            SDL_Log("Out of memory indexing dropdown options");
+            break;
+        }
+    }
+    d->results_valid = false;
+    if (d->open) xi_dropdown_refilter(d);
+    xi_Invalidate(d);
+}
+
+// Add one option (the string must outlive the dropdown); returns its index
+int xi_AddDropdownOption(xi_Dropdown *d, const char *option) {
+    if (!xi_reserve_options(d, d->option_count + 1)) return -1;
+    int index = d->option_count++;
+    d->options[index] = option ? option : "";
+    d->removed[index] = false;
+    if (!xi_index_option(d, index)) SDL_Log("Out of memory indexing dropdown option");
+    d->results_valid = false;
+    if (d->open) xi_dropdown_refilter(d);
+    return index;
+}
+
+// Remove an option from the list; other options keep their indices
+void xi_RemoveDropdownOption(xi_Dropdown *d, int index) {
+    if (index < 0 || index >= d->option_count || d->removed[index]) return;
+    d->removed[index] = true;
+
+    int lo = 0, hi = d->sorted_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (xi_compare_options(d, d->sorted[mid], index) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < d->sorted_count && d->sorted[lo] == index) {
+        memmove(d->sorted + lo, d->sorted + lo + 1, (d->sorted_count - lo - 1) * sizeof(int));
+        d->sorted_count--;
+    }
+    for (const char *text = d->options[index]; text[0] && text[1] && text[2]; ++text) {
+        xi_Trigram *trigram = xi_find_trigram(d, xi_trigram_key(text), false);
+        if (!trigram) continue;
+        int a = 0, b = trigram->count;
+        while (a < b) {
+            int mid = (a + b) / 2;
+            if (trigram->options[mid] < index) a = mid + 1;
+            else b = mid;
+        }
+        if (a < trigram->count && trigram->options[a] == index) {
+            memmove(trigram->options + a, trigram->options + a + 1, (trigram->count - a - 1) * sizeof(int));
+            trigram->count--;
+        }
+    }
+    if (d->selected == index) d->selected = -1;
+    d->results_valid = false;
+    if (d->open) xi_dropdown_refilter(d);
+    xi_Invalidate(d);
+}
+
+static int xi_compare_ints(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Recompute results for the current query
+static void xi_dropdown_refilter(xi_Dropdown *d) {
+    const char *query = d->query;
+    size_t length = strlen(query);
+    int count = 0;
+
+    if (length == 0) {
+        for (int i = 0; i < d->option_count; ++i) {
+            if (!d->removed[i]) d->results[count++] = i;
+        }
+    } else {
+        // Candidates for "contains": the last results when the query only got longer,
+        // else the options sharing the query's rarest trigram, else everything
+        const int *candidates = NULL;
+        int candidate_count = 0;
+        bool narrowing = d->results_valid && strlen(d->last_query) > 0 &&
+                         SDL_strncasecmp(query, d->last_query, strlen(d->last_query)) == 0;
+        if (narrowing) {
+            memcpy(d->scratch, d->results, d->result_count * sizeof(int));
+            SDL_qsort(d->scratch, d->result_count, sizeof(int), xi_compare_ints);
+            candidates = d->scratch;
+            candidate_count = d->result_count;
+        } else if (length >= 3) {
+            xi_Trigram *rarest = NULL;
+            for (size_t i = 0; i + 2 < length; ++i) {
+                xi_Trigram *trigram = xi_find_trigram(d, xi_trigram_key(query + i), false);
+                if (!trigram || trigram->count == 0) {
+                    rarest = NULL;
+                    candidate_count = 0;
+                    candidates = d->scratch;
+                    break;
+                }
+                if (!rarest || trigram->count < rarest->count) rarest = trigram;
+            }
+            if (rarest) {
+                candidates = rarest->options;
+                candidate_count = rarest->count;
+            }
+        }
+
+        // Prefix matches straight from the sorted order
+        int first = xi_sorted_lower_bound(d, query, length, false);
+        int end = xi_sorted_lower_bound(d, query, length, true);
+        for (int i = first; i < end; ++i) d->results[count++] = d->sorted[i];
+
+        // Then everything else containing the query, in option order
+        if (candidates) {
+            for (int i = 0; i < candidate_count; ++i) {
+                int option = candidates[i];
+                if (d->removed[option]) continue;
+                const char *found = xi_find_nocase(d->options[option], query);
+                if (found && found != d->options[option]) d->results[count++] = option;
+            }
+        } else if (!narrowing && length < 3) {
+            for (int option = 0; option < d->option_count; ++option) {
+                if (d->removed[option]) continue;
+                const char *found = xi_find_nocase(d->options[option], query);
+                if (found && found != d->options[option]) d->results[count++] = option;
+            }
+        }
+    }
+
+    d->result_count = count;
+    d->results_valid = true;
+    SDL_strlcpy(d->last_query, query, sizeof(d->last_query));
+
+    // Resize the popup to the results and start at the top
+    xi_Table *popup = &d->popup;
+    int rows = count < XI_DROPDOWN_ROWS ? count : XI_DROPDOWN_ROWS;
+    xi_SetRowCount(popup, count);
+    xi_SetSize(popup, d->node.bounds.w, (rows ? rows : 1) * popup->row_height);
+    xi_ScrollTo(popup, 0, 0);
+    xi_RefreshTable(popup);
+    xi_SetTableSelection(popup, count ? 0 : -1);
+}
+
+static const char *xi_dropdown_cell(void *userdata, int row, int column, char *buffer, int size) {
+    (void)column;
+    (void)buffer;
+    (void)size;
+    xi_Dropdown *d = (xi_Dropdown*)userdata;
+    return row < d->result_count ? d->options[d->results[row]] : "";
+}
+
+static bool xi_dropdown_mark(void *userdata, int row, int column, const char *text, int *start, int *length) {
+    (void)row;
+    (void)column;
+    xi_Dropdown *d = (xi_Dropdown*)userdata;
+    if (!d->query[0]) return false;
+    const char *found = xi_find_nocase(text, d->query);
+    if (!found) return false;
+    *start = (int)(found - text);
+    *length = (int)strlen(d->query);
+    return true;
+}
+
+// Below the field, or above it when there is no room. Runs with every bounds refresh
+// while the dropdown is open, so the popup stays with a field that moves or scrolls.
+static void xi_place_popup(xi_Node *owner) {
+    if (owner->type != WIDGET_DROPDOWN) return;
+    xi_Dropdown *d = (xi_Dropdown*)owner;
+    const SDL_Rect *b = &d->node.bounds;
+    int rows = d->option_count < XI_DROPDOWN_ROWS ? d->option_count : XI_DROPDOWN_ROWS;
+    int height = (rows ? rows : 1) * d->popup.row_height;
+    int y = b->y + b->h;
+    if (y + height > xi_overlay.height && b->y - height >= 0) y = b->y - height;
+    xi_SetPosition(&d->popup, b->x, y);
+}
+
+void xi_OpenDropdown(xi_Dropdown *d) {
+    if (d->open) return;
+    d->open = true;
+    d->query[0] = '\0';
+    d->results_valid = false;
+    d->popup.source.userdata = d;  // the dropdown sits at its final address now
+
+    // The popup goes to the window the field is in, not necessarily the current one
+    xi_Context *previous = xi_current;
+    xi_MakeCurrent(xi_context_of(&d->node));
+
+    xi_AddWidget(&xi_overlay, &d->popup);
+    xi_input_capture = &d->node;
+    xi_UpdateBounds();  // places the popup
+    xi_dropdown_refilter(d);
+    xi_Invalidate(d);
+    xi_MakeCurrent(previous);
+}
+
+void xi_CloseDropdown(xi_Dropdown *d) {
+    if (!d->open) return;
+    d->open = false;
+    xi_Context *context = xi_context_of(&d->node);
+    xi_RemoveWidget(&d->popup);
+    if (context->input_capture == &d->node) context->input_capture = NULL;
+    xi_Invalidate(d);
+}
+
+static void xi_dropdown_choose(xi_Dropdown *d, int row) {
+    if (row >= 0 && row < d->result_count) d->selected = d->results[row];
+    xi_CloseDropdown(d);
+}
+
+void render_dropdown(xi_Dropdown *d) {
+    const SDL_Rect *b = &d->node.bounds;
+    if (!xi_skin_node(&d->node)) {
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, d->background_color, FILLED);
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, COLOR_BLUE, OUTLINE);
+    }
+
+    const char *text = d->open ? d->query : d->selected >= 0 ? d->options[d->selected] : "";
+    int text_y = b->y + (b->h - d->font_size) / 2;
+    SDL_Rect clip = xi_intersect_rect(d->node.clip, (SDL_Rect){b->x, b->y, b->w - b->h, b->h});
+    xi_apply_clip(&clip);
+    xi_DrawText(grenderer, text, b->x + 5, text_y, d->text_color, d->font_size);
+    if (d->open) {
+        int width, height;
+        xi_MeasureText(text, d->font_size, &width, &height);
+        xi_DrawRect(grenderer, b->x + 5 + width, text_y, 2, d->font_size, d->text_color, FILLED);
+    }
+    xi_apply_clip(&d->node.clip);
+    xi_DrawText(grenderer, d->open ? "^" : "v", b->x + b->w - b->h / 2 - d->font_size / 4, text_y, d->text_color, d->font_size);
+}
+
+void update_dropdown(xi_Dropdown *d, SDL_Event *event) {
+    if (!d->open) {
+        if (event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT &&
+            xi_point_in_bounds(&d->node, event->button.x, event->button.y)) {
+            xi_OpenDropdown(d);
+        }
+        return;
+    }
+
+    xi_Table *popup = &d->popup;
+    size_t length = strlen(d->query);
+    switch (event->type) {
+        case SDL_TEXTINPUT:
+            if (length + strlen(event->text.text) < XI_DROPDOWN_QUERY) {
+                strcat(d->query, event->text.text);
+                xi_dropdown_refilter(d);
+                xi_Invalidate(d);
+            }
+            break;
+        case SDL_KEYDOWN:
+            switch (event->key.keysym.sym) {
+                case SDLK_BACKSPACE:
+                    if (length > 0) {
+                        d->query[length - 1] = '\0';
+                        d->results_valid = false;  // a shorter query can match more
+                        xi_dropdown_refilter(d);
+                        xi_Invalidate(d);
+                    }
+                    break;
+                case SDLK_DOWN:
+                    if (popup->selected + 1 < popup->row_count) xi_SetTableSelection(popup, popup->selected + 1);
+                    break;
+                case SDLK_UP:
+                    if (popup->selected > 0) xi_SetTableSelection(popup, popup->selected - 1);
+                    break;
+                case SDLK_PAGEDOWN: {
+                    int row = popup->selected + XI_DROPDOWN_ROWS - 1;
+                    xi_SetTableSelection(popup, row < popup->row_count ? row : popup->row_count - 1);
+                    break;
+                }
+                case SDLK_PAGEUP: {
+                    int row = popup->selected - (XI_DROPDOWN_ROWS - 1);
+                    xi_SetTableSelection(popup, row > 0 ? row : (popup->row_count ? 0 : -1));
+                    break;
+                }
+                case SDLK_RETURN:
+                case SDLK_KP_ENTER:
+                    xi_dropdown_choose(d, popup->selected);
+                    break;
+                case SDLK_ESCAPE:
+                    xi_CloseDropdown(d);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+            if (xi_point_in_bounds(&popup->node, event->button.x, event->button.y)) {
+                xi_dropdown_choose(d, xi_TableRowAt(popup, event->button.x, event->button.y));
+            } else {
+                xi_CloseDropdown(d);  // clicks outside (including the field) close the list
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void xi_DestroyDropdown(xi_Dropdown *d) {
+    xi_CloseDropdown(d);
+    xi_free_option_index(d);
+    SDL_free(d->options);
+    SDL_free(d->removed);
+    SDL_free(d->sorted);
+    SDL_free(d->results);
+    SDL_free(d->scratch);
+    d->options = NULL;
+    d->removed = NULL;
+    d->sorted = d->results = d->scratch = NULL;
+    d->option_count = d->option_capacity = d->result_count = 0;
+    xi_DestroyTable(&d->popup);
+}
+
+static void xi_forget_widget(xi_Node *node) {
+    xi_StopAnimations(node);
+    xi_Unbind(node);
+    if (node->scroll) xi_stop_kinetic(node);
+    if (node->type == WIDGET_ENTRY) {
+        TextEntry *entry = (TextEntry*)node;
+        xi_CancelTimer(entry->blink_timer);
+        entry->blink_timer = 0;
+    } else if (node->type == WIDGET_DROPDOWN) {
+        xi_CloseDropdown((xi_Dropdown*)node);  // its popup sits in the overlay
+    }
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        if (xi_contexts[i] && xi_contexts[i]->input_capture == node) xi_contexts[i]->input_capture = NULL;
+    }
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        xi_forget_widget(child);
+    }
+}
+
+
+//=================== IMAGE ==================
+/*
+    xi_Image logo = xi_CreateImage(0, 0, 64, 64, "logo.png", COLOR_GRAY);
+    xi_AddWidget(&panel, &logo);
+    ...
+    xi_DestroyImage(&logo);   // before xiDestroyWindow
+
+ Nothing is loaded until the image is first drawn, so thumbnails outside the view
+ cost nothing. Files are decoded on the worker threads and shrunk there to the widget
+ size (box filter, aspect ratio kept), so a 4K photo shown at 64 px becomes a 64 px
+ texture. EventLoop uploads the results, at most XI_IMAGE_UPLOAD_BUDGET bytes per
+ frame; until then the placeholder color is drawn. Widgets showing the same file at
+ the same size in the same window share one refcounted texture.
+
+ BMP files always work. Define XI_USE_SDL_IMAGE (and link SDL2_image) for PNG, JPEG
+ and the other formats SDL_image reads.
+*/
+#define XI_IMAGE_UPLOAD_BUDGET (4 * 1024 * 1024)  // bytes of pixels uploaded per frame
+#define XI_IMAGE_BUCKETS 256
+
+typedef enum {
+    XI_IMAGE_LOADING,   // queued or decoding on a worker
+    XI_IMAGE_DECODED,   // pixels waiting for upload
+    XI_IMAGE_READY,
+    XI_IMAGE_FAILED
+} xi_ImageState;
+
+struct xi_Image;
+
+typedef struct xi_ImageEntry {
+    struct xi_ImageEntry *next;         // hash chain
+    struct xi_ImageEntry *next_upload;
+    char *path;
+    int width, height;                  // size it was requested at; part of the key
+    SDL_Renderer *renderer;             // window it is drawn in; textures can't be shared
+    Uint32 hash;
+    int refs;
+    xi_ImageState state;
+    SDL_Surface *surface;               // written by the worker, then owned by the UI thread
+    SDL_Texture *texture;
+    int texture_width, texture_height;
+    struct xi_Image *users;             // widgets to repaint when the texture arrives
+} xi_ImageEntry;
+
+typedef struct xi_Image {
+    xi_Node node;
+    const char *path;
+    Color placeholder_color;
+    xi_ImageEntry *entry;
+    struct xi_Image *next_user;
+} xi_Image;
+
+static xi_ImageEntry *xi_image_buckets[XI_IMAGE_BUCKETS];
+static xi_ImageEntry *xi_image_uploads = NULL, *xi_image_uploads_tail = NULL;
+
+xi_Image xi_CreateImage(int x, int y, int width, int height, const char *path, Color placeholder_color) {
+    xi_Image image;
+    memset(&image, 0, sizeof(image));
+    image.node = xi_make_node(WIDGET_IMAGE, x, y, width, height);
+    image.path = path;
+    image.placeholder_color = placeholder_color;
+    return image;
+}
+
+static Uint32 xi_image_hash(const char *path, int width, int height) {
+    Uint32 hash = 2166136261u;  // FNV-1a
+    for (const char *c = path; *c; ++c) {
+        hash = (hash ^ (Uint8)*c) * 16777619u;
+    }
+    hash = (hash ^ (Uint32)width) * 16777619u;
+    return (hash ^ (Uint32)height) * 16777619u;
+}
+
+// Shrink an ARGB8888 surface to fit width x height, averaging every source pixel
+// into the destination pixel it falls in. Alpha-weighted so edges don't darken.
+// Smaller pictures are returned as they are; the renderer scales those up.
+static SDL_Surface *xi_shrink_surface(SDL_Surface *src, int width, int height) {
+    if (src->w <= width && src->h <= height) return src;
+    double scale = (double)width / src->w < (double)height / src->h ? (double)width / src->w
+                                                                     : (double)height / src->h;
+    int dw = (int)(src->w * scale + 0.5), dh = (int)(src->h * scale + 0.5);
+    if (dw < 1) dw = 1;
+    if (dh < 1) dh = 1;
+    SDL_Surface *dst = SDL_CreateRGBSurfaceWithFormat(0, dw, dh, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!dst) return src;
+
+    for (int y = 0; y < dh; ++y) {
+        int sy0 = (int)((Sint64)y * src->h / dh), sy1 = (int)((Sint64)(y + 1) * src->h / dh);
+        if (sy1 <= sy0) sy1 = sy0 + 1;
+        Uint32 *out = (Uint32*)((Uint8*)dst->pixels + y * dst->pitch);
+        for (int x = 0; x < dw; ++x) {
+            int sx0 = (int)((Sint64)x * src->w / dw), sx1 = (int)((Sint64)(x + 1) * src->w / dw);
+            if (sx1 <= sx0) sx1 = sx0 + 1;
+            Uint64 r = 0, g = 0, b = 0, a = 0;
+            for (int sy = sy0; sy < sy1; ++sy) {
+                const Uint32 *in = (const Uint32*)((const Uint8*)src->pixels + sy * src->pitch);
+                for (int sx = sx0; sx < sx1; ++sx) {
+                    Uint32 p = in[sx], pa = p >> 24;
+                    a += pa;
+                    r += ((p >> 16) & 0xFF) * pa;
+                    g += ((p >> 8) & 0xFF) * pa;
+                    b += (p & 0xFF) * pa;
+                }
+            }
+            Uint32 n = (Uint32)((sy1 - sy0) * (sx1 - sx0));
+            out[x] = a ? (Uint32)(a / n) << 24 | (Uint32)(r / a) << 16 | (Uint32)(g / a) << 8 | (Uint32)(b / a) : 0;
+        }
+    }
+    SDL_FreeSurface(src);
+    return dst;
+}
+
+static void xi_image_decoded(void *data);
+
+// Runs on a worker: read, convert and shrink. Only entry->surface is written here.
+static void xi_decode_image(void *data) {
+    xi_ImageEntry *entry = (xi_ImageEntry*)data;
+#ifdef XI_USE_SDL_IMAGE
+    SDL_Surface *loaded = IMG_Load(entry->path);
+#else
+    SDL_Surface *loaded = SDL_LoadBMP(entry->path);
+#endif
+    if (!loaded) {
+        SDL_Log("Failed to load image %s: %s", entry->path, SDL_GetError());
+    } else {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+        if (converted) entry->surface = xi_shrink_surface(converted, entry->width, entry->height);
+    }
+    xi_PostClosure(xi_image_decoded, entry);
+}
+
+static void xi_free_image_entry(xi_ImageEntry *entry) {
+    xi_ImageEntry **link = &xi_image_buckets[entry->hash % XI_IMAGE_BUCKETS];
+    while (*link && *link != entry) link = &(*link)->next;
+    if (*link) *link = entry->next;  // entries of a closed window are out of the table already
+    xi_release_surface(entry->surface);
+    if (entry->texture) SDL_DestroyTexture(entry->texture);
+    SDL_free(entry->path);
+    SDL_free(entry);
+}
+
+static void xi_repaint_image_users(xi_ImageEntry *entry) {
+    for (struct xi_Image *user = entry->users; user; user = user->next_user) {
+        xi_Invalidate(user);
+    }
+}
+
+// The pool stopped before decoding it: fail it like an unreadable file
+static void xi_image_not_decoded(void *data) {
+    xi_ImageEntry *entry = (xi_ImageEntry*)data;
+    if (entry->refs == 0) {
+        xi_free_image_entry(entry);
+        return;
+    }
+    entry->state = XI_IMAGE_FAILED;
+}
+
+// Back on the UI thread: queue the pixels for upload
+static void xi_image_decoded(void *data) {
+    xi_ImageEntry *entry = (xi_ImageEntry*)data;
+    if (entry->refs == 0) {
+        xi_free_image_entry(entry);  // every user went away while it was decoding
+        return;
+    }
+    if (!entry->surface) {
+        entry->state = XI_IMAGE_FAILED;
+        xi_repaint_image_users(entry);
+        return;
+    }
+    entry->state = XI_IMAGE_DECODED;
+    entry->next_upload = NULL;
+    if (xi_image_uploads_tail) xi_image_uploads_tail->next_upload = entry;
+    else xi_image_uploads = entry;
+    xi_image_uploads_tail = entry;
+}
+
+static void xi_acquire_image(xi_Image *image) {
+    // Decoded at the pixel size it covers in this window
+    int width = (int)SDL_ceilf(image->node.width * xi_current->scale);
+    int height = (int)SDL_ceilf(image->node.height * xi_current->scale);
+    if (!image->path || width <= 0 || height <= 0) return;
+    Uint32 hash = xi_image_hash(image->path, width, height);
+    xi_ImageEntry *entry = xi_image_buckets[hash % XI_IMAGE_BUCKETS];
+    while (entry && !(entry->hash == hash && entry->width == width && entry->height == height &&
+                      entry->renderer == grenderer && strcmp(entry->path, image->path) == 0)) {
+        entry = entry->next;
+    }
+
+    if (!entry) {
+        entry = SDL_calloc(1, sizeof(xi_ImageEntry));
+        char *path = SDL_strdup(image->path);
+        if (!entry || !path) {
+            SDL_Log("Out of memory for image %s", image->path);
+            SDL_free(entry);
+            SDL_free(path);
+            return;
+        }
+        entry->path = path;
+        entry->width = width;
+        entry->height = height;
+        entry->renderer = grenderer;
+        entry->hash = hash;
+        entry->state = XI_IMAGE_LOADING;
+        entry->next = xi_image_buckets[hash % XI_IMAGE_BUCKETS];
+        xi_image_buckets[hash % XI_IMAGE_BUCKETS] = entry;
+        if (!xi_run_in_background(xi_decode_image, xi_image_not_decoded, entry)) {
+            entry->state = XI_IMAGE_FAILED;
+        }
+    }
+    entry->refs++;
+    image->entry = entry;
+    image->next_user = entry->users;
+    entry->users = image;
+}
+
+static void xi_release_image(xi_Image *image) {
+    xi_ImageEntry *entry = image->entry;
+    if (!entry) return;
+    struct xi_Image **link = &entry->users;
+    while (*link != image) link = &(*link)->next_user;
+    *link = image->next_user;
+    image->entry = NULL;
+    image->next_user = NULL;
+
+    // Loading and queued entries are freed when the worker or the upload pass is done with them
+    if (--entry->refs == 0 && (entry->state == XI_IMAGE_READY || entry->state == XI_IMAGE_FAILED)) {
+        xi_free_image_entry(entry);
+    }
+}
+
+// A window is closing: take its entries out of the cache and away from their widgets,
+// which load again if they are shown in another window. Entries still being decoded or
+// uploaded are freed when that is done, as their refs are 0 now.
+static void xi_image_drop_renderer(SDL_Renderer *renderer) {
+    for (int i = 0; i < XI_IMAGE_BUCKETS; ++i) {
+        xi_ImageEntry **link = &xi_image_buckets[i];
+        while (*link) {
+            xi_ImageEntry *entry = *link;
+            if (entry->renderer != renderer) {
+                link = &entry->next;
+                continue;
+            }
+            *link = entry->next;
+            entry->next = NULL;
+            for (struct xi_Image *user = entry->users, *next; user; user = next) {
+                next = user->next_user;
+                user->entry = NULL;
+                user->next_user = NULL;
+            }
+            entry->users = NULL;
+            entry->refs = 0;
+            if (entry->state == XI_IMAGE_READY || entry->state == XI_IMAGE_FAILED) xi_free_image_entry(entry);
+        }
+    }
+}
+
+// Show another file; the old texture is released
+void xi_SetImage(xi_Image *image, const char *path) {
+    xi_release_image(image);
+    image->path = path;
+    xi_Invalidate(image);
+}
+
+void xi_DestroyImage(xi_Image *image) {
+    xi_release_image(image);
+    image->path = NULL;
+}
+
+// Turn decoded pixels into textures, up to XI_IMAGE_UPLOAD_BUDGET bytes (and always at
+// least one picture). Returns true while more are waiting, so EventLoop keeps frames coming.
+bool xi_UploadImages(void) {
+    size_t uploaded = 0;
+    while (xi_image_uploads) {
+        xi_ImageEntry *entry = xi_image_uploads;
+        size_t bytes = (size_t)entry->surface->pitch * entry->surface->h;
+        if (entry->refs > 0 && uploaded > 0 && uploaded + bytes > XI_IMAGE_UPLOAD_BUDGET) break;
+
+        xi_image_uploads = entry->next_upload;
+        if (!xi_image_uploads) xi_image_uploads_tail = NULL;
+        if (entry->refs == 0) {
+            xi_free_image_entry(entry);
+            continue;
+        }
+
+        if (!entry->renderer) {
+            // Software windows draw straight from the pixels
+            entry->texture_width = entry->surface->w;
+            entry->texture_height = entry->surface->h;
+            entry->state = XI_IMAGE_READY;
+            uploaded += bytes;
+            xi_repaint_image_users(entry);
+            continue;
+        }
+        entry->texture = SDL_CreateTextureFromSurface(entry->renderer, entry->surface);
+        if (entry->texture) {
+            entry->texture_width = entry->surface->w;
+            entry->texture_height = entry->surface->h;
+            entry->state = XI_IMAGE_READY;
+        } else {
+            SDL_Log("Failed to upload image %s: %s", entry->path, SDL_GetError());
+            entry->state = XI_IMAGE_FAILED;
+        }
+        SDL_FreeSurface(entry->surface);
+        entry->surface = NULL;
+        uploaded += bytes;
+        xi_repaint_image_users(entry);
+    }
+    return xi_image_uploads != NULL;
+}
+
+void render_image(xi_Image *image) {
+    const SDL_Rect *b = &image->node.bounds;
+    xi_ImageEntry *entry = image->entry;
+    int pixel_w = (int)SDL_ceilf(image->node.width * xi_current->scale);
+    int pixel_h = (int)SDL_ceilf(image->node.height * xi_current->scale);
+    xi_lock_shared();
+    if (entry && (entry->width != pixel_w || entry->height != pixel_h)) {
+        xi_release_image(image);  // resized or rescaled: load a copy at the new size
+        entry = NULL;
+    }
+    if (!entry) {
+        xi_acquire_image(image);
+        entry = image->entry;
+    }
+    xi_unlock_shared();
+
+    if (!entry || entry->state != XI_IMAGE_READY) {
+        xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, image->placeholder_color, FILLED);
+        if (!entry || entry->state == XI_IMAGE_FAILED) {
+            xi_DrawRect(grenderer, b->x, b->y, b->w, b->h, COLOR_RED, OUTLINE);
+        }
+        return;
+    }
+
+    // Fit inside the widget keeping the aspect ratio, centered
+    int w = b->w, h = (int)((Sint64)entry->texture_height * b->w / entry->texture_width);
+    if (h > b->h) {
+        h = b->h;
+        w = (int)((Sint64)entry->texture_width * b->h / entry->texture_height);
+    }
+    SDL_Rect dst = {b->x + (b->w - w) / 2 - xi_origin_x, b->y + (b->h - h) / 2 - xi_origin_y, w, h};
+    if (xi_current->software) {
+        SDL_Rect pixels = {xi_soft_px(dst.x), xi_soft_px(dst.y), xi_soft_px(dst.x + w) - xi_soft_px(dst.x),
+                           xi_soft_px(dst.y + h) - xi_soft_px(dst.y)};
+        xi_soft_blit(entry->surface, pixels);
+        return;
+    }
+    if (xi_current->pipe) {
+        xi_record_surface(entry->surface, (SDL_FRect){(float)dst.x, (float)dst.y, (float)w, (float)h});
+        return;
+    }
+    SDL_RenderCopy(grenderer, entry->texture, NULL, &dst);
+}
+
+
+//=================== UI FILES ==================
+/*
+ Screens can be described in a text file, compiled to a binary one, and loaded
+ without recompiling the program:
+
+    # settings.xui
+    container title="Settings" layout=column gap=10 padding=10 grow=1 fill {
+        text text="Volume" color=#202020 font=16
+        slider name=volume size=200x30 range=0,100 value=50
+        group layout=row gap=6 {
+            button name=save text="Save" size=100x40 background=#007acc
+            entry name=comment size=300x40 font=16
+        }
+    }
+
+    xi_CompileUI("settings.xui", "settings.xuib");    // at build time, or in a tool
+    xi_UI *ui = xi_LoadUI("settings.xuib", NULL);      // NULL = top level
+    Slider *volume = xi_FindWidget(ui, "volume");
+    ...
+    xi_UnloadUI(ui);
+
+ Items are container, group (invisible, arranges its children), button, label, text,
+ slider and entry, each followed by key=value attributes and optionally { children }:
+ name, text (title for containers), at=X,Y, size=WxH, color (text), background,
+ hover, click (#rrggbb or #rrggbbaa), font, range=MIN,MAX, value, layout=none|row|
+ column|grid, gap, padding, columns, grow, and the flags fill and movable. Lines
+ starting with # are comments.
+
+ The binary file is a header, one fixed-size record per widget in tree order, a
+ sorted name table and a pool of NUL-terminated strings. Loading maps the file,
+ checks the offsets, constructs every widget into a single allocation and links the
+ tree in one pass. Nothing is parsed and no string is copied: labels, buttons, texts
+ and titles point into the mapping, which stays until xi_UnloadUI. Entries copy their
+ initial text, since they edit it. Records are in the byte order of the machine that
+ compiled them; files from another byte order are refused.
+*/
+#define XI_UI_VERSION 1
+
+enum { XI_UI_FILL = 1, XI_UI_MOVABLE = 2 };
+
+typedef struct {
+    char magic[4];          // "XIUI"
+    Uint32 version;
+    Uint32 record_count, name_count;
+    Uint32 records, names, strings, strings_size;  // offsets from the start of the file
+} xi_UIHeader;
+
+typedef struct {
+    Uint8 type;             // WidgetType
+    Uint8 layout;           // xi_LayoutKind for its children
+    Uint8 flags;
+    Uint8 grow;
+    Sint32 parent;          // earlier record, -1 for the top level
+    Sint32 x, y, width, height;
+    Sint16 gap, padding;
+    Uint32 text;            // string offset, 0 for none
+    Uint8 colors[4][4];     // text, background, hover, click as r, g, b, a
+    Sint32 values[4];       // font size or min, max, value; grid columns last
+} xi_UIRecord;
+
+typedef struct {
+    Uint32 name;            // string offset
+    Uint32 record;
+} xi_UIName;
+
+typedef struct {
+    const Uint8 *data;      // the mapped file
+    size_t size;
+    bool mapped;            // false: read into memory where mapping isn't possible
+    const xi_UIHeader *header;
+    void *widgets;          // every widget, in one allocation
+    xi_Node **nodes;        // by record
+    int count;
+    size_t bytes;           // held while loaded: the file and the widgets
+} xi_UI;
+
+// ------------------------------ compiler ------------------------------
+
+typedef struct {
+    const char *path;
+    const char *src;
+    size_t pos, len;
+    int line;
+    bool failed;
+    xi_UIRecord *records;
+    int count, capacity;
+    char *strings;
+    Uint32 strings_size, strings_capacity;
+    Uint32 *string_slots;   // offsets + 1 by hash, so repeated strings are stored once
+    Uint32 slot_count, string_count;
+    xi_UIName *names;
+    int name_count, name_capacity;
+} xi_UICompiler;
+
+static void xi_ui_error(xi_UICompiler *c, const char *message, const char *detail) {
+    if (!c->failed) SDL_Log("%s:%d: %s%s%s", c->path, c->line, message, detail ? " " : "", detail ? detail : "");
+    c->failed = true;
+}
+
+static bool xi_ui_grow(void **array, int *capacity, int needed, size_t item) {
+    if (needed <= *capacity) return true;
+    int grown = *capacity ? *capacity * 2 : 64;
+    while (grown < needed) grown *= 2;
+    void *resized = SDL_realloc(*array, (size_t)grown * item);
+    if (!resized) return false;
+    *array = resized;
+    *capacity = grown;
+    return true;
+}
+
+static Uint32 xi_ui_hash(const char *text) {
+    Uint32 hash = 2166136261u;  // FNV-1a
+    for (const unsigned char *c = (const unsigned char*)text; *c; ++c) hash = (hash ^ *c) * 16777619u;
+    return hash;
+}
+
+// Offset of text in the string pool, adding it the first time
+static Uint32 xi_ui_intern(xi_UICompiler *c, const char *text) {
+    if (!text[0]) return 0;  // the pool starts with an empty string
+    if ((c->string_count + 1) * 2 > c->slot_count) {
+        Uint32 slot_count = c->slot_count ? c->slot_count * 2 : 256;
+        Uint32 *slots = SDL_calloc(slot_count, sizeof(Uint32));
+        if (!slots) { xi_ui_error(c, "out of memory", NULL); return 0; }
+        for (Uint32 i = 0; i < c->slot_count; ++i) {
+            if (!c->string_slots[i]) continue;
+            Uint32 s = xi_ui_hash(c->strings + c->string_slots[i] - 1) & (slot_count - 1);
+            while (slots[s]) s = (s + 1) & (slot_count - 1);
+            slots[s] = c->string_slots[i];
+        }
+        SDL_free(c->string_slots);
+        c->string_slots = slots;
+        c->slot_count = slot_count;
+    }
+    Uint32 s = xi_ui_hash(text) & (c->slot_count - 1);
+    for (; c->string_slots[s]; s = (s + 1) & (c->slot_count - 1)) {
+        if (strcmp(c->strings + c->string_slots[s] - 1, text) == 0) return c->string_slots[s] - 1;
+    }
+    Uint32 length = (Uint32)strlen(text) + 1, offset = c->strings_size;
+    int capacity = (int)c->strings_capacity;
+    if (!xi_ui_grow((void**)&c->strings, &capacity, (int)(offset + length), 1)) {
+        xi_ui_error(c, "out of memory", NULL);
+        return 0;
+    }
+    c->strings_capacity = (Uint32)capacity;
+    memcpy(c->strings + offset, text, length);
+    c->strings_size += length;
+    c->string_slots[s] = offset + 1;
+    c->string_count++;
+    return offset;
+}
+
+// Only blanks before pos on its line
+static bool xi_ui_line_start(const xi_UICompiler *c) {
+    size_t p = c->pos;
+    while (p > 0 && (c->src[p - 1] == ' ' || c->src[p - 1] == '\t' || c->src[p - 1] == '\r')) p--;
+    return p == 0 || c->src[p - 1] == '\n';
+}
+
+static void xi_ui_skip_space(xi_UICompiler *c) {
+    while (c->pos < c->len) {
+        char ch = c->src[c->pos];
+        if (ch == '#' && xi_ui_line_start(c)) {
+            while (c->pos < c->len && c->src[c->pos] != '\n') c->pos++;  // comment
+        } else if (SDL_isspace((unsigned char)ch)) {
+            if (ch == '\n') c->line++;
+            c->pos++;
+        } else {
+            break;
+        }
+    }
+}
+
+// Next word or quoted string into buffer; false at the end of the input
+static bool xi_ui_token(xi_UICompiler *c, char *buffer, int size) {
+    xi_ui_skip_space(c);
+    if (c->pos >= c->len) return false;
+    int n = 0;
+    char ch = c->src[c->pos];
+    if (ch == '{' || ch == '}' || ch == '=') {
+        buffer[n++] = ch;
+        c->pos++;
+    } else if (ch == '"') {
+        for (c->pos++; c->pos < c->len && c->src[c->pos] != '"'; c->pos++) {
+            ch = c->src[c->pos];
+            if (ch == '\n') c->line++;
+            if (ch == '\\' && c->pos + 1 < c->len) {
+                ch = c->src[++c->pos];
+                if (ch == 'n') ch = '\n';
+                else if (ch == 't') ch = '\t';
+            }
+            if (n < size - 1) buffer[n++] = ch;
+        }
+        if (c->pos >= c->len) xi_ui_error(c, "unterminated string", NULL);
+        c->pos++;
+    } else {
+        while (c->pos < c->len) {
+            ch = c->src[c->pos];
+            if (SDL_isspace((unsigned char)ch) || ch == '{' || ch == '}' || ch == '=' || ch == '"') break;
+            if (n < size - 1) buffer[n++] = ch;
+            c->pos++;
+        }
+    }
+    buffer[n] = '\0';
+    return true;
+}
+
+static bool xi_ui_peek(xi_UICompiler *c, char ch) {
+    xi_ui_skip_space(c);
+    return c->pos < c->len && c->src[c->pos] == ch;
+}
+
+// Whole numbers separated by sep ("10,20" or "300x40"); false unless exactly count
+static bool xi_ui_numbers(const char *text, char sep, int *out, int count) {
+    for (int i = 0; i < count; ++i) {
+        char *end;
+        long value = SDL_strtol(text, &end, 10);
+        if (end == text || *end != (i == count - 1 ? '\0' : sep)) return false;
+        out[i] = (int)value;
+        text = end + 1;
+    }
+    return true;
+}
+
+static bool xi_ui_color(const char *text, Uint8 out[4]) {
+    size_t length = strlen(text);
+    if (text[0] != '#' || (length != 7 && length != 9)) return false;
+    char *end;
+    Uint32 value = (Uint32)SDL_strtoul(text + 1, &end, 16);
+    if (*end) return false;
+    if (length == 7) value = value << 8 | 0xFF;
+    out[0] = (Uint8)(value >> 24);
+    out[1] = (Uint8)(value >> 16);
+    out[2] = (Uint8)(value >> 8);
+    out[3] = (Uint8)value;
+    return true;
+}
+
+static const struct { const char *word; WidgetType type; } xi_ui_types[] = {
+    {"container", WIDGET_CONTAINER}, {"group", WIDGET_GROUP}, {"button", WIDGET_BUTTON}, {"label", WIDGET_LABEL},
+    {"text", WIDGET_TEXT}, {"slider", WIDGET_SLIDER}, {"entry", WIDGET_ENTRY},
+};
+
+// Create* defaults for what the description leaves out
+static void xi_ui_defaults(xi_UIRecord *r) {
+    static const Uint8 black[4] = {0, 0, 0, 255}, white[4] = {255, 255, 255, 255}, gray[4] = {200, 200, 200, 255};
+    static const Uint8 blue[4] = {0, 122, 204, 255}, hover[4] = {0, 102, 184, 255}, click[4] = {0, 92, 174, 255};
+    memcpy(r->colors[0], black, 4);
+    memcpy(r->colors[1], white, 4);
+    memcpy(r->colors[2], hover, 4);
+    memcpy(r->colors[3], click, 4);
+    r->values[0] = 16;  // font size
+    if (r->type == WIDGET_BUTTON) {
+        memcpy(r->colors[0], white, 4);
+        memcpy(r->colors[1], blue, 4);
+    } else if (r->type == WIDGET_LABEL) {
+        r->colors[1][3] = 0;  // transparent
+    } else if (r->type == WIDGET_CONTAINER) {
+        memcpy(r->colors[1], gray, 4);
+    } else if (r->type == WIDGET_SLIDER) {
+        r->values[0] = 0;
+        r->values[1] = 100;
+        r->values[2] = 0;
+    }
+}
+
+static void xi_ui_attribute(xi_UICompiler *c, xi_UIRecord *r, int index, const char *key, const char *value) {
+    int n[2] = {0, 0};
+    if (strcmp(key, "fill") == 0) { r->flags |= XI_UI_FILL; return; }
+    if (strcmp(key, "movable") == 0) { r->flags |= XI_UI_MOVABLE; return; }
+    if (!value) { xi_ui_error(c, "missing value for", key); return; }
+
+    if (strcmp(key, "name") == 0) {
+        if (!xi_ui_grow((void**)&c->names, &c->name_capacity, c->name_count + 1, sizeof(xi_UIName))) {
+            xi_ui_error(c, "out of memory", NULL);
+            return;
+        }
+        c->names[c->name_count++] = (xi_UIName){xi_ui_intern(c, value), (Uint32)index};
+    } else if (strcmp(key, "text") == 0 || strcmp(key, "title") == 0) {
+        r->text = xi_ui_intern(c, value);
+    } else if (strcmp(key, "at") == 0) {
+        if (!xi_ui_numbers(value, ',', n, 2)) xi_ui_error(c, "expected at=X,Y, got", value);
+        r->x = n[0]; r->y = n[1];
+    } else if (strcmp(key, "size") == 0) {
+        if (!xi_ui_numbers(value, 'x', n, 2)) xi_ui_error(c, "expected size=WxH, got", value);
+        r->width = n[0]; r->height = n[1];
+    } else if (strcmp(key, "range") == 0) {
+        if (!xi_ui_numbers(value, ',', n, 2)) xi_ui_error(c, "expected range=MIN,MAX, got", value);
+        r->values[0] = n[0]; r->values[1] = n[1];
+    } else if (strcmp(key, "layout") == 0) {
+        static const char *kinds[] = {"none", "row", "column", "grid"};
+        int kind = 0;
+        while (kind < 4 && strcmp(value, kinds[kind]) != 0) kind++;
+        if (kind == 4) xi_ui_error(c, "unknown layout", value);
+        r->layout = (Uint8)kind;
+    } else if (strcmp(key, "color") == 0 || strcmp(key, "background") == 0 || strcmp(key, "hover") == 0 || strcmp(key, "click") == 0) {
+        int role = key[0] == 'c' ? (key[1] == 'o' ? 0 : 3) : key[0] == 'b' ? 1 : 2;
+        if (!xi_ui_color(value, r->colors[role])) xi_ui_error(c, "expected #rrggbb or #rrggbbaa, got", value);
+    } else {
+        static const char *numbers[] = {"font", "value", "gap", "padding", "columns", "grow"};
+        int which = 0;
+        while (which < 6 && strcmp(key, numbers[which]) != 0) which++;
+        if (which == 6) { xi_ui_error(c, "unknown attribute", key); return; }
+        if (!xi_ui_numbers(value, 0, n, 1)) { xi_ui_error(c, "expected a number, got", value); return; }
+        switch (which) {
+            case 0: r->values[0] = n[0]; break;
+            case 1: r->values[2] = n[0]; break;
+            case 2: r->gap = (Sint16)n[0]; break;
+            case 3: r->padding = (Sint16)n[0]; break;
+            case 4: r->values[3] = n[0]; break;
+            default: r->grow = (Uint8)(n[0] < 0 ? 0 : n[0] > 255 ? 255 : n[0]); break;
+        }
+    }
+}
+
+// One item and its children; word is the item's type
+static void xi_ui_item(xi_UICompiler *c, const char *word, int parent, int depth) {
+    int type = 0;
+    while (type < (int)SDL_arraysize(xi_ui_types) && strcmp(word, xi_ui_types[type].word) != 0) type++;
+    if (type == (int)SDL_arraysize(xi_ui_types)) { xi_ui_error(c, "unknown widget", word); return; }
+    if (depth > 64) { xi_ui_error(c, "nested too deeply", NULL); return; }
+    if (!xi_ui_grow((void**)&c->records, &c->capacity, c->count + 1, sizeof(xi_UIRecord))) {
+        xi_ui_error(c, "out of memory", NULL);
+        return;
+    }
+    int index = c->count++;
+    xi_UIRecord record = {0};
+    record.type = (Uint8)xi_ui_types[type].type;
+    record.parent = parent;
+    xi_ui_defaults(&record);
+
+    // Attributes are key=value or a flag; any other word starts the next item
+    char key[64], value[1024];
+    while (!c->failed && !xi_ui_peek(c, '{') && !xi_ui_peek(c, '}')) {
+        size_t start = c->pos;
+        int line = c->line;
+        if (!xi_ui_token(c, key, sizeof(key))) break;
+        if (xi_ui_peek(c, '=')) {
+            xi_ui_token(c, value, sizeof(value));  // the '='
+            if (!xi_ui_token(c, value, sizeof(value))) { xi_ui_error(c, "missing value for", key); break; }
+            xi_ui_attribute(c, &record, index, key, value);
+        } else if (strcmp(key, "fill") == 0 || strcmp(key, "movable") == 0) {
+            xi_ui_attribute(c, &record, index, key, NULL);
+        } else {
+            c->pos = start;
+            c->line = line;
+            break;
+        }
+    }
+    c->records[index] = record;
+
+    if (xi_ui_peek(c, '{')) {
+        if (record.type != WIDGET_CONTAINER && record.type != WIDGET_GROUP) { xi_ui_error(c, "only containers and groups have children:", word); return; }
+        xi_ui_token(c, key, sizeof(key));
+        while (!c->failed && !xi_ui_peek(c, '}')) {
+            if (!xi_ui_token(c, key, sizeof(key))) { xi_ui_error(c, "missing '}'", NULL); return; }
+            xi_ui_item(c, key, index, depth + 1);
+        }
+        xi_ui_token(c, key, sizeof(key));
+    }
+}
+
+static const char *xi_ui_sort_strings;  // the pool, while sorting names
+
+static int xi_ui_compare_names(const void *a, const void *b) {
+    return strcmp(xi_ui_sort_strings + ((const xi_UIName*)a)->name, xi_ui_sort_strings + ((const xi_UIName*)b)->name);
+}
+
+// Put the new file in place of the old one in one step; a process that has the old
+// one mapped by xi_LoadUI keeps its copy
+static bool xi_ui_replace(const char *temp_path, const char *path) {
+#ifdef _WIN32
+    if (MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING)) return true;
+    SDL_Log("Failed to replace '%s' (error %lu)", path, GetLastError());
+#else
+    if (rename(temp_path, path) == 0) return true;
+    SDL_Log("Failed to replace '%s': %s", path, strerror(errno));
+#endif
+    remove(temp_path);
+    return false;
+}
+
+// Compile a text description into the binary form xi_LoadUI maps. Errors are logged
+// with their line.
+bool xi_CompileUI(const char *source_path, const char *output_path) {
+    size_t length;
+    char *source = SDL_LoadFile(source_path, &length);
+    if (!source) {
+        SDL_Log("Failed to read '%s': %s", source_path, SDL_GetError());
+        return false;
+    }
+    xi_UICompiler c = {0};
+    c.path = source_path;
+    c.src = source;
+    c.len = length;
+    c.line = 1;
+    int capacity = 0;
+    if (xi_ui_grow((void**)&c.strings, &capacity, 1, 1)) {
+        c.strings_capacity = (Uint32)capacity;
+        c.strings[0] = '\0';
+        c.strings_size = 1;
+    } else {
+        c.failed = true;
+    }
+
+    char word[64];
+    while (!c.failed && xi_ui_token(&c, word, sizeof(word))) {
+        if (strcmp(word, "}") == 0) xi_ui_error(&c, "unexpected '}'", NULL);
+        else xi_ui_item(&c, word, -1, 0);
+    }
+
+    if (!c.failed && c.name_count > 1) {
+        xi_ui_sort_strings = c.strings;
+        SDL_qsort(c.names, c.name_count, sizeof(xi_UIName), xi_ui_compare_names);
+        for (int i = 1; i < c.name_count; ++i) {
+            if (strcmp(c.strings + c.names[i].name, c.strings + c.names[i - 1].name) == 0) {
+                SDL_Log("%s: duplicate name %s", source_path, c.strings + c.names[i].name);
+                c.failed = true;
+                break;
+            }
+        }
+    }
+
+    bool written = false;
+    if (!c.failed) {
+        xi_UIHeader header = {{'X', 'I', 'U', 'I'}, XI_UI_VERSION, (Uint32)c.count, (Uint32)c.name_count};
+        header.records = sizeof(header);
+        header.names = header.records + (Uint32)(c.count * sizeof(xi_UIRecord));
+        header.strings = header.names + (Uint32)(c.name_count * sizeof(xi_UIName));
+        header.strings_size = c.strings_size;
+        // Written next to the output and renamed over it: truncating a file that is
+        // mapped somewhere would crash that process (SIGBUS) on its next read
+        size_t temp_size = strlen(output_path) + 5;
+        char *temp_path = SDL_malloc(temp_size);
+        SDL_RWops *out = NULL;
+        if (temp_path) {
+            SDL_snprintf(temp_path, temp_size, "%s.tmp", output_path);
+            out = SDL_RWFromFile(temp_path, "wb");
+        }
+        if (out) {
+            written = SDL_RWwrite(out, &header, sizeof(header), 1) == 1 &&
+                      (!c.count || SDL_RWwrite(out, c.records, sizeof(xi_UIRecord), c.count) == (size_t)c.count) &&
+                      (!c.name_count || SDL_RWwrite(out, c.names, sizeof(xi_UIName), c.name_count) == (size_t)c.name_count) &&
+                      SDL_RWwrite(out, c.strings, 1, c.strings_size) == c.strings_size;
+            written = SDL_RWclose(out) == 0 && written;
+            if (!written) {
+                SDL_Log("Failed to write '%s': %s", temp_path, SDL_GetError());
+                remove(temp_path);
+            } else {
+                written = xi_ui_replace(temp_path, output_path);
+            }
+        } else {
+            SDL_Log("Failed to write '%s': %s", output_path, SDL_GetError());
+        }
+        SDL_free(temp_path);
+    }
+    SDL_free(c.records);
+    SDL_free(c.strings);
+    SDL_free(c.string_slots);
+    SDL_free(c.names);
+    SDL_free(source);
+    return written;
+}
+
+// ------------------------------ loader ------------------------------
+
+static void xi_ui_unmap(xi_UI *ui) {
+    if (!ui->data) return;
+    if (!ui->mapped) SDL_free((void*)ui->data);
+#ifdef _WIN32
+    else UnmapViewOfFile(ui->data);
+#else
+    else munmap((void*)ui->data, ui->size);
+#endif
+    ui->data = NULL;
+}
+
+// The whole file, mapped read-only
+static bool xi_ui_map(xi_UI *ui, const char *path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+        if (mapping) {
+            ui->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);  // the view keeps the mapping alive
+            ui->size = (size_t)size.QuadPart;
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        off_t size = lseek(fd, 0, SEEK_END);
+        void *data = size > 0 ? mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        if (data != MAP_FAILED) {
+            ui->data = data;
+            ui->size = (size_t)size;
+        }
+        close(fd);
+    }
+#endif
+    ui->mapped = ui->data != NULL;
+    if (!ui->data) ui->data = SDL_LoadFile(path, &ui->size);  // e.g. files inside an app bundle
+    return ui->data != NULL;
+}
+
+// Offsets and counts stay inside the file, parents come first, strings end in NUL
+static bool xi_ui_valid(const xi_UI *ui) {
+    const xi_UIHeader *h = (const xi_UIHeader*)ui->data;
+    Uint64 size = ui->size;
+    if (size < sizeof(*h) || memcmp(h->magic, "XIUI", 4) != 0 || h->version != XI_UI_VERSION) return false;
+    if (h->records % 4 || h->names % 4 || h->strings_size == 0) return false;
+    if (h->records + (Uint64)h->record_count * sizeof(xi_UIRecord) > size) return false;
+    if (h->names + (Uint64)h->name_count * sizeof(xi_UIName) > size) return false;
+    if (h->strings + (Uint64)h->strings_size > size || ui->data[h->strings + h->strings_size - 1] != '\0') return false;
+
+    const xi_UIRecord *records = (const xi_UIRecord*)(ui->data + h->records);
+    for (Uint32 i = 0; i < h->record_count; ++i) {
+        const xi_UIRecord *r = &records[i];
+        if (r->parent < -1 || r->parent >= (Sint32)i || r->text >= h->strings_size || r->layout > XI_LAYOUT_GRID) return false;
+        if (r->parent >= 0 && records[r->parent].type != WIDGET_CONTAINER && records[r->parent].type != WIDGET_GROUP) return false;
+        bool known = false;
+        for (int t = 0; t < (int)SDL_arraysize(xi_ui_types); ++t) known |= r->type == xi_ui_types[t].type;
+        if (!known) return false;
+    }
+    const xi_UIName *names = (const xi_UIName*)(ui->data + h->names);
+    for (Uint32 i = 0; i < h->name_count; ++i) {
+        if (names[i].name >= h->strings_size || names[i].record >= h->record_count) return false;
+    }
+    return true;
+}
+
+static size_t xi_ui_widget_size(Uint8 type) {
+    size_t size;
+    switch (type) {
+        case WIDGET_CONTAINER: size = sizeof(xi_Container); break;
+        case WIDGET_BUTTON: size = sizeof(Button); break;
+        case WIDGET_LABEL: size = sizeof(Label); break;
+        case WIDGET_TEXT: size = sizeof(Text); break;
+        case WIDGET_SLIDER: size = sizeof(Slider); break;
+        case WIDGET_ENTRY: size = sizeof(TextEntry); break;
+        default: size = sizeof(xi_Node); break;
+    }
+    return (size + 15) & ~(size_t)15;
+}
+
+static Color xi_ui_rgba(const Uint8 c[4]) {
+    return (Color){c[0], c[1], c[2], c[3]};
+}
+
+// Build one widget from its record at memory
+static xi_Node *xi_ui_build(void *memory, const xi_UIRecord *r, const char *strings) {
+    const char *text = strings + r->text;  // offset 0 is the empty string
+    switch (r->type) {
+        case WIDGET_CONTAINER:
+            *(xi_Container*)memory = createContainer(r->x, r->y, r->width, r->height, xi_ui_rgba(r->colors[1]),
+                                                     r->text ? text : NULL, r->flags & XI_UI_MOVABLE);
+            break;
+        case WIDGET_BUTTON:
+            *(Button*)memory = CreateButton(r->x, r->y, r->width, r->height, text, xi_ui_rgba(r->colors[0]),
+                                            xi_ui_rgba(r->colors[1]), xi_ui_rgba(r->colors[2]), xi_ui_rgba(r->colors[3]));
+            break;
+        case WIDGET_LABEL:
+            *(Label*)memory = CreateLabel(r->x, r->y, r->width, r->height, text, xi_ui_rgba(r->colors[0]), xi_ui_rgba(r->colors[1]));
+            break;
+        case WIDGET_TEXT:
+            *(Text*)memory = CreateText(text, r->x, r->y, xi_ui_rgba(r->colors[0]), r->values[0]);
+            break;
+        case WIDGET_SLIDER:
+            *(Slider*)memory = CreateSlider(r->x, r->y, r->width, r->height, r->values[0], r->values[1], r->values[2]);
+            break;
+        case WIDGET_ENTRY: {
+            TextEntry *entry = memory;
+            *entry = CreateTextEntry(r->x, r->y, r->width, r->height, r->values[0], xi_ui_rgba(r->colors[0]), xi_ui_rgba(r->colors[1]));
+            SDL_strlcpy(entry->text, text, MAX_TEXT_LENGTH);  // entries edit their own copy
+            break;
+        }
+        default:
+            *(xi_Node*)memory = xi_make_node(WIDGET_GROUP, r->x, r->y, r->width, r->height);
+            break;
+    }
+    return memory;
+}
+
+// Map a compiled UI file and add its widgets under parent (NULL: the top level).
+// NULL if the file can't be read or isn't a valid UI file.
+xi_UI *xi_LoadUI(const char *path, void *parent) {
+    xi_UI *ui = SDL_calloc(1, sizeof(xi_UI));
+    if (!ui) return NULL;
+    if (!xi_ui_map(ui, path)) {
+        SDL_Log("Failed to open '%s'", path);
+        SDL_free(ui);
+        return NULL;
+    }
+    if (!xi_ui_valid(ui)) {
+        SDL_Log("'%s' is not a UI file for this version", path);
+        xi_ui_unmap(ui);
+        SDL_free(ui);
+        return NULL;
+    }
+
+    const xi_UIHeader *h = ui->header = (const xi_UIHeader*)ui->data;
+    const xi_UIRecord *records = (const xi_UIRecord*)(ui->data + h->records);
+    const char *strings = (const char*)ui->data + h->strings;
+    size_t total = 0;
+    for (Uint32 i = 0; i < h->record_count; ++i) total += xi_ui_widget_size(records[i].type);
+    ui->count = (int)h->record_count;
+    ui->widgets = SDL_malloc(total ? total : 1);
+    ui->nodes = SDL_malloc((h->record_count ? h->record_count : 1) * sizeof(xi_Node*));
+    if (!ui->widgets || !ui->nodes) {
+        SDL_Log("Out of memory loading '%s'", path);
+        SDL_free(ui->widgets);
+        SDL_free(ui->nodes);
+        xi_ui_unmap(ui);
+        SDL_free(ui);
+        return NULL;
+    }
+
+    ui->bytes = ui->size + total + h->record_count * sizeof(xi_Node*);
+    Uint8 *memory = ui->widgets;
+    for (Uint32 i = 0; i < h->record_count; ++i) {
+        const xi_UIRecord *r = &records[i];
+        xi_Node *node = xi_ui_build(memory, r, strings);
+        memory += xi_ui_widget_size(r->type);
+        ui->nodes[i] = node;
+        if (r->layout != XI_LAYOUT_NONE || r->gap || r->padding) {
+            node->layout.kind = (xi_LayoutKind)r->layout;
+            node->layout.gap = r->gap;
+            node->layout.padding = r->padding;
+            node->layout.columns = r->values[3] > 0 ? r->values[3] : 1;
+        }
+        node->layout.grow = r->grow;
+        node->layout.fill = (r->flags & XI_UI_FILL) != 0;
+        xi_AddWidget(r->parent < 0 ? parent : ui->nodes[r->parent], node);
+    }
+    return ui;
+}
+
+// Widget given name=... in the description, or NULL
+void *xi_FindWidget(xi_UI *ui, const char *name) {
+    if (!ui || !name) return NULL;
+    const xi_UIName *names = (const xi_UIName*)(ui->data + ui->header->names);
+    const char *strings = (const char*)ui->data + ui->header->strings;
+    int low = 0, high = (int)ui->header->name_count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int order = strcmp(strings + names[mid].name, name);
+        if (order == 0) return ui->nodes[names[mid].record];
+        if (order < 0) low = mid + 1;
+        else high = mid - 1;
+    }
+    return NULL;
+}
+
+// Take a loaded UI out of the tree, free its widgets and unmap the file
+void xi_UnloadUI(xi_UI *ui) {
+    if (!ui) return;
+    for (int i = ui->count - 1; i >= 0; --i) {
+        xi_Node *node = ui->nodes[i];
+        const xi_UIRecord *r = (const xi_UIRecord*)(ui->data + ui->header->records) + i;
+        if (r->parent < 0) {
+            xi_detach_widget(node);
+            xi_forget_widget(node);  // and all below it
+        }
+        if (node->type == WIDGET_BUTTON) SDL_free(((Button*)node)->owned_text);
+        else if (node->type == WIDGET_LABEL) SDL_free(((Label*)node)->owned_text);
+        else if (node->type == WIDGET_TEXT) SDL_free(((Text*)node)->owned_text);
+    }
+    SDL_free(ui->widgets);
+    SDL_free(ui->nodes);
+    xi_ui_unmap(ui);
+    SDL_free(ui);
+}
+
+//=================== TABS ==================
+/*
+ A row of tabs over one page at a time. Pages are built the first time they are
+ shown, from a callback or a compiled UI file (see UI FILES):
+
+    static size_t build_network(void *page, void *userdata) {
+        static Text hint;                      // widgets live as long as the page
+        hint = CreateText("Addresses", 0, 0, COLOR_BLACK, 16);
+        xi_AddWidget(page, &hint);
+        return sizeof(hint);                   // memory the page holds, for the budget
+    }
+
+    xi_Tabs tabs = xi_CreateTabs(0, 0, 600, 400, 16, COLOR_BLACK, COLOR_WHITE);
+    xi_AddWidget(NULL, &tabs);
+    xi_AddTab(&tabs, "Network", build_network, NULL, NULL);
+    xi_AddTabFromFile(&tabs, "Storage", "storage.xuib");
+    xi_SetTabBudget(&tabs, 256 * 1024);        // optional
+
+ Only the shown page is in the widget tree, so hidden pages get no events, layout or
+ drawing. A page that is hidden gives up its scroll backing stores straight away.
+ With a budget, hidden pages are destroyed, least recently shown first, while
+ together they hold more than the budget; they are built again when shown. A
+ callback page without a free function can't be rebuilt and is never evicted.
+*/
+#define XI_TAB_PADDING 12
+
+typedef size_t (*xi_PageBuild)(void *page, void *userdata);  // returns bytes held
+typedef void (*xi_PageFree)(void *page, void *userdata);
+
+typedef struct {
+    const char *title;
+    xi_PageBuild build;
+    xi_PageFree free_page;
+    void *userdata;
+    const char *path;       // UI file instead of a callback
+    xi_Node page;           // WIDGET_GROUP holding the page's widgets
+    xi_UI *ui;
+    bool built;
+    size_t bytes;           // reported by the builder, or the loaded file's
+    Uint32 shown_at;        // xi_tab_clock when last hidden
+    int width;              // of its tab in the strip; 0 until measured
+} xi_TabPage;
+
+typedef struct {
+    xi_Node node;
+    xi_TabPage **pages;     // one allocation each: their nodes sit in the tree
+    int page_count;
+    int current;            // -1 before the first page
+    int font_size;
+    Color text_color;
+    Color background_color;
+    size_t budget;          // bytes hidden pages may keep; (size_t)-1 for no limit
+    int builds;             // pages built so far, counting rebuilds
+} xi_Tabs;
+
+static Uint32 xi_tab_clock = 0;
+
+static int xi_tab_strip_height(const xi_Tabs *tabs) {
+    return tabs->font_size + XI_TAB_PADDING;
+}
+
+xi_Tabs xi_CreateTabs(int x, int y, int width, int height, int font_size, Color text_color, Color background_color) {
+    xi_Tabs tabs = {0};
+    tabs.node = xi_make_node(WIDGET_TABS, x, y, width, height);
+    tabs.node.clips_children = true;
+    tabs.node.layout.kind = XI_LAYOUT_COLUMN;  // the page fills what is under the strip
+    tabs.current = -1;
+    tabs.font_size = font_size;
+    tabs.text_color = text_color;
+    tabs.background_color = background_color;
+    tabs.budget = (size_t)-1;
+    tabs.node.layout.inset_top = xi_tab_strip_height(&tabs);
+    return tabs;
+}
+
+// Drop the textures of scrolled areas in a subtree; they are made again when shown
+static void xi_drop_scroll_textures(xi_Node *node) {
+    if (node->scroll) {
+        xi_stop_kinetic(node);
+        SDL_DestroyTexture(node->scroll->texture[0]);
+        SDL_DestroyTexture(node->scroll->texture[1]);
+        node->scroll->texture[0] = node->scroll->texture[1] = NULL;
+        node->scroll->valid = false;
+    }
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        xi_drop_scroll_textures(child);
+    }
+}
+
+static bool xi_tab_build(xi_Tabs *tabs, xi_TabPage *page) {
+    if (page->built) return true;
+    page->page = xi_make_node(WIDGET_GROUP, 0, 0, 0, 0);
+    page->page.layout.grow = 1;
+    page->page.layout.fill = true;
+    if (page->path) {
+        page->ui = xi_LoadUI(page->path, &page->page);
+        if (!page->ui) return false;
+        page->bytes = page->ui->bytes;
+    } else {
+        page->bytes = page->build(&page->page, page->userdata);
+    }
+    page->built = true;
+    tabs->builds++;
+    return true;
+}
+
+static void xi_tab_free(xi_TabPage *page) {
+    if (!page->built) return;
+    if (page->ui) {
+        xi_UnloadUI(page->ui);
+    } else if (page->free_page) {
+        xi_forget_widget(&page->page);  // hidden pages are out of the tree already
+        page->free_page(&page->page, page->userdata);
+    }
+    page->ui = NULL;
+    page->built = false;
+    page->bytes = 0;
+}
+
+// Destroy hidden pages, least recently shown first, until the rest fit the budget
+static void xi_tab_evict(xi_Tabs *tabs) {
+    for (;;) {
+        size_t held = 0;
+        xi_TabPage *oldest = NULL;
+        for (int i = 0; i < tabs->page_count; ++i) {
+            xi_TabPage *page = tabs->pages[i];
+            if (i == tabs->current || !page->built) continue;
+            held += page->bytes;
+            if ((page->path || page->free_page) && (!oldest || page->shown_at < oldest->shown_at)) oldest = page;
+        }
+        if (held <= tabs->budget || !oldest) return;
+        xi_tab_free(oldest);
+    }
+}
+
+// Show page index, building it first if needed
+void xi_SelectTab(xi_Tabs *tabs, int index) {
+    if (index < 0 || index >= tabs->page_count || index == tabs->current) return;
+    xi_TabPage *page = tabs->pages[index];
+    if (!xi_tab_build(tabs, page)) return;
+    if (tabs->current >= 0) {
+        xi_TabPage *hidden = tabs->pages[tabs->current];
+        xi_detach_widget(&hidden->page);  // stays alive and bound while hidden
+        xi_drop_scroll_textures(&hidden->page);
+        hidden->shown_at = ++xi_tab_clock;
+    }
+    tabs->current = index;
+    xi_AddWidget(tabs, &page->page);
+    xi_tab_evict(tabs);
+    xi_Invalidate(tabs);
+}
+
+static int xi_add_tab_page(xi_Tabs *tabs, xi_TabPage *page) {
+    xi_TabPage **pages = SDL_realloc(tabs->pages, (tabs->page_count + 1) * sizeof(xi_TabPage*));
+    xi_TabPage *copy = SDL_malloc(sizeof(xi_TabPage));
+    if (!pages || !copy) {
+        SDL_Log("Out of memory adding tab '%s'", page->title);
+        if (pages) tabs->pages = pages;
+        SDL_free(copy);
+        return -1;
+    }
+    *copy = *page;
+    tabs->pages = pages;
+    tabs->pages[tabs->page_count] = copy;
+    int index = tabs->page_count++;
+    if (tabs->current < 0) xi_SelectTab(tabs, index);  // the first page is the visible one
+    else xi_Invalidate(tabs);
+    return index;
+}
+
+// Add a page built by build(page, userdata) when first shown. free_page, if given,
+// destroys what build made, which lets the budget evict the page. Returns its index.
+int xi_AddTab(xi_Tabs *tabs, const char *title, xi_PageBuild build, xi_PageFree free_page, void *userdata) {
+    xi_TabPage page = {title, build, free_page, userdata};
+    return xi_add_tab_page(tabs, &page);
+}
+
+// Add a page loaded from a compiled UI file when first shown
+int xi_AddTabFromFile(xi_Tabs *tabs, const char *title, const char *ui_path) {
+    xi_TabPage page = {title};
+    page.path = ui_path;
+    return xi_add_tab_page(tabs, &page);
+}
+
+// Bytes hidden pages may hold before the least recently shown are destroyed
+void xi_SetTabBudget(xi_Tabs *tabs, size_t bytes) {
+    tabs->budget = bytes;
+    xi_tab_evict(tabs);
+}
+
+// Free every built page and the page list; the widget stays
+void xi_DestroyTabs(xi_Tabs *tabs) {
+    if (tabs->current >= 0) xi_RemoveWidget(&tabs->pages[tabs->current]->page);
+    for (int i = 0; i < tabs->page_count; ++i) {
+        xi_tab_free(tabs->pages[i]);
+        SDL_free(tabs->pages[i]);
+    }
+    SDL_free(tabs->pages);
+    tabs->pages = NULL;
+    tabs->page_count = 0;
+    tabs->current = -1;
+}
+
+// Width of tab i in the strip. Measured once; the scale changing measures it again.
+static int xi_tab_width(const xi_Tabs *tabs, int i) {
+    xi_TabPage *page = tabs->pages[i];
+    if (page->width) return page->width;
+    int width, height;
+    if (!xi_MeasureText(page->title, tabs->font_size, &width, &height)) return 2 * XI_TAB_PADDING;
+    page->width = width + 2 * XI_TAB_PADDING;
+    return page->width;
+}
+
+void render_tabs(xi_Tabs *tabs) {
+    const SDL_Rect *b = &tabs->node.bounds;
+    int strip = xi_tab_strip_height(tabs);
+    Color idle = xi_mix_color(tabs->background_color, COLOR_BLACK, 0.15f);
+    bool skinned = xi_skin_node(&tabs->node);  // the strip; the page keeps its color
+    if (!skinned) xi_DrawRect(grenderer, b->x, b->y, b->w, strip, idle, FILLED);
+    xi_DrawRect(grenderer, b->x, b->y + strip, b->w, b->h - strip, tabs->background_color, FILLED);
+    int x = b->x;
+    for (int i = 0; i < tabs->page_count && x < b->x + b->w; ++i) {
+        int width = xi_tab_width(tabs, i);
+        if (!skinned && i == tabs->current) xi_DrawRect(grenderer, x, b->y, width, strip, tabs->background_color, FILLED);
+        xi_DrawText(grenderer, tabs->pages[i]->title, x + XI_TAB_PADDING, b->y + XI_TAB_PADDING / 2, tabs->text_color, tabs->font_size);
+        x += width;
+    }
+}
+
+void update_tabs(xi_Tabs *tabs, SDL_Event *event) {
+    if (event->type != SDL_MOUSEBUTTONDOWN || event->button.button != SDL_BUTTON_LEFT) return;
+    const SDL_Rect *b = &tabs->node.bounds;
+    int mx = event->button.x, my = event->button.y;
+    if (my < b->y || my >= b->y + xi_tab_strip_height(tabs) || mx < b->x || mx >= b->x + b->w) return;
+    for (int i = 0, x = b->x; i < tabs->page_count; ++i) {
+        int width = xi_tab_width(tabs, i);
+        if (mx < x + width) {
+            xi_SelectTab(tabs, i);
+            return;
+        }
+        x += width;
+    }
+}
+
+//=================== IMMEDIATE MODE ==================
+/*
+ An immediate-mode front end on top of the retained widgets. The UI is described by a
+ function that runs again whenever something may have changed (input, timers, posted
+ updates), and widgets are simply called where they should appear:
+
+    static void tools(void *userdata) {
+        Settings *s = userdata;
+        xi_ImText("Pressure: %d kPa", s->pressure);
+        xi_ImSlider("gain", &s->gain, 0, 100);
+        xi_ImBeginRow("actions");
+        if (xi_ImButton("Apply")) apply(s);
+        if (xi_ImButton("Reset")) reset(s);
+        xi_ImEndRow();
+    }
+    ...
+    xi_SetImmediateUI(NULL, tools, &settings);   // NULL: directly in the window
+
+ Each call is identified by a hash of its label (text after "##" is part of the id but
+ not shown, "Apply##2"), the enclosing rows and xi_ImPushID. The id finds the widget
+ made for it last time in an open-addressing table, so its state (hover fades, the
+ text being typed, cached text textures and layout) carries over; only what actually
+ changed is updated and repainted. Widgets not submitted in a pass are destroyed
+ at its end. Labels used twice at the same level get distinct ids in call order.
+*/
+#define XI_IM_ID_STACK 32
+
+typedef enum {
+    XI_IM_TEXT,
+    XI_IM_BUTTON,
+    XI_IM_SLIDER,
+    XI_IM_ENTRY,
+    XI_IM_ROW
+} xi_ImKind;
+
+typedef struct {
+    Uint32 id;              // 0 marks a free slot
+    Uint32 pass;            // last pass that submitted it
+    xi_ImKind kind;
+    xi_Node *widget;        // heap-allocated retained widget
+    char *text;             // shown text (label without "##..."), owned
+    int value;              // last value the application saw (slider value, button clicks)
+    Uint32 repeats;         // times the same label followed it in this pass
+    bool fresh;             // widget was just allocated and still has to be built
+} xi_ImSlot;
+
+typedef struct {
+    xi_Node *parent;
+    xi_Node *last;          // last widget placed in parent during this pass
+    Uint32 seed;
+} xi_ImLevel;
+
+static struct {
+    xi_Node panel;          // WIDGET_GROUP holding the top level, as a column
+    bool installed;
+    void (*build)(void *userdata);
+    void *userdata;
+    xi_ImSlot *entries;
+    int capacity, count;    // power-of-two capacity, at most half full
+    Uint32 pass;
+    xi_ImLevel levels[XI_IM_ID_STACK];
+    int depth;
+    Uint32 ids[XI_IM_ID_STACK];
+    int id_depth;
+} xi_im;
+
+static Uint32 xi_im_hash(Uint32 seed, const char *label) {
+    Uint32 hash = seed ^ 2166136261u;  // FNV-1a
+    for (const char *c = label; *c; ++c) {
+        hash = (hash ^ (Uint8)*c) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+static Uint32 xi_im_seed(void) {
+    Uint32 seed = xi_im.levels[xi_im.depth].seed;
+    return xi_im.id_depth ? seed ^ (xi_im.ids[xi_im.id_depth - 1] * 0x9E3779B1u) : seed;
+}
+
+static xi_ImSlot *xi_im_slot(xi_ImSlot *entries, int capacity, Uint32 id) {
+    Uint32 i = (id * 2654435761u) & (capacity - 1);
+    while (entries[i].id && entries[i].id != id) i = (i + 1) & (capacity - 1);
+    return &entries[i];
+}
+
+static bool xi_im_grow(void) {
+    int capacity = xi_im.capacity ? xi_im.capacity * 2 : 256;
+    xi_ImSlot *entries = SDL_calloc(capacity, sizeof(xi_ImSlot));
+    if (!entries) {
+        SDL_Log("Out of memory for immediate-mode widgets");
+        return false;
+    }
+    for (int i = 0; i < xi_im.capacity; ++i) {
+        if (xi_im.entries[i].id) *xi_im_slot(entries, capacity, xi_im.entries[i].id) = xi_im.entries[i];
+    }
+    SDL_free(xi_im.entries);
+    xi_im.entries = entries;
+    xi_im.capacity = capacity;
+    return true;
+}
+
+// Put node right after `after` (or first) in parent, moving it only if it isn't there
+static void xi_im_place(xi_Node *parent, xi_Node *node, xi_Node *after) {
+    if (node->parent == parent && node->prev_sibling == after) return;
+    xi_detach_widget(node);
+    node->parent = parent;
+    node->prev_sibling = after;
+    node->next_sibling = after ? after->next_sibling : parent->first_child;
+    if (node->next_sibling) node->next_sibling->prev_sibling = node;
+    else parent->last_child = node;
+    if (after) after->next_sibling = node;
+    else parent->first_child = node;
+    xi_mark_bounds_dirty(node);
+    xi_MarkLayoutDirty(node);
+}
+
+static void xi_im_destroy(xi_ImSlot *entry) {
+    xi_Node *node = entry->widget;
+    if (entry->kind == XI_IM_ROW) {
+        // Its children were collected too (or moved elsewhere already)
+        while (node->first_child) xi_detach_widget(node->first_child);
+    }
+    xi_detach_widget(node);
+    xi_forget_widget(node);
+    SDL_free(entry->text);
+    SDL_free(node);
+}
+
+// Find or create the widget for label at the current level and place it in order
+static xi_ImSlot *xi_im_submit(xi_ImKind kind, const char *label, size_t widget_size) {
+    if (!xi_im.installed) return NULL;
+    if ((xi_im.count + 1) * 2 > xi_im.capacity && !xi_im_grow()) return NULL;
+
+    Uint32 id = xi_im_hash(xi_im_seed(), label);
+    xi_ImSlot *entry = xi_im_slot(xi_im.entries, xi_im.capacity, id);
+    if (entry->id && entry->pass == xi_im.pass) {
+        // Same label again at this level: the n-th repeat gets the n-th derived id
+        Uint32 repeat = ++entry->repeats;
+        do {
+            id = (id ^ repeat) * 0x9E3779B1u + repeat;
+            if (!id) id = 1;
+            entry = xi_im_slot(xi_im.entries, xi_im.capacity, id);
+        } while (entry->id && entry->pass == xi_im.pass);
+    }
+    if (entry->id && entry->kind == kind) {
+        entry->pass = xi_im.pass;
+        entry->repeats = 0;
+        xi_ImLevel *level = &xi_im.levels[xi_im.depth];
+        xi_im_place(level->parent, entry->widget, level->last);
+        level->last = entry->widget;
+        return entry;
+    }
+
+    xi_Node *widget = SDL_calloc(1, widget_size);
+    if (!widget) {
+        SDL_Log("Out of memory for immediate-mode widget %s", label);
+        return NULL;
+    }
+    if (entry->id) xi_im_destroy(entry);  // same id, different kind of widget: start over
+    else xi_im.count++;
+    entry->id = id;
+    entry->kind = kind;
+    entry->widget = widget;
+    entry->text = NULL;
+    entry->value = 0;
+    entry->fresh = true;
+    entry->repeats = 0;
+    entry->pass = xi_im.pass;
+    return entry;
+}
+
+// First call for a widget: place the freshly built widget
+static void xi_im_attach(xi_ImSlot *entry) {
+    entry->fresh = false;
+    xi_ImLevel *level = &xi_im.levels[xi_im.depth];
+    xi_im_place(level->parent, entry->widget, level->last);
+    level->last = entry->widget;
+}
+
+// Replace the shown text if it changed; returns true when it did
+static bool xi_im_set_text(xi_ImSlot *entry, const char *text, size_t length) {
+    if (entry->text && strncmp(entry->text, text, length) == 0 && entry->text[length] == '\0') return false;
+    char *copy = SDL_malloc(length + 1);
+    if (!copy) return false;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    SDL_free(entry->text);
+    entry->text = copy;
+    return true;
+}
+
+static size_t xi_im_visible_length(const char *label) {
+    const char *hidden = strstr(label, "##");
+    return hidden ? (size_t)(hidden - label) : strlen(label);
+}
+
+// Build the UI inside parent (NULL: the window) by calling build(userdata) on every pass.
+// Pass a NULL build to remove it.
+void xi_SetImmediateUI(void *parent, void (*build)(void *userdata), void *userdata) {
+    if (!xi_im.installed) {
+        xi_im.panel = xi_make_node(WIDGET_GROUP, 0, 0, 0, 0);
+        xi_SetLayout(&xi_im.panel, XI_LAYOUT_COLUMN, 6, 8);
+        xi_im.installed = true;
+    }
+    xi_detach_widget(&xi_im.panel);  // its widgets stay for the next build
+    xi_im.build = build;
+    xi_im.userdata = userdata;
+    if (build) xi_AddWidget(parent, &xi_im.panel);
+}
+
+static void xi_im_collect(void) {
+    // Backward-shift deletion keeps every probe chain intact without tombstones
+    for (int i = 0; i < xi_im.capacity; ++i) {
+        while (xi_im.entries[i].id && xi_im.entries[i].pass != xi_im.pass) {
+            xi_im_destroy(&xi_im.entries[i]);
+            xi_im.count--;
+            int hole = i;
+            for (int j = (i + 1) & (xi_im.capacity - 1); xi_im.entries[j].id; j = (j + 1) & (xi_im.capacity - 1)) {
+                int home = (int)((xi_im.entries[j].id * 2654435761u) & (xi_im.capacity - 1));
+                // Move j into the hole unless its home lies cyclically in (hole, j]
+                bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+                if (!stays) {
+                    xi_im.entries[hole] = xi_im.entries[j];
+                    hole = j;
+                }
+            }
+            memset(&xi_im.entries[hole], 0, sizeof(xi_ImSlot));
+        }
+    }
+}
+
+void xi_ImPushID(const char *id) {
+    if (xi_im.id_depth < XI_IM_ID_STACK) xi_im.ids[xi_im.id_depth++] = xi_im_hash(xi_im_seed(), id);
+}
+
+void xi_ImPopID(void) {
+    if (xi_im.id_depth > 0) xi_im.id_depth--;
+}
+
+// Lay out the following widgets side by side until xi_ImEndRow
+void xi_ImBeginRow(const char *id) {
+    if (xi_im.depth + 1 >= XI_IM_ID_STACK) return;
+    xi_ImSlot *entry = xi_im_submit(XI_IM_ROW, id, sizeof(xi_Node));
+    if (!entry) {
+        // Keep xi_ImEndRow balanced; the row's widgets go to the enclosing level
+        xi_im.levels[xi_im.depth + 1] = xi_im.levels[xi_im.depth];
+        xi_im.depth++;
+        return;
+    }
+    if (entry->fresh) {
+        *entry->widget = xi_make_node(WIDGET_GROUP, 0, 0, 0, 0);
+        xi_SetLayout(entry->widget, XI_LAYOUT_ROW, 6, 0);
+        xi_im_attach(entry);
+    }
+    xi_ImLevel *level = &xi_im.levels[++xi_im.depth];
+    level->parent = entry->widget;
+    level->last = NULL;
+    level->seed = entry->id;
+}
+
+void xi_ImEndRow(void) {
+    if (xi_im.depth == 0) return;
+    xi_ImLevel *inner = &xi_im.levels[xi_im.depth--];
+    if (inner->parent == xi_im.levels[xi_im.depth].parent) {
+        xi_im.levels[xi_im.depth].last = inner->last;  // row fell back to this level
+    }
+}
+
+// Run the immediate-mode UI once; EventLoop calls it after input and updates are handled
+void xi_ImmediateFrame(void) {
+    if (!xi_im.build) return;
+    xi_im.pass++;
+    xi_im.depth = 0;
+    xi_im.id_depth = 0;
+    xi_im.levels[0] = (xi_ImLevel){&xi_im.panel, NULL, 0};
+    xi_im.build(xi_im.userdata);
+    while (xi_im.depth > 0) xi_ImEndRow();  // forgiving about a missing xi_ImEndRow
+    xi_im_collect();
+}
+
+// A line of text; formatted like printf
+void xi_ImText(const char *format, ...) {
+    xi_ImSlot *entry = xi_im_submit(XI_IM_TEXT, format, sizeof(Text));
+    if (!entry) return;
+    va_list args;
+    va_start(args, format);
+    char buffer[MAX_TEXT_LENGTH];
+    SDL_vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    Text *text = (Text*)entry->widget;
+    bool fresh = entry->fresh;
+    if (xi_im_set_text(entry, buffer, strlen(buffer)) || fresh) {
+        if (fresh) {
+            *text = CreateText(entry->text, 0, 0, COLOR_BLACK, 16);
+            xi_im_attach(entry);
+        }
+        text->text = entry->text;
+        xi_MarkLayoutDirty(text);  // Text is sized by its content
+        xi_Invalidate(text);
+    }
+}
+
+// A push button; true on the pass after it was clicked (pressed and released over it)
+bool xi_ImButton(const char *label) {
+    xi_ImSlot *entry = xi_im_submit(XI_IM_BUTTON, label, sizeof(Button));
+    if (!entry) return false;
+    Button *button = (Button*)entry->widget;
+    bool fresh = entry->fresh;
+    if (xi_im_set_text(entry, label, xi_im_visible_length(label)) || fresh) {
+        int width = 0, height = 0;
+        xi_MeasureText(entry->text, 16, &width, &height);
+        if (fresh) {
+            *button = CreateButton(0, 0, width + 20, height + 20, entry->text, COLOR_WHITE, COLOR_DARK_BLUE, COLOR_BLUE, COLOR_GRAY);
+            xi_im_attach(entry);
+        } else {
+            button->text = entry->text;
+            xi_SetSize(button, width + 20, height + 20);
+            xi_Invalidate(button);
+        }
+    }
+    bool clicked = button->clicks != entry->value;
+    entry->value = button->clicks;
+    return clicked;
+}
+
+// A slider bound to *value; true when the user moved it
+bool xi_ImSlider(const char *label, int *value, int min_value, int max_value) {
+    xi_ImSlot *entry = xi_im_submit(XI_IM_SLIDER, label, sizeof(Slider));
+    if (!entry) return false;
+    Slider *slider = (Slider*)entry->widget;
+    // A value out of range is shown at the nearest end, on the first pass too
+    int v = *value < min_value ? min_value : *value > max_value ? max_value : *value;
+    if (entry->fresh) {
+        *slider = CreateSlider(0, 0, 200, 30, min_value, max_value, v);
+        entry->value = v;
+        xi_im_attach(entry);
+        return false;
+    }
+    if (slider->min_value != min_value || slider->max_value != max_value) {
+        slider->min_value = min_value;
+        slider->max_value = max_value;
+        xi_Invalidate(slider);
+    }
+    if (slider->value != entry->value) {
+        *value = entry->value = slider->value;  // dragged since the last pass
+        return true;
+    }
+    if (v != slider->value) {
+        // Changed by the application
+        slider->value = entry->value = v;
+        xi_Invalidate(slider);
+    }
+    return false;
+}
+
+// A text field editing buffer (size bytes); true when the user changed it
+bool xi_ImEntry(const char *label, char *buffer, int size) {
+    xi_ImSlot *entry = xi_im_submit(XI_IM_ENTRY, label, sizeof(TextEntry));
+    if (!entry || size <= 0) return false;
+    TextEntry *field = (TextEntry*)entry->widget;
+    if (entry->fresh) {
+        *field = CreateTextEntry(0, 0, 200, 30, 16, COLOR_BLACK, COLOR_WHITE);
+        SDL_strlcpy(field->text, buffer, MAX_TEXT_LENGTH);
+        xi_im_attach(entry);
+        return false;
+    }
+    if (strncmp(field->text, buffer, size) == 0) return false;
+    if (field->active) {
+        SDL_strlcpy(buffer, field->text, size);  // typed since the last pass
+        return true;
+    }
+    SDL_strlcpy(field->text, buffer, MAX_TEXT_LENGTH);  // changed by the application
+    int length = strlen(field->text);
+    if (field->cursor_position > length) field->cursor_position = length;
+    xi_Invalidate(field);
+    return false;
+}
+
+void xi_DestroyImmediateUI(void) {
+    xi_SetImmediateUI(NULL, NULL, NULL);
+    xi_im.pass++;
+    xi_im_collect();  // nothing was submitted in this pass: everything goes
+    SDL_free(xi_im.entries);
+    xi_im.entries = NULL;
+    xi_im.capacity = xi_im.count = 0;
+}
+
+
+//=================== Main Loop ==================
+//=====================RENDER ALL WIDGETS=============================
+static XI_THREAD_LOCAL SDL_Rect xi_active_clip;
+static XI_THREAD_LOCAL bool xi_clip_active = false;
+
+// Only talk to the renderer when the clip rectangle actually changes
+static void xi_apply_clip(const SDL_Rect *clip) {
+    SDL_Rect r = xi_intersect_rect(*clip, xi_clip_limit);
+    r.x -= xi_origin_x;
+    r.y -= xi_origin_y;
+    if (xi_clip_active && r.x == xi_active_clip.x && r.y == xi_active_clip.y &&
+        r.w == xi_active_clip.w && r.h == xi_active_clip.h) {
+        return;
+    }
+    xi_active_clip = r;
+    xi_clip_active = true;
+    if (xi_current->software) {
+        // Every pixel the rectangle touches, within the framebuffer
+        float scale = xi_current->scale;
+        int x0 = (int)SDL_floorf(r.x * scale), y0 = (int)SDL_floorf(r.y * scale);
+        SDL_Rect pixels = {x0, y0, (int)SDL_ceilf((r.x + r.w) * scale) - x0, (int)SDL_ceilf((r.y + r.h) * scale) - y0};
+        SDL_Rect canvas = {0, 0, xi_current->canvas->w, xi_current->canvas->h};
+        xi_soft_clip = xi_intersect_rect(pixels, canvas);
+        return;
+    }
+    if (xi_current->pipe) {
+        xi_record_clip(&r);
+        return;
+    }
+    SDL_RenderSetClipRect(grenderer, &r);
+}
+
+static void xi_reset_clip(void) {
+    xi_clip_active = false;
+    if (xi_current->software) {
+        xi_soft_clip = (SDL_Rect){0, 0, xi_current->canvas->w, xi_current->canvas->h};
+        return;
+    }
+    if (xi_current->pipe) {
+        xi_record_clip(NULL);
+        return;
+    }
+    SDL_RenderSetClipRect(grenderer, NULL);
+}
+
+// Draw into target (NULL: the window) in logical units. SDL resets the scale whenever
+// the target changes, and each target keeps its own clip rectangle.
+static void xi_set_render_target(SDL_Texture *target) {
+    if (xi_current->software || xi_current->pipe) {
+        xi_reset_clip();  // one framebuffer, or targets the render thread picks
+        return;
+    }
+    SDL_SetRenderTarget(grenderer, target);
+    SDL_RenderSetScale(grenderer, xi_current->scale, xi_current->scale);
+    xi_clip_active = false;
+}
+
+static void render_scrollbar(xi_Node *node) {
+    int viewport = xi_viewport_height(node);
+    if (node->content_height <= viewport || viewport <= 0) return;
+
+    Color thumb_color = {160, 160, 160, 255};
+    int thumb_height = viewport * viewport / node->content_height;
+    if (thumb_height < 20) thumb_height = 20;
+    int thumb_y = node->bounds.y + node->layout.inset_top +
+                  (int)((long long)(viewport - thumb_height) * node->scroll_y / (node->content_height - viewport));
+    xi_apply_clip(&node->clip);
+    SDL_Rect thumb = {node->bounds.x + node->bounds.w - 6, thumb_y, 4, thumb_height};
+    // Over the children, so never out of a run's batch, which went out before them
+    bool batched = xi_skins_batched;
+    xi_skins_batched = false;
+    bool skinned = xi_draw_skin(XI_SKIN_SCROLLBAR, thumb, 255);
+    xi_skins_batched = batched;
+    if (!skinned) xi_DrawRect(grenderer, thumb.x, thumb.y, thumb.w, thumb.h, thumb_color, FILLED);
+}
+
+static void render_node(xi_Node *node);
+
+static bool xi_skin_node(xi_Node *node) {
+    const SDL_Rect *b = &node->bounds;
+    switch (node->type) {
+        case WIDGET_BUTTON: {
+            Button *button = (Button*)node;
+            if (!xi_draw_skin(XI_SKIN_BUTTON, *b, 255)) return false;
+            xi_draw_skin(XI_SKIN_BUTTON_HOVER, *b, (Uint8)(button->hover_amount * 255 + 0.5f));
+            xi_draw_skin(XI_SKIN_BUTTON_CLICK, *b, (Uint8)(button->click_amount * 255 + 0.5f));
+            return true;
+        }
+        case WIDGET_ENTRY:
+            return xi_draw_skin(((TextEntry*)node)->active ? XI_SKIN_ENTRY_FOCUS : XI_SKIN_ENTRY, *b, 255);
+        case WIDGET_SLIDER: {
+            if (!xi_draw_skin(XI_SKIN_SLIDER_TRACK, *b, 255)) return false;
+            SDL_Rect knob = {slider_handle_x((Slider*)node), b->y, b->h, b->h};
+            xi_draw_skin(XI_SKIN_SLIDER_KNOB, knob, 255);
+            return true;
+        }
+        case WIDGET_CONTAINER: {
+            xi_Container *container = (xi_Container*)node;
+            if (!xi_draw_skin(XI_SKIN_PANEL, *b, 255)) return false;
+            if (container->title && container->title[0]) {
+                xi_draw_skin(XI_SKIN_TITLE_BAR, (SDL_Rect){b->x, b->y, b->w, 30}, 255);  // render_container's bar
+            }
+            return true;
+        }
+        case WIDGET_DROPDOWN:
+            return xi_draw_skin(XI_SKIN_DROPDOWN, *b, 255);
+        case WIDGET_TABS: {
+            xi_Tabs *tabs = (xi_Tabs*)node;
+            if (!xi_theme || !xi_theme->skins[XI_SKIN_TAB].rect.w || !xi_theme->skins[XI_SKIN_TAB_ACTIVE].rect.w) return false;
+            int strip = xi_tab_strip_height(tabs);
+            for (int i = 0, x = b->x; i < tabs->page_count && x < b->x + b->w; ++i) {
+                int width = xi_tab_width(tabs, i);
+                xi_draw_skin(i == tabs->current ? XI_SKIN_TAB_ACTIVE : XI_SKIN_TAB, (SDL_Rect){x, b->y, width, strip}, 255);
+                x += width;
+            }
+            return true;
+        }
+        case WIDGET_TABLE: {
+            int header = node->layout.inset_top;  // render_table's header strip
+            return header > 0 && xi_draw_skin(XI_SKIN_TABLE_HEADER, (SDL_Rect){b->x, b->y, b->w, header}, 255);
+        }
+        default:
+            return false;
+    }
+}
+
+// Whether the skins of node's children go into the batch of node's run. Only laid-out
+// containers keep their children apart; absolutely placed ones may overlap, and below
+// anything else (a scroll area's backing store, a table, tabs) skins are drawn one by one.
+static bool xi_skin_descends(const xi_Node *node) {
+    if (node->scrollable) return false;
+    return node->type == WIDGET_ROOT || (node->type == WIDGET_CONTAINER && node->layout.kind != XI_LAYOUT_NONE);
+}
+
+// Add the skins of node and the subtree below it to xi_skin_batch, culled like render_node
+static void xi_collect_skins(xi_Node *node) {
+    SDL_Rect clip = xi_intersect_rect(node->clip, xi_clip_limit);
+    if (!xi_rects_overlap(&node->bounds, &clip)) {
+        if (node->clips_children || !node->first_child) return;
+    } else {
+        xi_skin_clip = clip;
+        xi_skin_node(node);
+    }
+    if (!xi_skin_descends(node)) return;
+    bool ordered = xi_children_ordered(node);
+    for (xi_Node *child = xi_first_visible_child(node); child; child = child->next_sibling) {
+        if (ordered && xi_past_visible_end(node, child)) break;
+        xi_collect_skins(child);
+    }
+}
+
+// Draw siblings first up to end: all their skins in one call, then the rest of each
+static void xi_render_run(xi_Node *first, xi_Node *end) {
+    if (!xi_theme || xi_current->software || xi_skins_batched) {
+        for (xi_Node *node = first; node != end; node = node->next_sibling) render_node(node);
+        return;
+    }
+    xi_SkinBatch batch = {0};
+    xi_skin_batch = &batch;
+    for (xi_Node *node = first; node != end; node = node->next_sibling) xi_collect_skins(node);
+    xi_skin_batch = NULL;
+    if (batch.quads) {
+        xi_reset_clip();  // the quads are cut to their clips already
+        if (xi_current->pipe) {
+            xi_record_geometry(batch.vertices, batch.quads * 4, batch.indices, batch.quads * 6, xi_theme->atlas);
+        } else {
+            SDL_Texture *texture = xi_skin_texture(xi_theme);
+            if (texture) SDL_RenderGeometry(grenderer, texture, batch.vertices, batch.quads * 4, batch.indices, batch.quads * 6);
+        }
+    }
+    xi_skins_batched = true;
+    for (xi_Node *node = first; node != end; node = node->next_sibling) render_node(node);
+    xi_skins_batched = false;
+}
+
+// Where the run of root's children starting at first ends: before the first sibling
+// that overlaps a member, so no skin of a run can cover another member's text
+static xi_Node *xi_skin_run_end(xi_Node *root, xi_Node *first, bool ordered) {
+    SDL_Rect taken[XI_SKIN_RUN];
+    int count = 0;
+    xi_Node *end = first;
+    while (end && count < XI_SKIN_RUN && !(ordered && xi_past_visible_end(root, end))) {
+        bool overlaps = false;
+        for (int i = 0; i < count && !overlaps; ++i) overlaps = xi_rects_overlap(&taken[i], &end->bounds);
+        if (overlaps) break;
+        taken[count++] = end->bounds;
+        end = end->next_sibling;
+    }
+    return end;
+}
+
+// A root's children in runs whose bounds don't overlap
+static void xi_render_skinned(xi_Node *root) {
+    bool ordered = xi_children_ordered(root);
+    xi_Node *first = xi_first_visible_child(root);
+    while (first && !(ordered && xi_past_visible_end(root, first))) {
+        xi_Node *end = xi_skin_run_end(root, first, ordered);
+        xi_render_run(first, end);
+        first = end;
+    }
+}
+
+static void render_children(xi_Node *node) {
+    if (node->type == WIDGET_ROOT && xi_theme && !xi_current->software && !xi_skins_batched) {
+        xi_render_skinned(node);
+        return;
+    }
+    bool ordered = xi_children_ordered(node);
+    for (xi_Node *child = xi_first_visible_child(node); child; child = child->next_sibling) {
+        if (ordered && xi_past_visible_end(node, child)) break;
+        render_node(child);
+    }
+}
+
+// Opaque color behind a node's children, needed to repaint parts of a backing store
+static bool xi_node_background(xi_Node *node, Color *color);
+
+// Repaint part (absolute coordinates) of a scroll area's backing store
+static void xi_repaint_scroll_region(xi_Node *node, SDL_Rect region, Color background) {
+    SDL_Rect saved_limit = xi_clip_limit;
+    xi_clip_limit = region;
+    xi_apply_clip(&region);
+    xi_DrawRect(grenderer, region.x, region.y, region.w, region.h, background, FILLED);
+    render_children(node);
+    xi_clip_limit = saved_limit;
+}
+
+/*
+ Draws the children of a scroll area through its backing store. Returns false when
+ the store can't be used and the children should be drawn directly.
+*/
+static bool render_scroll_cache(xi_Node *node) {
+    xi_ScrollState *cache = node->scroll;
+    Color background;
+    // The software rasterizer redraws strips cheaply enough without a second framebuffer;
+    // the render thread owns the textures a store would need
+    if (!cache || cache->disabled || xi_current->software || xi_current->pipe || !xi_node_background(node, &background)) return false;
+
+    SDL_Rect view = node->bounds;
+    view.y += node->layout.inset_top;
+    view.h -= node->layout.inset_top;
+    if (view.w <= 0 || view.h <= 0) return true;
+
+    float scale = xi_current->scale;
+    if (cache->width != view.w || cache->height != view.h || cache->scale != scale || !cache->texture[0]) {
+        int pixel_w = (int)SDL_ceilf(view.w * scale), pixel_h = (int)SDL_ceilf(view.h * scale);
+        SDL_DestroyTexture(cache->texture[0]);
+        SDL_DestroyTexture(cache->texture[1]);
+        cache->texture[0] = SDL_CreateTexture(grenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, pixel_w, pixel_h);
+        cache->texture[1] = SDL_CreateTexture(grenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, pixel_w, pixel_h);
+        if (!cache->texture[0] || !cache->texture[1]) {
+            SDL_Log("Scroll backing store unavailable, drawing directly: %s", SDL_GetError());
+            SDL_DestroyTexture(cache->texture[0]);
+            SDL_DestroyTexture(cache->texture[1]);
+            cache->texture[0] = cache->texture[1] = NULL;
+            cache->disabled = true;
+            return false;
+        }
+        cache->width = view.w;
+        cache->height = view.h;
+        cache->scale = scale;
+        cache->valid = false;
+    }
+
+    // The store only holds what was visible; if that changed (window edge, parent clip), repaint
+    SDL_Rect visible = xi_intersect_rect(node->clip, view);
+    visible.x -= view.x;
+    visible.y -= view.y;
+    if (visible.x != cache->cached_clip.x || visible.y != cache->cached_clip.y ||
+        visible.w != cache->cached_clip.w || visible.h != cache->cached_clip.h) {
+        cache->valid = false;
+        cache->cached_clip = visible;
+    }
+
+    int dx = node->scroll_x - cache->cached_x;
+    int dy = node->scroll_y - cache->cached_y;
+    bool full = !cache->valid || SDL_abs(dx) >= view.w || SDL_abs(dy) >= view.h;
+    if (scale != (int)scale) full = full || dx || dy;  // a fractional shift would blur: repaint
+    if (full || dx || dy) {
+        SDL_Texture *previous_target = SDL_GetRenderTarget(grenderer);
+        int saved_origin_x = xi_origin_x, saved_origin_y = xi_origin_y;
+        SDL_Rect saved_limit = xi_clip_limit;
+
+        // While painting the store, (view.x, view.y) is its top-left corner and only the
+        // part that was visible on screen is painted
+        xi_origin_x = view.x;
+        xi_origin_y = view.y;
+        xi_clip_limit = xi_intersect_rect(node->clip, view);
+
+        if (full) {
+            xi_set_render_target(cache->texture[cache->current]);
+            xi_repaint_scroll_region(node, view, background);
+        } else {
+            // Shift what is still visible into the other texture...
+            int next = 1 - cache->current;
+            xi_set_render_target(cache->texture[next]);
+            xi_reset_clip();
+            // The source is in texture pixels, the destination in (scaled) units
+            int s = (int)scale;
+            SDL_Rect dst = {dx < 0 ? -dx : 0, dy < 0 ? -dy : 0, view.w - SDL_abs(dx), view.h - SDL_abs(dy)};
+            SDL_Rect src = {(dx > 0 ? dx : 0) * s, (dy > 0 ? dy : 0) * s, dst.w * s, dst.h * s};
+            SDL_RenderCopy(grenderer, cache->texture[cache->current], &src, &dst);
+            cache->current = next;
+
+            // ...and render only the strips that scrolled into view
+            if (dy > 0) xi_repaint_scroll_region(node, (SDL_Rect){view.x, view.y + view.h - dy, view.w, dy}, background);
+            if (dy < 0) xi_repaint_scroll_region(node, (SDL_Rect){view.x, view.y, view.w, -dy}, background);
+            if (dx > 0) xi_repaint_scroll_region(node, (SDL_Rect){view.x + view.w - dx, view.y, dx, view.h}, background);
+            if (dx < 0) xi_repaint_scroll_region(node, (SDL_Rect){view.x, view.y, -dx, view.h}, background);
+        }
+
+        xi_origin_x = saved_origin_x;
+        xi_origin_y = saved_origin_y;
+        xi_clip_limit = saved_limit;
+        xi_set_render_target(previous_target);
+        cache->cached_x = node->scroll_x;
+        cache->cached_y = node->scroll_y;
+        cache->valid = true;
+    }
+
+    SDL_Rect clip = xi_child_clip(node);
+    xi_apply_clip(&clip);
+    SDL_Rect dst = {view.x - xi_origin_x, view.y - xi_origin_y, view.w, view.h};
+    SDL_RenderCopy(grenderer, cache->texture[cache->current], NULL, &dst);
+    return true;
+}
+
+static void render_node(xi_Node *node) {
+    SDL_Rect clip = xi_intersect_rect(node->clip, xi_clip_limit);
+    if (!xi_rects_overlap(&node->bounds, &clip)) {
+        // Culled. Children of a clipping node can't be visible either.
+        if (node->clips_children || !node->first_child) return;
+    } else {
+        xi_apply_clip(&node->clip);
+        switch (node->type) {
+            case WIDGET_CONTAINER:
+                render_container((xi_Container*)node);
+                break;     
+            case WIDGET_BUTTON:
+                render_button((Button*)node);
+                break;
+            case WIDGET_LABEL:
+                render_label((Label*)node);
+                break;
+            case WIDGET_TEXT:
+                render_text((Text*)node);
+                break;
+         case WIDGET_SLIDER:
+                render_slider((Slider*)node);
+                break; 
+         case WIDGET_ENTRY:
+             	render_text_entry((TextEntry*)node);
+                break;
+            case WIDGET_TABLE:
+                render_table((xi_Table*)node);
+                break;
+            case WIDGET_TABLE_CELL:
+                render_table_cell((xi_Table*)node->parent, (xi_TableCell*)node);
+                break;
+            case WIDGET_PLOT:
+                render_plot((xi_Plot*)node);
+                break;
+            case WIDGET_DROPDOWN:
+                render_dropdown((xi_Dropdown*)node);
+                break;
+            case WIDGET_IMAGE:
+                render_image((xi_Image*)node);
+                break;
+            case WIDGET_TABS:
+                render_tabs((xi_Tabs*)node);
+                break;
+            // Add cases for other widget types here as you implement them
+            default:
+                break;
+        }
+    }
+    // Children are drawn after (on top of) their parent
+    bool batched = xi_skins_batched;
+    if (!xi_skin_descends(node)) xi_skins_batched = false;
+    if (!node->scrollable || !render_scroll_cache(node)) {
+        render_children(node);
+    }
+    xi_skins_batched = batched;
+    if (node->scrollable) {
+        render_scrollbar(node);
+    }
+}
+
+static bool xi_node_background(xi_Node *node, Color *color) {
+    if (node->type == WIDGET_CONTAINER && ((xi_Container*)node)->color.a == 255) {
+        *color = ((xi_Container*)node)->color;
+        return true;
+    }
+    if (node->type == WIDGET_TABLE && ((xi_Table*)node)->background_color.a == 255) {
+        *color = ((xi_Table*)node)->background_color;
+        return true;
+    }
+    return false;
+}
+
+static void xi_draw_task(xi_BuildTask *task) {
+    xi_DisplayList *buffer = &task->buffer;
+    buffer->count = 0;
+    buffer->data_used = 0;
+    xi_recording = buffer;
+    xi_clip_limit = xi_build.clip_limit;
+    xi_clip_active = false;  // the first clip is always recorded; xi_append_commands drops it if unchanged
+    xi_render_run(task->node, task->end);
+    xi_recording = NULL;
+}
+
+// Add a task's commands to the list being built, as if drawn here: geometry moves to the
+// list's data and a leading clip equal to the current one is dropped
+static void xi_append_commands(const xi_DisplayList *buffer) {
+    bool clip_seen = false;
+    for (int i = 0; i < buffer->count; ++i) {
+        const xi_DrawCmd *cmd = &buffer->cmds[i];
+        if (cmd->op == XI_CMD_CLIP || cmd->op == XI_CMD_NO_CLIP) {
+            const SDL_Rect *r = &cmd->u.rect;
+            if (!clip_seen && cmd->op == XI_CMD_CLIP && xi_clip_active && r->x == xi_active_clip.x &&
+                r->y == xi_active_clip.y && r->w == xi_active_clip.w && r->h == xi_active_clip.h) {
+                clip_seen = true;
+                continue;
+            }
+            clip_seen = true;
+            xi_clip_active = cmd->op == XI_CMD_CLIP;
+            if (xi_clip_active) xi_active_clip = *r;
+        }
+        if (cmd->op == XI_CMD_GEOMETRY) {
+            const SDL_Vertex *vertices = (const SDL_Vertex*)(buffer->data + cmd->u.geometry.offset);
+            xi_record_geometry(vertices, cmd->u.geometry.vertex_count,
+                               (const int*)(vertices + cmd->u.geometry.vertex_count), cmd->u.geometry.index_count,
+                               cmd->u.geometry.surface);
+            continue;
+        }
+        xi_DrawCmd *out = xi_record(cmd->op);
+        if (out) *out = *cmd;
+    }
+}
+
+// render_node(root) for a display list, with the root's children recorded on the build
+// threads. False when there is nothing to split (or no threads): draw it the usual way.
+static bool xi_parallel_render(xi_Node *root) {
+    if (xi_build.threads == 0 || !xi_current->pipe || !xi_recording || root->scrollable) return false;
+    xi_build.task_count = 0;
+    bool ordered = xi_children_ordered(root);
+    xi_Node *child = xi_first_visible_child(root);
+    while (child && !(ordered && xi_past_visible_end(root, child))) {
+        // Themed, a task is one of the runs xi_render_skinned draws, so the skins are
+        // batched exactly as they would be on one thread
+        xi_Node *end = xi_theme ? xi_skin_run_end(root, child, ordered) : child->next_sibling;
+        xi_BuildTask *task = xi_add_task(child);
+        if (!task) return false;
+        task->end = end;
+        child = end;
+    }
+    if (xi_build.task_count < 2) return false;
+
+    SDL_Rect clip = xi_intersect_rect(root->clip, xi_clip_limit);
+    if (!xi_rects_overlap(&root->bounds, &clip)) {
+        if (root->clips_children) return true;
+    } else {
+        xi_apply_clip(&root->clip);  // roots draw nothing of their own
+    }
+    // This thread draws tasks too; put its own state back afterwards
+    xi_DisplayList *list = xi_recording;
+    SDL_Rect active_clip = xi_active_clip;
+    bool clip_active = xi_clip_active;
+    xi_build.clip_limit = xi_clip_limit;
+    xi_run_tasks(xi_draw_task);
+    xi_recording = list;
+    xi_clip_limit = xi_build.clip_limit;
+    xi_active_clip = active_clip;
+    xi_clip_active = clip_active;
+    for (int i = 0; i < xi_build.task_count; ++i) xi_append_commands(&xi_build.tasks[i].buffer);
+    return true;
+}
+
+void render_widgets() {
+/*
+ Walks the widget tree depth-first from xi_root and calls the render function for
+ each widget's type. Layout and cached bounds are refreshed first; both only touch
+ the subtrees that changed, so moving a container costs one pass over its own
+ subtree and nothing else. Widgets outside their container's clip are culled.
+ Everything taken from the frame arena is released at the end.
+*/
+    int allocations = SDL_AtomicGet(&xi_heap_allocations);
+    xi_UpdateLayout();
+    xi_UpdateBounds();
+    if (!xi_parallel_render(&xi_root)) render_node(&xi_root);
+    render_node(&xi_overlay);
+    xi_reset_clip();
+    xi_reset_frame_arena();
+    xi_reset_build_arenas();
+    xi_frame_stats.heap_allocations = (Uint32)(SDL_AtomicGet(&xi_heap_allocations) - allocations);
+}
+
+static void dispatch_node_event(xi_Node *node, SDL_Event *event) {
+    switch (node->type) {
+        case WIDGET_CONTAINER:
+            handleContainerMovement((xi_Container*)node, event);
+            break;
+        case WIDGET_BUTTON:
+            update_button((Button*)node, event);
+            break;
+        case WIDGET_SLIDER:
+            update_slider((Slider*)node, event);
+            break;
+        case WIDGET_ENTRY:
+            handle_text_entry_click((TextEntry*)node, event);
+            update_text_entry((TextEntry*)node, event);
+            break;
+        case WIDGET_TABLE:
+            update_table((xi_Table*)node, event);
+            return;  // cells don't take input
+        case WIDGET_PLOT:
+            update_plot((xi_Plot*)node, event);
+            break;
+        case WIDGET_DROPDOWN:
+            update_dropdown((xi_Dropdown*)node, event);
+            break;
+        case WIDGET_TABS:
+            update_tabs((xi_Tabs*)node, event);
+            break;
+        default:
+            break;
+    }
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        dispatch_node_event(child, event);
+    }
+}
+
+// Route an input event to every widget in the tree; hit-tests use the cached bounds.
+// While a popup is open its owner gets the event alone.
+void dispatch_widget_event(SDL_Event *event) {
+    xi_UpdateLayout();
+    xi_UpdateBounds();
+    if (event->type == SDL_MOUSEWHEEL) {
+        int mx, my;
+        SDL_GetMouseState(&mx, &my);
+        xi_Node *target = xi_scroll_target(&xi_overlay, mx, my);
+        if (!target && !xi_input_capture) target = xi_scroll_target(&xi_root, mx, my);
+        if (target) {
+            // Each notch adds enough speed to glide about XI_SCROLL_STEP pixels
+            xi_Fling(target, -event->wheel.x * XI_SCROLL_STEP * XI_SCROLL_FRICTION,
+                     -event->wheel.y * XI_SCROLL_STEP * XI_SCROLL_FRICTION);
+        }
+    }
+    if (xi_input_capture) {
+        dispatch_node_event(xi_input_capture, event);
+        return;
+    }
+    dispatch_node_event(&xi_overlay, event);
+    dispatch_node_event(&xi_root, event);
+}
+
+/*
+ Frames are drawn into xi_screen, which keeps the window's pixels between frames.
+ When nothing but xi_Invalidate() happened since the last frame (a blinking cursor,
+ a hover fade), only the damaged rectangle is cleared and drawn again; the rest of
+ the window is reused. Without render-target support every frame is drawn in full.
+*/
+// Re-measure everything: text sizes in logical units change a little with the scale
+static void xi_mark_tree_dirty(xi_Node *node) {
+    node->layout.measure_dirty = true;
+    node->layout.arrange_dirty = true;
+    if (node->type == WIDGET_TABS) {
+        xi_Tabs *tabs = (xi_Tabs*)node;
+        for (int i = 0; i < tabs->page_count; ++i) tabs->pages[i]->width = 0;
     }
+    for (xi_Node *child = node->first_child; child; child = child->next_sibling) {
+        xi_mark_tree_dirty(child);
+    }
+}
 
-    // Redraw container outline after adjusting for title bar
-    xi_DrawRect(grenderer, x, y, width, height, container->color, OUTLINE);
+// Pick up the display scale, which changes when the window moves to another monitor
+static void xi_update_scale(void) {
+    int window_w, window_h, pixel_w = 0, pixel_h = 0;
+    SDL_GetWindowSize(gwindow, &window_w, &window_h);
+    if (xi_current->software) {
+        SDL_Surface *window_surface = SDL_GetWindowSurface(gwindow);
+        if (window_surface) pixel_w = window_surface->w;
+    } else if (!xi_current->pipe) {
+        SDL_GetRendererOutputSize(grenderer, &pixel_w, &pixel_h);
+    }
+    float scale = window_w > 0 && pixel_w > 0 ? (float)pixel_w / window_w : 1.0f;
+    if (xi_current->pipe) scale = xi_pipe_scale();  // measured by the render thread
+    if (scale == xi_current->scale) return;
+    xi_current->scale = scale;
+    xi_mark_tree_dirty(&xi_root);
+    xi_mark_tree_dirty(&xi_overlay);
+    xi_redraw = true;
 }
 
-// Handle container movement if movable is true
-void handleContainerMovement(xi_Container *container, SDL_Event *event) {
-    static bool dragging = false;
-    static int offsetX = 0, offsetY = 0;
+//=================== FRAME CAPTURE ==================
+/*
+ Records what a window shows, frame by frame, without the UI thread waiting for disk
+ or compression:
 
-    if (!container->movable) return;
+    xi_StartCapture("session.xiraw", XI_CAPTURE_RAW);      // one file
+    xi_StartCapture("shots/frame%05d.png", XI_CAPTURE_IMAGES);  // one image per frame
+    ...
+    xi_CaptureStats stats = xi_StopCapture();      // writes what is still queued
 
-    if (event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT) {
-        int mouseX = event->button.x;
-        int mouseY = event->button.y;
+ Each drawn frame copies only the part it changed from the framebuffer into one of
+ XI_CAPTURE_BUFFERS pooled buffers, allocated for whole frames when the capture starts
+ so no frame pays for growing one. A writer thread takes the buffers in order. Raw
+ files get them as they are; image sequences keep a whole frame, patch it and hand a
+ copy to the worker pool to compress (PNG with XI_USE_SDL_IMAGE, otherwise BMP), at most
+ XI_CAPTURE_ENCODERS at once. When every buffer is still waiting the frame is dropped
+ and counted, and the next one is copied whole so nothing is patched onto a gap.
+ Frames are only recorded when something was drawn; each carries its time.
 
-        // Check if click is within the title bar
-        if (mouseX >= container->x && mouseX <= container->x + container->width &&
-            mouseY >= container->y && mouseY <= container->y + 30) {
-            dragging = true;
-            offsetX = mouseX - container->x;
-            offsetY = mouseY - container->y;
-        }
-    } else if (event->type == SDL_MOUSEBUTTONUP && event->button.button == SDL_BUTTON_LEFT) {
-        dragging = false;
-    } else if (event->type == SDL_MOUSEMOTION && dragging) {
-        container->x = event->motion.x - offsetX;
-        container->y = event->motion.y - offsetY;
-    }
-}
+ A raw file starts with "XICAPRAW" and is a run of records, all little endian:
+ frame number, ms since the start, window width and height, x, y, w, h (8 x 32 bits)
+ and the w*h ARGB8888 pixels of the changed rectangle. A frame covering the whole
+ window follows every gap in the frame numbers.
 
-//==================== WIDGETS ==================
+ Only software windows (xi_UseSoftwareRenderer) can be captured. Reading a GPU frame
+ back with SDL_RenderReadPixels stalls the UI thread until the GPU is done every frame,
+ and SDL has no way to read back later; pipelined frames only exist on the render thread.
+*/
+#define XI_CAPTURE_BUFFERS 8
+#define XI_CAPTURE_ENCODERS 4
 
-// --------------------------- Text Entry Struct ---------------------------
+typedef enum { XI_CAPTURE_RAW, XI_CAPTURE_IMAGES } xi_CaptureFormat;
+
+typedef struct xi_CaptureStats {
+    int captured;               // frames handed to the writer
+    int dropped;                // frames skipped because the writer was behind
+    int written;
+    int failed;                 // frames the disk or encoder refused
+    Uint64 bytes;               // pixels copied on the UI thread
+    float copy_ms;              // average UI thread time per captured frame
+} xi_CaptureStats;
 
-#define MAX_TEXT_LENGTH 256
 typedef struct {
-    int x, y, width, height;
-    char text[MAX_TEXT_LENGTH];
-    int cursor_position;
-    int text_offset;
-    bool active;
-    int font_size;
-    Color text_color;
-    Color background_color;
-    xi_Container* parent;
-} TextEntry;
+    Uint8 *pixels;              // ARGB8888, rect.w * 4 bytes per row
+    size_t capacity;
+    SDL_Rect rect;              // what the frame changed, in pixels
+    int width, height;          // whole window
+    Uint32 index, time;
+} xi_CaptureFrame;
 
-// Initialize a single-line text entry box
-TextEntry CreateTextEntry(int x, int y, int width, int height, int font_size, Color text_color, Color background_color) {
-    TextEntry entry;
-    entry.x = x;
-    entry.y = y;
-    entry.width = width;
-    entry.height = height;
-    entry.font_size = font_size;
-    entry.text_color = text_color;
-    entry.background_color = background_color;
-    entry.active = false;
-    entry.cursor_position = 0;
-    entry.text_offset = 0;
-    entry.parent=NULL;
-    memset(entry.text, 0, MAX_TEXT_LENGTH); // Initialize text with empty characters
-    
-    // registers widgets so sw_loop() can keep track of it, see render_widgets() for more details
-    	register_widget(WIDGET_ENTRY, &entry);
-    	
-    return entry;
-}
+typedef struct xi_Capture {
+    xi_CaptureFormat format;
+    char *path;                 // file, or pattern with the frame number for images
+    SDL_RWops *file;
+    xi_CaptureFrame frames[XI_CAPTURE_BUFFERS];
+    Uint32 produced, consumed;  // ring positions, under lock
+    SDL_mutex *lock;
+    SDL_cond *wake;             // frames queued or stopping
+    SDL_cond *done;             // an encoder slot came free
+    SDL_Thread *thread;
+    bool stop;
+    // UI thread
+    bool keyframe;              // the next frame must cover the whole window
+    int width, height;          // of the last captured frame
+    Uint32 next_index, start;
+    Uint64 copy_ticks;
+    // writer thread
+    SDL_Surface *whole;         // image sequences: the frame as patched so far
+    SDL_Surface *encoders[XI_CAPTURE_ENCODERS];
+    bool encoding[XI_CAPTURE_ENCODERS];
+    bool reported;              // first write error logged
+    xi_CaptureStats stats;
+} xi_Capture;
 
-// Render the text entry box with scrolling support
-void render_text_entry(TextEntry *entry) {
-        //------------------ for containers ------------
-        int x, y;
+typedef struct {
+    xi_Capture *capture;
+    int slot;
+    Uint32 index;
+} xi_CaptureJob;
 
-        if (entry->parent) { // Check if rect is inside a container
-            x = entry->parent->x + entry->x; 
-            y = entry->parent->y + entry->y; 
-        } else {
-            x = entry->x;
-            y = entry->y;
-        }
-        //--------------------------
-    // Draw background
-    xi_DrawRect(grenderer, x, y, entry->width, entry->height, entry->background_color, FILLED);
+static void xi_capture_failed(xi_Capture *c, const char *what) {
+    SDL_LockMutex(c->lock);
+    if (!c->reported) SDL_Log("Capture: %s failed: %s", what, SDL_GetError());
+    c->reported = true;
+    c->stats.failed++;
+    SDL_UnlockMutex(c->lock);
+}
 
-    // Draw border
-    xi_DrawRect(grenderer, x, y, entry->width, entry->height, COLOR_BLUE, OUTLINE);
+static bool xi_capture_write_raw(xi_Capture *c, const xi_CaptureFrame *frame) {
+    Uint32 header[8] = {frame->index, frame->time, (Uint32)frame->width, (Uint32)frame->height,
+                        (Uint32)frame->rect.x, (Uint32)frame->rect.y, (Uint32)frame->rect.w, (Uint32)frame->rect.h};
+    for (int i = 0; i < 8; ++i) {
+        if (SDL_WriteLE32(c->file, header[i]) != 1) return false;
+    }
+    size_t size = (size_t)frame->rect.w * frame->rect.h * 4;
+    return size == 0 || SDL_RWwrite(c->file, frame->pixels, size, 1) == 1;
+}
 
-    // Determine max visible characters (adjust for padding)
-    int max_visible_chars = (entry->width - 10) / 10;  // 10px padding on the left side
-    int text_length = strlen(entry->text);
+static void xi_capture_encode(void *data) {
+    xi_CaptureJob *job = data;
+    xi_Capture *c = job->capture;
+    char name[1024];
+    SDL_snprintf(name, sizeof(name), c->path, (int)job->index);
+#ifdef XI_USE_SDL_IMAGE
+    bool saved = IMG_SavePNG(c->encoders[job->slot], name) == 0;
+#else
+    bool saved = SDL_SaveBMP(c->encoders[job->slot], name) == 0;
+#endif
+    if (!saved) xi_capture_failed(c, name);
+    SDL_LockMutex(c->lock);
+    if (saved) c->stats.written++;
+    c->encoding[job->slot] = false;
+    SDL_CondBroadcast(c->done);
+    SDL_UnlockMutex(c->lock);
+    SDL_free(job);
+}
 
-    // Adjust text offset (scrolling one char earlier)
-    if (entry->cursor_position >= entry->text_offset + max_visible_chars - 1) {
-        entry->text_offset = entry->cursor_position - (max_visible_chars - 1);
-    } else if (entry->cursor_position < entry->text_offset) {
-        entry->text_offset = entry->cursor_position;
+// Patch the whole frame and give a copy of it to the worker pool
+static bool xi_capture_write_image(xi_Capture *c, const xi_CaptureFrame *frame) {
+    if (!c->whole || c->whole->w != frame->width || c->whole->h != frame->height) {
+        SDL_FreeSurface(c->whole);
+        c->whole = SDL_CreateRGBSurfaceWithFormat(0, frame->width, frame->height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!c->whole) return false;
+    }
+    for (int y = 0; y < frame->rect.h; ++y) {
+        Uint8 *row = (Uint8*)c->whole->pixels + (size_t)(frame->rect.y + y) * c->whole->pitch + frame->rect.x * 4;
+        memcpy(row, frame->pixels + (size_t)y * frame->rect.w * 4, (size_t)frame->rect.w * 4);
     }
 
-    // Get substring to display
-    char visible_text[MAX_TEXT_LENGTH];
-    strncpy(visible_text, entry->text + entry->text_offset, max_visible_chars);
-    visible_text[max_visible_chars] = '\0';
-
-    // Draw only the visible portion of text
-    xi_DrawText(grenderer,  visible_text, x + 5, y + 5, entry->text_color, entry->font_size);
+    SDL_LockMutex(c->lock);
+    int slot = -1;
+    for (;;) {
+        for (int i = 0; i < XI_CAPTURE_ENCODERS && slot < 0; ++i) {
+            if (!c->encoding[i]) slot = i;
+        }
+        if (slot >= 0) break;
+        SDL_CondWait(c->done, c->lock);
+    }
+    c->encoding[slot] = true;
+    SDL_UnlockMutex(c->lock);
 
-    // Draw cursor
-    if (entry->active) {
-        int cursor_x = entry->x + 5 + ((entry->cursor_position - entry->text_offset) * 10);
-        xi_DrawRect(grenderer, cursor_x, y + 5, 2, entry->font_size, entry->text_color, FILLED);
+    SDL_Surface *copy = c->encoders[slot];
+    if (!copy || copy->w != c->whole->w || copy->h != c->whole->h) {
+        SDL_FreeSurface(copy);
+        copy = c->encoders[slot] = SDL_CreateRGBSurfaceWithFormat(0, c->whole->w, c->whole->h, 32, SDL_PIXELFORMAT_ARGB8888);
+    }
+    xi_CaptureJob *job = copy ? SDL_malloc(sizeof(xi_CaptureJob)) : NULL;
+    if (!job) {
+        SDL_LockMutex(c->lock);
+        c->encoding[slot] = false;
+        SDL_UnlockMutex(c->lock);
+        return false;
     }
+    memcpy(copy->pixels, c->whole->pixels, (size_t)c->whole->h * c->whole->pitch);
+    *job = (xi_CaptureJob){c, slot, frame->index};
+    // xi_StartCapture started the pool; starting it from this thread would race the UI thread
+    if (!xi_queue_job(xi_capture_encode, NULL, job)) xi_capture_encode(job);  // no pool: encode here
+    return true;
 }
 
-// Update text entry with user input and enable scrolling
-void update_text_entry(TextEntry *entry, SDL_Event *event) {
-    if (!entry->active) return;
+static int xi_capture_writer(void *data) {
+    xi_Capture *c = data;
+    SDL_LockMutex(c->lock);
+    for (;;) {
+        while (c->consumed == c->produced && !c->stop) SDL_CondWait(c->wake, c->lock);
+        if (c->consumed == c->produced) break;  // stopped and drained
+        xi_CaptureFrame *frame = &c->frames[c->consumed % XI_CAPTURE_BUFFERS];
+        SDL_UnlockMutex(c->lock);
 
-    if (event->type == SDL_TEXTINPUT) {
-        int text_length = strlen(entry->text);
-        if (text_length < MAX_TEXT_LENGTH - 1) {
-            memmove(&entry->text[entry->cursor_position + 1], &entry->text[entry->cursor_position], text_length - entry->cursor_position + 1);
-            entry->text[entry->cursor_position] = event->text.text[0];
-            entry->cursor_position++;
-        }
-    } else if (event->type == SDL_KEYDOWN) {
-        if (event->key.keysym.sym == SDLK_BACKSPACE && entry->cursor_position > 0) {
-            memmove(&entry->text[entry->cursor_position - 1], &entry->text[entry->cursor_position], strlen(entry->text) - entry->cursor_position + 1);
-            entry->cursor_position--;
-        } else if (event->key.keysym.sym == SDLK_LEFT && entry->cursor_position > 0) {
-            entry->cursor_position--;
-        } else if (event->key.keysym.sym == SDLK_RIGHT && entry->cursor_position < strlen(entry->text)) {
-            entry->cursor_position++;
+        if (c->format == XI_CAPTURE_RAW) {
+            if (xi_capture_write_raw(c, frame)) {
+                SDL_LockMutex(c->lock);
+                c->stats.written++;
+                SDL_UnlockMutex(c->lock);
+            } else {
+                xi_capture_failed(c, c->path);
+            }
+        } else if (!xi_capture_write_image(c, frame)) {
+            xi_capture_failed(c, "encoding a frame");
         }
+
+        SDL_LockMutex(c->lock);
+        c->consumed++;
+    }
+    // Wait for the last images to be compressed
+    for (int i = 0; i < XI_CAPTURE_ENCODERS; ++i) {
+        while (c->encoding[i]) SDL_CondWait(c->done, c->lock);
     }
+    SDL_UnlockMutex(c->lock);
+    return 0;
 }
 
-// Handle activation on mouse click
-void handle_text_entry_click(TextEntry *entry, SDL_Event *event) {
-    if (event->type == SDL_MOUSEBUTTONDOWN) {
-        int mx = event->button.x;
-        int my = event->button.y;
+static void xi_free_capture(xi_Capture *c) {
+    if (c->file) SDL_RWclose(c->file);
+    for (int i = 0; i < XI_CAPTURE_BUFFERS; ++i) SDL_free(c->frames[i].pixels);
+    for (int i = 0; i < XI_CAPTURE_ENCODERS; ++i) SDL_FreeSurface(c->encoders[i]);
+    SDL_FreeSurface(c->whole);
+    if (c->lock) SDL_DestroyMutex(c->lock);
+    if (c->wake) SDL_DestroyCond(c->wake);
+    if (c->done) SDL_DestroyCond(c->done);
+    SDL_free(c->path);
+    SDL_free(c);
+}
 
-        if (mx >= entry->x && mx <= entry->x + entry->width &&
-            my >= entry->y && my <= entry->y + entry->height) {
-            entry->active = true;
-        } else {
-            entry->active = false;
+// Start recording the current window. For XI_CAPTURE_IMAGES path is a printf pattern
+// taking the frame number, e.g. "frame%05d.png".
+bool xi_StartCapture(const char *path, xi_CaptureFormat format) {
+    if (xi_current->capture) {
+        SDL_Log("This window is already being captured");
+        return false;
+    }
+    if (!xi_current->software) {
+        SDL_Log("Only software windows can be captured (see xi_UseSoftwareRenderer)");
+        return false;
+    }
+    xi_Capture *c = SDL_calloc(1, sizeof(xi_Capture));
+    if (!c) {
+        SDL_Log("Out of memory starting a capture");
+        return false;
+    }
+    c->format = format;
+    c->path = SDL_strdup(path);
+    c->lock = SDL_CreateMutex();
+    c->wake = SDL_CreateCond();
+    c->done = SDL_CreateCond();
+    if (!c->path || !c->lock || !c->wake || !c->done) {
+        SDL_Log("Failed to start capture: %s", SDL_GetError());
+        xi_free_capture(c);
+        return false;
+    }
+    if (format == XI_CAPTURE_RAW) {
+        c->file = SDL_RWFromFile(path, "wb");
+        if (!c->file || SDL_RWwrite(c->file, "XICAPRAW", 8, 1) != 1) {
+            SDL_Log("Failed to open %s: %s", path, SDL_GetError());
+            xi_free_capture(c);
+            return false;
         }
     }
-} 
-
+    // Buffers for whole frames up front and touched once: a fresh page costs more than
+    // copying into it, and no captured frame should pay for that
+    SDL_Surface *canvas = xi_current->canvas;
+    size_t whole = canvas ? (size_t)canvas->w * canvas->h * 4 : 0;
+    for (int i = 0; i < XI_CAPTURE_BUFFERS && whole > 0; ++i) {
+        c->frames[i].pixels = SDL_malloc(whole);
+        if (!c->frames[i].pixels) {
+            SDL_Log("Out of memory starting a capture");
+            xi_free_capture(c);
+            return false;
+        }
+        memset(c->frames[i].pixels, 0, whole);
+        c->frames[i].capacity = whole;
+    }
+    // On this thread: the writer only queues encodes, it never starts the pool
+    if (format == XI_CAPTURE_IMAGES) xi_start_workers();
+    c->thread = SDL_CreateThread(xi_capture_writer, "xi capture", c);
+    if (!c->thread) {
+        SDL_Log("Failed to start capture thread: %s", SDL_GetError());
+        xi_free_capture(c);
+        return false;
+    }
+    c->keyframe = true;
+    c->start = SDL_GetTicks();
+    xi_current->capture = c;
+    xi_redraw = true;  // the first frame shows everything
+    return true;
+}
 
-// ---------------- Label Structure ----------------
-typedef struct {
-    int x, y, width, height;
-    const char *text;
-    Color text_color;
-    Color background_color; // Can be transparent
-    xi_Container* parent;
-} Label;
+static void xi_stop_capture(xi_Context *context, xi_CaptureStats *stats) {
+    xi_Capture *c = context->capture;
+    if (!c) return;
+    SDL_LockMutex(c->lock);
+    c->stop = true;
+    SDL_CondSignal(c->wake);
+    SDL_UnlockMutex(c->lock);
+    SDL_WaitThread(c->thread, NULL);
+    if (stats) *stats = c->stats;
+    context->capture = NULL;
+    xi_free_capture(c);
+}
 
-// ---------------- Button Structure ----------------
-typedef struct {
-    int x, y, width, height;
-    const char *text;
-    Color text_color;
-    Color background_color;
-    Color hover_color;
-    Color click_color;
-    bool hovered;
-    bool clicked;
-    xi_Container* parent;
-} Button;
+// Stop recording the current window once everything queued is written
+xi_CaptureStats xi_StopCapture(void) {
+    xi_CaptureStats stats = {0};
+    xi_stop_capture(xi_current, &stats);
+    return stats;
+}
 
-// ---------------- Text Structure ----------------
-typedef struct {
-    int x, y;
-    const char *text;
-    Color text_color;
-    int font_size;
-    xi_Container* parent;
-} Text;
+xi_CaptureStats xi_GetCaptureStats(void) {
+    xi_CaptureStats stats = {0};
+    xi_Capture *c = xi_current->capture;
+    if (!c) return stats;
+    SDL_LockMutex(c->lock);
+    stats = c->stats;
+    SDL_UnlockMutex(c->lock);
+    return stats;
+}
 
-// ---------------- Label Functions ----------------
-Label CreateLabel(int x, int y, int width, int height, const char *text, Color text_color, Color background_color) {
-    Label label = {x, y, width, height, text, text_color, background_color, NULL};
-    
-    register_widget(WIDGET_LABEL, &label);
-    	
-    return label;
+static void xi_capture_drop(xi_Capture *c) {
+    SDL_LockMutex(c->lock);
+    c->stats.dropped++;
+    SDL_UnlockMutex(c->lock);
+    c->keyframe = true;  // the writer must not patch the next frame onto the gap
 }
 
-void render_label(Label *label) {
-    int x, y;
+// Copy what this frame changed (area, in pixels) out of the framebuffer into the next
+// free buffer. Call after drawing.
+static void xi_capture_frame(SDL_Rect area, int width, int height) {
+    xi_Capture *c = xi_current->capture;
+    Uint64 begin = SDL_GetPerformanceCounter();
+    Uint32 index = c->next_index++;
 
-    if (label->parent) { // Check if rect is inside a container
-        x = label->parent->x + label->x; 
-        y = label->parent->y + label->y; 
-    } else {
-        x = label->x;
-        y = label->y;
+    SDL_LockMutex(c->lock);
+    bool full = c->produced - c->consumed == XI_CAPTURE_BUFFERS;
+    SDL_UnlockMutex(c->lock);
+    if (full) {
+        xi_capture_drop(c);
+        return;
     }
-    if (label->background_color.a != 0) {  // If not transparent
-        xi_DrawRect(grenderer, x, y, label->width, label->height, label->background_color, FILLED);
+
+    if (width != c->width || height != c->height) c->keyframe = true;
+    SDL_Rect window = {0, 0, width, height};
+    area = c->keyframe ? window : xi_intersect_rect(area, window);
+    xi_CaptureFrame *frame = &c->frames[c->produced % XI_CAPTURE_BUFFERS];  // only the writer moves consumed
+    size_t size = (size_t)area.w * area.h * 4;
+    if (size > frame->capacity) {
+        Uint8 *pixels = SDL_realloc(frame->pixels, size);
+        if (!pixels) {
+            SDL_Log("Out of memory capturing a frame");
+            xi_capture_drop(c);
+            return;
+        }
+        frame->pixels = pixels;
+        frame->capacity = size;
     }
-    xi_DrawText(grenderer, label->text, x + 5,y + 5, label->text_color, 16);
-}
+    SDL_Surface *canvas = xi_current->canvas;
+    for (int y = 0; y < area.h; ++y) {
+        memcpy(frame->pixels + (size_t)y * area.w * 4,
+               (Uint8*)canvas->pixels + (size_t)(area.y + y) * canvas->pitch + area.x * 4, (size_t)area.w * 4);
+    }
+    frame->rect = area;
+    frame->width = c->width = width;
+    frame->height = c->height = height;
+    frame->index = index;
+    frame->time = SDL_GetTicks() - c->start;
+    c->keyframe = false;
+    c->copy_ticks += SDL_GetPerformanceCounter() - begin;
 
-// ---------------- Button Functions ----------------
-Button CreateButton(int x, int y, int width, int height, const char *text, Color text_color, Color background_color, Color hover_color, Color click_color) {
-    Button button = {x, y, width, height, text, text_color, background_color, hover_color, click_color, false, false, NULL};
-    register_widget(WIDGET_TEXT, &button);
-    return button;
+    SDL_LockMutex(c->lock);
+    c->produced++;
+    c->stats.captured++;
+    c->stats.bytes += size;
+    c->stats.copy_ms = 1000.0f * c->copy_ticks / SDL_GetPerformanceFrequency() / c->stats.captured;
+    SDL_CondSignal(c->wake);
+    SDL_UnlockMutex(c->lock);
 }
 
-void render_button(Button *button) {
-    //------------------ for containers ------------
-    int x, y;
+// Software windows: draw into the framebuffer and copy the changed part to the window
+static void xi_render_software_frame(void) {
+    if (!xi_soft_prepare_canvas()) return;
+    bool full = xi_redraw;
+    SDL_Rect damage = xi_damage;
+    xi_redraw = false;
+    xi_damaged = false;
 
-    if (button->parent) { // Check if rect is inside a container
-        x = button->parent->x + button->x; 
-        y = button->parent->y + button->y; 
+    SDL_Rect area = {0, 0, xi_current->canvas->w, xi_current->canvas->h};
+    xi_reset_clip();
+    if (full) {
+        xi_ClearScreen(grenderer, COLOR_GRAY);
+        render_widgets();
     } else {
-        x = button->x;
-        y = button->y;
-    }
-    //--------------------------
-    Color current_color = button->background_color;
-    if (button->clicked) {
-        current_color = button->click_color;
-    } else if (button->hovered) {
-        current_color = button->hover_color;
+        SDL_Rect saved_limit = xi_clip_limit;
+        xi_clip_limit = damage;
+        xi_apply_clip(&damage);
+        area = xi_soft_clip;
+        xi_soft_fill_pixels(area.x, area.y, area.x + area.w, area.y + area.h, xi_pack_color(COLOR_GRAY));
+        render_widgets();  // culled to the damaged part
+        xi_clip_limit = saved_limit;
     }
 
-    xi_DrawRect(grenderer, x, y, button->width, button->height, current_color, FILLED);
-    xi_DrawText(grenderer,  button->text,x + 10, y + 10, button->text_color, 16);
-}
+    if (xi_current->capture) xi_capture_frame(area, xi_current->canvas->w, xi_current->canvas->h);
 
-void update_button(Button *button, SDL_Event *event) {
-    int mx = event->motion.x;
-    int my = event->motion.y;
+    SDL_Surface *window_surface = SDL_GetWindowSurface(gwindow);
+    if (!window_surface || area.w <= 0 || area.h <= 0) return;
+    SDL_Rect to = area;
+    SDL_BlitSurface(xi_current->canvas, &area, window_surface, &to);
+    SDL_UpdateWindowSurfaceRects(gwindow, &area, 1);
+}
 
-    if (event->type == SDL_MOUSEMOTION) {
-        button->hovered = (mx >= button->x && mx <= button->x + button->width &&
-                           my >= button->y && my <= button->y + button->height);
+// Pipelined windows: record the frame for the render thread, or skip it while it is behind
+static void xi_render_pipelined_frame(void) {
+    xi_DisplayList *list = xi_begin_display_list();
+    if (!list) return;  // redraw and damage stay pending
+    if (SDL_AtomicSet(&xi_current->pipe->need_full, 0) || SDL_AtomicGet(&xi_current->pipe->no_screen)) {
+        xi_redraw = true;
     }
-    if (event->type == SDL_MOUSEBUTTONDOWN && button->hovered) {
-        button->clicked = true;
-    }
-    if (event->type == SDL_MOUSEBUTTONUP) {
-        button->clicked = false;
+    bool full = xi_redraw;
+    SDL_Rect damage = xi_damage;
+    xi_redraw = false;
+    xi_damaged = false;
+    list->full = full;
+
+    xi_reset_clip();
+    if (full) {
+        xi_ClearScreen(grenderer, COLOR_GRAY);
+        render_widgets();
+    } else {
+        SDL_Rect saved_limit = xi_clip_limit;
+        xi_clip_limit = damage;
+        xi_apply_clip(&damage);
+        xi_DrawRect(grenderer, damage.x, damage.y, damage.w, damage.h, COLOR_GRAY, FILLED);
+        render_widgets();  // culled to the damaged part
+        xi_clip_limit = saved_limit;
     }
+    xi_submit_display_list(list);
 }
 
-// ---------------- Text Functions ----------------
-Text CreateText( const char *text,int x, int y, Color text_color, int font_size) {
-    Text txt = {x, y, text, text_color, font_size,NULL};
-    
-    register_widget(WIDGET_TEXT, &txt);
-    	
-    return txt;
-}
+//=================== FRAME PACING ==================
+/*
+ Without pacing a pending frame is drawn as soon as XI_FRAME_INTERVAL has passed and
+ then waits for the display, so the input it shows can be most of a refresh old by
+ the time it is seen. Paced frames start as late as they safely can instead:
 
-void render_text(Text *text) {
-    int x, y;
+    xi_SetFramePacing(XI_PACE_LATENCY);  // every refresh, after xiCreateWindow
+    xi_SetFramePacing(XI_PACE_POWER);    // every other refresh
+    xi_SetFramePacing(XI_PACE_OFF);
 
-    if (text->parent) { // Check if rect is inside a container
-        x = text->parent->x + text->x; 
-        y = text->parent->y + text->y; 
-    } else {
-        x = text->x;
-        y = text->y;
-    }
-    xi_DrawText(grenderer, text->text,x,y, text->text_color,text->font_size);
-}
+ The main window then presents in sync with vblank, which gives the refresh phase. The
+ interval starts from the display mode and follows the measured time between presents.
+ Each frame aims for a vblank and starts the slowest of the last XI_PACING_SAMPLES
+ drawing times (plus XI_PACING_MARGIN) before it; EventLoop sleeps until then, reads
+ the input that arrived meanwhile and draws, so a drag reaches the screen one drawing
+ time after it was read. Nothing is drawn while nothing changed. Other windows are
+ drawn first in the same pass. A pipelined or software main window keeps its own
+ presents and is only spaced by the interval. xi_pacing_stats counts missed vblanks.
+*/
+typedef enum { XI_PACE_OFF, XI_PACE_LATENCY, XI_PACE_POWER } xi_PacingMode;
 
-// ----------- slider -----------------
-typedef struct {
-    int x, y, width, height;
-    int min_value, max_value;
-    int value;
-    bool dragging;
-    xi_Container* parent;
-} Slider;
+#define XI_PACING_SAMPLES 32
+#define XI_PACING_MARGIN 1500  // us of slack for wake-up jitter
 
-// Create a slider
-Slider CreateSlider(int x, int y, int width, int height, int min_value, int max_value, int start_value) {
-    Slider slider = {x, y, width, height, min_value, max_value, start_value, false,NULL};
-    register_widget(WIDGET_SLIDER, &slider);
-    	
-    return slider;
-}
+typedef struct {
+    int frames;
+    int missed;                 // presented a refresh or more after the vblank aimed for
+    float refresh_ms;           // current estimate of the refresh interval
+    float lead_ms;              // how long before vblank frames start
+} xi_PacingStats;
 
-// Render the slider with a centered value
-void render_slider(Slider *slider) {
-        //------------------ for containers ------------
-        int x, y;
+xi_PacingStats xi_pacing_stats;
 
-        if (slider->parent) { // Check if rect is inside a container
-            x = slider->parent->x + slider->x; 
-            y = slider->parent->y + slider->y; 
-        } else {
-            x = slider->x;
-            y = slider->y;
-        }
-        //--------------------------
-    // Draw the bar (track)
-    xi_DrawRect(grenderer, x, y, slider->width, slider->height, COLOR_WHITE, FILLED);
+static struct {
+    xi_PacingMode mode;
+    bool synced;                // the main renderer waits for vblank
+    bool presented;             // the main window presented in this pass
+    Uint64 frequency;           // performance counter ticks per second
+    Uint64 refresh;             // ticks between vblanks
+    Uint64 last_vblank;         // when the last main window present returned; 0 before one
+    Uint64 target;              // vblank the scheduled frame aims for
+    Uint64 start_at;            // when to start drawing it; 0 when nothing is scheduled
+    Uint64 frame_start;
+    Uint64 costs[XI_PACING_SAMPLES];  // recent drawing times, up to the present
+    int cost_index;
+} xi_pacing;
 
-    // Calculate the thumb (handle) position
-    float percentage = (float)(slider->value - slider->min_value) / (slider->max_value - slider->min_value);
-    int handle_x = x + (int)(percentage * (slider->width - slider->height)); // Keep thumb inside the track
+void xi_SetFramePacing(xi_PacingMode mode) {
+    xi_Context *context = xi_main_context;
+    xi_pacing.mode = mode;
+    xi_pacing.frequency = SDL_GetPerformanceFrequency();
+    xi_pacing.last_vblank = 0;
+    xi_pacing.start_at = 0;
+    SDL_memset(xi_pacing.costs, 0, sizeof(xi_pacing.costs));
 
-    // Draw the thumb (handle) inside the bar
-    xi_DrawRect(grenderer, handle_x, y, slider->height, slider->height, COLOR_BLUE, FILLED);
+    int rate = 60;
+    SDL_DisplayMode display;
+    if (context->window && SDL_GetWindowDisplayMode(context->window, &display) == 0 && display.refresh_rate > 0) {
+        rate = display.refresh_rate;
+    }
+    xi_pacing.refresh = xi_pacing.frequency / rate;
+    xi_pacing_stats.refresh_ms = 1000.0f / rate;
 
-    // Render the value inside the thumb
-    char value_text[16];
-    snprintf(value_text, sizeof(value_text), "%d", slider->value);
+    bool synced = false;
+    if (context->renderer) {  // not a pipelined or software window
+        synced = mode != XI_PACE_OFF;
+        if (SDL_RenderSetVSync(context->renderer, synced) != 0) {
+            if (synced) SDL_Log("No vsync, pacing frames on the nominal refresh: %s", SDL_GetError());
+            synced = false;
+        }
+    }
+    xi_pacing.synced = synced;
+}
 
-    int text_x = handle_x + (slider->height / 4);  // Center inside the thumb
-    int text_y = y + (slider->height / 4);
+static Uint64 xi_pacing_lead(void) {
+    Uint64 cost = 0;
+    for (int i = 0; i < XI_PACING_SAMPLES; ++i) {
+        if (xi_pacing.costs[i] > cost) cost = xi_pacing.costs[i];
+    }
+    return cost + xi_pacing.frequency * XI_PACING_MARGIN / 1000000;
+}
 
-    xi_DrawText(grenderer, value_text, text_x, text_y,  COLOR_WHITE,slider->height / 2);
+// Pick the vblank the next frame aims for and when drawing it has to start
+static void xi_pacing_schedule(Uint64 now) {
+    Uint64 lead = xi_pacing_lead();
+    Uint64 period = xi_pacing.refresh * (xi_pacing.mode == XI_PACE_POWER ? 2 : 1);
+    Uint64 target = xi_pacing.last_vblank + period;
+    if (!xi_pacing.last_vblank) {
+        target = now + lead;  // no phase yet
+    } else if (target < now + lead) {
+        Uint64 behind = now + lead - target;
+        target += (behind + xi_pacing.refresh - 1) / xi_pacing.refresh * xi_pacing.refresh;
+    }
+    xi_pacing.target = target;
+    xi_pacing.start_at = target - lead;
+    xi_pacing_stats.lead_ms = 1000.0f * lead / xi_pacing.frequency;
 }
 
-// Update the slider based on mouse input
-void update_slider(Slider *slider, SDL_Event *event) {
-    int mx = event->motion.x;
-    int my = event->motion.y;
+// ms EventLoop may sleep before the pending frame has to start
+static int xi_pacing_wait(void) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (!xi_pacing.start_at) xi_pacing_schedule(now);
+    if (now >= xi_pacing.start_at) return 0;
+    return (int)((xi_pacing.start_at - now) * 1000 / xi_pacing.frequency);
+}
 
-    if (event->type == SDL_MOUSEBUTTONDOWN) {
-        float percentage = (float)(slider->value - slider->min_value) / (slider->max_value - slider->min_value);
-        int handle_x = slider->x + (int)(percentage * (slider->width - slider->height));
+static bool xi_pacing_due(void) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (!xi_pacing.start_at) xi_pacing_schedule(now);
+    return now + xi_pacing.frequency / 1000 > xi_pacing.start_at;  // the wait can't get closer than 1 ms
+}
 
-        if (mx >= handle_x && mx <= handle_x + slider->height &&
-            my >= slider->y && my <= slider->y + slider->height) {
-            slider->dragging = true;
+static void xi_pacing_presented(Uint64 drawn, Uint64 presented) {
+    xi_pacing.costs[xi_pacing.cost_index++ % XI_PACING_SAMPLES] = drawn - xi_pacing.frame_start;
+    if (xi_pacing.synced && xi_pacing.last_vblank) {
+        // Refine the interval from presents a whole number of refreshes apart
+        Uint64 delta = presented - xi_pacing.last_vblank;
+        Uint64 refreshes = (delta + xi_pacing.refresh / 2) / xi_pacing.refresh;
+        if (refreshes >= 1 && refreshes <= 4) {
+            Sint64 error = (Sint64)(delta / refreshes) - (Sint64)xi_pacing.refresh;
+            if (error < (Sint64)xi_pacing.refresh / 8 && -error < (Sint64)xi_pacing.refresh / 8) {
+                xi_pacing.refresh += error / 16;
+                xi_pacing_stats.refresh_ms = 1000.0f * xi_pacing.refresh / xi_pacing.frequency;
+            }
         }
+        if (presented > xi_pacing.target + xi_pacing.refresh / 2) xi_pacing_stats.missed++;
     }
+    xi_pacing.last_vblank = presented;
+    xi_pacing_stats.frames++;
+}
 
-    if (event->type == SDL_MOUSEMOTION && slider->dragging) {
-        int new_value = slider->min_value + ((mx - slider->x) * (slider->max_value - slider->min_value)) / (slider->width - slider->height);
-        if (new_value < slider->min_value) new_value = slider->min_value;
-        if (new_value > slider->max_value) new_value = slider->max_value;
-        slider->value = new_value;
+static void xi_pacing_begin(void) {
+    xi_pacing.frame_start = SDL_GetPerformanceCounter();
+    xi_pacing.presented = false;
+}
+
+static void xi_pacing_end(void) {
+    if (!xi_pacing.presented && !xi_pacing.synced) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        xi_pacing_presented(now, now);  // the phase is wherever frames happen to end
     }
+    xi_pacing.start_at = 0;
+}
 
-    if (event->type == SDL_MOUSEBUTTONUP) {
-        slider->dragging = false;
+// Present the current window; with pacing the main window's presents time the frames
+static void xi_present(void) {
+    if (xi_pacing.mode == XI_PACE_OFF || xi_current != xi_main_context) {
+        SDL_RenderPresent(grenderer);
+        return;
     }
+    Uint64 drawn = SDL_GetPerformanceCounter();
+    SDL_RenderPresent(grenderer);  // returns at vblank when synced
+    xi_pacing_presented(drawn, SDL_GetPerformanceCounter());
+    xi_pacing.presented = true;
 }
 
+// Draws the current context's window
+static void xi_render_frame(void) {
+    xi_update_scale();
+    xi_UpdateLayout();
+    xi_UpdateBounds();  // anything that moved turns this into a full frame
+    if (xi_current->software) {
+        xi_render_software_frame();
+        return;
+    }
+    if (xi_current->pipe) {
+        xi_render_pipelined_frame();
+        return;
+    }
 
-//=================== Main Loop ==================
-//=====================RENDER ALL WIDGETS=============================
-void render_widgets() {
-/*
- Key Steps for render_widgets():
- 
-    *  Widget Registration: Whenever the user calls button(), label(), or text(), these widgets need to be registered in an internal data structure like a list or array.
-    * Widget Rendering: In render_widgets(), the system will loop through all registered widgets and call the appropriate rendering function for each one, like render_button(), render_label(), or render_text().
-    * Widget Type Checking: Each widget will have a type (e.g., button, label, text), and based on that type, the corresponding render function will be called.
-*/
-    for (int i = 0; i < widget_count; ++i) {
-        switch (widgets[i].type) {
-            case WIDGET_CONTAINER:
-                render_container((xi_Container*)widgets[i].widget);
-                break;     
-            case WIDGET_BUTTON:
-                render_button((Button*)widgets[i].widget);
-                break;
-            case WIDGET_LABEL:
-                render_label((Label*)widgets[i].widget);
-                break;
-            case WIDGET_TEXT:
-                render_text((Text*)widgets[i].widget);
-                break;
-         case WIDGET_SLIDER:
-                render_slider((Slider*)widgets[i].widget);
-                break; 
-         case WIDGET_ENTRY:
-             	render_text_entry((TextEntry*)widgets[i].widget);
-                break;
-            // Add cases for other widget types here as you implement them
-            default:
-                break;
+    int width, height;
+    SDL_GetRendererOutputSize(grenderer, &width, &height);
+    if (xi_screen && (width != xi_current->screen_width || height != xi_current->screen_height)) {
+        SDL_DestroyTexture(xi_screen);
+        xi_screen = NULL;
+    }
+    if (!xi_screen && !xi_current->screen_unsupported) {
+        xi_screen = SDL_CreateTexture(grenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!xi_screen) {
+            SDL_Log("No window copy, drawing full frames: %s", SDL_GetError());
+            xi_current->screen_unsupported = true;
         }
+        xi_current->screen_width = width;
+        xi_current->screen_height = height;
+        xi_redraw = true;
     }
+    xi_set_render_target(xi_screen);  // or the window, without a copy
+
+    // Reset first: whatever widgets invalidate while drawing goes into the next frame
+    bool full = xi_redraw || !xi_screen;
+    SDL_Rect damage = xi_damage;
+    xi_redraw = false;
+    xi_damaged = false;
+
+    if (full) {
+        //clear_screen(xiWindow.background_color);
+        xi_ClearScreen(grenderer, COLOR_GRAY);
+        render_widgets();  // Render all widgets (handled by library)
+    } else {
+        SDL_Rect saved_limit = xi_clip_limit;
+        xi_clip_limit = damage;
+        xi_apply_clip(&damage);
+        xi_DrawRect(grenderer, damage.x, damage.y, damage.w, damage.h, COLOR_GRAY, FILLED);
+        render_widgets();  // culled to the damaged part
+        xi_clip_limit = saved_limit;
+    }
+    if (xi_screen) {
+        xi_set_render_target(NULL);
+        xi_reset_clip();
+        SDL_RenderCopy(grenderer, xi_screen, NULL, NULL);
+    }
+    xi_present();
 }
 
 //=====================================gui loop=================================================
 bool program_active = true; 
+#define XI_FRAME_INTERVAL 16 // ms between frames, so bursts of posted updates are drawn at ~60 Hz
+Uint32 xi_last_frame = 0;
+
+// Window an event happened in; 0 for events that don't belong to one
+static Uint32 xi_event_window(const SDL_Event *event) {
+    switch (event->type) {
+        case SDL_WINDOWEVENT: return event->window.windowID;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: return event->key.windowID;
+        case SDL_TEXTINPUT: return event->text.windowID;
+        case SDL_MOUSEMOTION: return event->motion.windowID;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP: return event->button.windowID;
+        case SDL_MOUSEWHEEL: return event->wheel.windowID;
+        default: return 0;
+    }
+}
+
+void xi_HandleEvent(SDL_Event *event) {
+    if (event->type == xi_wake_event) {
+        return;  // posted work is picked up by xi_ProcessUpdateQueue()
+    }
+    // Deliver to the window it happened in; the rest go to the main window's widgets
+    Uint32 window_id = xi_event_window(event);
+    xi_Context *previous = xi_current;
+    xi_current = xi_main_context;
+    for (int i = 0; window_id && i < XI_MAX_WINDOWS; ++i) {
+        if (xi_contexts[i] && xi_contexts[i]->window_id == window_id) xi_current = xi_contexts[i];
+    }
+    switch (event->type) {
+        case SDL_QUIT:
+            program_active = false;  // User closed the window
+            break;
+        case SDL_WINDOWEVENT:
+            // SDL only sends SDL_QUIT once the last window is closed
+            if (event->window.event == SDL_WINDOWEVENT_CLOSE) {
+                if (xi_current != xi_main_context) SDL_HideWindow(gwindow);
+                else program_active = false;  // closing the main window ends the program
+            }
+            if (event->window.event == SDL_WINDOWEVENT_RESIZED ||
+                event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                // Top-level layout follows the window; only slots that change get re-arranged
+                xi_SetSize(&xi_root, event->window.data1, event->window.data2);
+                xi_SetSize(&xi_overlay, event->window.data1, event->window.data2);
+            }
+            xi_redraw = true;  // exposed, resized, restored...
+            break;
+        case SDL_RENDER_TARGETS_RESET:
+        case SDL_RENDER_DEVICE_RESET:
+            xi_redraw_all();  // texture contents were lost
+            break;
+        default:
+            break;
+    }
+    dispatch_widget_event(event);
+    xi_current = previous;
+    //buttons
+  //  sw_render_all_button_states(event);
+    //drop down: xi_Dropdown, routed by dispatch_widget_event
+    //slider
+    //sw_render_all_slider_states(event);
+    //entry
+  //   sw_render_all_entry_states(event);
+    // Widgets invalidate what their input changed, so no full frame here
+}
+
+// A window with something to draw; hidden and minimized ones wait until they are shown
+static bool xi_frame_pending(xi_Context *context) {
+    bool refused = context->pipe && SDL_AtomicGet(&context->pipe->need_full);  // by the render thread
+    if (!context->redraw && !context->damaged && !refused) return false;
+    return !(SDL_GetWindowFlags(context->window) & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED));
+}
+
+static bool xi_any_frame_pending(void) {
+    if (xi_image_uploads || xi_tween_count > 0) return true;
+    for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+        if (xi_contexts[i] && xi_frame_pending(xi_contexts[i])) return true;
+    }
+    return false;
+}
+
 void EventLoop() {
      while (program_active) {
          SDL_Event event;
-         while (SDL_PollEvent(&event)) {
-             switch (event.type) {
-                 case SDL_QUIT:
-                    program_active = false;  // User closed the window
-                     break;
-                 
-                     break;
-                 case SDL_WINDOWEVENT:
-                     if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
-                         // Resize event triggers window size update
-                     }
-                     break;
-                 default:
-                     break;
+         // Sleep until input, posted work or the next timer; with a frame pending, only
+         // wait out the frame interval
+         int timeout = xi_NextTimerDelay();
+         bool frame_pending = xi_any_frame_pending();
+         if (frame_pending) {
+             Uint32 elapsed = SDL_GetTicks() - xi_last_frame;
+             int frame_wait = elapsed >= XI_FRAME_INTERVAL ? 0 : XI_FRAME_INTERVAL - elapsed;
+             if (xi_pacing.mode != XI_PACE_OFF) frame_wait = xi_pacing_wait();
+             if (timeout < 0 || frame_wait < timeout) timeout = frame_wait;
+         }
+         if (timeout < 0 ? SDL_WaitEvent(&event) : SDL_WaitEventTimeout(&event, timeout)) {
+             xi_HandleEvent(&event);
+             while (SDL_PollEvent(&event)) {
+                 xi_HandleEvent(&event);
+             }
+         }
+         xi_ProcessUpdateQueue();
+         xi_TickTimers();
+         xi_ImmediateFrame();
+         xi_TickScrolling();  // flinging nodes keep their window redrawing
+         xi_PropagateValues();  // after everything that may have set a value
+
+         frame_pending = xi_any_frame_pending();
+         bool paced = xi_pacing.mode != XI_PACE_OFF;
+         if (frame_pending && (paced ? xi_pacing_due() : SDL_GetTicks() - xi_last_frame >= XI_FRAME_INTERVAL)) {
+             if (paced) xi_pacing_begin();
+             xi_UploadImages();  // within the budget; the rest go up over the next frames
+             xi_TickTweens();    // tweens repaint their own widgets
+             xi_last_frame = SDL_GetTicks();
+             xi_Context *previous = xi_current;
+             for (int i = 0; i < XI_MAX_WINDOWS; ++i) {
+                 if (!xi_contexts[i] || xi_contexts[i] == xi_main_context || !xi_frame_pending(xi_contexts[i])) continue;
+                 xi_current = xi_contexts[i];
+                 xi_render_frame();
+             }
+             if (xi_main_context->window && xi_frame_pending(xi_main_context)) {
+                 xi_current = xi_main_context;
+                 xi_render_frame();  // last: a paced present waits for vblank
              }
-             //buttons
-           //  sw_render_all_button_states(&event);
-             //drop down
-           //  sw_render_all_drop_down_states(&event);
-			//slider
-			//sw_render_all_slider_states(&event);
-            //entry
-        //   sw_render_all_entry_states(&event);
-        
+             xi_current = previous;
+             if (paced) xi_pacing_end();
          }
-          //clear_screen(xiWindow.background_color);
-          xi_ClearScreen(grenderer, COLOR_GRAY);
-         render_widgets();  // Render all widgets (handled by library)
-         SDL_RenderPresent(grenderer);       // Present the rendered output
      }
  }